@@ -0,0 +1,69 @@
+/*
+ * board_config.h
+ *
+ * Board descriptor of Arduino Uno (ATMEGA328P) with two VNH2SP30
+ * motor drivers (See. board.h for the contract).
+ */
+
+
+#ifndef BOARD_CONFIG_H_
+#define BOARD_CONFIG_H_
+
+#define BOARD_MOTOR_COUNT	2
+
+// Expands `X(N)` for every motor number N
+#define BOARD_FOR_EACH_MOTOR(X)		X(1) X(2)
+
+// Expands `X(N)` for every motor whose encoder channel A is on external
+// interrupt INTn (See. board_motor.h)
+#define BOARD_FOR_EACH_EXT_INT_MOTOR(X)	X(1) X(2)
+
+// Connection table for two VNH2SP30 motor controllers
+// * Pin format: ATMEGA328P (ARDUINO UNO)
+
+// +=========+============+===========+===========+=============+==============+=======+
+// |         |    IN A    |    IN B   |    PWM    |  HALL CH A  |  OC REGISTER |  EXTI |
+// +=========+============+===========+===========+=============+==============+=======+
+// | MOTOR1  |   PD7(7)   |  PB1(9)   |  PD5(5)   |   PD2(2)    |   OC0B       |  INT0 |
+// +---------+------------+-----------+-----------+-------------+--------------+-------+
+// | MOTOR2  |   PB0(8)   |  PB2(10)  |  PD6(6)   |   PD3(3)    |   OC0A       |  INT1 |
+// +---------+------------+-----------+-----------+-------------+--------------+-------+
+
+#define MOTOR_1_IN_A		PIN_D7
+#define MOTOR_1_IN_B		PIN_B1
+#define MOTOR_1_PWM			PIN_D5
+#define MOTOR_1_PWM_OCR		OCR0B
+#define MOTOR_1_PWM_TCCRA	TCCR0A
+#define MOTOR_1_PWM_COM0	COM0B0
+#define MOTOR_1_PWM_COM1	COM0B1
+#define MOTOR_1_HCHA		PIN_D2
+#define MOTOR_1_ENCODER_ISR	INT0_vect
+#define MOTOR_1_EXT_INT		INT0
+#define MOTOR_1_EXT_INTF	INTF0
+#define MOTOR_1_EICR		EICRA
+#define MOTOR_1_ISC0		ISC00
+#define MOTOR_1_ISC1		ISC01
+
+#define MOTOR_2_IN_A		PIN_B0
+#define MOTOR_2_IN_B		PIN_B2
+#define MOTOR_2_PWM			PIN_D6
+#define MOTOR_2_PWM_OCR		OCR0A
+#define MOTOR_2_PWM_TCCRA	TCCR0A
+#define MOTOR_2_PWM_COM0	COM0A0
+#define MOTOR_2_PWM_COM1	COM0A1
+#define MOTOR_2_HCHA		PIN_D3
+#define MOTOR_2_ENCODER_ISR	INT1_vect
+#define MOTOR_2_EXT_INT		INT1
+#define MOTOR_2_EXT_INTF	INTF1
+#define MOTOR_2_EICR		EICRA
+#define MOTOR_2_ISC0		ISC10
+#define MOTOR_2_ISC1		ISC11
+
+// Both PWM channels are on TIMER 0, TIMER 2 is the PID tick
+#define BOARD_PWM_USES_TIMER_0	1
+#define BOARD_PWM_USES_TIMER_2	0
+
+#define ONBOARD_LED		PIN_B5
+
+
+#endif /* BOARD_CONFIG_H_ */
@@ -18,8 +18,15 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h>
+#include <avr/sleep.h>
 #include <util/delay.h>
 #include "pid.h"
+#include "scheduler.h"
+#include "utils_bitops.h"
+#include "board.h"
+#include "board_motor.h"
+#include "motor_pwm.h"
+#include "pulse_tick_timer.h"
 
 
 /*
@@ -32,23 +39,6 @@
 
 #define PRIVATE static
 
-//////////////////////////////////////////////////////////////////////////
-// -- Bitwise Operators
-#define SET_BIT(REG, BIT) REG |= _BV(BIT)
-#define CLR_BIT(REG, BIT) REG &= ~_BV(BIT)
-#define TGL_BIT(REG, BIT) REG ^= _BV(BIT)
-
-#define IS_BIT_SET(REG, BIT) (REG & _BV(BIT))
-
-#define GET_BYTE(REG, OFFSET) (uint8_t)((REG >> OFFSET) & 0xFF)
-//////////////////////////////////////////////////////////////////////////
-
-//////////////////////////////////////////////////////////////////////////
-// ------ Pin Modes
-#define PIN_MODE_OUTPUT(REG, BIT) SET_BIT(REG, BIT)
-#define PIN_MODE_INPUT(REG, BIT)  CLR_BIT(REG, BIT)
-//////////////////////////////////////////////////////////////////////////
-
 //////////////////////////////////////////////////////////////////////////
 // Flag that is used to declare that a function or a block
 // of code uses some resource named X. If a resource is reused
@@ -101,18 +91,7 @@ typedef struct {
  *	Begin Pin Definitions
  */
 
-// Connection table for two VNH2SP30 motor controllers
-// * Pin format: ATMEGA328P (ARDUINO UNO)
-
-// +=========+============+===========+===========+=============+==============+=======+
-// |         |    IN A    |    IN B   |    PWM    |  HALL CH A  |  OC REGISTER |  EXTI |
-// +=========+============+===========+===========+=============+==============+=======+
-// | MOTOR1  |   PD7(7)   |  PB1(9)   |  PD5(5)   |   PD2(2)    |   OC0B       |  INT0 |
-// +---------+------------+-----------+-----------+-------------+--------------+-------+
-// | MOTOR2  |   PB0(8)   |  PB2(10)  |  PD6(6)   |   PD3(3)    |   OC0A       |  INT1 |
-// +---------+------------+-----------+-----------+-------------+--------------+-------+
-
-
+// Motor pins, PWM channels and encoder interrupts are in board_config.h
 
 /*
  *	End Pin Definitions
@@ -208,28 +187,24 @@ PRIVATE const float motor_on_rps = 1.0f;
  *	Start Global Variables
  */
 
-// Updated by TIMER 1 overflow ISR to increment.
-// Used to extend 16-bit TIMER 1 to 32 bits.
-// Acts as higher nibble for 16-bit TIMER 1.
-PRIVATE volatile uint16_t pulse_tick_counter_high_nibble = 0;
-
 // Motors
-PRIVATE motor_t g_motor_1;
-PRIVATE motor_t g_motor_2;
+#define DEFINE_MOTOR(N)	PRIVATE motor_t g_motor_##N;
+BOARD_FOR_EACH_MOTOR(DEFINE_MOTOR)
 
-// Signal to main loop that PID algorithm is
-// ready to be executed.
-PRIVATE volatile uint8_t g_flag_pid = 0;
+// Main loop tasks, task id is priority (0 is highest).
+typedef enum {
+	TASK_UPDATE_ENCODERS = 0,	// Posted by encoder ISRs
+	TASK_ADVANCE_PIDS = 1,		// Posted by TIMER2_COMPA_vect (PID tick)
+	TASK_PARSE_COMMAND = 2		// Posted by USART_RX_vect
+} task_id_e;
+
+PRIVATE scheduler_t g_scheduler;
 
 // Incremented on each PID execution (when PID timer triggers)
 // Used to keep track of duration of current command (measured in
 // multiples of PID intervals, see 'command_duration_pids')
 PRIVATE volatile uint32_t g_command_timer_pids;
 
-// Flag that indicates that there is a command in command buffer,
-// and that main loop should parse it.
-PRIVATE volatile uint8_t g_flag_command_received = 0;
-
 // Command buffer that holds received raw command from UART.
 // Will be extended to an array in future.
 PRIVATE volatile int8_t g_command_buffer = 0;
@@ -258,17 +233,17 @@ PRIVATE volatile uint8_t g_flag_command_running = 0;
 
 PRIVATE void debug_led_on(void)
 {
-	SET_BIT(PORTB, PORTB5);
+	WRITE_PIN(ONBOARD_LED, 1);
 }
 
 PRIVATE void debug_led_off(void)
 {
-	CLR_BIT(PORTB, PORTB5);
+	WRITE_PIN(ONBOARD_LED, 0);
 }
 
 PRIVATE void debug_led_toggle(void)
 {
-	TGL_BIT(PORTB, PORTB5);
+	TOGGLE_PIN(ONBOARD_LED);
 }
 
 PRIVATE void do_blink_debug_led(void)
@@ -354,109 +329,64 @@ PRIVATE inline void hall_encoder_do_save_timer_value(hall_encoder_t* hEncoder)
 	hEncoder->buffered_timer_value = hEncoder->timer_value;
 	
 	// Save timestamp
-	hEncoder->timer_value = TCNT1;
-	hEncoder->timer_value |= ((uint32_t)(pulse_tick_counter_high_nibble)) << 16;
+	hEncoder->timer_value = PulseTickTimer_GetTimestampFromISR();
 	
 	// Signal scheduler to calculate RPS
 	hEncoder->is_measurement_ready = 1;
+	Scheduler_PostFromISR(&g_scheduler, TASK_UPDATE_ENCODERS);
 }
 
 
 PRIVATE void setup_gpio_pins(void)
 {
 	// DEBUG INBUILD-LED
-	PIN_MODE_OUTPUT(DDRB, DDB5);
-	
-	// --- MOTOR 1
-		// IN A - PD7
-		PIN_MODE_OUTPUT(DDRD, DDD7);
-		// IN B - PB1
-		PIN_MODE_OUTPUT(DDRB, DDB1);
-		// PWM - PD5
-		PIN_MODE_OUTPUT(DDRD, DDD5);
-		// HALL CH A - PD2
-		PIN_MODE_INPUT(DDRD, DDD2);
-		
-	// --- MOTOR 2
-		// IN A - PB0
-		PIN_MODE_OUTPUT(DDRB, DDB0);
-		// IN B - PB2
-		PIN_MODE_OUTPUT(DDRB, DDB2);
-		// PWM - PD6
-		PIN_MODE_OUTPUT(DDRD, DDD6);
-		// HALL CH A - PD3
-		PIN_MODE_INPUT(DDRD, DDD3);
+	PIN_MODE_OUTPUT(ONBOARD_LED);
+	
+	// MOTORS (See. board_config.h)
+	board_motor_setup_pins();
 		
 	// --- UART
 		// RX - PD0
-		PIN_MODE_INPUT(DDRD, DDD0);
+		PIN_MODE_INPUT(PIN_D0);
 		// TX - PD1
-		PIN_MODE_OUTPUT(DDRD, DDD1);
+		PIN_MODE_OUTPUT(PIN_D1);
 }
 
 PRIVATE void set_motor_direction(command_e command)
 {
 	// Clockwise direction = INA & ~INB
 	
-	// --- MOTOR 1 : IN A (PD7), IN B (PB1)
-	// --- MOTOR 2 : IN A (PB0), IN B (PB2)
+	// Motor 2 is mounted mirrored, it turns backward to drive forward
 
 	switch(command)
 	{
 		case COMMAND_FORWARD:
 		//do_blink_debug_led_times(1);
-		
-		// Motor 1
-		SET_BIT(PORTD, PORTD7);
-		CLR_BIT(PORTB, PORTB1);
-		
-		// Motor 2
-		CLR_BIT(PORTB, PORTB0);
-		SET_BIT(PORTB, PORTB2);
-		
+		BOARD_MOTOR_SET_FORWARD(1);
+		BOARD_MOTOR_SET_BACKWARD(2);
 		break;
 		
 		case COMMAND_BACKWARD:
 		//do_blink_debug_led_times(2);
-		// Motor 1
-		CLR_BIT(PORTD, PORTD7);
-		SET_BIT(PORTB, PORTB1);
-		
-		// Motor 2
-		SET_BIT(PORTB, PORTB0);
-		CLR_BIT(PORTB, PORTB2);
+		BOARD_MOTOR_SET_BACKWARD(1);
+		BOARD_MOTOR_SET_FORWARD(2);
 		break;
 		
 		case COMMAND_LEFT:
 		//do_blink_debug_led_times(3);
-		// Motor 1
-		SET_BIT(PORTD, PORTD7);
-		CLR_BIT(PORTB, PORTB1);
-		
-		// Motor 2
-		SET_BIT(PORTB, PORTB0);
-		CLR_BIT(PORTB, PORTB2);
+		BOARD_MOTOR_SET_FORWARD(1);
+		BOARD_MOTOR_SET_FORWARD(2);
 		break;
 		
 		case COMMAND_RIGHT:
 		//do_blink_debug_led_times(4);
-		// Motor 1
-		CLR_BIT(PORTD, PORTD7);
-		SET_BIT(PORTB, PORTB1);
-		
-		// Motor 2
-		CLR_BIT(PORTB, PORTB0);
-		SET_BIT(PORTB, PORTB2);
+		BOARD_MOTOR_SET_BACKWARD(1);
+		BOARD_MOTOR_SET_BACKWARD(2);
 		break;
 		
 		case COMMAND_STOP:
-		// Motor 1
-		CLR_BIT(PORTD, PORTD7);
-		CLR_BIT(PORTB, PORTB1);
-		
-		// Motor 2
-		CLR_BIT(PORTB, PORTB0);
-		CLR_BIT(PORTB, PORTB2);
+#define STOP_MOTOR(N)	BOARD_MOTOR_SET_STOP(N);
+		BOARD_FOR_EACH_MOTOR(STOP_MOTOR)
 		break;
 		
 		default:
@@ -467,130 +397,6 @@ PRIVATE void set_motor_direction(command_e command)
 
 }
 
-PRIVATE void configure_motor_pwm_timer(void)
-{
-	//////////////////////////////////////////////////////////////////////////
-	// Two motors need two PWM channels (Output Compare Registers):
-	// - 8 bit TIMER0 Channels A & B
-	//////////////////////////////////////////////////////////////////////////
-	
-	//////////////////////////////////////////////////////////////////////////
-	// -- Timer 0
-	// Phase corrected PWM mode
-	
-	// Set phase corrected PWM mode of operation
-	SET_BIT(TCCR0A, WGM00);
-	CLR_BIT(TCCR0A, WGM01);
-	CLR_BIT(TCCR0B, WGM02);
-	
-	// Set on upcount, clear on downcount
-	// Output Compare - A
-	SET_BIT(TCCR0A, COM0A0);
-	SET_BIT(TCCR0A, COM0A1);
-	
-	// Output Compare - B
-	SET_BIT(TCCR0A, COM0B0);
-	SET_BIT(TCCR0A, COM0B1);
-
-	// Set clock prescaler to 1/8
-	// Which gives 16MHz/(8 * 510) = 3.9 kHz PWM frequency
-	CLR_BIT(TCCR0B, CS00);
-	SET_BIT(TCCR0B, CS01);
-	CLR_BIT(TCCR0B, CS02);
-	
-	// Disable interrupts
-	// Overflow
-	CLR_BIT(TIMSK0, TOV0);
-	// Output Compare B Match
-	CLR_BIT(TIMSK0, OCIE0A);
-	// Output Compare B Match
-	CLR_BIT(TIMSK0, OCIE0B);
-	//////////////////////////////////////////////////////////////////////////
-}
-
-// input:
-// - duty_cycle = [0..100] = Duty Cycle Percentage
-// output:
-// - Output compare value for:
-//		* 8 bit timer
-//		* Phase corrected PWM mode
-//		* Set on upcount, clear on downcount
-PRIVATE inline uint8_t calculate_oc_value_from_dc(uint32_t duty_cycle)
-{
-	// Set phase corrected PWM value from defined duty cycle
-	// NOTE: Formula used is modified for integer division
-	
-	// Phase Corrected PWM (TOP = 0xFF)
-	// with 'Set on upcount, reset on downcount'
-	return (uint8_t)((255 * ((uint32_t)100 - duty_cycle))/100);
-}
-
-
-PRIVATE void enable_encoder_interrupt(void)
-{
-	// Enable Pullups (Disable pullup blockade)
-	CLR_BIT(MCUCR, PUD);
-	
-	//////////////////////////////////////////////////////////////////////////
-	// -- MOTOR 1
-	// Configure PD2 (INT0) as input
-	CLR_BIT(DDRD, DDD2);
-	
-	// Enable pullup (IG32E Hall encoder docs require 1k external pullup)
-	SET_BIT(PORTD, PORTD2);
-	
-	// Set rising edge mode for INT0 (PD2)
-	SET_BIT(EICRA, ISC00);
-	SET_BIT(EICRA, ISC01);
-	
-	// Enable external interrupt
-	 SET_BIT(EIMSK, INT0);
-	//////////////////////////////////////////////////////////////////////////
-
-	//////////////////////////////////////////////////////////////////////////
-	// -- MOTOR 2
-	// Configure PD3 (INT1) as input
-	CLR_BIT(DDRD, DDD3);
-	
-	// Enable pullup (IG32E Hall encoder docs require 1k external pullup)
-	SET_BIT(PORTD, PORTD3);
-	
-	// Set rising edge mode for INT1 (PD3)
-	SET_BIT(EICRA, ISC10);
-	SET_BIT(EICRA, ISC11);
-	
-	// Enable external interrupt
-	SET_BIT(EIMSK, INT1);
-	//////////////////////////////////////////////////////////////////////////
-
-}
- 
-PRIVATE void configure_pulse_tick_timer(void) 
-{
-	// Set normal mode of operation
-	CLR_BIT(TCCR1A, COM1A0);
-	CLR_BIT(TCCR1A, COM1A1);
-	
-	CLR_BIT(TCCR1A, WGM10);
-	CLR_BIT(TCCR1A, WGM11);
-	CLR_BIT(TCCR1B, WGM12);
-	CLR_BIT(TCCR1B, WGM13);
-	
-	// Initialize timer value
-	TCNT1 = 0;
-}
-
-PRIVATE void enable_pulse_tick_timer(void)
-{
-	// Enable overflow interrupt	
-	SET_BIT(TIMSK1, TOIE1);
-	
-	// Enable clock (no prescaler)
-	SET_BIT(TCCR1B, CS10);
-	CLR_BIT(TCCR1B, CS11);
-	CLR_BIT(TCCR1B, CS12);
-}
-
 // Calculated new RPS value for 'hEncoder' Hall Encoder
 // From saved timer values (which are saved in INT0/1 ISRs)
 PRIVATE void do_update_rps(hall_encoder_t* hEncoder)
@@ -692,47 +498,35 @@ PRIVATE void setup_usart_receive(void)
 
 PRIVATE void setup_PID(void)
 {
-	// PID Controller for Motor 1
-	PID_Init(
-		&g_motor_1.pid,		/* pid_t Handle				*/
-		PID_KP,				/* Kp - Proportional Term	*/
-		0,					/* Td - Derivative Term		*/
-		PID_TI,				/* Ti - Integral Term		*/
-		0,					/* Minimum PID Output Value */
-		95					/* Maximum PID Output Value */
-	);
-	
-	// PID Controller for Motor 2
-	PID_Init(
-		&g_motor_2.pid,		/* pid_t Handle				*/
-		PID_KP,				/* Kp - Proportional Term	*/
-		0,					/* Td - Derivative Term		*/
-		PID_TI,				/* Ti - Integral Term		*/
-		0,					/* Minimum PID Output Value */
-		95					/* Maximum PID Output Value */
+	// PID Controller of every motor
+#define SETUP_MOTOR_PID(N)							\
+	PID_Init(										\
+		&g_motor_##N.pid,	/* pid_t Handle				*/	\
+		PID_KP,				/* Kp - Proportional Term	*/	\
+		0,					/* Td - Derivative Term		*/	\
+		PID_TI,				/* Ti - Integral Term		*/	\
+		0,					/* Minimum PID Output Value */	\
+		95					/* Maximum PID Output Value */	\
 	);
+	BOARD_FOR_EACH_MOTOR(SETUP_MOTOR_PID)
 }
 
 PRIVATE void do_advance_pids(void)
 {
-	float error_1 = 0;
-	float input_1 = 0;
-	
-	float error_2 = 0;
-	float input_2 = 0;
+	motor_pwm_compare_t compares[BOARD_MOTOR_COUNT];
 	
 	// TODO: Robust sample time calculation
 	
-	error_1 = g_motor_1.setpoint - g_motor_1.hall_encoder.current_rps;
-	input_1 = PID_Advance(&g_motor_1.pid, SAMPLE_TIME_S, error_1);
-	OCR0B = calculate_oc_value_from_dc((uint32_t)input_1);
-	
-	error_2 = g_motor_2.setpoint - g_motor_2.hall_encoder.current_rps;
-	input_2 = PID_Advance(&g_motor_2.pid, SAMPLE_TIME_S, error_2);
-	OCR0A = calculate_oc_value_from_dc((uint32_t)input_2);
+	// Fraction of PID output is kept down to PWM resolution (See. motor_pwm.h)
+#define ADVANCE_MOTOR_PID(N)																	\
+	{																							\
+		const float error = g_motor_##N.setpoint - g_motor_##N.hall_encoder.current_rps;		\
+		const float input = PID_Advance(&g_motor_##N.pid, SAMPLE_TIME_S, error);				\
+		compares[BOARD_MOTOR_INDEX(N)] = motor_pwm_compare_from_duty(PIDQ_FROM_FLOAT(input));	\
+	}
+	BOARD_FOR_EACH_MOTOR(ADVANCE_MOTOR_PID)
 	
-	// Reset PWM timer for correct transition between duty cycles
-	TCNT0 = 0;
+	motor_pwm_write(compares);
 	
 	//////////////////////////////////////////////////////////////////////////
 	// -------------- DEBUG
@@ -745,16 +539,11 @@ PRIVATE void do_advance_pids(void)
 		//do_handle_fatal_error();
 	//}
 	
-	//uint8_t a = calculate_oc_value_from_dc((uint32_t)input);
-	//usart_send(&a, 1);
-	
-	
-	//usart_send((unsigned char*)&input_1, sizeof(float));
+	//usart_send((unsigned char*)&compares[0], sizeof(motor_pwm_compare_t));
 	//const float a = SAMPLE_TIME_S;
 	//usart_send((unsigned char*)&a, sizeof(float));
 	
 	//usart_send((unsigned char*)&g_motor_2.hall_encoder.current_rps, sizeof(float));
-	//usart_send((unsigned char*)&error_2, sizeof(float));
 	//usart_send((unsigned char*)&g_motor_2.setpoint, sizeof(float));
 	//////////////////////////////////////////////////////////////////////////
 	
@@ -769,8 +558,8 @@ PRIVATE void do_parse_command(void)
 	}	
 	
 	// Set motor speeds
-	g_motor_1.setpoint = motor_on_rps;
-	g_motor_2.setpoint = motor_on_rps;
+#define SET_MOTOR_ON(N)	g_motor_##N.setpoint = motor_on_rps;
+	BOARD_FOR_EACH_MOTOR(SET_MOTOR_ON)
 	
 	command_e command = COMMAND_UNKNOWN;
 	
@@ -813,77 +602,92 @@ PRIVATE void do_on_command_complete(void)
 {
 	//set_motor_direction(COMMAND_STOP);
 	
-	g_motor_1.setpoint = 0;
-	g_motor_2.setpoint = 0;
-	
 	// Clamp PWM to 0% duty cycle
-	OCR0A = 0xFF;
-	OCR0B = 0xFF;
+	motor_pwm_stop();
 	
-	PID_ClearAccumulatedValues(&g_motor_1.pid);
-	PID_ClearAccumulatedValues(&g_motor_2.pid);
+#define CLEAR_MOTOR(N)							\
+	g_motor_##N.setpoint = 0;					\
+	PID_ClearAccumulatedValues(&g_motor_##N.pid);
+	BOARD_FOR_EACH_MOTOR(CLEAR_MOTOR)
 	//debug_led_off();
 }
 
 
+PRIVATE void task_update_encoders(void)
+{
+#define UPDATE_MOTOR_ENCODER(N)								\
+	if(g_motor_##N.hall_encoder.is_measurement_ready)		\
+	{														\
+		g_motor_##N.hall_encoder.is_measurement_ready = 0;	\
+		do_update_rps(&g_motor_##N.hall_encoder);			\
+	}
+	BOARD_FOR_EACH_MOTOR(UPDATE_MOTOR_ENCODER)
+}
+
+PRIVATE void task_advance_pids(void)
+{
+	if(!g_flag_command_running)
+	{
+		return;
+	}
+	
+	do_advance_pids();
+	
+	if(g_command_timer_pids >= command_duration_pids)
+	{
+		do_on_command_complete();
+		g_flag_command_running = 0;
+		g_command_timer_pids = 0;
+	}
+}
+
+PRIVATE void task_parse_command(void)
+{
+	// TODO: do not set command running flag on unknown command
+	do_parse_command();
+}
+
+PRIVATE void setup_scheduler(void)
+{
+	Scheduler_Init(&g_scheduler);
+	
+	// CPU sleeps when no task is ready, timers and USART keep running
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	
+	Scheduler_RegisterTask(&g_scheduler, TASK_UPDATE_ENCODERS,	task_update_encoders);
+	Scheduler_RegisterTask(&g_scheduler, TASK_ADVANCE_PIDS,		task_advance_pids);
+	Scheduler_RegisterTask(&g_scheduler, TASK_PARSE_COMMAND,	task_parse_command);
+}
+
 int main(void)
 {
 	
 	// Setup
 	setup_gpio_pins();
 	
-	configure_motor_pwm_timer();
+	motor_pwm_init();
 	setup_pid_timer();
-	configure_pulse_tick_timer();
+	PulseTickTimer_Init(NULL);
 	
 	setup_usart_receive();
 	
 	setup_PID();
 	
-	enable_encoder_interrupt();
-	enable_pulse_tick_timer();
-
+	board_motor_enable_encoder_interrupts();
+	PulseTickTimer_Start();
+	
+	setup_scheduler();
 	
 	sei();
 
 	enable_pid_timer();
 	
-	g_motor_1.hall_encoder.current_rps = 0;
-	g_motor_2.hall_encoder.current_rps = 0;
+#define RESET_MOTOR_RPS(N)	g_motor_##N.hall_encoder.current_rps = 0;
+	BOARD_FOR_EACH_MOTOR(RESET_MOTOR_RPS)
 	
     while (1) 
     {
-		if(g_motor_1.hall_encoder.is_measurement_ready)
-		{
-			do_update_rps(&g_motor_1.hall_encoder);
-			g_motor_1.hall_encoder.is_measurement_ready = 0;
-		}
-		
-		if(g_motor_2.hall_encoder.is_measurement_ready)
-		{
-			do_update_rps(&g_motor_2.hall_encoder);
-			g_motor_2.hall_encoder.is_measurement_ready = 0;
-		}
-		
-		if(g_flag_pid && g_flag_command_running)
-		{
-			do_advance_pids();
-			g_flag_pid = 0;
-		}
-		
-		if(g_flag_command_received)
-		{
-			// TODO: do not set command running flag on unknown command
-			do_parse_command();
-			g_flag_command_received = 0;
-		}
-		
-		if(g_flag_command_running && g_command_timer_pids >= command_duration_pids)
-		{
-			do_on_command_complete();
-			g_flag_command_running = 0;
-			g_command_timer_pids = 0;
-		}
+		Scheduler_RunNextOrSleep(&g_scheduler);
     }
 }
 
@@ -895,20 +699,10 @@ int main(void)
  *	Start Signal Handlers
  */
 
-ISR(INT0_vect)
-{
-	hall_encoder_do_save_timer_value(&g_motor_1.hall_encoder);
-}
-
-ISR(INT1_vect)
-{
-	hall_encoder_do_save_timer_value(&g_motor_2.hall_encoder);
-}
-
-ISR(TIMER1_OVF_vect)
-{
-	++pulse_tick_counter_high_nibble;
-}
+// Channel A of every motor (See. board_config.h)
+#define DEFINE_MOTOR_ENCODER_ISR(N)	\
+	ISR(MOTOR_##N##_ENCODER_ISR) { hall_encoder_do_save_timer_value(&g_motor_##N.hall_encoder); }
+BOARD_FOR_EACH_MOTOR(DEFINE_MOTOR_ENCODER_ISR)
 
 ISR(TIMER2_COMPA_vect)
 {	
@@ -919,7 +713,7 @@ ISR(TIMER2_COMPA_vect)
 	}
 	
 	// Signal the loop that PID is waiting for next calculation
-	g_flag_pid = 1;
+	Scheduler_PostFromISR(&g_scheduler, TASK_ADVANCE_PIDS);
 }
 
 ISR(USART_RX_vect)
@@ -927,7 +721,7 @@ ISR(USART_RX_vect)
 	if (IS_BIT_SET(UCSR0A, RXC0) && !g_flag_command_running)
 	{
 		g_command_buffer = UDR0;
-		g_flag_command_received = 1;
+		Scheduler_PostFromISR(&g_scheduler, TASK_PARSE_COMMAND);
 	}
 	else
 	{
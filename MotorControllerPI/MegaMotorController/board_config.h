@@ -0,0 +1,158 @@
+/*
+ * board_config.h
+ *
+ * Board descriptor of Arduino Mega (ATMEGA2560) with three VNH2SP30
+ * motor drivers (See. board.h for the contract).
+ * Pins depend on build switches of main.c (PWM backend, encoder mode),
+ * so this header is included after Build Configuration.
+ */ 
+
+
+#ifndef BOARD_CONFIG_H_
+#define BOARD_CONFIG_H_
+
+#define BOARD_MOTOR_COUNT	3
+
+// Expands `X(N)` for every motor number N
+#define BOARD_FOR_EACH_MOTOR(X)		X(1) X(2) X(3)
+
+// Expands `X(N)` for every motor whose encoder channel A is on external
+// interrupt INTn (MOTOR_<N>_EXT_INT, MOTOR_<N>_EXT_INTF, MOTOR_<N>_EICR,
+// MOTOR_<N>_ISC0 and MOTOR_<N>_ISC1 are defined for these motors only)
+#if defined(USE_INPUT_CAPTURE_ENCODER)
+#define BOARD_FOR_EACH_EXT_INT_MOTOR(X)	X(3)
+#else
+#define BOARD_FOR_EACH_EXT_INT_MOTOR(X)	X(1) X(2) X(3)
+#endif
+
+// Connection table for two VNH2SP30 motor controllers
+// * Pin format: ATMEGA2560 (ARDUINO MEGA)
+
+
+//	+===========+============+============+============+
+//	|     /     |  MOTOR 1   |   MOTOR 2  |   MOTOR 3  |
+//	+===========+============+============+============+
+//	| IN A      | PA1(DIO23) | PA2(DIO24) | PA3(DIO25) |
+//	+-----------+------------+------------+------------+
+//	| IN B      | PC1(DIO36) | PC2(DIO35) | PC3(DIO34) |
+//	+-----------+------------+------------+------------+
+//	| PWM       | PH6(PWM9)  | PG5(PWM4)  | PB4(PWM10) |
+//	+-----------+------------+------------+------------+
+//	| HALL CH A | PE4(PWM2)  | PE5(PWM3)  | PD2(COM19) |
+//	+-----------+------------+------------+------------+
+//	| EXT INT   | INT4       | INT5       | INT2       |
+//	+-----------+------------+------------+------------+
+//	| HALL CH A | PL0(DIO49) | PL1(DIO48) | PD2(COM19) |
+//	| (ICP)     | ICP4       | ICP5       | INT2       |
+//	+-----------+------------+------------+------------+
+//	| HALL CH B | PK0(A8)    | PK1(A9)    | PK2(A10)   |
+//	| (QUAD)    | PCINT16    | PCINT17    | PCINT18    |
+//	+-----------+------------+------------+------------+
+//	| OC REG    | OC2B       | OC0B       | OC2A       |
+//	| (TIMER 5) | OC5A(PL3)  | OC5B(PL4)  | OC5C(PL5)  |
+//	+-----------+------------+------------+------------+
+//	| CUR SENSE | PF0(A0)    | PF1(A1)    | PF2(A2)    |
+//	| (CS)      | ADC0       | ADC1       | ADC2       |
+//	+-----------+------------+------------+------------+
+
+#define MOTOR_1_IN_A	PIN_A1
+#define MOTOR_1_IN_B	PIN_C1
+#if MOTOR_PWM_BACKEND == MOTOR_PWM_BACKEND_TIMER_5
+#define MOTOR_1_PWM		PIN_L3
+#define MOTOR_1_PWM_OCR	OCR5A
+#define MOTOR_1_PWM_TCCRA	TCCR5A
+#define MOTOR_1_PWM_COM0	COM5A0
+#define MOTOR_1_PWM_COM1	COM5A1
+#else
+#define MOTOR_1_PWM		PIN_H6
+#define MOTOR_1_PWM_OCR	OCR2B
+#define MOTOR_1_PWM_TCCRA	TCCR2A
+#define MOTOR_1_PWM_COM0	COM2B0
+#define MOTOR_1_PWM_COM1	COM2B1
+#endif
+#if defined(USE_INPUT_CAPTURE_ENCODER)
+#define MOTOR_1_HCHA	PIN_L0
+#define MOTOR_1_ENCODER_ISR	TIMER4_CAPT_vect
+#else
+#define MOTOR_1_HCHA	PIN_E4
+#define MOTOR_1_ENCODER_ISR	INT4_vect
+#define MOTOR_1_EXT_INT		INT4
+#define MOTOR_1_EXT_INTF	INTF4
+#define MOTOR_1_EICR		EICRB
+#define MOTOR_1_ISC0		ISC40
+#define MOTOR_1_ISC1		ISC41
+#endif
+#define MOTOR_1_HCHB	PIN_K0
+#define MOTOR_1_CS_ADC	0
+
+#define MOTOR_2_IN_A	PIN_A2
+#define MOTOR_2_IN_B	PIN_C2
+#if MOTOR_PWM_BACKEND == MOTOR_PWM_BACKEND_TIMER_5
+#define MOTOR_2_PWM		PIN_L4
+#define MOTOR_2_PWM_OCR	OCR5B
+#define MOTOR_2_PWM_TCCRA	TCCR5A
+#define MOTOR_2_PWM_COM0	COM5B0
+#define MOTOR_2_PWM_COM1	COM5B1
+#else
+#define MOTOR_2_PWM		PIN_G5
+#define MOTOR_2_PWM_OCR	OCR0B
+#define MOTOR_2_PWM_TCCRA	TCCR0A
+#define MOTOR_2_PWM_COM0	COM0B0
+#define MOTOR_2_PWM_COM1	COM0B1
+#endif
+#if defined(USE_INPUT_CAPTURE_ENCODER)
+#define MOTOR_2_HCHA	PIN_L1
+#define MOTOR_2_ENCODER_ISR	TIMER5_CAPT_vect
+#else
+#define MOTOR_2_HCHA	PIN_E5
+#define MOTOR_2_ENCODER_ISR	INT5_vect
+#define MOTOR_2_EXT_INT		INT5
+#define MOTOR_2_EXT_INTF	INTF5
+#define MOTOR_2_EICR		EICRB
+#define MOTOR_2_ISC0		ISC50
+#define MOTOR_2_ISC1		ISC51
+#endif
+#define MOTOR_2_HCHB	PIN_K1
+#define MOTOR_2_CS_ADC	1
+
+#define MOTOR_3_IN_A	PIN_A3
+#define MOTOR_3_IN_B	PIN_C3
+#if MOTOR_PWM_BACKEND == MOTOR_PWM_BACKEND_TIMER_5
+#define MOTOR_3_PWM		PIN_L5
+#define MOTOR_3_PWM_OCR	OCR5C
+#define MOTOR_3_PWM_TCCRA	TCCR5A
+#define MOTOR_3_PWM_COM0	COM5C0
+#define MOTOR_3_PWM_COM1	COM5C1
+#else
+#define MOTOR_3_PWM		PIN_B4
+#define MOTOR_3_PWM_OCR	OCR2A
+#define MOTOR_3_PWM_TCCRA	TCCR2A
+#define MOTOR_3_PWM_COM0	COM2A0
+#define MOTOR_3_PWM_COM1	COM2A1
+#endif
+#define MOTOR_3_HCHA	PIN_D2
+#define MOTOR_3_ENCODER_ISR	INT2_vect
+#define MOTOR_3_EXT_INT		INT2
+#define MOTOR_3_EXT_INTF	INTF2
+#define MOTOR_3_EICR		EICRA
+#define MOTOR_3_ISC0		ISC20
+#define MOTOR_3_ISC1		ISC21
+#define MOTOR_3_HCHB	PIN_K2
+#define MOTOR_3_CS_ADC	2
+
+// 8-bit timers of MOTOR_PWM_BACKEND_TIMER_0_2 (See. motor_pwm.h). OC0A is
+// not driven, it triggers current sense ADC (See. motor_current.h)
+#define BOARD_PWM_USES_TIMER_0	1
+#define BOARD_PWM_USES_TIMER_2	1
+
+#define ONBOARD_LED		PIN_B7
+
+// Scope probe of PROFILER_MODE_GPIO (See. profiler.h). PB6 (DIO12)
+#define PROFILER_GPIO_PIN	PIN_B6
+
+// RS-485 transceiver driver enable (DE and /RE tied together), used with
+// USE_BUS_ADDRESSING. PG1 (DIO40)
+#define RS485_DE		PIN_G1
+
+
+#endif /* BOARD_CONFIG_H_ */
@@ -19,16 +19,29 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h>
+#include <avr/sleep.h>
 #include <util/delay.h>
-#include <string.h> // memset
+#include <util/atomic.h> // ATOMIC_BLOCK
+#include <string.h> // memcpy
 #include <limits.h> // UINT32_MAX
-#include <math.h> // signbit
+#include <math.h> // fabs
 #include "pid.h"
+#include "pid_bank.h"
+#include "quadrature_encoder.h"
 #include "utils_bitops.h"
 #include "util_pindefs.h"
 #include "stxetx_protocol.h"
 #include "circular_buffer.h"
-#include "cma.h"				
+#include "spsc_ring.h"
+#include "filter.h"
+#include "scheduler.h"
+#include "soft_timer.h"
+#include "setpoint_ramp.h"
+#include "sysid.h"
+#include "relay_autotune.h"
+#include "gain_store.h"
+#include "event_log.h"
+#include "kinematics.h"
 
 
 /*
@@ -41,6 +54,170 @@
 
 #define PRIVATE static
 
+//////////////////////////////////////////////////////////////////////////
+// ------ Build Configuration
+
+// Motor PI controller implementation:
+// - defined: fixed-point Q16.16 controllers batched in a pid_bank_t (PIDBank_*),
+//            no soft-float in PID step
+// - undefined: floating point controller per motor (PID_*)
+// Cycles of both are compared with probe PROBE_PID_CONTROLLERS (See. PROFILER_MODE)
+#define USE_FIXED_POINT_PID
+
+// Hall encoder timestamp source for MOTOR 1 and MOTOR 2:
+// - defined: input capture units of TIMER 4 (ICP4) and TIMER 5 (ICP5) timestamp
+//            edges in hardware. TIMER 4 is then free-running (capture time base).
+//            (Encoders must be wired to PL0/PL1)
+// - undefined: external interrupts INT4/INT5 timestamp edges with TIMER 1
+// MOTOR 3 always uses INT2 (no other input capture pin is available on Mega header)
+//#define USE_INPUT_CAPTURE_ENCODER
+
+// Encoder decoding:
+// - defined: channel A and B are decoded (quadrature), signed tick count and
+//            hybrid (count/period) speed estimate are kept per motor.
+//            (Channel B must be wired to PK0/PK1/PK2)
+// - undefined: only rising edges of channel A are timestamped (speed has no sign)
+//#define USE_QUADRATURE_ENCODER
+
+// RPS (Revolutions Per Second) measurement filter pipeline, evaluated
+// on every encoder pulse: median (spike rejection) -> moving average [-> biquad]
+// Defaults, can be changed at run time with hall_encoder_configure_filters()
+// - Median taps (0 = disabled, 3 or 5)
+#define RPS_MEDIAN_TAPS 3
+// - Moving average window is 2^RPS_AVERAGE_WINDOW_SHIFT pulses (0 = disabled)
+#define RPS_AVERAGE_WINDOW_SHIFT 1
+// - Optional biquad low-pass, cutoff frequency relative to pulse frequency
+//#define RPS_BIQUAD_CUTOFF_RATIO 0.1f
+
+// Setpoint profile generated ahead of PI controllers (evaluated every PID tick):
+// - Setpoints change by at most SETPOINT_RAMP_ACCELERATION [rps/s]
+//   (trapezoidal speed profile). 0 applies setpoints as steps.
+// - Non-zero SETPOINT_RAMP_JERK [rps/s^2] also ramps the acceleration (S-curve).
+// Defaults, can be changed at run time with `SET_RAMP` message
+#define SETPOINT_RAMP_ACCELERATION 20.0f
+#define SETPOINT_RAMP_JERK 0.0f
+
+// Odometry broadcast while command is running:
+// - defined: `ODOMETRY_COMPACT` frame (signed Q8.8 speeds, 16-bit microsecond
+//            timestamp of PID tick, sequence number) every
+//            ODOMETRY_COMPACT_DECIMATION PID ticks
+// - undefined: `ODOMETRY` frame (float averages, 1ms resolution) every 500ms
+//#define USE_COMPACT_ODOMETRY
+// 1..4, timestamp wraps every 65.536ms so host can unwrap it for up to 4 ticks (64ms)
+#define ODOMETRY_COMPACT_DECIMATION 2
+
+#if defined(USE_COMPACT_ODOMETRY) && (ODOMETRY_COMPACT_DECIMATION < 1 || ODOMETRY_COMPACT_DECIMATION > 4)
+	#error "ODOMETRY_COMPACT_DECIMATION must be 1..4"
+#endif
+
+// USART0 link speed (usart_speed_e) after reset. Host can move the link to
+// another speed with `SET_BAUD` message (See. on_received_msg_set_baud()).
+#define USART_BOOT_SPEED USART_SPEED_115200
+// Speed set by `SET_BAUD` is reverted to previous one unless a valid frame
+// is received at the new speed within this time
+#define USART_SPEED_CONFIRM_TIMEOUT_MS 1000
+// Consecutive malformed frames (checksum, length or ETX errors) after which
+// link falls back to next lower speed (never below USART_BOOT_SPEED)
+#define USART_SPEED_FALLBACK_ERROR_COUNT 8
+// Minimum time between two unsolicited `LINK_ERROR` reports (system clock).
+// Errors in between are only counted (See. DIAGNOSTICS message).
+#define LINK_ERROR_REPORT_INTERVAL_MS 1000
+
+// Multi-drop bus (e.g. RS-485 half duplex, several boards on one host link):
+// - defined: every frame carries address byte after STX (See. stxetx_protocol.c).
+//            Frames of other nodes are dropped in USART0_RX_vect before they are
+//            decoded. Frames sent to STXETX_ADDRESS_BROADCAST are executed by all
+//            nodes and never answered. Transmitted frames carry BUS_NODE_ADDRESS.
+//            Driver enable pin (RS485_DE, board_config.h) is high while transmitting.
+// - undefined: point to point link, frames have no address
+//#define USE_BUS_ADDRESSING
+// Address of this board (0x00..0xFE), unique on the bus
+#define BUS_NODE_ADDRESS 0x01
+
+#if defined(USE_BUS_ADDRESSING) && (BUS_NODE_ADDRESS == STXETX_ADDRESS_BROADCAST)
+	#error "BUS_NODE_ADDRESS must not be the broadcast address"
+#endif
+
+// PID tick telemetry capture into SRAM (See. TELEMETRY_ARM and TELEMETRY_DUMP messages)
+// - Number of records (power of two, at most 128), one record is 23 bytes (3 motors)
+#define TELEMETRY_RECORD_COUNT 64
+
+// Hot path profiler (See. profiler.h and probe_id_e):
+// - PROFILER_MODE_DISABLED: PROFILE_BEGIN/PROFILE_END compile to nothing
+// - PROFILER_MODE_CYCLES: min/max/mean cycles per probe (See. PROFILER_QUERY message)
+// - PROFILER_MODE_GPIO: PROFILER_GPIO_PIN of board_config.h is high while PROFILER_GPIO_PROBE runs
+#define PROFILER_MODE PROFILER_MODE_DISABLED
+#define PROFILER_GPIO_PROBE PROBE_ADVANCE_PIDS
+
+// PID controller timestep:
+// - defined: measured time between PID executions (TIMER 1) is passed to
+//            controllers, so merged (missed) ticks integrate the real time
+// - undefined: fixed SAMPLE_TIME_S
+// Timing statistics are always collected (See. DIAGNOSTICS message)
+//#define USE_MEASURED_PID_TIMESTEP
+
+// Open-loop system identification (See. SYSID_START message):
+// - Encoder edge periods are buffered in a ring of SYSID_SAMPLE_COUNT samples
+//   (power of two, at most 128, one sample is 6 bytes) and streamed in `SYSID_DATA` frames
+// - defined SYSID_FIT_MODEL: first-order model y[k] = A*u[k-1] + B*y[k-1]
+//   (See. MOTOR_MODEL_A/MOTOR_MODEL_B) is also fitted on the device at PID rate
+//   and sent in `SYSID_RESULT`
+#define SYSID_SAMPLE_COUNT 64
+#define SYSID_FIT_MODEL
+
+// Relay feedback auto-tuning of PI gains (See. AUTOTUNE_START message):
+// - First AUTOTUNE_SKIP_CYCLES oscillation cycles are not measured (settling)
+// - Run fails if oscillation is not measured within AUTOTUNE_TIMEOUT_MS
+// Gains are loaded from EEPROM in setup_PID(), PID_KP/PID_TI are used if stored
+// record is not valid (See. PID_GAINS message and gain_store.h)
+#define AUTOTUNE_SKIP_CYCLES 2
+#define AUTOTUNE_TIMEOUT_MS 10000
+
+// Motor PWM backend (See. motor_pwm.h):
+// - MOTOR_PWM_BACKEND_TIMER_0_2: 8-bit TIMER 0/2, 3.9 kHz (PWM on PH6, PG5, PB4)
+// - MOTOR_PWM_BACKEND_TIMER_5:   16-bit TIMER 5, MOTOR_PWM_FREQUENCY_HZ (PWM on PL3, PL4, PL5)
+#define MOTOR_PWM_BACKEND MOTOR_PWM_BACKEND_TIMER_0_2
+#define MOTOR_PWM_FREQUENCY_HZ 20000UL
+
+// Motor current sensing (See. motor_current.h):
+// - defined: current sense outputs of motor drivers are sampled by ADC (ISR scans
+//            motors round-robin, in the middle of PWM pulse with TIMER 0/2 backend).
+//            While mean current of a motor exceeds the limit, duty cycle ceiling of
+//            its PI controller is lowered (See. do_update_motor_currents()).
+//            Currents are sent in `CURRENT` channel of `STREAM_DATA`.
+//            (CS outputs must be wired to PF0/PF1/PF2)
+// - undefined: ADC is not used, `CURRENT` stream channel reads 0
+//#define USE_CURRENT_SENSING
+// Current limit of every motor [mA] after reset (0 = no limit),
+// can be changed at run time with `CURRENT_LIMIT` message
+#define CURRENT_LIMIT_MA 10000
+
+#if defined(USE_QUADRATURE_ENCODER) && defined(USE_INPUT_CAPTURE_ENCODER)
+	#error "USE_QUADRATURE_ENCODER requires channel A on external interrupts (INT4/INT5/INT2)"
+#endif
+//////////////////////////////////////////////////////////////////////////
+
+// Configured by PROFILER_MODE above
+#include "profiler.h"
+// Board descriptor, pins are configured by build switches above
+#include "board.h"
+#include "board_motor.h"
+// Configured by MOTOR_PWM_BACKEND above
+#include "motor_pwm.h"
+#include "pulse_tick_timer.h"
+#if defined(USE_CURRENT_SENSING)
+// Trigger is configured by MOTOR_PWM_BACKEND above
+#include "motor_current.h"
+#endif
+
+#if PID_BANK_MAX_CONTROLLERS < BOARD_MOTOR_COUNT
+	#error "Define PID_BANK_MAX_CONTROLLERS (compiler symbol, also used by pid_bank.c) to at least BOARD_MOTOR_COUNT"
+#endif
+
+#if (MOTOR_PWM_BACKEND == MOTOR_PWM_BACKEND_TIMER_5) && defined(USE_INPUT_CAPTURE_ENCODER)
+	#error "MOTOR_PWM_BACKEND_TIMER_5 uses TIMER 5, which USE_INPUT_CAPTURE_ENCODER needs for ICP5"
+#endif
+
 
 //////////////////////////////////////////////////////////////////////////
 // ------ Pin Modes
@@ -76,24 +253,6 @@
 #endif
 	
 	
-#define SET_MOTOR_DIRECTION_FORWARD(M_IN_A, M_IN_B)		\
-		do {											\
-			WRITE_PIN(M_IN_A, 1);						\
-			WRITE_PIN(M_IN_B, 0);						\
-		 } while(0);
-	 
-#define SET_MOTOR_DIRECTION_BACKWARD(M_IN_A, M_IN_B)	\
-		do {											\
-			WRITE_PIN(M_IN_A, 0);						\
-			WRITE_PIN(M_IN_B, 1);						\
-		} while(0);
-
-#define SET_MOTOR_DIRECTION_STOP(M_IN_A, M_IN_B)		\
-		do {											\
-			WRITE_PIN(M_IN_A, 0);						\
-			WRITE_PIN(M_IN_B, 0);						\
-		} while(0);
-
 /*
  *	End Macros
  */
@@ -103,25 +262,289 @@
  */
 
 typedef struct {
+	// Timestamp of the last encoder pulse (owned by encoder ISR)
 	uint32_t timer_value;
-	uint32_t buffered_timer_value;
-	float current_rps;
-	cumulative_moving_average_t average_rps;
-	uint8_t  is_measurement_ready;
+	// Ticks between last two encoder pulses, published by encoder ISR
+	// and read by main loop only inside an atomic block (See. do_update_rps())
+	volatile uint32_t captured_period_ticks;
+	// Filtered speed in RPS, Q16.16 fixed-point
+	pidq_value_t current_rps;
+	// Speed filter pipeline (See. hall_encoder_configure_filters())
+	median_filter_t rps_median;
+	moving_average_t rps_average;
+#if defined(RPS_BIQUAD_CUTOFF_RATIO)
+	biquad_t rps_biquad;
+#endif
+	// Mean of unfiltered speed since command start (odometry), Q16.16
+	mean_accumulator_t average_rps;
+	volatile uint8_t  is_measurement_ready;
+	// TIMER 1 overflow count at the last encoder pulse (See. do_check_encoder_timeout())
+	volatile uint16_t last_pulse_overflow_count;
+	// Incremented by encoder ISR with every pulse (wraps)
+	volatile uint16_t pulse_count;
+	// Set when no pulse arrived for ENCODER_STALL_TIMEOUT_OVERFLOWS
+	uint8_t is_stalled;
+	// Index of motor in `g_motors` (tags system identification samples)
+	uint8_t motor_index;
 } hall_encoder_t;
 
 typedef struct {
 	hall_encoder_t hall_encoder;
+#if defined(USE_QUADRATURE_ENCODER)
+	quadrature_encoder_t quadrature_encoder;
+#endif
+#if !defined(USE_FIXED_POINT_PID)
+	// Fixed-point controllers are kept in `g_pid_bank`
 	pid_t pid;
-	float setpoint;
+	pid_feedforward_t feedforward;
+#else
+	pidq_feedforward_t feedforward;
+#endif
+	// Target speed in RPS (absolute value), Q16.16 fixed-point
+	pidq_value_t setpoint;
+	// Last PID output (duty cycle in %)
+	uint8_t duty_cycle;
+	// Sign of last non-zero setpoint applied to direction pins (+1/-1),
+	// direction of Hall encoder speed (also while motor coasts)
+	int8_t direction;
+	// Generates signed `setpoint` profile towards commanded speed
+	// (See. do_advance_setpoint_ramps())
+	setpoint_ramp_t setpoint_ramp;
+#if !defined(USE_QUADRATURE_ENCODER)
+	// Signed Hall pulse count, sign of every pulse is taken from `direction`
+	// (See. do_update_hall_positions())
+	int32_t position;
+	// `hall_encoder.pulse_count` included in `position`
+	uint16_t position_pulse_count;
+#endif
+#if defined(USE_CURRENT_SENSING)
+	// Mean current over last PID tick [mA] (See. do_update_motor_currents())
+	uint16_t current_ma;
+	// Duty cycle ceiling of current limit loop (upper limit of PI output), Q16.16
+	pidq_value_t duty_cycle_ceiling;
+#endif
 } motor_t;
 
+#if defined(USE_CURRENT_SENSING)
+// ADC samples of one motor since last PID tick (See. ISR(ADC_vect))
+typedef struct {
+	uint16_t sum;
+	uint8_t count;
+} current_scan_t;
+#endif
+
+// Per motor part of telemetry record, speeds are Q8.8 RPS (as seen by PID)
+typedef struct {
+	int16_t setpoint;
+	int16_t rps;
+	int16_t error;
+	uint8_t duty_cycle;
+} telemetry_motor_sample_t;
+
+// Telemetry record captured at PID tick (sent as is, little endian, no padding)
+typedef struct {
+	// TIMER 1 timestamp of PID tick in microseconds (wraps every 65.536ms)
+	uint16_t timestamp_us;
+	telemetry_motor_sample_t motors[BOARD_MOTOR_COUNT];
+} telemetry_record_t;
+
+// Event which starts recording of armed telemetry capture
+typedef enum {
+	TELEMETRY_TRIGGER_IMMEDIATE = 0,		// First PID tick after arming
+	TELEMETRY_TRIGGER_COMMAND_START = 1,	// Command (or first segment) starts from standstill
+	TELEMETRY_TRIGGER_STALL = 2,			// Driven motor stalls
+	TELEMETRY_TRIGGER_ERROR_ABOVE = 3		// |error| of any motor exceeds threshold
+} telemetry_trigger_e;
+
+typedef enum {
+	TELEMETRY_STATE_IDLE = 0,
+	TELEMETRY_STATE_ARMED = 1,				// Waiting for trigger
+	TELEMETRY_STATE_RECORDING = 2,			// Until ring is full
+	TELEMETRY_STATE_DUMPING = 3				// Records are streamed by task_bulk_dump()
+} telemetry_state_e;
+
+typedef struct {
+	uint8_t state;
+	uint8_t trigger;
+	// Every `decimation`-th PID tick is recorded
+	uint8_t decimation;
+	uint8_t decimation_counter;
+	// Threshold of TELEMETRY_TRIGGER_ERROR_ABOVE, Q16.16
+	pidq_value_t error_threshold;
+} telemetry_capture_t;
+
+// Codes of records in persistent event log (See. event_log.h and do_log_event())
+typedef enum {
+	EVENT_CODE_BOOT = 1,			// Detail is reset cause (MCUSR)
+	EVENT_CODE_LINK_ERROR = 2,		// Detail is cause (link_error_e), rate limited
+	EVENT_CODE_MOTOR_STALL = 3,		// Detail is motor index
+	EVENT_CODE_FATAL_ERROR = 4,		// Detail is error code (0 if unknown), controller halts
+	EVENT_CODE_LINK_FALLBACK = 5	// Detail is new speed (usart_speed_e)
+} event_code_e;
+
+// Bits of `state_flags` in event_snapshot_t
+#define EVENT_STATE_COMMAND_RUNNING		(1 << 0)
+#define EVENT_STATE_SYSID_RUNNING		(1 << 1)
+#define EVENT_STATE_RX_SEQUENCE_SYNCED	(1 << 2)
+
+// Speed slots of event_snapshot_t, fixed by persistent record format (EVENT_LOG_SNAPSHOT_SIZE)
+#define EVENT_SNAPSHOT_RPS_SLOTS 3
+
+// Motors whose speed is stored in event_snapshot_t
+#define EVENT_SNAPSHOT_MOTOR_COUNT ((BOARD_MOTOR_COUNT < EVENT_SNAPSHOT_RPS_SLOTS) ? BOARD_MOTOR_COUNT : EVENT_SNAPSHOT_RPS_SLOTS)
+
+// Controller state stored with every event log record (little endian, no padding)
+typedef struct {
+	// Signed speed of motor 1..3, Q8.8 (0 if board has fewer motors)
+	int16_t rps[EVENT_SNAPSHOT_RPS_SLOTS];
+	uint8_t stalled_motors_mask;
+	uint8_t state_flags;
+} event_snapshot_t;
+
+_Static_assert(sizeof(event_snapshot_t) == EVENT_LOG_SNAPSHOT_SIZE, "event_snapshot_t must fill record snapshot");
+
+// State of `EVENT_LOG_DUMP` request (See. do_dump_event_log_frame())
+typedef struct {
+	uint8_t is_dumping;
+	// Next slot to read, counted from oldest
+	uint8_t slot_index;
+} event_log_dump_t;
+
+// Channels of `STREAM_DATA` frame, in order of appearance in payload
+// (See. do_broadcast_stream())
+typedef enum {
+	STREAM_CHANNEL_ODOMETRY = 0,	// Signed speed (and tick count)
+	STREAM_CHANNEL_PID = 1,			// Setpoint, error, duty cycle
+	STREAM_CHANNEL_ENCODER = 2,		// Raw encoder period
+	STREAM_CHANNEL_DIAGNOSTICS = 3,	// PID timing and queue counters
+	STREAM_CHANNEL_CURRENT = 4,		// Mean motor current
+	STREAM_CHANNEL_COUNT = 5
+} stream_channel_e;
+
+// Subscribed `STREAM_DATA` channels (See. on_received_msg_stream_subscribe())
+typedef struct {
+	// Channel is sent every `dividers[c]`-th PID tick, 0 = not subscribed
+	uint8_t dividers[STREAM_CHANNEL_COUNT];
+	uint8_t counters[STREAM_CHANNEL_COUNT];
+	// Bit i selects motor i (ignored by STREAM_CHANNEL_DIAGNOSTICS)
+	uint8_t motor_masks[STREAM_CHANNEL_COUNT];
+	// Incremented with every `STREAM_DATA` frame (host detects dropped frames)
+	uint8_t sequence;
+} stream_state_t;
+
+// Profiler probe IDs (See. PROFILER_MODE)
+typedef enum {
+	PROBE_USART0_RX = 0,			// USART0_RX_vect
+	PROBE_HALL_ENCODER_SAVE = 1,	// hall_encoder_do_save_timer_value() (encoder ISRs)
+	PROBE_UPDATE_RPS = 2,			// do_update_rps()
+	PROBE_ADVANCE_PIDS = 3,			// do_advance_pids()
+	PROBE_PID_CONTROLLERS = 4,		// feedforward and PI controllers of all motors (in do_advance_pids())
+	PROBE_COUNT
+} probe_id_e;
+
+// Encoder edge captured during system identification (sent as is, little endian, no padding)
+typedef struct {
+	uint8_t motor_index;
+	// Duty cycle [%] applied when edge arrived
+	uint8_t duty_cycle;
+	// TIMER 1 ticks since previous rising edge of the same motor
+	uint32_t period_ticks;
+} sysid_sample_t;
+
+typedef enum {
+	SYSID_EXCITATION_STEP = 0,		// Low duty cycle for `bit_period_ticks`, then high
+	SYSID_EXCITATION_PRBS = 1		// Low or high duty cycle by PRBS bit, new bit every `bit_period_ticks`
+} sysid_excitation_e;
+
+typedef enum {
+	SYSID_STATE_IDLE = 0,
+	SYSID_STATE_RUNNING = 1,		// Motors are excited, edges are captured and streamed
+	SYSID_STATE_FLUSHING = 2		// Motors stopped, rest of samples is streamed by task_sysid_stream()
+} sysid_state_e;
+
+typedef struct {
+	// Read by encoder ISRs
+	volatile uint8_t state;
+	uint8_t motor_mask;
+	uint8_t excitation;
+	uint8_t duty_cycle_low;
+	uint8_t duty_cycle_high;
+	// PID ticks per PRBS bit or PID ticks before step
+	uint8_t bit_period_ticks;
+	uint8_t bit_period_counter;
+	// Every `edge_decimation`-th edge of each motor is captured (owned by encoder ISRs)
+	uint8_t edge_decimation;
+	uint8_t edge_decimation_counters[BOARD_MOTOR_COUNT];
+	uint8_t prbs_states[BOARD_MOTOR_COUNT];
+	uint32_t elapsed_pid_ticks;
+	uint32_t duration_pid_ticks;
+	// Samples lost because ring was full (saturated, written by encoder ISRs)
+	volatile uint16_t dropped_samples_count;
+#if defined(SYSID_FIT_MODEL)
+	sysid_fit_t fits[BOARD_MOTOR_COUNT];
+#endif
+} sysid_run_t;
+
+// USART0 link speeds (index of `usart_speed_ubrr`, `SET_BAUD` payload)
 typedef enum {
-	CMD_RCV_IDLE = 0,
-	CMD_RCV_RECEIVING_IN_PROCESS = 1,
-	CMD_RCV_ESCAPE_ACTIVE = 2,
-	CMD_RCV_FULL_FRAME_READ = 3
-} command_receiver_state_e;
+	USART_SPEED_9600 = 0,
+	USART_SPEED_115200 = 1,
+	USART_SPEED_250000 = 2,
+	USART_SPEED_500000 = 3,
+	USART_SPEED_1000000 = 4,
+	USART_SPEED_COUNT = 5
+} usart_speed_e;
+
+typedef struct {
+	// usart_speed_e in use (written by USART0_TX_vect when switching)
+	volatile uint8_t speed;
+	// Restored when `speed` is not confirmed in time
+	uint8_t previous_speed;
+	// Applied by USART0_TX_vect after `SET_BAUD` reply is sent, USART_SPEED_COUNT = none
+	volatile uint8_t pending_speed;
+	// Set by USART0_TX_vect after switch, task_task_timers() then starts
+	// `g_usart_speed_confirm_timer` (speed is reverted unless confirmed)
+	volatile uint8_t is_switch_unconfirmed;
+	// Malformed frames received since last valid frame
+	uint8_t frame_error_streak;
+} usart_speed_state_t;
+
+// Causes of frames which are dropped by receive path
+typedef enum {
+	LINK_ERROR_STX_MISSING = 0,		// Byte received outside of frame
+	LINK_ERROR_ETX_MISSING = 1,		// Frame cut short by next STX or not terminated
+	LINK_ERROR_OVERFLOW = 2,		// Payload does not fit in PAYLOAD_BUFFER_SIZE
+	LINK_ERROR_CHECKSUM = 3,		// CRC-8 mismatch
+	LINK_ERROR_INVALID_LENGTH = 4,	// Length field does not match frame, or payload too short for message
+	LINK_ERROR_UNKNOWN_TYPE = 5,	// msg_type without handler
+	LINK_ERROR_COUNT = 6
+} link_error_e;
+
+// Reply of `TELEMETRY_ARM`, `SYSID_START` and `AUTOTUNE_START`, and of rejected
+// `KINEMATICS_CONFIG` and `BODY_VELOCITY` (See. do_send_start_status())
+typedef enum {
+	START_STATUS_STARTED = 0,			// Request accepted
+	START_STATUS_BUSY = 1,				// Command, identification or auto-tuning is active
+	START_STATUS_INVALID_ARGUMENT = 2,	// Argument out of range, request ignored
+	START_STATUS_NOT_CONFIGURED = 3		// Required configuration was not received, request ignored
+} start_status_e;
+
+typedef enum {
+	PID_GAINS_SOURCE_DEFAULTS = 0,	// PID_KP, PID_TI
+	PID_GAINS_SOURCE_EEPROM = 1,	// Loaded at boot
+	PID_GAINS_SOURCE_RUNTIME = 2	// Set by `PID_GAINS` message or auto-tuning run
+} pid_gains_source_e;
+
+typedef struct {
+	// Read by TIMER3_COMPA_vect
+	volatile uint8_t is_running;
+	uint8_t motor_mask;
+	// AUTOTUNE_FLAG_*
+	uint8_t flags;
+	// relay_autotune_rule_e
+	uint8_t rule;
+	relay_autotune_t tunes[BOARD_MOTOR_COUNT];
+} autotune_run_t;
 
 /*
  *	End Type Definitions
@@ -132,45 +555,7 @@ typedef enum {
  *	Begin Pin Definitions
  */
 
-// Connection table for two VNH2SP30 motor controllers
-// * Pin format: ATMEGA2560 (ARDUINO MEGA)
-
-
-//	+===========+============+============+============+
-//	|     /     |  MOTOR 1   |   MOTOR 2  |   MOTOR 3  |
-//	+===========+============+============+============+
-//	| IN A      | PA1(DIO23) | PA2(DIO24) | PA3(DIO25) |
-//	+-----------+------------+------------+------------+
-//	| IN B      | PC1(DIO36) | PC2(DIO35) | PC3(DIO34) |
-//	+-----------+------------+------------+------------+
-//	| PWM       | PH6(PWM9)  | PG5(PWM4)  | PB4(PWM10) |
-//	+-----------+------------+------------+------------+
-//	| HALL CH A | PE4(PWM2)  | PE5(PWM3)  | PD2(COM19) |
-//	+-----------+------------+------------+------------+
-//	| EXT INT   | INT4       | INT5       | INT2       |
-//	+-----------+------------+------------+------------+
-//	| OC REG    | OC2B       | OC0B       | OC2A       |
-//	+-----------+------------+------------+------------+
-
-#define MOTOR_1_IN_A	PIN_A1
-#define MOTOR_1_IN_B	PIN_C1
-#define MOTOR_1_PWM		PIN_H6
-#define MOTOR_1_HCHA	PIN_E4
-#define MOTOR_1_ENCODER_ISR	INT4_vect
-
-#define MOTOR_2_IN_A	PIN_A2
-#define MOTOR_2_IN_B	PIN_C2
-#define MOTOR_2_PWM		PIN_G5
-#define MOTOR_2_HCHA	PIN_E5
-#define MOTOR_2_ENCODER_ISR	INT5_vect
-
-#define MOTOR_3_IN_A	PIN_A3
-#define MOTOR_3_IN_B	PIN_C3
-#define MOTOR_3_PWM		PIN_B4
-#define MOTOR_3_HCHA	PIN_D2
-#define MOTOR_3_ENCODER_ISR	INT2_vect
-
-#define ONBOARD_LED		PIN_B7
+// Pin map, motor count and encoder ISR vectors: See. board_config.h
 
 /*
  *	End Pin Definitions
@@ -212,6 +597,26 @@ typedef enum {
 #define PID_KP	(float)4.0f
 #define PID_TI	(float)128.8773f
 
+// Upper limit of PI output (duty cycle [%]), lower limit is 0
+#define PID_OUTPUT_MAX	95
+
+// Feedforward from identified first-order motor model u[%] -> y[rps]
+// (See. pid_feedforward_t), PI controllers only correct deviation from model
+// response, so PID_KP/PID_TI need no retuning for feedforward operation.
+// PID_FEEDFORWARD_NONE makes controllers pure feedback.
+#define PID_FEEDFORWARD_MODE	PID_FEEDFORWARD_INVERSE_MODEL
+#define MOTOR_MODEL_A			(float)0.04924f
+#define MOTOR_MODEL_B			(float)0.2617f
+// Duty cycle [%] added for every non-zero setpoint (static friction)
+#define PID_FEEDFORWARD_OFFSET	(float)0.0f
+
+// Anti-windup of PI controllers (See. pid_anti_windup_e)
+#define PID_ANTI_WINDUP_MODE	PID_ANTI_WINDUP_CONDITIONAL
+
+// Duty cycle [%] per RPS that holds constant speed (static gain of motor model),
+// used to seed controllers of motors that are still turning when command starts
+#define MOTOR_MODEL_STATIC_GAIN	((1.0f - MOTOR_MODEL_B) / MOTOR_MODEL_A)
+
 //#define PID_KP	(float)50
 //#define PID_TI	(float)10
 
@@ -219,47 +624,207 @@ typedef enum {
 //#define PID_TI	(float)100000.0f
 
 
-// PID Sampling frequency and period
-#define SAMPLING_FREQUENCY 62.5f
+// PID Sampling period (whole milliseconds of system clock) and frequency.
+// MOTOR_MODEL_A/MOTOR_MODEL_B and gains are identified at this period, a shorter one
+// needs them re-identified (See. SYSID_START) and cycles of PROBE_PID_CONTROLLERS.
+#define PID_TICK_PERIOD_MS 16
+#define SAMPLING_FREQUENCY (1000.0f / PID_TICK_PERIOD_MS)
 #define SAMPLE_TIME_S (1.0f/SAMPLING_FREQUENCY)
 //////////////////////////////////////////////////////////////////////////
 
-// RPS (Revolutions Per Second) measurement filter
-// Implemented as Exponential Moving Average filter
-// with following difference equation
-// x[n] = RPS_ALPHA * x[n-1] + (1 - RPS_ALPHA) * u[n]
-// where x is the filtered value and u is measurement
-#define RPS_ALPHA 0.5f
-
 // IG32E-35K motor Hall encoder number of pulses per rotation
 #define PULSES_PER_ROTATION 245
 
-// Baud rate = 115.2kbps; U2X=0
-//#define BAUD_RATE_UBBR_115_2_KBPS 8
-#define BAUD_RATE_UBBR_9_6_KBPS 103
-#define BAUD_RATE_UBBR_115_2_KBPS BAUD_RATE_UBBR_9_6_KBPS
+// Speed is calculated in period domain with one 32-bit division:
+//		RPS (Q16.16) = RPS_TICKS_CONSTANT / ticks
+// where ticks is number of TIMER 1 ticks (F_CPU) between two encoder pulses
+#define RPS_TICKS_CONSTANT ((uint32_t)(((uint64_t)F_CPU << PIDQ_FRACTION_BITS) / PULSES_PER_ROTATION))
+#if ((F_CPU * 65536ULL) / PULSES_PER_ROTATION) > 0xFFFFFFFFULL
+	#error "RPS_TICKS_CONSTANT does not fit in 32 bits"
+#endif
+
+// USART0 runs in double speed mode (U2X0 = 1): baud = F_CPU / (8 * (UBRR + 1)).
+// Divider grid of U2X0 = 1 contains every U2X0 = 0 divider, so rounded
+// UBRR gives the smallest baud rate error available.
+#define USART_UBRR_U2X(BAUD) ((((F_CPU) + 4UL * (BAUD)) / (8UL * (BAUD))) - 1)
+// Baud rate error of USART_UBRR_U2X(BAUD) in 0.1%
+#define USART_BAUD_ERROR_PERMILLE(BAUD) \
+	((((F_CPU) / (8UL * (USART_UBRR_U2X(BAUD) + 1UL)) > (BAUD)) \
+		? ((F_CPU) / (8UL * (USART_UBRR_U2X(BAUD) + 1UL)) - (BAUD)) \
+		: ((BAUD) - (F_CPU) / (8UL * (USART_UBRR_U2X(BAUD) + 1UL)))) * 1000UL / (BAUD))
+
+// UBRR0 of speeds in usart_speed_e order (16 MHz: 0.2%, 2.1%, 0%, 0%, 0% error)
+PRIVATE const uint16_t usart_speed_ubrr[USART_SPEED_COUNT] PROGMEM = {
+	USART_UBRR_U2X(9600UL),
+	USART_UBRR_U2X(115200UL),
+	USART_UBRR_U2X(250000UL),
+	USART_UBRR_U2X(500000UL),
+	USART_UBRR_U2X(1000000UL)
+};
+
+// Speeds whose baud rate error exceeds this are not offered by `SET_BAUD`
+#define USART_BAUD_MAX_ERROR_PERMILLE 25
+
+// Bit of speed `INDEX` (usart_speed_e) if its error is within limit, 0 otherwise
+#define USART_SPEED_SUPPORTED_BIT(INDEX, BAUD) \
+	((USART_BAUD_ERROR_PERMILLE(BAUD) <= USART_BAUD_MAX_ERROR_PERMILLE) ? (1U << (INDEX)) : 0U)
+
+// Mask of speeds usable with this F_CPU (bit n = usart_speed_e n), same order as `usart_speed_ubrr`
+#define USART_SUPPORTED_SPEED_MASK ((uint8_t)(	\
+	USART_SPEED_SUPPORTED_BIT(0, 9600UL)	|	\
+	USART_SPEED_SUPPORTED_BIT(1, 115200UL)	|	\
+	USART_SPEED_SUPPORTED_BIT(2, 250000UL)	|	\
+	USART_SPEED_SUPPORTED_BIT(3, 500000UL)	|	\
+	USART_SPEED_SUPPORTED_BIT(4, 1000000UL)))
+
+// USART_BOOT_SPEED must always work
+#if USART_BAUD_ERROR_PERMILLE(115200UL) > USART_BAUD_MAX_ERROR_PERMILLE
+	#error "115200 baud (USART_BOOT_SPEED) error exceeds USART_BAUD_MAX_ERROR_PERMILLE with this F_CPU"
+#endif
+
+// Shortest period (in TIMER 1 ticks) for which RPS can be represented in Q16.16
+#define RPS_MIN_PERIOD_TICKS 2
+
+// Time without encoder pulse after which speed is set to zero and
+// encoder is flagged as stalled, in TIMER 1 overflows (65536/F_CPU = 4.096ms)
+// 62 overflows ~ 0.25s (~0.016 RPS)
+#define ENCODER_STALL_TIMEOUT_OVERFLOWS 62
+
+#if defined(USE_QUADRATURE_ENCODER)
+// Every edge of channel A and B is counted
+#define QUADRATURE_TICKS_PER_ROTATION (4 * PULSES_PER_ROTATION)
+// Ticks per PID period at which speed estimate switches from
+// period based to count based (8 ticks at 62.5 Hz ~ 0.5 RPS)
+#define QUADRATURE_HYBRID_THRESHOLD_TICKS 8
+#endif
+
+// `MOVE_DISTANCE` distances are in encoder ticks (See. get_motor_position()):
+// quadrature ticks in quadrature builds, Hall pulses otherwise
+#if defined(USE_QUADRATURE_ENCODER)
+#define POSITION_TICKS_PER_ROTATION QUADRATURE_TICKS_PER_ROTATION
+#else
+#define POSITION_TICKS_PER_ROTATION PULSES_PER_ROTATION
+#endif
+
+// Position loop (See. do_advance_position_loop()) commands speed
+// POSITION_KP * remaining rotations [rps], limited to commanded maximum.
+// Slowest speed keeps motor moving until last tick, below ~0.2 RPS
+// the encoder stall timeout would zero speed feedback.
+#define POSITION_KP 4.0f
+#define POSITION_MIN_RPS 0.25f
+
+#if defined(USE_CURRENT_SENSING)
+// Samples summed per motor between two PID ticks (~20 are taken), further
+// samples are dropped so that sum of 10-bit samples stays in 16 bits
+#define CURRENT_SCAN_MAX_SAMPLES 64
+// Current limit loop (See. do_update_motor_currents()): every PID tick, duty
+// cycle ceiling changes by CURRENT_LIMIT_GAIN [%/mA] * (limit - current)
+#define CURRENT_LIMIT_GAIN 0.002f
+// Lowest duty cycle ceiling [%], must stay above PI output minimum (0)
+#define CURRENT_LIMIT_MIN_DUTY 1
+#endif
+
+#if defined(USE_INPUT_CAPTURE_ENCODER)
+// Capture timers (TIMER 4/5) run with prescaler = 8 (2^3), 0.5us resolution
+#define CAPTURE_TIMER_PRESCALER_SHIFT 3
+#endif
+
+// System clock (TIMER 3, CTC) ticks every millisecond (prescaler = 64)
+#define SYSTEM_CLOCK_PRESCALER 64UL
+#define SYSTEM_CLOCK_COMPARE_VALUE ((uint16_t)(F_CPU / SYSTEM_CLOCK_PRESCALER / 1000UL - 1))
+
+#if (F_CPU % (SYSTEM_CLOCK_PRESCALER * 1000UL)) != 0
+	#error "System clock period is not a whole number of TIMER 3 ticks with this F_CPU"
+#endif
+
+// Time between `ODOMETRY` broadcasts
+#define ODOMETRY_BROADCAST_PERIOD_MS 500
+
+// Monotonic time base shared by PID tick and software timers,
+// incremented every millisecond by TIMER3_COMPA_vect (wraps after ~49.7 days)
+PRIVATE volatile uint32_t g_system_clock_ms = 0;
 
-// Defines maximum "believable" RPS value
-// All RPS values above RPS_UPPER_DISCARD_LIMIT
-// will not be saved as RPS values, instead old
-// value will be held. (Crude low pass filter)
-// (Disturbance rejection)
-#define RPS_UPPER_DISCARD_LIMIT 10.0f
+// Software timers on `g_system_clock_ms`, expired ones are handled by task_task_timers()
+PRIVATE soft_timer_queue_t g_soft_timers;
 
-// Commands last for 3.008 seconds (T_PID = 1/62.5 s)
-//const uint32_t command_duration_pids = 188;
-PRIVATE volatile uint32_t g_target_command_duration__50ms_ticks = 3000/50;
+typedef enum {
+	SOFT_TIMER_COMMAND = 0,				// End of current segment
+	SOFT_TIMER_ODOMETRY = 1,			// `ODOMETRY` broadcast
+	SOFT_TIMER_USART_SPEED_CONFIRM = 2	// Reverts unconfirmed `SET_BAUD` speed
+} soft_timer_id_e;
+
+// Ends current segment, not running while endless segment is executed
+PRIVATE soft_timer_t g_command_timer;
+// Periodic while command is running (unless USE_COMPACT_ODOMETRY)
+PRIVATE soft_timer_t g_odometry_timer;
+PRIVATE soft_timer_t g_usart_speed_confirm_timer;
+
+// System clock at last `ODOMETRY` broadcast (or command start)
+PRIVATE uint32_t g_odometry_last_broadcast_ms = 0;
+
+// PID tick is generated by TIMER3_COMPA_vect every PID_TICK_PERIOD_MS
+// while enabled (See. pause_pid_timer(), resume_pid_timer())
+PRIVATE volatile uint8_t g_flag_pid_tick_enabled = 0;
+PRIVATE volatile uint32_t g_pid_tick_deadline_ms = 0;
+
+// Timed setpoint segment. Segments queued with `SEGMENTS` message are
+// executed back-to-back without stopping motors or clearing PID state.
+typedef struct {
+	float rps[BOARD_MOTOR_COUNT];
+	// Exact duration in milliseconds, UINT32_MAX = segment never ends
+	uint32_t duration_ms;
+} motion_segment_t;
+
+// Size of segment as found in `COMMAND` and `SEGMENTS` payloads:
+// float setpoint [rps] of every motor + uint32_t duration [ms]
+#define MOTION_SEGMENT_PAYLOAD_SIZE (BOARD_MOTOR_COUNT * sizeof(float) + sizeof(uint32_t))
+
+// Number of segments which can wait behind currently executed one (power of two)
+#define SEGMENT_QUEUE_SIZE 8
 
-// Incremented in task timer ISR. Represents duration of command
-// in units of 50ms ticks.
-PRIVATE volatile uint32_t g_command_duration_counter__50ms_ticks;
+// Defines `segment_queue_t` and `segment_queue_*()` functions.
+// Both ends are used from main loop only.
+SPSC_RING_DEFINE(segment_queue, motion_segment_t, SEGMENT_QUEUE_SIZE)
+
+PRIVATE segment_queue_t g_segment_queue;
+
+// Size of `MOVE_DISTANCE` payload:
+// int32_t distance [ticks] of every motor + float maximum speed [rps] + uint32_t timeout [ms]
+#define MOVE_DISTANCE_PAYLOAD_SIZE (BOARD_MOTOR_COUNT * sizeof(int32_t) + sizeof(float) + sizeof(uint32_t))
+
+// Position closed-loop command (`MOVE_DISTANCE`), outer loop of speed PI
+typedef struct {
+	uint8_t is_active;
+	// Mask of motors which reached their target, they are held stopped
+	uint8_t reached_mask;
+	// Sign of distance of every motor (target is passed when remaining distance changes sign)
+	int8_t directions[BOARD_MOTOR_COUNT];
+	// Absolute target positions (See. get_motor_position())
+	int32_t targets[BOARD_MOTOR_COUNT];
+	// Speed limit of position loop, RPS (absolute value)
+	float max_rps;
+} position_command_t;
+
+PRIVATE position_command_t g_position;
+
+// Size of `BODY_VELOCITY` payload:
+// int16_t vx [mm/s], vy [mm/s], omega [mrad/s] + uint32_t duration [ms]
+#define BODY_VELOCITY_PAYLOAD_SIZE (3 * sizeof(int16_t) + sizeof(uint32_t))
+
+// Matrix of `KINEMATICS_CONFIG` payload (bit of `g_kinematics_matrix_mask`)
+typedef enum {
+	KINEMATICS_MATRIX_INVERSE = 0,	// Wheel RPS from body velocity (`BODY_VELOCITY`)
+	KINEMATICS_MATRIX_FORWARD = 1	// Body velocity from wheel RPS (`POSE`)
+} kinematics_matrix_e;
 
-// Incremented in task timer ISR. Represents time since last
-// odometry broadcast in units of 50ms ticks.
-PRIVATE volatile uint32_t g_odometry_time_since_last_broadcast__50ms_ticks;
+// Size of `KINEMATICS_CONFIG` payload: matrix id + 3x3 Q16.16 matrix
+#define KINEMATICS_CONFIG_PAYLOAD_SIZE (1 + 9 * sizeof(pidq_value_t))
 
-// Time between odometry broadcasts
-PRIVATE const uint32_t odometry_broadcast_period__50ms_ticks = 500/50;
+// Body kinematics of three wheel base, pose is integrated every PID tick
+// of a command once forward matrix is configured (See. do_advance_pose())
+PRIVATE kinematics_t g_kinematics;
+// Matrices received with `KINEMATICS_CONFIG` (bit n = kinematics_matrix_e n)
+PRIVATE uint8_t g_kinematics_matrix_mask = 0;
 
 // Setpoint RPS (Revolutions Per Second) when motor is on
 // PRIVATE const float motor_on_rps = 0.5f;
@@ -273,63 +838,276 @@ PRIVATE const uint32_t odometry_broadcast_period__50ms_ticks = 500/50;
  *	Start Global Variables
  */
 
-// Updated by TIMER 1 overflow ISR to increment.
-// Used to extend 16-bit TIMER 1 to 32 bits.
-// Acts as higher nibble for 16-bit TIMER 1.
-PRIVATE volatile uint16_t pulse_tick_counter_high_nibble = 0;
+#if defined(USE_INPUT_CAPTURE_ENCODER)
+// Updated by TIMER 4/5 overflow ISRs. Extend capture timers to 32 bits.
+PRIVATE volatile uint16_t capture_timer_4_high_nibble = 0;
+PRIVATE volatile uint16_t capture_timer_5_high_nibble = 0;
+#endif
 
 // Motors
-PRIVATE motor_t g_motor_1;
-PRIVATE motor_t g_motor_2;
-PRIVATE motor_t g_motor_3;
+#define MOTOR_COUNT BOARD_MOTOR_COUNT
+#define DEFINE_MOTOR(N)		PRIVATE motor_t g_motor_##N;
+BOARD_FOR_EACH_MOTOR(DEFINE_MOTOR)
+
+// Per-motor statements, expanded with BOARD_FOR_EACH_MOTOR
+#define RESET_MOTOR_AVERAGE_RPS(N)	mean_accumulator_reset(&g_motor_##N.hall_encoder.average_rps);
+
+#if defined(USE_QUADRATURE_ENCODER)
+// Current channel A/B state of motor `N`
+#define MOTOR_QUADRATURE_STATE(N)	QENC_STATE(READ_PIN(MOTOR_##N##_HCHA), READ_PIN(MOTOR_##N##_HCHB))
+#endif
+
+// Motors by index (index 0 = Motor 1). Hot paths use `g_motor_N`
+// expanded with BOARD_FOR_EACH_MOTOR, loops over this table are for
+// code that is not time critical.
+#define MOTOR_ADDRESS(N)	&g_motor_##N,
+PRIVATE motor_t* const g_motors[MOTOR_COUNT] = { BOARD_FOR_EACH_MOTOR(MOTOR_ADDRESS) };
+
+#if defined(USE_FIXED_POINT_PID)
+// PI controllers of all motors (controller index = motor index in `g_motors`)
+PRIVATE pid_bank_t g_pid_bank;
+#endif
 
-// Signal to main loop that PID algorithm is
-// ready to be executed.
-PRIVATE volatile uint8_t g_flag_pid = 0;
+#if defined(USE_CURRENT_SENSING)
+// ADC channel of current sense output of every motor
+#define MOTOR_CS_ADC_CHANNEL(N)	MOTOR_##N##_CS_ADC,
+PRIVATE const uint8_t g_current_adc_channels[MOTOR_COUNT] = { BOARD_FOR_EACH_MOTOR(MOTOR_CS_ADC_CHANNEL) };
+// DIDR0 bits of current sense inputs
+#define MOTOR_CS_ADC_BIT(N)		(1 << MOTOR_##N##_CS_ADC) |
+#define CURRENT_ADC_CHANNEL_MASK ((uint8_t)(BOARD_FOR_EACH_MOTOR(MOTOR_CS_ADC_BIT) 0))
+
+// Filled by ADC ISR, taken by do_update_motor_currents() every PID tick
+PRIVATE volatile current_scan_t g_current_scans[MOTOR_COUNT];
+// Motor of conversion in progress and motor of channel selected in ADMUX
+// (differ in free running mode, See. MOTOR_CURRENT_FREE_RUNNING)
+PRIVATE uint8_t g_current_scan_converting = 0;
+PRIVATE uint8_t g_current_scan_selected = 0;
+// Current limit of every motor [mA], 0 = no limit (See. `CURRENT_LIMIT` message)
+PRIVATE uint16_t g_current_limit_ma = CURRENT_LIMIT_MA;
+#endif
 
-// Flag that indicates that there is a command in command buffer,
-// and that main loop should parse it.
-PRIVATE volatile uint8_t g_flag_frame_awaits_decoding = 0;
+// Main loop tasks, task id is priority (0 is highest).
+// Encoder and PID tasks run before communication and telemetry.
+typedef enum {
+	TASK_UPDATE_ENCODERS = 0,		// Posted by encoder ISRs
+	TASK_ADVANCE_PIDS = 1,			// Posted by TIMER3_COMPA_vect (PID tick)
+	TASK_CHECK_ENCODER_TIMEOUTS = 2,// Posted by on_pulse_tick_timer_overflow()
+	TASK_EXECUTE_COMMAND = 3,		// Posted when command frame is decoded
+	TASK_RECEIVE = 4,				// Posted by USART0_RX_vect
+	TASK_TASK_TIMERS = 5,			// Posted by TIMER3_COMPA_vect (software timer expired)
+	TASK_BULK_DUMP = 6,				// Posted by `TELEMETRY_DUMP` and `EVENT_LOG_DUMP` requests, reposts itself
+	TASK_SYSID_STREAM = 7			// Posted by encoder ISRs during identification, reposts itself
+} task_id_e;
+
+PRIVATE scheduler_t g_scheduler;
+
+// TIMER 1 timestamp of last PID tick (set in TIMER3_COMPA_vect)
+PRIVATE volatile uint32_t g_pid_tick_timestamp = 0;
+
+// Longest delay between PID tick interrupt and start of PID task during
+// current command (wake-up from sleep + running higher priority tasks),
+// in TIMER 1 ticks. Reported in `FINISHED` message.
+PRIVATE uint32_t g_pid_wake_latency_max_ticks = 0;
+
+// PID tick period in TIMER 1 ticks
+#define PID_TICK_PERIOD_PULSE_TICKS ((uint32_t)(F_CPU / SAMPLING_FREQUENCY))
+
+// PID loop timing statistics (See. DIAGNOSTICS message), times in TIMER 1 ticks.
+// Collected since start or since last reset by DIAGNOSTICS request.
+typedef struct {
+	// PID executions
+	uint32_t executed_count;
+	// PID executions which finished after next PID tick was due
+	uint16_t overrun_count;
+	// Measured time between consecutive PID executions (ticks of the same command)
+	uint32_t dt_min_ticks;
+	uint32_t dt_max_ticks;
+	// Longest PID execution (do_advance_pids() with telemetry)
+	uint32_t execution_max_ticks;
+	// TIMER 1 timestamp of tick of previous PID execution, valid if `has_previous_tick`
+	uint32_t previous_tick_timestamp;
+	uint8_t has_previous_tick;
+} pid_timing_stats_t;
+
+PRIVATE pid_timing_stats_t g_pid_timing;
+
+// PID ticks merged with the next one because PID task was still waiting
+// to run (incremented in TIMER3_COMPA_vect)
+PRIVATE volatile uint16_t g_pid_missed_ticks_count = 0;
 
 // Flag that indicates command (in form of a stxetx_frame_t g_received_frame)
 // is ready to be processed
 PRIVATE volatile uint8_t g_flag_command_in_queue = 0;
 
-// Size of receiving frame buffer used to serialize and send frame, in bytes
-#define FRAME_ENCODE_BUFFER_SIZE 32
-// Size of receiving frame buffer used to deserialize frame from receive buffer, in bytes
-#define FRAME_DECODE_BUFFER_SIZE 32
-// See STXETX stxetx_decode_n function description
+// Size of buffer which holds un-escaped payload of received frame, in bytes
+// See STXETX stxetx_decoder_init function description
 #define PAYLOAD_BUFFER_SIZE 64
 
 // Received and decoded STXETX frame.
 PRIVATE volatile stxetx_frame_t g_received_frame;
 
-// Frame buffer that holds *one full* received raw frame from UART.
-PRIVATE volatile uint8_t g_frame_decode_buffer[FRAME_DECODE_BUFFER_SIZE] = {0};
-
-// Number of bytes written to g_frame_decode_buffer
-PRIVATE volatile uint8_t g_frame_decode_buffer_length = 0;
+// Payload of frame which is being received (g_received_frame.p_payload points here).
+PRIVATE uint8_t g_received_payload_buffer[PAYLOAD_BUFFER_SIZE] = {0};
 
-// Frame buffer that holds encoded frame to be sent over UART.
-										  
-PRIVATE volatile uint8_t g_frame_encode_buffer[FRAME_DECODE_BUFFER_SIZE] = {0};
-
-// Number of bytes written in g_frame_encode_buffer
-PRIVATE volatile uint8_t g_frame_encode_buffer_length = 0;
+// Incremental decoder which un-escapes received bytes as they arrive.
+PRIVATE stxetx_decoder_t g_frame_decoder;
 
 // Flag that indicated that current command is being executed.
 PRIVATE volatile uint8_t g_flag_command_running = 0;
 
-PRIVATE volatile command_receiver_state_e g_frame_receiver_state = CMD_RCV_IDLE;
+// Size of UART receive queue in bytes (power of two, at most 128).
+// Filled by USART0_RX_vect ISR, drained by task_receive().
+#define RECEIVE_BUFFER_SIZE 128
+
+// Defines `usart_rx_ring_t` and `usart_rx_ring_*()` functions
+SPSC_RING_DEFINE(usart_rx_ring, uint8_t, RECEIVE_BUFFER_SIZE)
+
+PRIVATE usart_rx_ring_t g_receive_buffer;
+
+// Number of received bytes discarded because receive queue was full
+PRIVATE volatile uint16_t g_receive_dropped_bytes_count = 0;
+
+// USART0 baud rate negotiation and fallback
+PRIVATE usart_speed_state_t g_usart_speed;
+
+// Dropped received frames per link_error_e cause (saturated)
+PRIVATE uint16_t g_link_error_counts[LINK_ERROR_COUNT] = {0};
+// System clock at last `LINK_ERROR` report
+PRIVATE uint32_t g_link_error_last_report_ms = 0;
+PRIVATE uint8_t g_flag_link_error_reported = 0;
+
+// Sequence number of next FLAG_SHOULD_ACK frame. Until first such frame
+// (or one with FLAG_SEQUENCE_RESET) is accepted any number is accepted.
+PRIVATE uint8_t g_rx_expected_sequence = 0;
+PRIVATE uint8_t g_flag_rx_sequence_synced = 0;
+
+#if defined(USE_BUS_ADDRESSING)
+// Drops frames of other nodes in USART0_RX_vect (before receive queue)
+PRIVATE stxetx_address_filter_t g_receive_address_filter;
+#endif
+
+// Set while broadcast frame is executed, frames are not transmitted
+// (all nodes would answer at once)
+PRIVATE uint8_t g_flag_transmit_muted = 0;
+
+// `COMMAND` received with FLAG_SYNC, started by next `SYNC_APPLY`
+PRIVATE motion_segment_t g_staged_segment;
+PRIVATE uint8_t g_flag_segment_staged = 0;
+
+// Size of UART transmit queue in bytes (power of two). Drained by USART0_UDRE_vect ISR.
+#define TRANSMIT_BUFFER_SIZE 128
+
+// Space taken by address of transmitted frame if it is escaped
+#if defined(USE_BUS_ADDRESSING)
+#define FRAME_ADDRESS_MAX_ENCODED_SIZE 2
+#else
+#define FRAME_ADDRESS_MAX_ENCODED_SIZE 0
+#endif
+
+// Storage of `g_transmit_buffer`, only accessed through it (CBuf orders data and index accesses)
+PRIVATE uint8_t g_transmit_buffer_internal_[TRANSMIT_BUFFER_SIZE] = {0};
+PRIVATE circular_buffer_t g_transmit_buffer;
+
+// Number of frames (or raw `usart_send` blocks) which were discarded
+// because there was not enough free space in transmit queue.
+PRIVATE volatile uint16_t g_transmit_dropped_frames_count = 0;
+
+// TIMER 1 overflow count at last encoder timeout check
+PRIVATE uint16_t g_encoder_timeout_last_check_overflow_count = 0;
+
+// Bit i is set if motor i stalled while driven during current command.
+// Reported in `FINISHED` message.
+PRIVATE uint8_t g_stalled_motors_mask = 0;
 
-#define RECEIVE_BUFFER_SIZE 64
-																	 
-												  
-													   
+// Defines `telemetry_ring_t` and `telemetry_ring_*()` functions.
+// Filled by task_advance_pids(), drained by task_bulk_dump().
+SPSC_RING_DEFINE(telemetry_ring, telemetry_record_t, TELEMETRY_RECORD_COUNT)
 
-PRIVATE volatile uint8_t g_receive_buffer_internal_[RECEIVE_BUFFER_SIZE] = {0};
-PRIVATE volatile circular_buffer_t g_receive_buffer;
+PRIVATE telemetry_ring_t g_telemetry_ring;
+PRIVATE telemetry_capture_t g_telemetry;
+
+// Subscribed `STREAM_DATA` channels, sent by task_advance_pids()
+PRIVATE stream_state_t g_stream;
+
+// Records sent in one `TELEMETRY_DATA` frame
+#define TELEMETRY_RECORDS_PER_FRAME 2
+
+// Space needed in transmit queue for `TELEMETRY_DATA` frame if every byte is escaped
+// (STX, [ADDRESS], TYPE, FLAGS, LEN, payload, CRC, ETX)
+#define TELEMETRY_FRAME_MAX_ENCODED_SIZE \
+	(2 * (3 + 1 + TELEMETRY_RECORDS_PER_FRAME * sizeof(telemetry_record_t) + 1) + 2 + FRAME_ADDRESS_MAX_ENCODED_SIZE)
+
+PRIVATE event_log_dump_t g_event_log_dump;
+
+// Records sent in one `EVENT_LOG_DATA` frame
+#define EVENT_LOG_RECORDS_PER_FRAME 2
+
+// Slots read from EEPROM in one call of do_dump_event_log_frame(),
+// erased slots would otherwise hold the main loop while whole ring is read
+#define EVENT_LOG_SLOTS_PER_DUMP_CALL 16
+
+// Space needed in transmit queue for `EVENT_LOG_DATA` frame
+// if every byte is escaped (See. TELEMETRY_FRAME_MAX_ENCODED_SIZE)
+#define EVENT_LOG_FRAME_MAX_ENCODED_SIZE \
+	(2 * (3 + 1 + EVENT_LOG_RECORDS_PER_FRAME * sizeof(event_log_record_t) + 1) + 2 + FRAME_ADDRESS_MAX_ENCODED_SIZE)
+
+// Defines `sysid_ring_t` and `sysid_ring_*()` functions.
+// Filled by encoder ISRs, drained by task_sysid_stream().
+SPSC_RING_DEFINE(sysid_ring, sysid_sample_t, SYSID_SAMPLE_COUNT)
+
+PRIVATE sysid_ring_t g_sysid_ring;
+PRIVATE sysid_run_t g_sysid;
+
+// Samples sent in one `SYSID_DATA` frame
+#define SYSID_SAMPLES_PER_FRAME 4
+
+// Space needed in transmit queue for `SYSID_DATA` and `SYSID_RESULT` frames
+// if every byte is escaped (See. TELEMETRY_FRAME_MAX_ENCODED_SIZE)
+#define SYSID_DATA_FRAME_MAX_ENCODED_SIZE \
+	(2 * (3 + 3 + SYSID_SAMPLES_PER_FRAME * sizeof(sysid_sample_t) + 1) + 2 + FRAME_ADDRESS_MAX_ENCODED_SIZE)
+#define SYSID_RESULT_FRAME_MAX_ENCODED_SIZE \
+	(2 * (3 + 1 + MOTOR_COUNT * 2 * sizeof(float) + 1) + 2 + FRAME_ADDRESS_MAX_ENCODED_SIZE)
+
+// PRBS seed of motor `I` (any distinct non-zero 7-bit values, See. sysid_prbs_next())
+#define SYSID_PRBS_SEED(I) ((uint8_t)(0x01 + 0x2A * (I)))
+
+// Gains currently used by motor PI controllers
+PRIVATE pid_gains_t g_pid_gains[MOTOR_COUNT];
+PRIVATE uint8_t g_pid_gains_source = PID_GAINS_SOURCE_DEFAULTS;
+
+// `PID_GAINS` flags
+#define PID_GAINS_FLAG_SAVE (1 << 0)
+
+// `PID_GAINS` and `AUTOTUNE_RESULT` reply EEPROM status bits
+#define PID_GAINS_EEPROM_SAVE_PENDING (1 << 0)
+#define PID_GAINS_EEPROM_SAVE_REJECTED (1 << 1)
+
+PRIVATE autotune_run_t g_autotune;
+
+// `AUTOTUNE_START` flags
+#define AUTOTUNE_FLAG_APPLY (1 << 0)
+#define AUTOTUNE_FLAG_SAVE (1 << 1)
+
+#define AUTOTUNE_TIMEOUT_PID_TICKS ((uint16_t)(AUTOTUNE_TIMEOUT_MS * (SAMPLING_FREQUENCY / 1000.0f)))
+
+#if defined(USE_COMPACT_ODOMETRY)
+// Incremented with every `ODOMETRY_COMPACT` frame (host detects dropped frames)
+PRIVATE uint8_t g_odometry_compact_sequence = 0;
+
+// PID ticks since last `ODOMETRY_COMPACT` frame
+PRIVATE uint8_t g_odometry_compact_decimation_counter = 0;
+#endif
+
+// Frame which is currently being encoded in place into transmit queue
+// (see usart_frame_begin()). Only one frame can be encoded at a time.
+typedef struct {
+	// Number of bytes reserved past the end of transmit queue
+	size_t n_reserved;
+	// Free space in transmit queue when the frame was started
+	size_t n_available;
+} usart_tx_reservation_t;
+
+PRIVATE usart_tx_reservation_t g_transmit_reservation;
 
 
 /*
@@ -355,35 +1133,149 @@ PRIVATE void do_handle_fatal_error_with_error_code(uint8_t error_code);
 PRIVATE USE_IF_LITTLE_ENDIAN void _usart_send_little_endian(unsigned char* pData, int length);
 PRIVATE USE_IF_BIG_ENDIAN	 void _usart_send_big_endian(unsigned char* pData, int length);
 PRIVATE void usart_send_frame(stxetx_frame_t frame);
+PRIVATE uint8_t* usart_tx_queue_reserve_span(void* p_context, uint8_t n, uint8_t* p_n_reserved);
+PRIVATE uint8_t usart_frame_begin(stxetx_encoder_t* h_encoder, uint8_t msg_type, uint8_t flags);
+PRIVATE uint8_t usart_frame_end(stxetx_encoder_t* h_encoder);
+PRIVATE uint8_t usart_frame_finish(stxetx_encoder_t* h_encoder);
+PRIVATE void usart_frame_commit(void);
+PRIVATE uint8_t usart_tx_queue_write(const uint8_t* pData, size_t length);
+PRIVATE size_t usart_tx_queue_get_free_space(void);
+PRIVATE uint16_t usart_tx_queue_get_dropped_frames_count(void);
 PRIVATE inline void hall_encoder_do_save_timer_value(hall_encoder_t* hEncoder);
+#if defined(USE_INPUT_CAPTURE_ENCODER)
+PRIVATE inline void hall_encoder_do_save_capture_value(hall_encoder_t* hEncoder, uint16_t capture_value, uint16_t high_nibble, uint8_t is_overflow_pending);
+PRIVATE void enable_capture_encoder(void);
+#endif
 PRIVATE void setup_gpio_pins(void);
-PRIVATE void configure_motors_for_action(float motor_1_rps, float motor_2_rps, float motor_3_rps);
-PRIVATE void configure_motor_pwm_timer(void);
-PRIVATE inline uint8_t calculate_oc_value_from_dc(uint32_t duty_cycle);
+PRIVATE void configure_motors_for_action(const float rps[MOTOR_COUNT]);
+PRIVATE void apply_motor_setpoints(const pidq_value_t rps[MOTOR_COUNT]);
+PRIVATE void do_write_motor_duty_cycles(void);
+PRIVATE void configure_setpoint_ramps(float acceleration_rps_per_s, float jerk_rps_per_s2);
+PRIVATE void do_advance_setpoint_ramps(void);
+PRIVATE void stop_motors(void);
 PRIVATE void enable_encoder_interrupt(void);
-PRIVATE void configure_pulse_tick_timer(void) ;
-PRIVATE void enable_pulse_tick_timer(void);
+#if defined(USE_QUADRATURE_ENCODER)
+PRIVATE inline void motor_do_on_quadrature_edge(motor_t* hMotor, uint8_t state, uint8_t is_channel_a_edge);
+PRIVATE void do_update_quadrature_estimates(void);
+#endif
+PRIVATE pidq_value_t get_motor_feedback_rps(motor_t* hMotor);
+PRIVATE pidq_value_t get_motor_signed_rps(motor_t* hMotor);
+#if !defined(USE_QUADRATURE_ENCODER)
+PRIVATE void do_update_hall_positions(void);
+#endif
+PRIVATE int32_t get_motor_position(motor_t* hMotor);
+PRIVATE void on_pulse_tick_timer_overflow(void);
+PRIVATE void hall_encoder_configure_filters(hall_encoder_t* hEncoder, uint8_t median_taps, uint8_t average_window_shift);
+PRIVATE void hall_encoder_reset_filters(hall_encoder_t* hEncoder);
 PRIVATE void do_update_rps(hall_encoder_t* hEncoder);
-PRIVATE void setup_task_timer(void);
-PRIVATE void enable_task_timer(void);
-PRIVATE void setup_pid_timer(void);
-PRIVATE void enable_pid_timer(void);
+PRIVATE void do_check_encoder_timeout(hall_encoder_t* hEncoder, uint16_t overflow_count);
+PRIVATE void do_check_encoder_timeouts(void);
+PRIVATE void setup_system_clock(void);
+PRIVATE void enable_system_clock(void);
+PRIVATE uint32_t system_clock_get_ms(void);
+PRIVATE void setup_soft_timers(void);
 PRIVATE void pause_pid_timer(void);
 PRIVATE void resume_pid_timer(void);
 PRIVATE void setup_usart_receive(void);
+PRIVATE void usart_write_speed_registers(uint8_t speed);
+PRIVATE void do_set_usart_speed(uint8_t speed);
+PRIVATE void do_on_usart_frame_error(void);
+PRIVATE void do_on_link_error(uint8_t cause);
+PRIVATE void do_log_event(uint8_t code, uint8_t detail);
+PRIVATE uint8_t convert_stxetx_error_to_link_error(uint8_t error);
+PRIVATE void setup_usart_transmit(void);
 PRIVATE void setup_PID(void);
+PRIVATE void clear_PID(void);
+PRIVATE void do_seed_motor_pids(void);
+#if !defined(USE_FIXED_POINT_PID)
+PRIVATE void setup_motor_pid(pid_t* hPID);
+PRIVATE pidq_value_t do_advance_motor_pid(motor_t* hMotor);
+#endif
 PRIVATE void do_advance_pids(void);
+#if defined(USE_CURRENT_SENSING)
+PRIVATE void setup_current_sensing(void);
+PRIVATE void do_update_motor_currents(void);
+PRIVATE void reset_current_limits(void);
+PRIVATE void set_motor_duty_cycle_ceiling(uint8_t index, pidq_value_t ceiling);
+PRIVATE void on_received_msg_current_limit(void);
+#endif
+PRIVATE void parse_motion_segment(const uint8_t* p_payload, motion_segment_t* p_segment);
+PRIVATE uint32_t limit_duration_ms(uint32_t duration_ms);
+PRIVATE void do_command_motion_segment(const motion_segment_t* p_segment);
+PRIVATE void do_start_motion_segment(const motion_segment_t* p_segment);
+PRIVATE void do_advance_position_loop(void);
+PRIVATE void do_on_position_reached(void);
+PRIVATE void on_received_msg_move_distance(void);
+PRIVATE void on_received_msg_kinematics_config(void);
+PRIVATE void on_received_msg_body_velocity(void);
+PRIVATE void on_received_msg_pose(void);
+PRIVATE void do_advance_pose(void);
+PRIVATE void do_send_pose(void);
+PRIVATE void do_continue_motion_segment(const motion_segment_t* p_segment);
+PRIVATE void do_start_command_timer(uint32_t start_ms, uint32_t duration_ms);
+PRIVATE void do_on_command_timer_expired(void);
+PRIVATE void do_send_segments_ack(uint8_t n_accepted);
 PRIVATE void on_received_msg_command(void);
+PRIVATE void on_received_msg_segments(void);
 PRIVATE void on_received_msg_stop(void);
+PRIVATE void on_received_msg_set_ramp(void);
+PRIVATE void do_send_start_status(uint8_t msg_type, uint8_t status);
+PRIVATE void on_received_msg_telemetry_arm(void);
+PRIVATE void on_received_msg_telemetry_dump(void);
+PRIVATE void on_received_msg_event_log_dump(void);
+PRIVATE void on_received_msg_stream_subscribe(void);
+PRIVATE void on_received_msg_profiler_query(void);
 PRIVATE void on_received_msg_unknown(void);
 PRIVATE void do_execute_command(void);
 PRIVATE void do_broadcast_average_rps(void);
+PRIVATE int16_t convert_q16_16_to_q8_8(pidq_value_t value);
+PRIVATE int16_t convert_q16_16_to_milli(pidq_value_t value);
+#if defined(USE_COMPACT_ODOMETRY)
+PRIVATE void do_broadcast_compact_odometry(uint32_t tick_timestamp);
+#endif
+PRIVATE void do_broadcast_stream(uint32_t tick_timestamp);
+PRIVATE void do_on_telemetry_event(telemetry_trigger_e event);
+PRIVATE void do_record_telemetry(uint32_t tick_timestamp);
 PRIVATE void do_on_command_complete(void);
-PRIVATE inline void command_buffer_write_byte(uint8_t data_byte);
-PRIVATE inline void clear_command_buffer();
 PRIVATE void do_on_command_byte_received(uint8_t byte_received);
-PRIVATE void do_parse_received_frame(void);
+PRIVATE uint8_t do_accept_sequenced_frame(stxetx_frame_t* p_frame);
+PRIVATE void do_send_frame_ack(uint8_t sequence);
+PRIVATE void do_send_frame_nak(uint8_t error);
 PRIVATE void setup_motors(void);
+PRIVATE void setup_scheduler(void);
+PRIVATE void task_update_encoders(void);
+PRIVATE void task_advance_pids(void);
+PRIVATE void task_check_encoder_timeouts(void);
+PRIVATE void task_execute_command(void);
+PRIVATE void task_receive(void);
+PRIVATE void task_task_timers(void);
+PRIVATE void task_bulk_dump(void);
+PRIVATE void do_dump_telemetry_frame(void);
+PRIVATE void do_dump_event_log_frame(void);
+PRIVATE void reset_pid_timing_stats(void);
+PRIVATE void do_update_pid_timing(uint32_t tick_timestamp);
+#if defined(USE_MEASURED_PID_TIMESTEP)
+PRIVATE void do_set_pid_timestep(uint32_t dt_ticks);
+#endif
+PRIVATE uint16_t convert_pulse_ticks_to_us_u16(uint32_t ticks);
+PRIVATE void on_received_msg_diagnostics(void);
+PRIVATE inline void do_capture_sysid_edge(hall_encoder_t* hEncoder);
+PRIVATE void on_received_msg_sysid_start(void);
+PRIVATE void do_advance_sysid(void);
+PRIVATE void do_finish_sysid(void);
+#if defined(SYSID_FIT_MODEL)
+PRIVATE void do_send_sysid_result(void);
+#endif
+PRIVATE void task_sysid_stream(void);
+PRIVATE uint8_t is_valid_pid_gains(float Kp, float Ti);
+PRIVATE void set_motor_pid_gains(uint8_t index, float Kp, float Ti);
+PRIVATE void do_send_pid_gains(uint8_t eeprom_status);
+PRIVATE void on_received_msg_pid_gains(void);
+PRIVATE void on_received_msg_autotune_start(void);
+PRIVATE void on_received_msg_sync_apply(void);
+PRIVATE void on_received_msg_set_baud(void);
+PRIVATE void do_advance_autotune(void);
+PRIVATE void do_finish_autotune(void);
 
 
 /*
@@ -424,6 +1316,9 @@ void do_blink_debug_led_times(int times)
 
 void do_handle_fatal_error(void)
 {
+	do_log_event(EVENT_CODE_FATAL_ERROR, 0);
+	EventLog_Flush();
+	
 	// Signal fatal error with debug LED blinking
 	while(1)
 	{
@@ -437,6 +1332,10 @@ void do_handle_fatal_error_with_error_code(uint8_t error_code)
 	const int flutter_half_period_ms = 50;
 	const int flutter_duration_ms = 2000;
 	const int error_code_flutter_delay_ms = 1000;
+	
+	do_log_event(EVENT_CODE_FATAL_ERROR, error_code);
+	EventLog_Flush();
+	
 	// Signal fatal error with debug LED blinking
 	while(1)
 	{
@@ -455,339 +1354,597 @@ void do_handle_fatal_error_with_error_code(uint8_t error_code)
 }
 										  
 // Assumes little-endianness
+// Data is queued to transmit queue, it does not block.
 void _usart_send_little_endian(unsigned char* pData, int length)
 {
-	
-	// Send Data
-	int i;
-	for (i = 0; i < length; ++i)
-	{
-		while (!IS_BIT_SET(UCSR0A, UDRE0))
-		{
-			;
-		}
-		UDR0 = pData[i];
-	}
+	usart_tx_queue_write(pData, (size_t)length);
 }
 
 // Assumes big-endianness
+// Data is queued to transmit queue, it does not block.
 void _usart_send_big_endian(unsigned char* pData, int length)
 {
+	uint8_t reversed[length];
 	
-	// Send Data
 	int i;
-	for (i = length-1; i >= 0; --i)
+	for (i = 0; i < length; ++i)
 	{
-		while (!IS_BIT_SET(UCSR0A, UDRE0))
-		{
-			;
-		}
-		UDR0 = pData[i];
+		reversed[i] = pData[length - 1 - i];
 	}
+	
+	usart_tx_queue_write(reversed, (size_t)length);
 }
 
-
-void usart_send_frame(stxetx_frame_t frame)
+// Copies `length` bytes to the transmit queue and starts USART0_UDRE_vect ISR
+// which drains the queue in background. Data is written all-or-nothing, if
+// there is not enough room in the queue it is discarded and
+// `g_transmit_dropped_frames_count` is incremented.
+// Returns circular_buffer_error_e
+uint8_t usart_tx_queue_write(const uint8_t* pData, size_t length)
 {
-	memset(g_frame_encode_buffer, 0, FRAME_ENCODE_BUFFER_SIZE);
-
-	uint8_t frame_size = 0;
-
-	uint8_t ec = stxetx_encode_n(
-		g_frame_encode_buffer,
-		frame,
-		frame_size,
-		&frame_size
-	);
+	// Main loop is the only producer (moves `head`), USART0_UDRE_vect only
+	// moves `tail`, so the SPSC queue needs no atomic section
+	const uint8_t error = CBuf_WriteN(&g_transmit_buffer, pData, length);
 	
-	if (ec != STXETX_ERROR_NO_ERROR)				
+	if (error != CBUF_ERROR_NO_ERROR)
 	{
-		do_handle_fatal_error_with_error_code(ec);
+		++g_transmit_dropped_frames_count;
+		return error;
 	}
 	
-	g_frame_encode_buffer_length = frame_size;
-	usart_send(g_frame_encode_buffer, g_frame_encode_buffer_length);
+#if defined(USE_BUS_ADDRESSING)
+	// Take the bus, released in USART0_TX_vect when transmit queue is drained
+	WRITE_PIN(RS485_DE, 1);
+#endif
+	
+	// Enable USART data register empty interrupt (starts transmission)
+	SET_BIT(UCSR0B, UDRIE0);
+	
+	return CBUF_ERROR_NO_ERROR;
 }
 
-inline void hall_encoder_do_save_timer_value(hall_encoder_t* hEncoder)
+// Returns number of bytes that can still be queued for transmission
+// (ISR can only make it grow, 8-bit indices are read without atomic section)
+size_t usart_tx_queue_get_free_space(void)
 {
-	if (NULL == hEncoder)
+	return CBuf_GetFreeSpace(&g_transmit_buffer);
+}
+
+// Returns number of frames dropped because transmit queue was full
+uint16_t usart_tx_queue_get_dropped_frames_count(void)
+{
+	uint16_t dropped_frames_count = 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		do_handle_fatal_error();
-		return;
+		dropped_frames_count = g_transmit_dropped_frames_count;
 	}
 	
-	// Save timer value
-	hEncoder->buffered_timer_value = hEncoder->timer_value;
-	
-	// Save timestamp
-	hEncoder->timer_value = TCNT1;
-	hEncoder->timer_value |= ((uint32_t)(pulse_tick_counter_high_nibble)) << 16;
-	
-	// Signal scheduler to calculate RPS
-	hEncoder->is_measurement_ready = 1;
+	return dropped_frames_count;
 }
 
 
-void setup_gpio_pins(void)
+void usart_send_frame(stxetx_frame_t frame)
 {
-	// DEBUG INBUILT-LED
-	PIN_MODE_OUTPUT(ONBOARD_LED);
+	stxetx_encoder_t encoder;
 	
-	// MOTOR 1
-	PIN_MODE_OUTPUT(MOTOR_1_IN_A);
-	PIN_MODE_OUTPUT(MOTOR_1_IN_B);
-	PIN_MODE_OUTPUT(MOTOR_1_PWM);
-	PIN_MODE_INPUT(MOTOR_1_HCHA);
-		
-	// MOTOR 2
-	PIN_MODE_OUTPUT(MOTOR_2_IN_A);
-	PIN_MODE_OUTPUT(MOTOR_2_IN_B);
-	PIN_MODE_OUTPUT(MOTOR_2_PWM);
-	PIN_MODE_INPUT(MOTOR_2_HCHA);
-		
-	// MOTOR 3
-	PIN_MODE_OUTPUT(MOTOR_3_IN_A);
-	PIN_MODE_OUTPUT(MOTOR_3_IN_B);
-	PIN_MODE_OUTPUT(MOTOR_3_PWM);
-	PIN_MODE_INPUT(MOTOR_3_HCHA);
-		
-	//// --- UART 0
-		//// RX - PE0
-		//PIN_MODE_INPUT(DDRE, DDE0);
-		//// TX - PE1
-		//PIN_MODE_OUTPUT(DDRE, DDE1);
+	usart_frame_begin(&encoder, frame.msg_type, frame.flags);
+	stxetx_encoder_push_bytes(&encoder, frame.p_payload, frame.len_bytes);
+	
+	// Frames which do not fit in transmit queue are dropped (and counted)
+	usart_frame_end(&encoder);
 }
 
-// `motor_X_rps` is positive for positive rotations
-// and negative for negative rotations. Zero stops motors.
-void configure_motors_for_action(float motor_1_rps, float motor_2_rps, float motor_3_rps)
+// `stxetx_reserve_span_fn` which reserves bytes directly in transmit queue
+// (contiguous span up to the end of the raw buffer, encoder asks again after wrap).
+// Reserved bytes are invisible to USART0_UDRE_vect until usart_frame_end().
+uint8_t* usart_tx_queue_reserve_span(void* p_context, uint8_t n, uint8_t* p_n_reserved)
 {
-	// Clockwise direction = INA & ~INB
+	usart_tx_reservation_t* p_reservation = (usart_tx_reservation_t*)p_context;
 	
-	// --- MOTOR 1 : IN A (PA1), IN B (PC1)
-	// --- MOTOR 2 : IN A (PA2), IN B (PC2)
-	// --- MOTOR 3 : IN A (PA3), IN B (PC3)
+	*p_n_reserved = 0;
 	
-	/*============= MOTOR 1 =============*/
-	if (motor_1_rps == 0)
-	{
-		g_motor_1.setpoint = 0;
-		SET_MOTOR_DIRECTION_STOP(MOTOR_1_IN_A, MOTOR_1_IN_B);
-	}
-	else if(signbit(motor_1_rps) == 0)
-	{
-		g_motor_1.setpoint = motor_1_rps;
-		SET_MOTOR_DIRECTION_BACKWARD(MOTOR_1_IN_A, MOTOR_1_IN_B);
-	}
-	else
+	if (p_reservation->n_reserved >= p_reservation->n_available)
 	{
-		g_motor_1.setpoint = fabs(motor_1_rps);
-		SET_MOTOR_DIRECTION_FORWARD(MOTOR_1_IN_A, MOTOR_1_IN_B);
+		return NULL;
 	}
 	
-	/*============= MOTOR 2 =============*/
-	if (motor_2_rps == 0)
-	{
-		g_motor_2.setpoint = 0;
-		SET_MOTOR_DIRECTION_STOP(MOTOR_2_IN_A, MOTOR_2_IN_B);
-	}
-	else if(signbit(motor_2_rps) == 0)
-	{
-		g_motor_2.setpoint = motor_2_rps;
-		SET_MOTOR_DIRECTION_BACKWARD(MOTOR_2_IN_A, MOTOR_2_IN_B);
-	}
-	else
-	{
-		g_motor_2.setpoint = fabs(motor_2_rps);
-		SET_MOTOR_DIRECTION_FORWARD(MOTOR_2_IN_A, MOTOR_2_IN_B);
-	}
-		
-	/*============= MOTOR 3 =============*/
-	if (motor_3_rps == 0)
-	{
-		g_motor_3.setpoint = 0;
-		SET_MOTOR_DIRECTION_STOP(MOTOR_3_IN_A, MOTOR_3_IN_B);
-	}
-	else if(signbit(motor_3_rps) == 0)
+	// Only main loop moves the end of transmit queue, so no atomic section is needed
+	uint8_t* p_span = NULL;
+	size_t n_contiguous = CBuf_GetWriteSpan(&g_transmit_buffer, p_reservation->n_reserved, &p_span);
+	
+	const size_t n_left = p_reservation->n_available - p_reservation->n_reserved;
+	if (n_contiguous > n_left)
 	{
-		g_motor_3.setpoint = motor_3_rps;
-		SET_MOTOR_DIRECTION_BACKWARD(MOTOR_3_IN_A, MOTOR_3_IN_B);
+		n_contiguous = n_left;
 	}
-	else
+	
+	if (n_contiguous == 0)
 	{
-		g_motor_3.setpoint = fabs(motor_3_rps);
-		SET_MOTOR_DIRECTION_FORWARD(MOTOR_3_IN_A, MOTOR_3_IN_B);
+		return NULL;
 	}
-
+	
+	*p_n_reserved = (n < n_contiguous) ? n : (uint8_t)n_contiguous;
+	p_reservation->n_reserved += *p_n_reserved;
+	
+	return p_span;
 }
 
-void configure_motor_pwm_timer(void)
+// Starts frame which is escaped directly into transmit queue (no staging buffer).
+// Payload is added with stxetx_encoder_push_bytes() and frame is queued with usart_frame_end().
+// Returns stxetx_error_code_e
+uint8_t usart_frame_begin(stxetx_encoder_t* h_encoder, uint8_t msg_type, uint8_t flags)
 {
-	//////////////////////////////////////////////////////////////////////////
-	// Three motors need three PWM channels (Output Compare Registers):
-	// - 8 bit TIMER2 Channels A & B
-	// - 8 bit TIMER0 Channel  B
-	//////////////////////////////////////////////////////////////////////////
+	g_transmit_reservation.n_reserved = 0;
 	
-	//////////////////////////////////////////////////////////////////////////
-	// -- Timer 0
-	// Phase corrected PWM mode
-	
-	// Set phase corrected PWM mode of operation
-	SET_BIT(TCCR0A, WGM00);
-	CLR_BIT(TCCR0A, WGM01);
-	CLR_BIT(TCCR0B, WGM02);
-	
-	// Output Compare - B
-	SET_BIT(TCCR0A, COM0B0);
-	SET_BIT(TCCR0A, COM0B1);
-
-	// Set clock prescaler to 1/8
-	// Which gives 16MHz/(8 * 510) = 3.9 kHz PWM frequency
-	CLR_BIT(TCCR0B, CS00);
-	SET_BIT(TCCR0B, CS01);
-	CLR_BIT(TCCR0B, CS02);
-	
-	// Disable interrupts
-	// Overflow
-	CLR_BIT(TIMSK0, TOV0);
-	// Output Compare B Match
-	CLR_BIT(TIMSK0, OCIE0B);
-	//////////////////////////////////////////////////////////////////////////
+	// Free space can only grow while frame is being encoded (ISR only reads).
+	// Muted frame is encoded into no space and discarded by usart_frame_end().
+	g_transmit_reservation.n_available = g_flag_transmit_muted ? 0 : usart_tx_queue_get_free_space();
 	
-	//////////////////////////////////////////////////////////////////////////
-	// -- Timer 2
-	// Phase corrected PWM mode
-	
-	// Set phase corrected PWM mode of operation
-	SET_BIT(TCCR2A, WGM20);
-	CLR_BIT(TCCR2A, WGM21);
-	CLR_BIT(TCCR2B, WGM22);
-	
-	// Set on upcount, clear on downcount
-	// Output Compare - A
-	SET_BIT(TCCR2A, COM2A0);
-	SET_BIT(TCCR2A, COM2A1);
-	
-	// Output Compare - B
-	SET_BIT(TCCR2A, COM2B0);
-	SET_BIT(TCCR2A, COM2B1);
-
-	// Set clock prescaler to 1/8
-	// Which gives 16MHz/(8 * 510) = 3.9 kHz PWM frequency
-	CLR_BIT(TCCR2B, CS20);
-	SET_BIT(TCCR2B, CS21);
-	CLR_BIT(TCCR2B, CS22);
-	
-	// Disable interrupts
-	// Overflow
-	CLR_BIT(TIMSK2, TOV2);
-	// Output Compare B Match
-	CLR_BIT(TIMSK2, OCIE2A);
-	// Output Compare B Match
-	CLR_BIT(TIMSK2, OCIE2B);
-	//////////////////////////////////////////////////////////////////////////
+#if defined(USE_BUS_ADDRESSING)
+	// Host tells nodes apart by source address
+	return stxetx_encoder_begin_addressed(h_encoder, usart_tx_queue_reserve_span, &g_transmit_reservation,
+		BUS_NODE_ADDRESS, msg_type, flags);
+#else
+	return stxetx_encoder_begin(h_encoder, usart_tx_queue_reserve_span, &g_transmit_reservation, msg_type, flags);
+#endif
 }
 
-// input:
-// - duty_cycle = [0..100] = Duty Cycle Percentage
-// output:
-// - Output compare value for:
-//		* 8 bit timer
-//		* Phase corrected PWM mode
-//		* Set on upcount, clear on downcount
-inline uint8_t calculate_oc_value_from_dc(uint32_t duty_cycle)
+// Finishes frame started with usart_frame_begin() and queues it for transmission.
+// If frame did not fit in transmit queue, it is dropped and
+// `g_transmit_dropped_frames_count` is incremented.
+// Returns stxetx_error_code_e
+uint8_t usart_frame_end(stxetx_encoder_t* h_encoder)
 {
-	// Set phase corrected PWM value from defined duty cycle
-	// NOTE: Formula used is modified for integer division
+	uint8_t error = usart_frame_finish(h_encoder);
+	
+	if (error == STXETX_ERROR_NO_ERROR && !g_flag_transmit_muted)
+	{
+		usart_frame_commit();
+	}
 	
-	// Phase Corrected PWM (TOP = 0xFF)
-	// with 'Set on upcount, reset on downcount'
-	return (uint8_t)((255 * ((uint32_t)100 - duty_cycle))/100);
+	return error;
 }
 
-
-void enable_encoder_interrupt(void)
+// Finishes frame started with usart_frame_begin() without queueing it.
+// Frame is queued with usart_frame_commit() if STXETX_ERROR_NO_ERROR is
+// returned (and transmit is not muted), otherwise it is dropped and counted.
+// Returns stxetx_error_code_e
+uint8_t usart_frame_finish(stxetx_encoder_t* h_encoder)
 {
-	// Enable Pullups (Disable pullup blockade)
-	CLR_BIT(MCUCR, PUD);
-	
-	//////////////////////////////////////////////////////////////////////////
-	// -- MOTOR 1
+	uint8_t error = stxetx_encoder_end(h_encoder);
 	
-	// Enable pullup (IG32E Hall encoder docs require 1k external pullup)
-	ENABLE_PULLUP(MOTOR_1_HCHA);
+	if (g_flag_transmit_muted)
+	{
+		return STXETX_ERROR_NO_ERROR;
+	}
 	
-	// TODO: MACRO FOR INT
-	// Set rising edge mode for INT4
-	SET_BIT(EICRB, ISC40);
-	SET_BIT(EICRB, ISC41);
+	if (error != STXETX_ERROR_NO_ERROR)
+	{
+		++g_transmit_dropped_frames_count;
+	}
 	
-	// Enable external interrupt
-	 SET_BIT(EIMSK, INT4);
-	//////////////////////////////////////////////////////////////////////////
+	return error;
+}
 
-	//////////////////////////////////////////////////////////////////////////
-	// -- MOTOR 2
+// Queues frame finished with usart_frame_finish() for transmission.
+void usart_frame_commit(void)
+{
+	// Single 8-bit `head` update publishes the whole frame to USART0_UDRE_vect
+	CBuf_CommitWrite(&g_transmit_buffer, g_transmit_reservation.n_reserved);
 	
-	// Enable pullup (IG32E Hall encoder docs require 1k external pullup)
-	ENABLE_PULLUP(MOTOR_2_HCHA);
+#if defined(USE_BUS_ADDRESSING)
+	// Take the bus, released in USART0_TX_vect when transmit queue is drained
+	WRITE_PIN(RS485_DE, 1);
+#endif
+	
+	// Enable USART data register empty interrupt (starts transmission)
+	SET_BIT(UCSR0B, UDRIE0);
+}
+
+// Called from encoder ISR
+inline void hall_encoder_do_save_timer_value(hall_encoder_t* hEncoder)
+{
+	if (NULL == hEncoder)
+	{
+		do_handle_fatal_error();
+		return;
+	}
 	
-	// TODO: MACRO FOR INT
-	// Set rising edge mode for INT5
-	SET_BIT(EICRB, ISC50);
-	SET_BIT(EICRB, ISC51);
+	PROFILE_BEGIN(PROBE_HALL_ENCODER_SAVE);
 	
-	// Enable external interrupt
-	SET_BIT(EIMSK, INT5);
-	//////////////////////////////////////////////////////////////////////////
+	const uint32_t timestamp = PulseTickTimer_GetTimestampFromISR();
+	
+	// Publish period, unsigned subtraction also handles timer wrap-around
+	hEncoder->captured_period_ticks = timestamp - hEncoder->timer_value;
+	hEncoder->timer_value = timestamp;
+	hEncoder->last_pulse_overflow_count = (uint16_t)(timestamp >> 16);
+	++hEncoder->pulse_count;
+	
+	// Signal scheduler to calculate RPS
+	hEncoder->is_measurement_ready = 1;
+	Scheduler_PostFromISR(&g_scheduler, TASK_UPDATE_ENCODERS);
+	
+	do_capture_sysid_edge(hEncoder);
+	
+	PROFILE_END(PROBE_HALL_ENCODER_SAVE);
+}
+
+#if defined(USE_INPUT_CAPTURE_ENCODER)
+// Called from input capture ISR. `capture_value` is ICRn, `high_nibble` is
+// overflow counter of TIMER n and `is_overflow_pending` is TOVn flag.
+inline void hall_encoder_do_save_capture_value(hall_encoder_t* hEncoder, uint16_t capture_value, uint16_t high_nibble, uint8_t is_overflow_pending)
+{
+	if (NULL == hEncoder)
+	{
+		do_handle_fatal_error();
+		return;
+	}
+	
+	// Timer overflowed, but TIMERn_OVF_vect has not run yet.
+	// Small capture value means edge was captured after overflow.
+	if (is_overflow_pending && capture_value < 0x8000)
+	{
+		high_nibble++;
+	}
+	
+	const uint32_t timestamp = ((uint32_t)high_nibble << 16) | capture_value;
+	
+	// Publish period in TIMER 1 ticks, so RPS calculation is independent of backend
+	hEncoder->captured_period_ticks = (timestamp - hEncoder->timer_value) << CAPTURE_TIMER_PRESCALER_SHIFT;
+	hEncoder->timer_value = timestamp;
+	hEncoder->last_pulse_overflow_count = PulseTickTimer_GetOverflowCountFromISR();
+	++hEncoder->pulse_count;
+	
+	// Signal scheduler to calculate RPS
+	hEncoder->is_measurement_ready = 1;
+	Scheduler_PostFromISR(&g_scheduler, TASK_UPDATE_ENCODERS);
+	
+	do_capture_sysid_edge(hEncoder);
+}
+#endif
+
+
+void setup_gpio_pins(void)
+{
+	// DEBUG INBUILT-LED
+	PIN_MODE_OUTPUT(ONBOARD_LED);
+	
+	// MOTORS
+	board_motor_setup_pins();
+		
+	//// --- UART 0
+		//// RX - PE0
+		//PIN_MODE_INPUT(DDRE, DDE0);
+		//// TX - PE1
+		//PIN_MODE_OUTPUT(DDRE, DDE1);
+}
+
+// `rps[i]` is positive for positive rotations of motor index i
+// and negative for negative rotations. Zero stops motors.
+// Speeds are approached gradually (See. do_advance_setpoint_ramps()).
+void configure_motors_for_action(const float rps[MOTOR_COUNT])
+{
+#define SET_MOTOR_RAMP_TARGET(N)	\
+	setpoint_ramp_set_target(&g_motor_##N.setpoint_ramp, PIDQ_FROM_FLOAT(rps[BOARD_MOTOR_INDEX(N)]));
+	BOARD_FOR_EACH_MOTOR(SET_MOTOR_RAMP_TARGET)
+}
+
+// Immediately applies signed Q16.16 speeds (`rps[i]` of motor index i)
+// to PID setpoints and direction pins.
+void apply_motor_setpoints(const pidq_value_t rps[MOTOR_COUNT])
+{
+	// Clockwise direction = INA & ~INB
+	
+#define APPLY_MOTOR_SETPOINT(N)												\
+	if (rps[BOARD_MOTOR_INDEX(N)] == 0)										\
+	{																		\
+		g_motor_##N.setpoint = 0;											\
+		BOARD_MOTOR_SET_STOP(N);											\
+	}																		\
+	else if (rps[BOARD_MOTOR_INDEX(N)] > 0)									\
+	{																		\
+		g_motor_##N.setpoint = rps[BOARD_MOTOR_INDEX(N)];					\
+		g_motor_##N.direction = 1;											\
+		BOARD_MOTOR_SET_BACKWARD(N);										\
+	}																		\
+	else																	\
+	{																		\
+		g_motor_##N.setpoint = -rps[BOARD_MOTOR_INDEX(N)];					\
+		g_motor_##N.direction = -1;											\
+		BOARD_MOTOR_SET_FORWARD(N);											\
+	}
+	BOARD_FOR_EACH_MOTOR(APPLY_MOTOR_SETPOINT)
+}
+
+// Converts limits to per PID tick units and applies them to all motors.
+// `acceleration_rps_per_s` = 0 disables ramping (setpoints are steps),
+// `jerk_rps_per_s2` = 0 selects trapezoidal profile.
+void configure_setpoint_ramps(float acceleration_rps_per_s, float jerk_rps_per_s2)
+{
+	const pidq_value_t max_rate = PIDQ_FROM_FLOAT(fabs(acceleration_rps_per_s) * SAMPLE_TIME_S);
+	const pidq_value_t max_rate_change = PIDQ_FROM_FLOAT(fabs(jerk_rps_per_s2) * SAMPLE_TIME_S * SAMPLE_TIME_S);
 	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		setpoint_ramp_set_limits(&g_motors[i]->setpoint_ramp, max_rate, max_rate_change);
+	}
+}
+
+// Advances setpoint profiles by one PID tick. Direction pins change
+// when profile crosses zero, not when command is received.
+void do_advance_setpoint_ramps(void)
+{
+	pidq_value_t rps[MOTOR_COUNT];
+	
+#define ADVANCE_MOTOR_RAMP(N)	\
+	rps[BOARD_MOTOR_INDEX(N)] = setpoint_ramp_advance(&g_motor_##N.setpoint_ramp);
+	BOARD_FOR_EACH_MOTOR(ADVANCE_MOTOR_RAMP)
+	
+	apply_motor_setpoints(rps);
+}
+
+// Stops motors without ramping (next command starts from zero speed)
+void stop_motors(void)
+{
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		setpoint_ramp_reset(&g_motors[i]->setpoint_ramp, 0);
+	}
+	
+	const pidq_value_t rps[MOTOR_COUNT] = { 0 };
+	apply_motor_setpoints(rps);
+}
+
+// Writes `duty_cycle` of all motors to PWM outputs
+void do_write_motor_duty_cycles(void)
+{
+	motor_pwm_compare_t compares[MOTOR_COUNT];
+	
+#define GET_MOTOR_DUTY_COMPARE(N)	\
+	compares[BOARD_MOTOR_INDEX(N)] = motor_pwm_compare_from_duty(PIDQ_FROM_INT(g_motor_##N.duty_cycle));
+	BOARD_FOR_EACH_MOTOR(GET_MOTOR_DUTY_COMPARE)
+	
+	motor_pwm_write(compares);
+}
+
+void enable_encoder_interrupt(void)
+{
+	// Rising edge external interrupts (See. board_motor.h)
+	board_motor_enable_encoder_interrupts();
+	
+#if defined(USE_INPUT_CAPTURE_ENCODER)
+	// MOTOR 1 and MOTOR 2 are timestamped by input capture units
+	enable_capture_encoder();
+#endif
+	
+#if defined(USE_QUADRATURE_ENCODER)
 	//////////////////////////////////////////////////////////////////////////
-	// -- MOTOR 3
+	// -- QUADRATURE (CHANNEL B)
 	
-	// Enable pullup (IG32E Hall encoder docs require 1k external pullup)
-	ENABLE_PULLUP(MOTOR_3_HCHA);
+	// Channel A interrupts on any edge (ISCn1:0 = 01), so every edge is decoded.
+	// Edges flagged while sense mode was changing are cleared.
+#define SETUP_MOTOR_EXT_INT_ANY_EDGE(N)				\
+	CLR_BIT(MOTOR_##N##_EICR, MOTOR_##N##_ISC1);	\
+	EIFR = _BV(MOTOR_##N##_EXT_INTF);
+	BOARD_FOR_EACH_EXT_INT_MOTOR(SETUP_MOTOR_EXT_INT_ANY_EDGE)
 	
-	// TODO: MACRO FOR INT
-	// Set rising edge mode for INT4
-	SET_BIT(EICRA, ISC20);
-	SET_BIT(EICRA, ISC21);
+	// Enable pullups (IG32E Hall encoder docs require 1k external pullup)
+#define SETUP_MOTOR_HCHB_PIN(N)			\
+	PIN_MODE_INPUT(MOTOR_##N##_HCHB);	\
+	ENABLE_PULLUP(MOTOR_##N##_HCHB);
+	BOARD_FOR_EACH_MOTOR(SETUP_MOTOR_HCHB_PIN)
 	
-	// Enable external interrupt
-	SET_BIT(EIMSK, INT2);
+	// Channel B interrupts on any edge (pin change interrupt 2)
+	SET_BIT(PCMSK2, PCINT16);
+	SET_BIT(PCMSK2, PCINT17);
+	SET_BIT(PCMSK2, PCINT18);
+	SET_BIT(PCIFR, PCIF2);
+	SET_BIT(PCICR, PCIE2);
 	//////////////////////////////////////////////////////////////////////////
+#endif
 
 }
  
-void configure_pulse_tick_timer(void) 
+#if defined(USE_QUADRATURE_ENCODER)
+// Called from encoder ISRs (channel A: INTn, channel B: PCINT2) with current channel levels
+inline void motor_do_on_quadrature_edge(motor_t* hMotor, uint8_t state, uint8_t is_channel_a_edge)
+{
+	qenc_update(&hMotor->quadrature_encoder, state);
+	
+	// Period is still measured between rising edges of channel A
+	if (is_channel_a_edge && (state & QENC_CHANNEL_A))
+	{
+		hall_encoder_do_save_timer_value(&hMotor->hall_encoder);
+	}
+}
+
+// Updates hybrid speed estimate of every motor.
+// Called once per PID period (estimation window).
+void do_update_quadrature_estimates(void)
+{
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		int32_t count = 0;
+		
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			count = g_motors[i]->quadrature_encoder.count;
+		}
+		
+		qenc_estimate_rps(&g_motors[i]->quadrature_encoder, count, g_motors[i]->hall_encoder.current_rps);
+	}
+}
+#endif
+
+// Returns absolute speed of motor used as controller feedback (Q16.16)
+pidq_value_t get_motor_feedback_rps(motor_t* hMotor)
+{
+#if defined(USE_QUADRATURE_ENCODER)
+	// Hybrid estimate is signed, setpoints are absolute values
+	const pidq_value_t rps = hMotor->quadrature_encoder.rps;
+	return (rps < 0) ? -rps : rps;
+#else
+	return hMotor->hall_encoder.current_rps;
+#endif
+}
+
+// Returns speed sign as commanded (positive for positive rotations), Q16.16
+pidq_value_t get_motor_signed_rps(motor_t* hMotor)
+{
+#if defined(USE_QUADRATURE_ENCODER)
+	return hMotor->quadrature_encoder.rps;
+#else
+	// Hall encoder has no direction information, last commanded direction is used
+	const pidq_value_t rps = hMotor->hall_encoder.current_rps;
+	return (hMotor->direction < 0) ? -rps : rps;
+#endif
+}
+
+#if !defined(USE_QUADRATURE_ENCODER)
+// Adds pulses counted since last call to signed `position` of every motor.
+// Called every PID tick and before positions are read, at most 65535
+// pulses may arrive in between.
+void do_update_hall_positions(void)
+{
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		uint16_t pulse_count = 0;
+		
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			pulse_count = g_motors[i]->hall_encoder.pulse_count;
+		}
+		
+		// Unsigned subtraction handles wrap-around of pulse counter
+		const uint16_t n_pulses = pulse_count - g_motors[i]->position_pulse_count;
+		g_motors[i]->position_pulse_count = pulse_count;
+		
+		if (g_motors[i]->direction < 0)
+		{
+			g_motors[i]->position -= n_pulses;
+		}
+		else
+		{
+			g_motors[i]->position += n_pulses;
+		}
+	}
+}
+#endif
+
+// Returns signed position in encoder ticks (See. POSITION_TICKS_PER_ROTATION),
+// positive for positive rotations
+int32_t get_motor_position(motor_t* hMotor)
+{
+#if defined(USE_QUADRATURE_ENCODER)
+	int32_t count = 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		count = hMotor->quadrature_encoder.count;
+	}
+	
+	return count;
+#else
+	// Hall encoder has no direction information, last commanded direction is used
+	return hMotor->position;
+#endif
+}
+
+#if defined(USE_INPUT_CAPTURE_ENCODER)
+void enable_capture_encoder(void)
 {
+	//////////////////////////////////////////////////////////////////////////
+	// -- MOTOR 1 (ICP4)
+	
+	// Enable pullup (IG32E Hall encoder docs require 1k external pullup)
+	ENABLE_PULLUP(MOTOR_1_HCHA);
+	
 	// Set normal mode of operation
-	CLR_BIT(TCCR1A, COM1A0);
-	CLR_BIT(TCCR1A, COM1A1);
+	TCCR4A = 0;
+	TCCR4B = 0;
+	TCNT4 = 0;
 	
-	CLR_BIT(TCCR1A, WGM10);
-	CLR_BIT(TCCR1A, WGM11);
-	CLR_BIT(TCCR1B, WGM12);
-	CLR_BIT(TCCR1B, WGM13);
+	// Capture on rising edge, enable noise canceler (constant 4 cycle delay)
+	SET_BIT(TCCR4B, ICES4);
+	SET_BIT(TCCR4B, ICNC4);
 	
-	// Initialize timer value
-	TCNT1 = 0;
+	// Clear stale capture and enable capture and overflow interrupts
+	SET_BIT(TIFR4, ICF4);
+	SET_BIT(TIMSK4, ICIE4);
+	SET_BIT(TIMSK4, TOIE4);
+	
+	// Enable clock (prescaler = 8)
+	WRITE_BIT(TCCR4B, CS40, 0);
+	WRITE_BIT(TCCR4B, CS41, 1);
+	WRITE_BIT(TCCR4B, CS42, 0);
+	//////////////////////////////////////////////////////////////////////////
+	
+	//////////////////////////////////////////////////////////////////////////
+	// -- MOTOR 2 (ICP5)
+	
+	// Enable pullup (IG32E Hall encoder docs require 1k external pullup)
+	ENABLE_PULLUP(MOTOR_2_HCHA);
+	
+	// Set normal mode of operation
+	TCCR5A = 0;
+	TCCR5B = 0;
+	TCNT5 = 0;
+	
+	// Capture on rising edge, enable noise canceler (constant 4 cycle delay)
+	SET_BIT(TCCR5B, ICES5);
+	SET_BIT(TCCR5B, ICNC5);
+	
+	// Clear stale capture and enable capture and overflow interrupts
+	SET_BIT(TIFR5, ICF5);
+	SET_BIT(TIMSK5, ICIE5);
+	SET_BIT(TIMSK5, TOIE5);
+	
+	// Enable clock (prescaler = 8)
+	WRITE_BIT(TCCR5B, CS50, 0);
+	WRITE_BIT(TCCR5B, CS51, 1);
+	WRITE_BIT(TCCR5B, CS52, 0);
+	//////////////////////////////////////////////////////////////////////////
+}
+#endif
+
+// Configures speed filter pipeline of 'hEncoder' Hall Encoder (resets filter state)
+// `median_taps` - 0 (disabled), 3 or 5
+// `average_window_shift` - moving average over 2^average_window_shift pulses
+void hall_encoder_configure_filters(hall_encoder_t* hEncoder, uint8_t median_taps, uint8_t average_window_shift)
+{
+	if (NULL == hEncoder)
+	{
+		do_handle_fatal_error();
+		return;
+	}
+	
+	median_filter_init(&hEncoder->rps_median, median_taps);
+	moving_average_init(&hEncoder->rps_average, average_window_shift);
+#if defined(RPS_BIQUAD_CUTOFF_RATIO)
+	biquad_init_lowpass(&hEncoder->rps_biquad, RPS_BIQUAD_CUTOFF_RATIO);
+#endif
 }
 
-void enable_pulse_tick_timer(void)
+// Clears speed filter history, next pulse sets filter state
+void hall_encoder_reset_filters(hall_encoder_t* hEncoder)
 {
-	// Enable overflow interrupt	
-	SET_BIT(TIMSK1, TOIE1);
+	if (NULL == hEncoder)
+	{
+		do_handle_fatal_error();
+		return;
+	}
 	
-	// Enable clock (no prescaler)
-	SET_BIT(TCCR1B, CS10);
-	CLR_BIT(TCCR1B, CS11);
-	CLR_BIT(TCCR1B, CS12);
+	median_filter_reset(&hEncoder->rps_median);
+	moving_average_reset(&hEncoder->rps_average);
+#if defined(RPS_BIQUAD_CUTOFF_RATIO)
+	biquad_reset(&hEncoder->rps_biquad);
+#endif
 }
 
 // Calculated new RPS value for 'hEncoder' Hall Encoder
-// From saved timer values (which are saved in INT0/1 ISRs)
+// From period captured in encoder ISRs (INT4/INT5/INT2).
+// Clears `is_measurement_ready` flag.
 void do_update_rps(hall_encoder_t* hEncoder)
 {	
 	if (NULL == hEncoder)
@@ -796,52 +1953,136 @@ void do_update_rps(hall_encoder_t* hEncoder)
 		return;
 	}
 	
-	float ticks = 0;
+	uint32_t ticks = 0;
 	
-	if (hEncoder->buffered_timer_value > hEncoder->timer_value)
+	// 32-bit period is published by encoder ISR, take a tear-free snapshot
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		ticks = hEncoder->timer_value + (UINT32_MAX - hEncoder->buffered_timer_value);
-	} 
-	else
+		ticks = hEncoder->captured_period_ticks;
+		hEncoder->is_measurement_ready = 0;
+	}
+	
+	// Pulse arrived, so encoder is moving again. Period measured across
+	// stall is meaningless, next pulse gives valid speed.
+	if (hEncoder->is_stalled)
+	{
+		hEncoder->is_stalled = 0;
+		return;
+	}
+	
+	// Physically impossible periods (RPS would not fit in Q16.16)
+	if(ticks < RPS_MIN_PERIOD_TICKS)
 	{
-		ticks = hEncoder->timer_value - hEncoder->buffered_timer_value;
+		return;
 	}
 	
-	// Ticks equals approx. 0
-	if(ticks < 0.9)
+	const pidq_value_t new_rps = (pidq_value_t)(RPS_TICKS_CONSTANT / ticks);
+	
+	pidq_value_t filtered_rps = median_filter_feed(&hEncoder->rps_median, new_rps);
+	filtered_rps = moving_average_feed(&hEncoder->rps_average, filtered_rps);
+#if defined(RPS_BIQUAD_CUTOFF_RATIO)
+	filtered_rps = biquad_feed(&hEncoder->rps_biquad, filtered_rps);
+#endif
+	hEncoder->current_rps = filtered_rps;
+	
+	mean_accumulator_feed(&hEncoder->average_rps, new_rps);
+}
+
+// Handles missing encoder pulses (do_update_rps() only runs on a pulse).
+// Next pulse is at least `elapsed` away, so speed can not be higher than
+// RPS(elapsed): speed decays toward zero once time since last pulse is
+// longer than the measured period. After ENCODER_STALL_TIMEOUT_OVERFLOWS
+// speed is set to zero and encoder is flagged as stalled.
+void do_check_encoder_timeout(hall_encoder_t* hEncoder, uint16_t overflow_count)
+{
+	if (NULL == hEncoder)
 	{
+		do_handle_fatal_error();
 		return;
 	}
 	
-	float new_rps = F_CPU/(ticks * PULSES_PER_ROTATION);
+	uint16_t last_pulse_overflow_count = 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		last_pulse_overflow_count = hEncoder->last_pulse_overflow_count;
+	}
+	
+	const uint16_t elapsed_overflows = overflow_count - last_pulse_overflow_count;
 	
-	// Crude low-pass (disturbance rejection) filter
-	if(new_rps < RPS_UPPER_DISCARD_LIMIT)
+	if (elapsed_overflows >= ENCODER_STALL_TIMEOUT_OVERFLOWS)
 	{
-		hEncoder->current_rps = RPS_ALPHA * hEncoder->current_rps + (1-RPS_ALPHA) * new_rps;
-		//hEncoder->current_rps = new_rps;
+		// Filter history is from before the stall
+		if (!hEncoder->is_stalled)
+		{
+			hall_encoder_reset_filters(hEncoder);
+		}
 		
-		cma_feed_sample(&hEncoder->average_rps, new_rps);
+		hEncoder->current_rps = 0;
+		hEncoder->is_stalled = 1;
+		return;
+	}
+	
+	// Lower bound of time since last pulse (partial overflows are not counted)
+	if (elapsed_overflows < 2)
+	{
+		return;
 	}
 	
-	//usart_send((unsigned char*)&new_rps, sizeof(float));
+	const uint32_t elapsed_ticks = ((uint32_t)(elapsed_overflows - 1)) << 16;
+	const pidq_value_t max_rps = (pidq_value_t)(RPS_TICKS_CONSTANT / elapsed_ticks);
 	
+	if (hEncoder->current_rps > max_rps)
+	{
+		hEncoder->current_rps = max_rps;
+	}
+}
+
+// Called from TIMER1_OVF_vect (See. pulse_tick_timer.h)
+void on_pulse_tick_timer_overflow(void)
+{
+	Scheduler_PostFromISR(&g_scheduler, TASK_CHECK_ENCODER_TIMEOUTS);
 }
 
-void setup_task_timer(void)
+// Checks encoder timeouts once per TIMER 1 overflow
+void do_check_encoder_timeouts(void)
 {
-	// 16-bit TIMER3 is used to time tasks like:
-	// Execution of commands, periodic sending of data, etc.
+	const uint16_t overflow_count = PulseTickTimer_GetOverflowCount();
+	
+	if (overflow_count == g_encoder_timeout_last_check_overflow_count)
+	{
+		return;
+	}
 	
-	// For this task, one tick of timer is set to 50ms and
-	// each task should sample timer at the beginning and
-	// measure duration in main loop.
+	g_encoder_timeout_last_check_overflow_count = overflow_count;
 	
-	// Prescaler = 256, Compare Value = 3125 gives one tick period of 50ms
-	const uint16_t timer_compare_value = 3125;
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		do_check_encoder_timeout(&g_motors[i]->hall_encoder, overflow_count);
+		
+		// Stall is only a fault if motor is driven
+		if (g_motors[i]->hall_encoder.is_stalled && g_motors[i]->setpoint != 0 && g_flag_command_running)
+		{
+			// Logged once per motor and command
+			if (!(g_stalled_motors_mask & (1 << i)))
+			{
+				g_stalled_motors_mask |= (1 << i);
+				do_log_event(EVENT_CODE_MOTOR_STALL, i);
+			}
+			
+			do_on_telemetry_event(TELEMETRY_TRIGGER_STALL);
+		}
+	}
+}
+
+void setup_system_clock(void)
+{
+	// 16-bit TIMER3 is the system clock: it counts milliseconds in
+	// `g_system_clock_ms`, generates PID tick and expires software timers.
 	
-	// Set output compare register A value
-	OCR3A = timer_compare_value;
+	// CTC period is OCR3A + 1 ticks, prescaler = 64 and compare value = 249
+	// give exactly 1ms at 16MHz (clock does not drift against F_CPU)
+	OCR3A = SYSTEM_CLOCK_COMPARE_VALUE;
 	
 	// Initialize timer value
 	TCNT3 = 0;
@@ -853,73 +2094,64 @@ void setup_task_timer(void)
 	WRITE_BIT(TCCR3B, WGM33, 0);
 }
 
-void enable_task_timer(void)
+void enable_system_clock(void)
 {
 	// Enable interrupt
 	SET_BIT(TIMSK3, OCIE3A);
 	
-	// Enable clock (prescaler = 256)
-	WRITE_BIT(TCCR3B, CS30, 0);
-	WRITE_BIT(TCCR3B, CS31, 0);
-	WRITE_BIT(TCCR3B, CS32, 1);
+	// Enable clock (prescaler = 64)
+	WRITE_BIT(TCCR3B, CS30, 1);
+	WRITE_BIT(TCCR3B, CS31, 1);
+	WRITE_BIT(TCCR3B, CS32, 0);
 }
 
-void setup_pid_timer(void)
+// Returns system clock in milliseconds, can be called from main loop.
+uint32_t system_clock_get_ms(void)
 {
-	// Time for timer to tick once T1 = 1024/F_CPU (prescaler = 1024).
-	// If we want timer to interrupt every T seconds, we must set compare register
-	// to N ticks where N = T/T1 = F_CPU/F_S where F_S is the sampling (interrupt) frequency.
-
-	//const uint8_t timer_compare_value = (uint8_t)(F_CPU/(1024 * SAMPLING_FREQUENCY));
-	
-	// 62.5 Hz
-	const uint16_t timer_compare_value = 250;
-	
-	// Set output compare register A value
-	OCR4A = timer_compare_value;
+	uint32_t now_ms = 0;
 	
-	// Initialize timer value
-	TCNT4 = 0;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		now_ms = g_system_clock_ms;
+	}
 	
-	// Set OC CTC (TOP = OCR4A) mode of operation
-	WRITE_BIT(TCCR4A, WGM40, 0);
-	WRITE_BIT(TCCR4A, WGM41, 0);
-	WRITE_BIT(TCCR4B, WGM42, 1);
-	WRITE_BIT(TCCR4B, WGM43, 0);
+	return now_ms;
 }
 
-void enable_pid_timer(void)
+void setup_soft_timers(void)
 {
-	// Enable interrupt
-	SET_BIT(TIMSK4, OCIE4A);
-	
-	// Enable clock (prescaler = 1024)
-	WRITE_BIT(TCCR4B, CS40, 1);
-	WRITE_BIT(TCCR4B, CS41, 0);
-	WRITE_BIT(TCCR4B, CS42, 1);
+	SoftTimer_InitQueue(&g_soft_timers);
+	SoftTimer_Init(&g_command_timer, SOFT_TIMER_COMMAND);
+	SoftTimer_Init(&g_odometry_timer, SOFT_TIMER_ODOMETRY);
+	SoftTimer_Init(&g_usart_speed_confirm_timer, SOFT_TIMER_USART_SPEED_CONFIRM);
 }
 
 void pause_pid_timer(void)
 {
-	// Disable interrupt
-	CLR_BIT(TIMSK4, OCIE4A);
+	g_flag_pid_tick_enabled = 0;
 }
 
+// First PID tick comes one PID period after resume
 void resume_pid_timer(void)
 {
-	// Reset timer value
-	TCNT4 = 0;
-	
-	// Enable interrupt
-	SET_BIT(TIMSK4, OCIE4A);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		g_pid_tick_deadline_ms = g_system_clock_ms + PID_TICK_PERIOD_MS;
+		g_flag_pid_tick_enabled = 1;
+	}
 }
 
 void setup_usart_receive(void)
 {
 	// --- USART0
 	
-	// Set baud rate to 115.2 kbps
-	UBRR0 = (uint16_t)BAUD_RATE_UBBR_115_2_KBPS;
+	// Set baud rate (double speed mode)
+	g_usart_speed.speed = USART_BOOT_SPEED;
+	g_usart_speed.previous_speed = USART_BOOT_SPEED;
+	g_usart_speed.pending_speed = USART_SPEED_COUNT;
+	g_usart_speed.is_switch_unconfirmed = 0;
+	g_usart_speed.frame_error_streak = 0;
+	usart_write_speed_registers(USART_BOOT_SPEED);
 	
 	// Enable receiver
 	SET_BIT(UCSR0B, RXEN0);
@@ -937,483 +2169,2969 @@ void setup_usart_receive(void)
 	SET_BIT(UCSR0B, RXCIE0);
 
 	// Setup receive buffer
-	uint8_t error = CBuf_Init(&g_receive_buffer, g_receive_buffer_internal_, RECEIVE_BUFFER_SIZE);
-	if(error != CBUF_ERROR_NO_ERROR)
+	usart_rx_ring_init(&g_receive_buffer);
+	
+	// Setup frame decoder
+	uint8_t error = stxetx_decoder_init(&g_frame_decoder, g_received_payload_buffer, PAYLOAD_BUFFER_SIZE);
+	if(error != STXETX_ERROR_NO_ERROR)
 	{
 		do_handle_fatal_error_with_error_code(error);
 	}
+	
+#if defined(USE_BUS_ADDRESSING)
+	stxetx_address_filter_init(&g_receive_address_filter, BUS_NODE_ADDRESS);
+	stxetx_decoder_set_addressed(&g_frame_decoder, 1);
+#endif
 }
 
-void setup_PID(void)
+// Writes UBRR0 and U2X0 of `speed` (usart_speed_e).
+// Frame being transmitted or received at that moment is corrupted.
+void usart_write_speed_registers(uint8_t speed)
 {
-	// PID Controller for Motor 1
-	PID_Init(
-		&g_motor_1.pid,		/* pid_t Handle				*/
-		PID_KP,				/* Kp - Proportional Term	*/
-		0,					/* Td - Derivative Term		*/
-		PID_TI,				/* Ti - Integral Term		*/
-		0,					/* Minimum PID Output Value */
-		95					/* Maximum PID Output Value */
-	);
+	// Plain write: TXC0 is cleared by writing one, MPCM0 stays off
+	UCSR0A = _BV(U2X0);
+	UBRR0 = pgm_read_word(&usart_speed_ubrr[speed]);
+}
+
+// Switches link to `speed` right away (from main loop). Unlike `SET_BAUD`
+// switch, new speed needs no confirmation.
+void do_set_usart_speed(uint8_t speed)
+{
+	SoftTimer_Stop(&g_soft_timers, &g_usart_speed_confirm_timer);
 	
-	// PID Controller for Motor 2
-	PID_Init(
-		&g_motor_2.pid,		/* pid_t Handle				*/
-		PID_KP,				/* Kp - Proportional Term	*/
-		0,					/* Td - Derivative Term		*/
-		PID_TI,				/* Ti - Integral Term		*/
-		0,					/* Minimum PID Output Value */
-		95					/* Maximum PID Output Value */
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		g_usart_speed.pending_speed = USART_SPEED_COUNT;
+		g_usart_speed.is_switch_unconfirmed = 0;
+		g_usart_speed.speed = speed;
+		g_usart_speed.previous_speed = speed;
+		usart_write_speed_registers(speed);
+	}
+	
+	g_usart_speed.frame_error_streak = 0;
+}
+
+// Counts malformed frames, link steps down to next lower supported speed when
+// USART_SPEED_FALLBACK_ERROR_COUNT frames in a row fail. Host finds
+// the node again by probing lower speeds.
+void do_on_usart_frame_error(void)
+{
+	if (++g_usart_speed.frame_error_streak < USART_SPEED_FALLBACK_ERROR_COUNT)
+	{
+		return;
+	}
+	
+	g_usart_speed.frame_error_streak = 0;
+	
+	uint8_t speed = g_usart_speed.speed;
+	
+	// USART_BOOT_SPEED is always supported
+	while (speed > USART_BOOT_SPEED)
+	{
+		--speed;
+		
+		if (USART_SUPPORTED_SPEED_MASK & (1 << speed))
+		{
+			break;
+		}
+	}
+	
+	if (speed != g_usart_speed.speed)
+	{
+		do_set_usart_speed(speed);
+		do_log_event(EVENT_CODE_LINK_FALLBACK, g_usart_speed.speed);
+	}
+}
+
+// Maps decoder error to link_error_e
+uint8_t convert_stxetx_error_to_link_error(uint8_t error)
+{
+	switch (error)
+	{
+		case STXETX_ERROR_STX_MISSING:
+			return LINK_ERROR_STX_MISSING;
+		
+		case STXETX_ERROR_ETX_MISSING:
+			return LINK_ERROR_ETX_MISSING;
+		
+		case STXETX_ERROR_BUFFER_TOO_SMALL:
+			return LINK_ERROR_OVERFLOW;
+		
+		case STXETX_ERROR_CHECKSUM_MISMATCH:
+			return LINK_ERROR_CHECKSUM;
+		
+		default:
+			return LINK_ERROR_INVALID_LENGTH;
+	}
+}
+
+// Counts dropped frame and reports it to host with `LINK_ERROR` message,
+// at most once per LINK_ERROR_REPORT_INTERVAL_MS. Payload is:
+// [0]     cause (link_error_e)
+// [1..12] dropped frames per cause since start or last DIAGNOSTICS reset (uint16_t[LINK_ERROR_COUNT], saturated)
+// Receiving and control loop continue, frame is just discarded.
+// Not sent on multi-drop bus (nodes transmit only when asked).
+// Reported errors except noise between frames are also written to event log,
+// the rate limit keeps a noisy link from wearing out EEPROM.
+void do_on_link_error(uint8_t cause)
+{
+	if (g_link_error_counts[cause] != UINT16_MAX)
+	{
+		++g_link_error_counts[cause];
+	}
+	
+	const uint32_t now_ms = system_clock_get_ms();
+	
+	if (g_flag_link_error_reported && now_ms - g_link_error_last_report_ms < LINK_ERROR_REPORT_INTERVAL_MS)
+	{
+		return;
+	}
+	
+	g_flag_link_error_reported = 1;
+	g_link_error_last_report_ms = now_ms;
+	
+	if (cause != LINK_ERROR_STX_MISSING)
+	{
+		do_log_event(EVENT_CODE_LINK_ERROR, cause);
+	}
+	
+#if !defined(USE_BUS_ADDRESSING)
+	stxetx_encoder_t encoder;
+	usart_frame_begin(&encoder, MSG_TYPE_LINK_ERROR, 0);
+	stxetx_encoder_push_bytes(&encoder, &cause, sizeof(uint8_t));
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)g_link_error_counts, sizeof(g_link_error_counts));
+	usart_frame_end(&encoder);
+#endif
+}
+
+// Appends record with snapshot of controller state to persistent event log.
+// Does not block (See. event_log.h), record is dropped if write queue is full.
+void do_log_event(uint8_t code, uint8_t detail)
+{
+	event_snapshot_t snapshot;
+	memset(&snapshot, 0, sizeof(snapshot));
+	
+	for (uint8_t i = 0; i < EVENT_SNAPSHOT_MOTOR_COUNT; i++)
+	{
+		snapshot.rps[i] = convert_q16_16_to_q8_8(get_motor_signed_rps(g_motors[i]));
+	}
+	
+	snapshot.stalled_motors_mask = g_stalled_motors_mask;
+	
+	if (g_flag_command_running)
+	{
+		snapshot.state_flags |= EVENT_STATE_COMMAND_RUNNING;
+	}
+	
+	if (g_sysid.state != SYSID_STATE_IDLE)
+	{
+		snapshot.state_flags |= EVENT_STATE_SYSID_RUNNING;
+	}
+	
+	if (g_flag_rx_sequence_synced)
+	{
+		snapshot.state_flags |= EVENT_STATE_RX_SEQUENCE_SYNCED;
+	}
+	
+	EventLog_Append(system_clock_get_ms(), code, detail, (const uint8_t*)&snapshot);
+}
+
+void setup_usart_transmit(void)
+{
+	// --- USART0
+	// Baud rate and frame format are set in setup_usart_receive()
+	
+	// Setup transmit queue
+	uint8_t error = CBuf_Init(&g_transmit_buffer, g_transmit_buffer_internal_, TRANSMIT_BUFFER_SIZE);
+	if(error != CBUF_ERROR_NO_ERROR)
+	{
+		do_handle_fatal_error_with_error_code(error);
+	}
+	
+	// Data register empty interrupt is enabled only while
+	// there is data in transmit queue
+	CLR_BIT(UCSR0B, UDRIE0);
+	
+#if defined(USE_BUS_ADDRESSING)
+	// Bus driver is disabled (receiving) until first frame is queued
+	WRITE_PIN(RS485_DE, 0);
+	PIN_MODE_OUTPUT(RS485_DE);
+	
+	// Transmit complete interrupt releases the bus
+	SET_BIT(UCSR0B, TXCIE0);
+#endif
+	
+	// Enable transmitter
+	SET_BIT(UCSR0B, TXEN0);
+}
+
+void setup_PID(void)
+{
+	pid_gains_t stored_gains[MOTOR_COUNT];
+	uint8_t is_stored_valid = GainStore_Load(stored_gains, MOTOR_COUNT);
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT && is_stored_valid; i++)
+	{
+		is_stored_valid = is_valid_pid_gains(stored_gains[i].Kp, stored_gains[i].Ti);
+	}
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		g_pid_gains[i].Kp = is_stored_valid ? stored_gains[i].Kp : PID_KP;
+		g_pid_gains[i].Ti = is_stored_valid ? stored_gains[i].Ti : PID_TI;
+	}
+	
+	g_pid_gains_source = is_stored_valid ? PID_GAINS_SOURCE_EEPROM : PID_GAINS_SOURCE_DEFAULTS;
+	
+#if defined(USE_FIXED_POINT_PID)
+	// PID Controllers for Motors 1, 2 and 3
+	PIDBank_Init(
+		&g_pid_bank,		/* pid_bank_t Handle		*/
+		MOTOR_COUNT,		/* Number of controllers	*/
+		PID_KP,				/* Kp - Proportional Term	*/
+		PID_TI,				/* Ti - Integral Term		*/
+		SAMPLE_TIME_S,		/* Timestep					*/
+		0,					/* Minimum PID Output Value */
+		PID_OUTPUT_MAX		/* Maximum PID Output Value */
 	);
 	
-	// PID Controller for Motor 3
-	PID_Init(
-		&g_motor_3.pid,		/* pid_t Handle				*/
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		PIDBank_SetGains(&g_pid_bank, i, g_pid_gains[i].Kp, g_pid_gains[i].Ti);
+		PIDQ_FeedforwardInit(&g_motors[i]->feedforward, PID_FEEDFORWARD_MODE,
+			MOTOR_MODEL_A, MOTOR_MODEL_B, PID_FEEDFORWARD_OFFSET);
+	}
+	
+	PIDBank_SetAntiWindup(&g_pid_bank, PID_ANTI_WINDUP_MODE);
+#else
+	// PID Controller of every motor
+#define SETUP_MOTOR_PID(N)	setup_motor_pid(&g_motor_##N.pid);
+	BOARD_FOR_EACH_MOTOR(SETUP_MOTOR_PID)
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		PID_SetGains(&g_motors[i]->pid, g_pid_gains[i].Kp, g_pid_gains[i].Ti);
+		PID_FeedforwardInit(&g_motors[i]->feedforward, PID_FEEDFORWARD_MODE,
+			MOTOR_MODEL_A, MOTOR_MODEL_B, PID_FEEDFORWARD_OFFSET);
+	}
+#endif
+}
+
+// Returns 1 if gains can be used by PI controllers (Ti = 0 is an error state of controller)
+uint8_t is_valid_pid_gains(float Kp, float Ti)
+{
+	return (uint8_t)(isfinite(Kp) && isfinite(Ti) && Kp >= 0 && Ti > 0);
+}
+
+// Changes gains of PI controller of motor `index`, also while command is running
+// (applied on next PID tick). Gains are not saved to EEPROM.
+void set_motor_pid_gains(uint8_t index, float Kp, float Ti)
+{
+	g_pid_gains[index].Kp = Kp;
+	g_pid_gains[index].Ti = Ti;
+	
+#if defined(USE_FIXED_POINT_PID)
+	PIDBank_SetGains(&g_pid_bank, index, Kp, Ti);
+#else
+	PID_SetGains(&g_motors[index]->pid, Kp, Ti);
+#endif
+}
+
+void clear_PID(void)
+{
+#if defined(USE_FIXED_POINT_PID)
+	PIDBank_ClearAccumulatedValues(&g_pid_bank);
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		PIDQ_FeedforwardClear(&g_motors[i]->feedforward);
+	}
+#else
+#define CLEAR_MOTOR_PID(N)	PID_ClearAccumulatedValues(&g_motor_##N.pid);
+	BOARD_FOR_EACH_MOTOR(CLEAR_MOTOR_PID)
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		PID_FeedforwardClear(&g_motors[i]->feedforward);
+	}
+#endif
+}
+
+// Bumpless start of command while motors may still be turning (e.g. command
+// sent shortly after previous one finished): setpoint ramps start from measured
+// speed instead of zero and controllers continue from duty cycle that holds that
+// speed (MOTOR_MODEL_STATIC_GAIN), so PI terms do not integrate up from zero duty.
+// Motors at rest are seeded with zero speed and duty, same as clear_PID().
+void do_seed_motor_pids(void)
+{
+#if defined(USE_QUADRATURE_ENCODER)
+	do_update_quadrature_estimates();
+#endif
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		motor_t* hMotor = g_motors[i];
+		const pidq_value_t signed_rps = get_motor_signed_rps(hMotor);
+		const pidq_value_t rps = (signed_rps < 0) ? -signed_rps : signed_rps;
+		
+		setpoint_ramp_reset(&hMotor->setpoint_ramp, signed_rps);
+		hMotor->setpoint = rps;
+		
+#if defined(USE_FIXED_POINT_PID)
+		const pidq_value_t duty_cycle = PIDQ_Multiply(rps, PIDQ_FROM_FLOAT(MOTOR_MODEL_STATIC_GAIN));
+		const pidq_value_t feedforward = PIDQ_FeedforwardSeed(&hMotor->feedforward, rps);
+		
+		// Setpoint equals measured speed, no error
+		PIDBank_SetState(&g_pid_bank, i, duty_cycle - feedforward, feedforward, 0);
+#else
+		const float duty_cycle = PIDQ_TO_FLOAT(rps) * MOTOR_MODEL_STATIC_GAIN;
+		const float feedforward = PID_FeedforwardSeed(&hMotor->feedforward, PIDQ_TO_FLOAT(rps));
+		
+		PID_SetState(&hMotor->pid, duty_cycle - feedforward, feedforward, 0);
+#endif
+	}
+}
+
+#if !defined(USE_FIXED_POINT_PID)
+void setup_motor_pid(pid_t* hPID)
+{
+	PID_InitFixedRate(
+		hPID,				/* pid_t Handle				*/
 		PID_KP,				/* Kp - Proportional Term	*/
 		0,					/* Td - Derivative Term		*/
 		PID_TI,				/* Ti - Integral Term		*/
+		SAMPLE_TIME_S,		/* Timestep					*/
 		0,					/* Minimum PID Output Value */
-		95					/* Maximum PID Output Value */
+		PID_OUTPUT_MAX		/* Maximum PID Output Value */
 	);
+	
+	PID_SetAntiWindup(hPID, PID_ANTI_WINDUP_MODE);
+}
+
+// Advances PI controller of `hMotor` by one sample.
+// Returns new duty cycle [0..100] for motor PWM (Q16.16, fraction is kept)
+pidq_value_t do_advance_motor_pid(motor_t* hMotor)
+{
+	// Controllers run in fixed-rate mode (timestep = SAMPLE_TIME_S, See. setup_motor_pid())
+	// PI corrects deviation from model response to feedforward (See. pid_feedforward_t)
+	const float feedforward = PID_FeedforwardAdvance(&hMotor->feedforward, PIDQ_TO_FLOAT(hMotor->setpoint));
+	const float error = hMotor->feedforward.reference - PIDQ_TO_FLOAT(get_motor_feedback_rps(hMotor));
+	const float input = PID_AdvanceFixedRateWithFeedforward(&hMotor->pid, error, feedforward);
+	
+	hMotor->duty_cycle = (uint8_t)input;
+	return PIDQ_FROM_FLOAT(input);
 }
+#endif
 
 void do_advance_pids(void)
 {
-	float error_1 = 0;
-	float input_1 = 0;
+	// Controllers use nominal SAMPLE_TIME_S unless USE_MEASURED_PID_TIMESTEP
+	// is defined (timestep is then set by do_update_pid_timing() before this call)
+	
+#if defined(USE_QUADRATURE_ENCODER)
+	do_update_quadrature_estimates();
+#else
+	do_update_hall_positions();
+#endif
 	
-	float error_2 = 0;
-	float input_2 = 0;
+	if (g_position.is_active)
+	{
+		do_advance_position_loop();
+	}
 	
-	float error_3 = 0;
-	float input_3 = 0;
+	do_advance_setpoint_ramps();
+	
+#if defined(USE_CURRENT_SENSING)
+	do_update_motor_currents();
+#endif
 	
-	// TODO: Robust sample time calculation
+#if defined(USE_FIXED_POINT_PID)
+	pidq_value_t errors[MOTOR_COUNT];
+	pidq_value_t feedforwards[MOTOR_COUNT];
+	pidq_value_t inputs[MOTOR_COUNT];
 	
-	error_1 = g_motor_1.setpoint - g_motor_1.hall_encoder.current_rps;
-	input_1 = PID_Advance(&g_motor_1.pid, SAMPLE_TIME_S, error_1);
-	OCR2B = calculate_oc_value_from_dc((uint32_t)input_1);
+	PROFILE_BEGIN(PROBE_PID_CONTROLLERS);
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		// Speed and setpoint are already Q16.16, no conversion needed.
+		// PI corrects deviation from model response to feedforward (See. pid_feedforward_t)
+		feedforwards[i] = PIDQ_FeedforwardAdvance(&g_motors[i]->feedforward, g_motors[i]->setpoint);
+		errors[i] = g_motors[i]->feedforward.reference - get_motor_feedback_rps(g_motors[i]);
+	}
 	
-	error_2 = g_motor_2.setpoint - g_motor_2.hall_encoder.current_rps;
-	input_2 = PID_Advance(&g_motor_2.pid, SAMPLE_TIME_S, error_2);
-	OCR0B = calculate_oc_value_from_dc((uint32_t)input_2);
+	// Controllers run in fixed-rate mode (timestep = SAMPLE_TIME_S, See. setup_PID())
+	PIDBank_AdvanceWithFeedforward(&g_pid_bank, errors, feedforwards, inputs);
+	PROFILE_END(PROBE_PID_CONTROLLERS);
 	
-	error_3 = g_motor_3.setpoint - g_motor_3.hall_encoder.current_rps;
-	input_3 = PID_Advance(&g_motor_3.pid, SAMPLE_TIME_S, error_3);
-	OCR2A = calculate_oc_value_from_dc((uint32_t)input_3);
+	motor_pwm_compare_t compares[MOTOR_COUNT];
 	
-	// Reset PWM timer for correct transition between duty cycles
-	TCNT0 = 0;
-	TCNT2 = 0;
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		g_motors[i]->duty_cycle = (uint8_t)PIDQ_TO_INT(inputs[i]);
+		// Fraction of PI output is kept down to PWM timer resolution
+		compares[i] = motor_pwm_compare_from_duty(inputs[i]);
+	}
 	
-	//////////////////////////////////////////////////////////////////////////
-	// -------------- DEBUG
+	motor_pwm_write(compares);
+#else
+	pidq_value_t inputs[MOTOR_COUNT];
 	
-	//usart_send(&g_motor_2.pid.current_error, sizeof(float));
+	PROFILE_BEGIN(PROBE_PID_CONTROLLERS);
+#define ADVANCE_MOTOR_PID(N)	inputs[BOARD_MOTOR_INDEX(N)] = do_advance_motor_pid(&g_motor_##N);
+	BOARD_FOR_EACH_MOTOR(ADVANCE_MOTOR_PID)
+	PROFILE_END(PROBE_PID_CONTROLLERS);
 	
+	motor_pwm_compare_t compares[MOTOR_COUNT];
 	
-	//if (PID_CheckError(&g_motor_1.pid, NULL) || PID_CheckError(&g_motor_2.pid, NULL))
-	//{
-		//do_handle_fatal_error();
-	//}
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		compares[i] = motor_pwm_compare_from_duty(inputs[i]);
+	}
+	
+	motor_pwm_write(compares);
+#endif
+}
+
+#if defined(USE_CURRENT_SENSING)
+void setup_current_sensing(void)
+{
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		g_current_scans[i].sum = 0;
+		g_current_scans[i].count = 0;
+		g_motors[i]->current_ma = 0;
+	}
+	
+	reset_current_limits();
+	
+	g_current_scan_converting = 0;
+	g_current_scan_selected = 0;
+	motor_current_init(g_current_adc_channels[0], CURRENT_ADC_CHANNEL_MASK);
+}
+
+// Takes ADC samples of last PID tick and advances current limit loop.
+// Duty cycle ceiling integrates (limit - current): it sinks while motor draws
+// more than the limit and rises back to PID_OUTPUT_MAX below it. Ceiling is
+// the upper output limit of PI controller, so its anti-windup keeps integral
+// term at the ceiling and speed control resumes bumplessly once current drops.
+// System identification and auto-tuning drive PWM open loop and are not limited.
+void do_update_motor_currents(void)
+{
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		uint16_t sum = 0;
+		uint8_t count = 0;
+		
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			sum = g_current_scans[i].sum;
+			count = g_current_scans[i].count;
+			g_current_scans[i].sum = 0;
+			g_current_scans[i].count = 0;
+		}
+		
+		motor_t* hMotor = g_motors[i];
+		hMotor->current_ma = motor_current_convert_to_ma(sum, count);
+		
+		if (g_current_limit_ma == 0)
+		{
+			continue;
+		}
+		
+		// At most 65535 mA * 131 (0.002 in Q16.16), fits in 32 bits
+		pidq_value_t ceiling = hMotor->duty_cycle_ceiling
+			+ ((int32_t)g_current_limit_ma - (int32_t)hMotor->current_ma) * PIDQ_FROM_FLOAT(CURRENT_LIMIT_GAIN);
+		
+		if (ceiling > PIDQ_FROM_INT(PID_OUTPUT_MAX))
+		{
+			ceiling = PIDQ_FROM_INT(PID_OUTPUT_MAX);
+		}
+		
+		if (ceiling < PIDQ_FROM_INT(CURRENT_LIMIT_MIN_DUTY))
+		{
+			ceiling = PIDQ_FROM_INT(CURRENT_LIMIT_MIN_DUTY);
+		}
+		
+		set_motor_duty_cycle_ceiling(i, ceiling);
+	}
+}
+
+// Releases current limit of every motor (ceiling = PID_OUTPUT_MAX)
+void reset_current_limits(void)
+{
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		set_motor_duty_cycle_ceiling(i, PIDQ_FROM_INT(PID_OUTPUT_MAX));
+	}
+}
+
+void set_motor_duty_cycle_ceiling(uint8_t index, pidq_value_t ceiling)
+{
+	g_motors[index]->duty_cycle_ceiling = ceiling;
+	
+#if defined(USE_FIXED_POINT_PID)
+	PIDBank_SetOutputMax(&g_pid_bank, index, ceiling);
+#else
+	PID_SetOutputMax(&g_motors[index]->pid, PIDQ_TO_FLOAT(ceiling));
+#endif
+}
+#endif
+
+// Reads one segment (MOTION_SEGMENT_PAYLOAD_SIZE bytes) from received payload
+void parse_motion_segment(const uint8_t* p_payload, motion_segment_t* p_segment)
+{
+	uint32_t duration_ms = 0;
+	
+#define PARSE_MOTOR_SETPOINT(N) \
+	memcpy((void*)&p_segment->rps[BOARD_MOTOR_INDEX(N)], (const void*)(p_payload + BOARD_MOTOR_INDEX(N) * sizeof(float)), sizeof(float));
+	
+	BOARD_FOR_EACH_MOTOR(PARSE_MOTOR_SETPOINT)
+#undef PARSE_MOTOR_SETPOINT
+	
+	memcpy((void*)&duration_ms, (const void*)(p_payload + BOARD_MOTOR_COUNT * sizeof(float)), sizeof(uint32_t));
+	
+	p_segment->duration_ms = limit_duration_ms(duration_ms);
+}
+
+// UINT32_MAX will be used in place of `float`'s INFINITY (segment never
+// ends), longer finite durations are limited to software timer range (~24 days)
+uint32_t limit_duration_ms(uint32_t duration_ms)
+{
+	if (duration_ms != UINT32_MAX && duration_ms > INT32_MAX)
+	{
+		return INT32_MAX;
+	}
+	
+	return duration_ms;
+}
+
+// Arms command timer to expire `duration_ms` after `start_ms`
+// (stops it for endless segment)
+void do_start_command_timer(uint32_t start_ms, uint32_t duration_ms)
+{
+	if (duration_ms == UINT32_MAX)
+	{
+		SoftTimer_Stop(&g_soft_timers, &g_command_timer);
+		return;
+	}
+	
+	SoftTimer_StartAt(&g_soft_timers, &g_command_timer, start_ms + duration_ms, 0);
+}
+
+// Starts executing segment from standstill (PID timer is paused).
+void do_start_motion_segment(const motion_segment_t* p_segment)
+{
+	// Identification or auto-tuning run is ended, command drives motors closed-loop
+	do_finish_sysid();
+	do_finish_autotune();
+	
+	// Timed segment replaces position command
+	g_position.is_active = 0;
+	
+	// Running controllers already continue from current duty cycle and
+	// setpoints, ramps take them to new targets (velocity form PI)
+	if (!g_flag_command_running)
+	{
+		do_seed_motor_pids();
+	}
+	
+	BOARD_FOR_EACH_MOTOR(RESET_MOTOR_AVERAGE_RPS)
+	
+	configure_motors_for_action(p_segment->rps);
+	
+	const uint32_t now_ms = system_clock_get_ms();
+	do_start_command_timer(now_ms, p_segment->duration_ms);
+	
+#if !defined(USE_COMPACT_ODOMETRY)
+	g_odometry_last_broadcast_ms = now_ms;
+	SoftTimer_StartAt(&g_soft_timers, &g_odometry_timer, now_ms + ODOMETRY_BROADCAST_PERIOD_MS, ODOMETRY_BROADCAST_PERIOD_MS);
+#endif
+	
+	g_stalled_motors_mask = 0;
+	g_pid_wake_latency_max_ticks = 0;
+	
+#if defined(USE_QUADRATURE_ENCODER)
+	// Restart estimation windows (PID timer was paused between commands)
+	do_update_quadrature_estimates();
+#endif
+	
+	do_on_telemetry_event(TELEMETRY_TRIGGER_COMMAND_START);
+	
+	// PID timer was paused, time since last PID execution is not a PID period
+	g_pid_timing.has_previous_tick = 0;
+	
+	g_flag_command_running = 1;
+	resume_pid_timer();
+}
+
+// Switches to next segment when previous one ended (command timer expired).
+// PID timer keeps running and PID state is kept, so there is no gap
+// between segments. Only setpoints and duration change.
+void do_continue_motion_segment(const motion_segment_t* p_segment)
+{
+	// Segment starts at end of previous one (not when this task ran),
+	// so segment boundaries do not accumulate task latency
+	do_start_command_timer(g_command_timer.deadline_ms, p_segment->duration_ms);
+	
+	// Odometry averages describe current segment only
+	BOARD_FOR_EACH_MOTOR(RESET_MOTOR_AVERAGE_RPS)
+	
+	configure_motors_for_action(p_segment->rps);
+}
+
+// Sets speed targets of motors moving to `MOVE_DISTANCE` targets, called
+// every PID tick before ramps are advanced. Speed is proportional to
+// remaining distance (See. POSITION_KP), so motor slows down near target,
+// and ramps (`SET_RAMP`) limit acceleration. Motor is stopped on the tick
+// its target is reached or passed, it never reverses to correct overshoot
+// (Hall position is only valid while direction is known).
+void do_advance_position_loop(void)
+{
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		if (g_position.reached_mask & (1 << i))
+		{
+			continue;
+		}
+		
+		const int32_t remaining = g_position.targets[i] - get_motor_position(g_motors[i]);
+		
+		if (remaining == 0 || (remaining < 0) != (g_position.directions[i] < 0))
+		{
+			g_position.reached_mask |= (1 << i);
+			setpoint_ramp_reset(&g_motors[i]->setpoint_ramp, 0);
+			continue;
+		}
+		
+		float rps = fabs(POSITION_KP * (float)remaining / POSITION_TICKS_PER_ROTATION);
+		
+		if (rps > g_position.max_rps)
+		{
+			rps = g_position.max_rps;
+		}
+		else if (rps < POSITION_MIN_RPS)
+		{
+			rps = POSITION_MIN_RPS;
+		}
+		
+		setpoint_ramp_set_target(&g_motors[i]->setpoint_ramp, PIDQ_FROM_FLOAT(g_position.directions[i] * rps));
+	}
+}
+
+// Ends `MOVE_DISTANCE` when every motor reached its target. Queued
+// segments follow without stopping PID, otherwise command completes.
+void do_on_position_reached(void)
+{
+	g_position.is_active = 0;
+	
+	motion_segment_t segment;
+	
+	if (segment_queue_pop(&g_segment_queue, &segment))
+	{
+		do_start_motion_segment(&segment);
+		return;
+	}
+	
+	g_flag_command_running = 0;
+	do_on_command_complete();
+}
+
+// `MOVE_DISTANCE` payload is (replaces whatever is being executed, like `COMMAND`,
+// offsets of BOARD_MOTOR_COUNT = 3, fields follow distances of all board motors):
+// [0..11]  distance of motor 1..3 in encoder ticks (int32_t, signed, See. POSITION_TICKS_PER_ROTATION)
+// [12..15] maximum speed [rps] (float, absolute value)
+// [16..19] timeout [ms] (uint32_t, UINT32_MAX = none)
+// Command ends with `FINISHED` when every motor stopped on its target,
+// or when timeout expires first (e.g. motor stalled, See. FINISHED stall mask).
+void on_received_msg_move_distance(void)
+{
+	if (g_received_frame.len_bytes < MOVE_DISTANCE_PAYLOAD_SIZE)
+	{
+		do_on_link_error(LINK_ERROR_INVALID_LENGTH);
+		return;
+	}
+	
+	int32_t distances[BOARD_MOTOR_COUNT];
+	float max_rps = 0;
+	
+	// Zero speed segment starts command, position loop sets speeds from first PID tick
+	motion_segment_t segment;
+	memset(&segment, 0, sizeof(segment));
+	
+	memcpy((void*)distances,			(const void*)(g_received_frame.p_payload), sizeof(distances));
+	memcpy((void*)&max_rps,				(const void*)(g_received_frame.p_payload + sizeof(distances)), sizeof(float));
+	memcpy((void*)&segment.duration_ms,	(const void*)(g_received_frame.p_payload + sizeof(distances) + sizeof(float)), sizeof(uint32_t));
+	
+	segment.duration_ms = limit_duration_ms(segment.duration_ms);
+	
+	segment_queue_init(&g_segment_queue);
+	do_start_motion_segment(&segment);
+	
+#if !defined(USE_QUADRATURE_ENCODER)
+	do_update_hall_positions();
+#endif
+	
+	g_position.reached_mask = 0;
+	g_position.max_rps = fabs(max_rps);
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		const int32_t distance = distances[i];
+		
+		g_position.targets[i] = get_motor_position(g_motors[i]) + distance;
+		g_position.directions[i] = (distance < 0) ? -1 : 1;
+		
+		if (distance == 0)
+		{
+			g_position.reached_mask |= (1 << i);
+		}
+	}
+	
+	g_position.is_active = 1;
+}
+
+// Sends `ACK` message used for flow control of `SEGMENTS`, payload is:
+// [0] number of segments accepted from last frame (0 = frame rejected)
+// [1] number of segments waiting in queue
+// [2] number of free slots in queue
+void do_send_segments_ack(uint8_t n_accepted)
+{
+	uint8_t payload[3];
+	payload[0] = n_accepted;
+	payload[1] = segment_queue_count(&g_segment_queue);
+	payload[2] = segment_queue_free_space(&g_segment_queue);
+	
+	stxetx_frame_t frame;
+	stxetx_init_empty_frame(&frame);
+	frame.msg_type = MSG_TYPE_ACK;
+	stxetx_add_payload(&frame, payload, sizeof(payload));
+	usart_send_frame(frame);
+}
+
+// `COMMAND` replaces whatever is being executed (queued segments are discarded)
+void on_received_msg_command(void)
+{		
+	if (g_received_frame.len_bytes < MOTION_SEGMENT_PAYLOAD_SIZE)
+	{
+		do_on_link_error(LINK_ERROR_INVALID_LENGTH);
+		return;
+	}
+	
+	motion_segment_t segment;
+	parse_motion_segment(g_received_frame.p_payload, &segment);
+	do_command_motion_segment(&segment);
+}
+
+// Starts segment of `COMMAND` or `BODY_VELOCITY` (queued segments are discarded)
+void do_command_motion_segment(const motion_segment_t* p_segment)
+{
+	// Staged segments of all nodes are started together by broadcast `SYNC_APPLY`
+	if (g_received_frame.flags & FLAG_SYNC)
+	{
+		g_staged_segment = *p_segment;
+		g_flag_segment_staged = 1;
+		return;
+	}
+	
+	segment_queue_init(&g_segment_queue);
+	do_start_motion_segment(p_segment);
+}
+
+// `KINEMATICS_CONFIG` payload is:
+// [0]     matrix (kinematics_matrix_e)
+// [1..36] 3x3 matrix, row-major (int32_t, Q16.16):
+//         KINEMATICS_MATRIX_INVERSE rows are wheels 1..3, columns vx [m/s], vy [m/s], omega [rad/s]
+//         KINEMATICS_MATRIX_FORWARD rows are vx, vy, omega, columns wheels 1..3 [rps]
+// Host precomputes both matrices (forward is inverse of inverse, or its
+// pseudo-inverse), payload holds one of them. Pose is reset to origin.
+// Unknown matrix is rejected with `KINEMATICS_CONFIG` START_STATUS_INVALID_ARGUMENT
+// (See. do_send_start_status()), accepted frames are not answered.
+void on_received_msg_kinematics_config(void)
+{
+	if (g_received_frame.len_bytes < KINEMATICS_CONFIG_PAYLOAD_SIZE)
+	{
+		do_on_link_error(LINK_ERROR_INVALID_LENGTH);
+		return;
+	}
+	
+	if (g_received_frame.p_payload[0] > KINEMATICS_MATRIX_FORWARD)
+	{
+		do_send_start_status(MSG_TYPE_KINEMATICS_CONFIG, START_STATUS_INVALID_ARGUMENT);
+		return;
+	}
+	
+	pidq_value_t matrix[3][3];
+	memcpy((void*)matrix, (const void*)(g_received_frame.p_payload + 1), sizeof(matrix));
+	
+	if (g_received_frame.p_payload[0] == KINEMATICS_MATRIX_INVERSE)
+	{
+		kinematics_set_inverse(&g_kinematics, matrix);
+	}
+	else
+	{
+		kinematics_set_forward(&g_kinematics, matrix);
+	}
+	
+	g_kinematics_matrix_mask |= (1 << g_received_frame.p_payload[0]);
+	kinematics_reset_pose(&g_kinematics);
+}
+
+// `BODY_VELOCITY` payload is (executed like `COMMAND`, also with FLAG_SYNC):
+// [0..1] vx [mm/s] (int16_t, body frame)
+// [2..3] vy [mm/s] (int16_t, body frame)
+// [4..5] omega [mrad/s] (int16_t, counter-clockwise)
+// [6..9] duration [ms] (uint32_t, UINT32_MAX = segment never ends)
+// Wheel speeds are computed with inverse matrix. Until it is configured
+// (See. `KINEMATICS_CONFIG`), frame is ignored and answered with `BODY_VELOCITY`
+// START_STATUS_NOT_CONFIGURED (See. do_send_start_status()), accepted frames
+// are not answered (like `COMMAND`).
+void on_received_msg_body_velocity(void)
+{
+	if (g_received_frame.len_bytes < BODY_VELOCITY_PAYLOAD_SIZE)
+	{
+		do_on_link_error(LINK_ERROR_INVALID_LENGTH);
+		return;
+	}
+	
+	if (!(g_kinematics_matrix_mask & (1 << KINEMATICS_MATRIX_INVERSE)))
+	{
+		do_send_start_status(MSG_TYPE_BODY_VELOCITY, START_STATUS_NOT_CONFIGURED);
+		return;
+	}
+	
+	int16_t velocity_milli[3];
+	uint32_t duration_ms = 0;
+	
+	memcpy((void*)velocity_milli,	(const void*)(g_received_frame.p_payload + 0), sizeof(velocity_milli));
+	memcpy((void*)&duration_ms,		(const void*)(g_received_frame.p_payload + 6), sizeof(uint32_t));
+	
+	pidq_value_t velocity[3];
+	
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		// mm/s -> m/s (mrad/s -> rad/s), Q16.16
+		velocity[i] = ((pidq_value_t)velocity_milli[i] * PIDQ_ONE) / 1000;
+	}
+	
+	pidq_value_t wheel_rps[KINEMATICS_WHEEL_COUNT];
+	kinematics_get_wheel_rps(&g_kinematics, velocity, wheel_rps);
+	
+	motion_segment_t segment;
+	memset(&segment, 0, sizeof(segment));
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT && i < KINEMATICS_WHEEL_COUNT; i++)
+	{
+		segment.rps[i] = PIDQ_TO_FLOAT(wheel_rps[i]);
+	}
+	
+	segment.duration_ms = limit_duration_ms(duration_ms);
+	do_command_motion_segment(&segment);
+}
+
+// `POSE` (no payload) is answered with `POSE` (See. do_send_pose())
+void on_received_msg_pose(void)
+{
+	do_send_pose();
+}
+
+// Integrates measured wheel speeds into pose, called every PID tick of a command
+void do_advance_pose(void)
+{
+	pidq_value_t wheel_rps[KINEMATICS_WHEEL_COUNT] = { 0 };
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT && i < KINEMATICS_WHEEL_COUNT; i++)
+	{
+		wheel_rps[i] = get_motor_signed_rps(g_motors[i]);
+	}
+	
+	kinematics_advance(&g_kinematics, wheel_rps);
+}
+
+// Sends `POSE` message, payload is:
+// [0..3]   x [m] (int32_t, Q16.16, world frame, origin at last `KINEMATICS_CONFIG`)
+// [4..7]   y [m] (int32_t, Q16.16)
+// [8..9]   heading (uint16_t, 65536 = full turn, counter-clockwise)
+// [10..15] vx [mm/s], vy [mm/s], omega [mrad/s] of last PID tick (int16_t, body frame, saturated)
+// Sent in place of `ODOMETRY` once forward matrix is configured.
+void do_send_pose(void)
+{
+	const pidq_value_t position[2] = {
+		KINEMATICS_GET_POSITION(&g_kinematics, KINEMATICS_X),
+		KINEMATICS_GET_POSITION(&g_kinematics, KINEMATICS_Y)
+	};
+	const uint16_t heading = (uint16_t)(g_kinematics.heading >> 16);
+	
+	int16_t velocity_milli[3];
+	
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		velocity_milli[i] = convert_q16_16_to_milli(g_kinematics.velocity[i]);
+	}
+	
+	stxetx_encoder_t encoder;
+	usart_frame_begin(&encoder, MSG_TYPE_POSE, 0);
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)position,		sizeof(position));
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)&heading,		sizeof(uint16_t));
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)velocity_milli,	sizeof(velocity_milli));
+	usart_frame_end(&encoder);
+}
+
+#if defined(USE_CURRENT_SENSING)
+// `CURRENT_LIMIT` payload is:
+// [0..1] [OPT] current limit of every motor [mA] (uint16_t, 0 = no limit), no payload = query only
+// Answered with `CURRENT_LIMIT`:
+// [0..1] current limit [mA] (uint16_t)
+// [2...] mean current of every motor over last PID tick [mA] (uint16_t)
+// New limit applies from next PID tick, also to command being executed.
+void on_received_msg_current_limit(void)
+{
+	if (g_received_frame.len_bytes > 0)
+	{
+		if (g_received_frame.len_bytes < sizeof(uint16_t))
+		{
+			do_on_link_error(LINK_ERROR_INVALID_LENGTH);
+			return;
+		}
+		
+		memcpy((void*)&g_current_limit_ma, (const void*)g_received_frame.p_payload, sizeof(uint16_t));
+		
+		if (g_current_limit_ma == 0)
+		{
+			reset_current_limits();
+		}
+	}
+	
+	uint16_t currents_ma[MOTOR_COUNT];
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		currents_ma[i] = g_motors[i]->current_ma;
+	}
+	
+	stxetx_encoder_t encoder;
+	usart_frame_begin(&encoder, MSG_TYPE_CURRENT_LIMIT, 0);
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)&g_current_limit_ma,	sizeof(uint16_t));
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)currents_ma,			sizeof(currents_ma));
+	usart_frame_end(&encoder);
+}
+#endif
+
+// `SET_BAUD` payload is:
+// [0] [OPT] requested speed (usart_speed_e), no payload = query only
+// Answered with `SET_BAUD` at current speed:
+// [0] speed used after this reply (usart_speed_e)
+// [1] 1 if requested speed was accepted, 0 otherwise
+// [2] mask of supported speeds (bit n = usart_speed_e n), speeds with baud
+//     rate error above USART_BAUD_MAX_ERROR_PERMILLE are not supported
+// Accepted speed is applied after reply is transmitted (USART0_TX_vect),
+// speed is kept if reply does not fit in transmit queue. Host then switches
+// its port and must send a frame at the new speed within
+// USART_SPEED_CONFIRM_TIMEOUT_MS, otherwise node goes back to previous speed.
+// Broadcast requests are ignored (switch could not be acknowledged).
+void on_received_msg_set_baud(void)
+{
+	if (g_flag_transmit_muted)
+	{
+		return;
+	}
+	
+	const uint8_t is_accepted = g_received_frame.len_bytes >= 1
+		&& g_received_frame.p_payload[0] < USART_SPEED_COUNT
+		&& (USART_SUPPORTED_SPEED_MASK & (1 << g_received_frame.p_payload[0]))
+		&& g_received_frame.p_payload[0] != g_usart_speed.speed;
+	
+	uint8_t payload[3];
+	payload[0] = is_accepted ? g_received_frame.p_payload[0] : g_usart_speed.speed;
+	payload[1] = is_accepted;
+	payload[2] = USART_SUPPORTED_SPEED_MASK;
+	
+	stxetx_encoder_t encoder;
+	usart_frame_begin(&encoder, MSG_TYPE_SET_BAUD, 0);
+	stxetx_encoder_push_bytes(&encoder, payload, sizeof(payload));
+	
+	// Dropped reply, host was not told about the switch
+	if (usart_frame_finish(&encoder) != STXETX_ERROR_NO_ERROR)
+	{
+		return;
+	}
+	
+	// Switch is requested and reply is published together, so USART0_UDRE_vect
+	// neither drains earlier frames with switch pending nor sends the last byte
+	// of reply without it
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (is_accepted)
+		{
+			g_usart_speed.pending_speed = payload[0];
+		}
+		
+		usart_frame_commit();
+	}
+}
+
+// `SYNC_APPLY` (no payload, usually sent to STXETX_ADDRESS_BROADCAST) starts
+// segment of last `COMMAND` received with FLAG_SYNC. Nodes without staged
+// segment ignore it. One frame starts motors of all boards on the bus at once.
+void on_received_msg_sync_apply(void)
+{
+	if (!g_flag_segment_staged)
+	{
+		return;
+	}
+	
+	g_flag_segment_staged = 0;
+	
+	segment_queue_init(&g_segment_queue);
+	do_start_motion_segment(&g_staged_segment);
+}
+
+// `SEGMENTS` appends one or more segments to segment queue.
+// Frame is either accepted whole or rejected when it does not fit.
+// Every frame is answered with `ACK`, so host can keep the queue
+// filled without overflowing it.
+void on_received_msg_segments(void)
+{
+	const uint8_t n_segments = g_received_frame.len_bytes / MOTION_SEGMENT_PAYLOAD_SIZE;
+	
+	if (n_segments == 0
+		|| (g_received_frame.len_bytes % MOTION_SEGMENT_PAYLOAD_SIZE) != 0
+		|| n_segments > segment_queue_free_space(&g_segment_queue))
+	{
+		do_send_segments_ack(0);
+		return;
+	}
+	
+	for (uint8_t i = 0; i < n_segments; i++)
+	{
+		motion_segment_t segment;
+		parse_motion_segment(g_received_frame.p_payload + i * MOTION_SEGMENT_PAYLOAD_SIZE, &segment);
+		segment_queue_push(&g_segment_queue, segment);
+	}
+	
+	if (!g_flag_command_running)
+	{
+		motion_segment_t segment;
+		segment_queue_pop(&g_segment_queue, &segment);
+		do_start_motion_segment(&segment);
+	}
+	
+	do_send_segments_ack(n_segments);
+}
+
+void on_received_msg_stop(void)
+{
+	g_flag_segment_staged = 0;
+	do_finish_sysid();
+	do_finish_autotune();
+	segment_queue_init(&g_segment_queue);
+	g_flag_command_running = 0;
+	do_on_command_complete();
+}
+
+// `SET_RAMP` payload is:
+// [0..3] float acceleration limit [rps/s] (0 = setpoints are applied as steps)
+// [4..7] float jerk limit [rps/s^2] (0 = trapezoidal profile)
+// New limits apply from next PID tick, also to command being executed.
+void on_received_msg_set_ramp(void)
+{
+	if (g_received_frame.len_bytes < 2 * sizeof(float))
+	{
+		do_on_link_error(LINK_ERROR_INVALID_LENGTH);
+		return;
+	}
+	
+	float acceleration_rps_per_s = 0;
+	float jerk_rps_per_s2 = 0;
+	
+	memcpy((void*)&acceleration_rps_per_s,	(const void*)(g_received_frame.p_payload + 0), sizeof(float));
+	memcpy((void*)&jerk_rps_per_s2,			(const void*)(g_received_frame.p_payload + 4), sizeof(float));
+	
+	configure_setpoint_ramps(acceleration_rps_per_s, jerk_rps_per_s2);
+}
+
+// Answers request `msg_type` with message of the same type, payload is:
+// [0] status (start_status_e)
+void do_send_start_status(uint8_t msg_type, uint8_t status)
+{
+	stxetx_encoder_t encoder;
+	usart_frame_begin(&encoder, msg_type, 0);
+	stxetx_encoder_push_bytes(&encoder, &status, sizeof(uint8_t));
+	usart_frame_end(&encoder);
+}
+
+// `TELEMETRY_ARM` payload is:
+// [0]    decimation, every N-th PID tick is recorded (0 is treated as 1)
+// [1]    trigger (telemetry_trigger_e)
+// [2..3] [OPT] |error| threshold of TELEMETRY_TRIGGER_ERROR_ABOVE in RPS (int16_t, Q8.8)
+// Previously captured records are discarded. Records are captured only while
+// command is running, recording stops when TELEMETRY_RECORD_COUNT records are captured.
+// Answered with `TELEMETRY_ARM` (See. do_send_start_status()), unknown trigger
+// is rejected with START_STATUS_INVALID_ARGUMENT.
+void on_received_msg_telemetry_arm(void)
+{
+	if (g_received_frame.len_bytes < 2)
+	{
+		do_on_link_error(LINK_ERROR_INVALID_LENGTH);
+		return;
+	}
+	
+	if (g_received_frame.p_payload[1] > TELEMETRY_TRIGGER_ERROR_ABOVE)
+	{
+		do_send_start_status(MSG_TYPE_TELEMETRY_ARM, START_STATUS_INVALID_ARGUMENT);
+		return;
+	}
+	
+	int16_t error_threshold_q8_8 = 0;
+	
+	if (g_received_frame.len_bytes >= 2 + sizeof(int16_t))
+	{
+		memcpy((void*)&error_threshold_q8_8, (const void*)(g_received_frame.p_payload + 2), sizeof(int16_t));
+	}
+	
+	telemetry_ring_init(&g_telemetry_ring);
+	
+	g_telemetry.decimation = (g_received_frame.p_payload[0] == 0) ? 1 : g_received_frame.p_payload[0];
+	g_telemetry.decimation_counter = 0;
+	g_telemetry.trigger = g_received_frame.p_payload[1];
+	g_telemetry.error_threshold = (pidq_value_t)((error_threshold_q8_8 < 0) ? -error_threshold_q8_8 : error_threshold_q8_8) * 256;
+	
+	g_telemetry.state = (g_telemetry.trigger == TELEMETRY_TRIGGER_IMMEDIATE)
+		? TELEMETRY_STATE_RECORDING
+		: TELEMETRY_STATE_ARMED;
+	
+	do_send_start_status(MSG_TYPE_TELEMETRY_ARM, START_STATUS_STARTED);
+}
+
+// `TELEMETRY_DUMP` (no payload) stops recording and streams captured
+// records at lowest priority (See. do_dump_telemetry_frame()).
+void on_received_msg_telemetry_dump(void)
+{
+	g_telemetry.state = TELEMETRY_STATE_DUMPING;
+	Scheduler_Post(&g_scheduler, TASK_BULK_DUMP);
+}
+
+// `EVENT_LOG_DUMP` (no payload) streams persistent event log at lowest
+// priority, after telemetry dump if both are requested (See. do_dump_event_log_frame()).
+// Repeated request restarts the dump from oldest record.
+void on_received_msg_event_log_dump(void)
+{
+	g_event_log_dump.slot_index = 0;
+	g_event_log_dump.is_dumping = 1;
+	Scheduler_Post(&g_scheduler, TASK_BULK_DUMP);
+}
+
+// `STREAM_SUBSCRIBE` payload is up to STREAM_CHANNEL_COUNT pairs, pair c is
+// channel c (stream_channel_e), missing pairs unsubscribe the channel:
+// [2c]   rate divider, channel is sent every N-th PID tick (0 = off)
+// [2c+1] motor mask, bit i selects motor i
+// Replaces previous subscription, all channels restart counting (channels
+// with equal divider are sent in the same frames).
+void on_received_msg_stream_subscribe(void)
+{
+	memset(&g_stream, 0, sizeof(g_stream));
+	
+	for (uint8_t c = 0; c < STREAM_CHANNEL_COUNT && 2 * c + 1 < g_received_frame.len_bytes; c++)
+	{
+		g_stream.dividers[c] = g_received_frame.p_payload[2 * c];
+		g_stream.motor_masks[c] = g_received_frame.p_payload[2 * c + 1] & BOARD_MOTOR_MASK;
+	}
+}
+
+// `PROFILER_QUERY` payload is [0] [OPT] 1 = reset statistics after reading.
+// Replies with `PROFILER_DATA` message, payload is:
+// [0]    PROFILER_MODE
+// [1]    number of probes N (0 unless PROFILER_MODE_CYCLES)
+// [2...] N x { uint16_t min, max, mean, number of samples } in CPU cycles
+//        (min = max = mean = 0 for probes without samples), index = probe_id_e
+void on_received_msg_profiler_query(void)
+{
+	const uint8_t n_probes = (PROFILER_MODE == PROFILER_MODE_CYCLES) ? PROBE_COUNT : 0;
+	const uint8_t mode = PROFILER_MODE;
+	
+	stxetx_encoder_t encoder;
+	usart_frame_begin(&encoder, MSG_TYPE_PROFILER_DATA, 0);
+	stxetx_encoder_push_bytes(&encoder, &mode, sizeof(uint8_t));
+	stxetx_encoder_push_bytes(&encoder, &n_probes, sizeof(uint8_t));
+	
+	for (uint8_t i = 0; i < n_probes; i++)
+	{
+		profiler_probe_t probe;
+		Profiler_GetProbe(i, &probe);
+		
+		uint16_t values[4] = {0, 0, 0, 0};
+		
+		if (probe.n_samples != 0)
+		{
+			values[0] = probe.min_cycles;
+			values[1] = probe.max_cycles;
+			values[2] = (uint16_t)(probe.total_cycles / probe.n_samples);
+			values[3] = probe.n_samples;
+		}
+		
+		stxetx_encoder_push_bytes(&encoder, (const uint8_t*)values, sizeof(values));
+	}
+	
+	usart_frame_end(&encoder);
+	
+	if (g_received_frame.len_bytes >= 1 && g_received_frame.p_payload[0] == 1)
+	{
+		Profiler_Reset();
+	}
+}
+
+// Converts TIMER 1 ticks to microseconds saturated to uint16_t
+uint16_t convert_pulse_ticks_to_us_u16(uint32_t ticks)
+{
+	const uint32_t us = ticks / (F_CPU / 1000000UL);
+	return (us > UINT16_MAX) ? UINT16_MAX : (uint16_t)us;
+}
+
+// `DIAGNOSTICS` request payload is [0] [OPT] 1 = reset statistics after reading.
+// Replies with `DIAGNOSTICS` message, payload is:
+// [0..3]   PID executions (uint32_t)
+// [4..5]   missed (merged) PID ticks (uint16_t, saturated)
+// [6..7]   PID overruns, execution ended after next tick was due (uint16_t, saturated)
+// [8..9]   min time between PID executions in microseconds (uint16_t, 0 if unknown)
+// [10..11] max time between PID executions in microseconds (uint16_t)
+// [12..13] max PID tick to PID task latency in microseconds (uint16_t)
+// [14..15] max PID execution time in microseconds (uint16_t)
+// [16..17] received bytes dropped because receive queue was full (uint16_t)
+// [18..19] frames dropped because transmit queue was full (uint16_t)
+// [20..31] dropped received frames per link_error_e cause (uint16_t[LINK_ERROR_COUNT], saturated)
+// Queue and link counters are reset together with PID statistics.
+void on_received_msg_diagnostics(void)
+{
+	uint16_t missed_ticks_count = 0;
+	uint16_t queue_counts[2] = {0};
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		missed_ticks_count = g_pid_missed_ticks_count;
+		queue_counts[0] = g_receive_dropped_bytes_count;
+		queue_counts[1] = g_transmit_dropped_frames_count;
+	}
+	
+	const uint16_t values[6] = {
+		missed_ticks_count,
+		g_pid_timing.overrun_count,
+		(g_pid_timing.dt_min_ticks == UINT32_MAX) ? 0 : convert_pulse_ticks_to_us_u16(g_pid_timing.dt_min_ticks),
+		convert_pulse_ticks_to_us_u16(g_pid_timing.dt_max_ticks),
+		convert_pulse_ticks_to_us_u16(g_pid_wake_latency_max_ticks),
+		convert_pulse_ticks_to_us_u16(g_pid_timing.execution_max_ticks)
+	};
+	
+	stxetx_encoder_t encoder;
+	usart_frame_begin(&encoder, MSG_TYPE_DIAGNOSTICS, 0);
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)&g_pid_timing.executed_count, sizeof(uint32_t));
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)values, sizeof(values));
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)queue_counts, sizeof(queue_counts));
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)g_link_error_counts, sizeof(g_link_error_counts));
+	usart_frame_end(&encoder);
+	
+	if (g_received_frame.len_bytes >= 1 && g_received_frame.p_payload[0] == 1)
+	{
+		reset_pid_timing_stats();
+		
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			g_receive_dropped_bytes_count = 0;
+			g_transmit_dropped_frames_count = 0;
+		}
+		
+		memset(g_link_error_counts, 0, sizeof(g_link_error_counts));
+	}
+}
+
+// Captures period just published by encoder ISR into `g_sysid_ring`.
+// Called from encoder ISRs, costs one comparison unless identification runs.
+inline void do_capture_sysid_edge(hall_encoder_t* hEncoder)
+{
+	if (g_sysid.state != SYSID_STATE_RUNNING)
+	{
+		return;
+	}
+	
+	const uint8_t i = hEncoder->motor_index;
+	
+	if (!(g_sysid.motor_mask & (1 << i)))
+	{
+		return;
+	}
+	
+	if (++g_sysid.edge_decimation_counters[i] < g_sysid.edge_decimation)
+	{
+		return;
+	}
+	
+	g_sysid.edge_decimation_counters[i] = 0;
+	
+	sysid_sample_t sample;
+	sample.motor_index = i;
+	sample.duty_cycle = g_motors[i]->duty_cycle;
+	sample.period_ticks = hEncoder->captured_period_ticks;
+	
+	if (!sysid_ring_push(&g_sysid_ring, sample))
+	{
+		if (g_sysid.dropped_samples_count != UINT16_MAX)
+		{
+			++g_sysid.dropped_samples_count;
+		}
+		return;
+	}
+	
+	Scheduler_PostFromISR(&g_scheduler, TASK_SYSID_STREAM);
+}
+
+// `SYSID_START` payload is:
+// [0]    mask of excited motors (bit i = motor i + 1), all are identified in parallel
+// [1]    excitation (sysid_excitation_e)
+// [2]    low duty cycle [%]
+// [3]    high duty cycle [%] (both limited to PID_OUTPUT_MAX)
+// [4]    STEP: PID ticks at low duty cycle before step
+//        PRBS: PID ticks per PRBS bit (0 is treated as 1)
+// [5]    edge decimation, every N-th encoder edge of a motor is captured (0 is treated as 1)
+// [6..7] duration in milliseconds (uint16_t)
+// Answered with `SYSID_START` (See. do_send_start_status()), request is rejected
+// with START_STATUS_BUSY while command or previous run is active and with
+// START_STATUS_INVALID_ARGUMENT for unknown excitation. Motors run open loop
+// (PID controllers and setpoint ramps are bypassed) in positive direction.
+// Captured edges are streamed in `SYSID_DATA` frames while running,
+// `STOP` or `COMMAND` ends run early (See. task_sysid_stream()).
+// The first edge of a motor which starts from standstill has no valid period.
+void on_received_msg_sysid_start(void)
+{
+	if (g_received_frame.len_bytes < 8)
+	{
+		do_on_link_error(LINK_ERROR_INVALID_LENGTH);
+		return;
+	}
+	
+	if (g_flag_command_running || g_sysid.state != SYSID_STATE_IDLE || g_autotune.is_running)
+	{
+		do_send_start_status(MSG_TYPE_SYSID_START, START_STATUS_BUSY);
+		return;
+	}
+	
+	if (g_received_frame.p_payload[1] > SYSID_EXCITATION_PRBS)
+	{
+		do_send_start_status(MSG_TYPE_SYSID_START, START_STATUS_INVALID_ARGUMENT);
+		return;
+	}
+	
+	const uint8_t* p_payload = g_received_frame.p_payload;
+	uint16_t duration_ms = 0;
+	
+	memcpy((void*)&duration_ms, (const void*)(p_payload + 6), sizeof(uint16_t));
+	
+	// Encoder ISRs do not push while state is idle
+	sysid_ring_init(&g_sysid_ring);
+	
+	g_sysid.motor_mask = p_payload[0] & ((1 << MOTOR_COUNT) - 1);
+	g_sysid.excitation = p_payload[1];
+	g_sysid.duty_cycle_low = (p_payload[2] > PID_OUTPUT_MAX) ? PID_OUTPUT_MAX : p_payload[2];
+	g_sysid.duty_cycle_high = (p_payload[3] > PID_OUTPUT_MAX) ? PID_OUTPUT_MAX : p_payload[3];
+	g_sysid.bit_period_ticks = (p_payload[4] == 0) ? 1 : p_payload[4];
+	g_sysid.bit_period_counter = 0;
+	g_sysid.edge_decimation = (p_payload[5] == 0) ? 1 : p_payload[5];
+	g_sysid.elapsed_pid_ticks = 0;
+	g_sysid.duration_pid_ticks = (uint32_t)((float)duration_ms * (SAMPLING_FREQUENCY / 1000.0f));
+	g_sysid.dropped_samples_count = 0;
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		g_sysid.edge_decimation_counters[i] = 0;
+		g_sysid.prbs_states[i] = SYSID_PRBS_SEED(i);
+		g_motors[i]->duty_cycle = 0;
+		mean_accumulator_reset(&g_motors[i]->hall_encoder.average_rps);
+#if defined(SYSID_FIT_MODEL)
+		sysid_fit_init(&g_sysid.fits[i]);
+#endif
+	}
+	
+	// Only direction pins matter, controllers do not run during identification
+	pidq_value_t directions[MOTOR_COUNT];
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		directions[i] = (g_sysid.motor_mask & (1 << i)) ? PIDQ_ONE : 0;
+	}
+	
+	apply_motor_setpoints(directions);
+	
+	g_pid_timing.has_previous_tick = 0;
+	
+	g_sysid.state = SYSID_STATE_RUNNING;
+	resume_pid_timer();
+	
+	do_send_start_status(MSG_TYPE_SYSID_START, START_STATUS_STARTED);
+}
+
+// Applies excitation of current PID tick (runs instead of do_advance_pids()
+// during identification). With SYSID_FIT_MODEL also feeds model fit with
+// mean unfiltered speed during past PID period and the new duty cycle.
+void do_advance_sysid(void)
+{
+	if (g_sysid.elapsed_pid_ticks >= g_sysid.duration_pid_ticks)
+	{
+		do_finish_sysid();
+		return;
+	}
+	
+	const uint8_t is_new_bit = (g_sysid.bit_period_counter == 0);
+	
+	if (++g_sysid.bit_period_counter >= g_sysid.bit_period_ticks)
+	{
+		g_sysid.bit_period_counter = 0;
+	}
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		if (!(g_sysid.motor_mask & (1 << i)))
+		{
+			continue;
+		}
+		
+		uint8_t duty_cycle = g_motors[i]->duty_cycle;
+		
+		if (g_sysid.excitation == SYSID_EXCITATION_STEP)
+		{
+			duty_cycle = (g_sysid.elapsed_pid_ticks < g_sysid.bit_period_ticks)
+				? g_sysid.duty_cycle_low
+				: g_sysid.duty_cycle_high;
+		}
+		else if (is_new_bit)
+		{
+			duty_cycle = sysid_prbs_next(&g_sysid.prbs_states[i])
+				? g_sysid.duty_cycle_high
+				: g_sysid.duty_cycle_low;
+		}
+		
+#if defined(SYSID_FIT_MODEL)
+		hall_encoder_t* hEncoder = &g_motors[i]->hall_encoder;
+		
+		// Filter pipeline adds lag, edges of past period are averaged instead
+		const pidq_value_t rps = (hEncoder->average_rps.n_samples != 0)
+			? mean_accumulator_get_value(&hEncoder->average_rps)
+			: hEncoder->current_rps;
+		
+		mean_accumulator_reset(&hEncoder->average_rps);
+		
+		// Only whole run of samples is fitted, first tick has no previous input
+		sysid_fit_feed(&g_sysid.fits[i], (float)duty_cycle, PIDQ_TO_FLOAT(rps));
+#endif
+		
+		g_motors[i]->duty_cycle = duty_cycle;
+	}
+	
+	do_write_motor_duty_cycles();
+	
+	++g_sysid.elapsed_pid_ticks;
+}
+
+// Ends identification run (if running): stops motors and PID timer,
+// task_sysid_stream() then sends remaining samples.
+void do_finish_sysid(void)
+{
+	if (g_sysid.state != SYSID_STATE_RUNNING)
+	{
+		return;
+	}
+	
+	// Encoder ISRs stop capturing
+	g_sysid.state = SYSID_STATE_FLUSHING;
+	
+	pause_pid_timer();
+	stop_motors();
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		g_motors[i]->duty_cycle = 0;
+	}
+	
+	motor_pwm_stop();
+	
+	Scheduler_Post(&g_scheduler, TASK_SYSID_STREAM);
+}
+
+#if defined(SYSID_FIT_MODEL)
+// Sends `SYSID_RESULT` message, payload is:
+// [0]    mask of motors with valid fit
+// [1...] 3 x { float A, float B } of motors 1, 2, 3 (0 if fit is not valid)
+void do_send_sysid_result(void)
+{
+	uint8_t valid_mask = 0;
+	float parameters[MOTOR_COUNT][2];
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		parameters[i][0] = 0;
+		parameters[i][1] = 0;
+		
+		if ((g_sysid.motor_mask & (1 << i))
+			&& sysid_fit_solve(&g_sysid.fits[i], &parameters[i][0], &parameters[i][1]))
+		{
+			valid_mask |= (1 << i);
+		}
+	}
+	
+	stxetx_encoder_t encoder;
+	usart_frame_begin(&encoder, MSG_TYPE_SYSID_RESULT, 0);
+	stxetx_encoder_push_bytes(&encoder, &valid_mask, sizeof(uint8_t));
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)parameters, sizeof(parameters));
+	usart_frame_end(&encoder);
+}
+#endif
+
+// Sends `PID_GAINS` message, payload is:
+// [0]     source of gains (pid_gains_source_e)
+// [1]     EEPROM status (PID_GAINS_EEPROM_* bits)
+// [2..25] 3 x { float Kp, float Ti } of motors 1, 2, 3
+void do_send_pid_gains(uint8_t eeprom_status)
+{
+	if (GainStore_IsBusy())
+	{
+		eeprom_status |= PID_GAINS_EEPROM_SAVE_PENDING;
+	}
+	
+	stxetx_encoder_t encoder;
+	usart_frame_begin(&encoder, MSG_TYPE_PID_GAINS, 0);
+	stxetx_encoder_push_bytes(&encoder, &g_pid_gains_source, sizeof(uint8_t));
+	stxetx_encoder_push_bytes(&encoder, &eeprom_status, sizeof(uint8_t));
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)g_pid_gains, sizeof(g_pid_gains));
+	usart_frame_end(&encoder);
+}
+
+// `PID_GAINS` request payload is either empty (get) or (set):
+// [0]     flags (PID_GAINS_FLAG_SAVE = also save all gains to EEPROM)
+// [1]     mask of motors whose gains are set (bit i = motor i + 1)
+// [2..25] 3 x { float Kp, float Ti } of motors 1, 2, 3 (ignored if not in mask)
+// Set is ignored if any masked gains are not valid (Kp < 0, Ti <= 0).
+// Gains apply on next PID tick, controllers keep running (the repo's Ti is an
+// integral rate, See. pid.h). Replies with `PID_GAINS` (See. do_send_pid_gains()).
+// Save is rejected while previous save is in progress.
+void on_received_msg_pid_gains(void)
+{
+	uint8_t eeprom_status = 0;
+	
+	if (g_received_frame.len_bytes > 0 && g_received_frame.len_bytes < 2 + sizeof(g_pid_gains))
+	{
+		do_on_link_error(LINK_ERROR_INVALID_LENGTH);
+		return;
+	}
+	
+	if (g_received_frame.len_bytes > 0)
+	{
+		const uint8_t* p_payload = g_received_frame.p_payload;
+		const uint8_t motor_mask = p_payload[1] & ((1 << MOTOR_COUNT) - 1);
+		pid_gains_t gains[MOTOR_COUNT];
+		uint8_t is_valid = 1;
+		
+		memcpy((void*)gains, (const void*)(p_payload + 2), sizeof(gains));
+		
+		for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+		{
+			if ((motor_mask & (1 << i)) && !is_valid_pid_gains(gains[i].Kp, gains[i].Ti))
+			{
+				is_valid = 0;
+			}
+		}
+		
+		if (is_valid)
+		{
+			for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+			{
+				if (motor_mask & (1 << i))
+				{
+					set_motor_pid_gains(i, gains[i].Kp, gains[i].Ti);
+					g_pid_gains_source = PID_GAINS_SOURCE_RUNTIME;
+				}
+			}
+			
+			if ((p_payload[0] & PID_GAINS_FLAG_SAVE) && !GainStore_Save(g_pid_gains, MOTOR_COUNT))
+			{
+				eeprom_status |= PID_GAINS_EEPROM_SAVE_REJECTED;
+			}
+		}
+	}
+	
+	do_send_pid_gains(eeprom_status);
+}
+
+// `AUTOTUNE_START` payload is:
+// [0]     mask of tuned motors (bit i = motor i + 1), all are tuned in parallel
+// [1]     flags (AUTOTUNE_FLAG_APPLY = use computed gains,
+//         AUTOTUNE_FLAG_SAVE = also save all gains to EEPROM, requires APPLY)
+// [2]     tuning rule (relay_autotune_rule_e)
+// [3]     relay bias duty cycle [%]
+// [4]     relay amplitude [%] (duty cycle is bias +- amplitude, limited to 0..PID_OUTPUT_MAX)
+// [5..8]  float speed setpoint [rps] (should be reached with bias duty cycle)
+// [9..12] float relay hysteresis [rps] (above speed noise)
+// [13]    number of measured oscillation cycles (0 is treated as 1)
+// Answered with `AUTOTUNE_START` (See. do_send_start_status()), request is
+// rejected with START_STATUS_BUSY while command, identification or previous
+// run is active and with START_STATUS_INVALID_ARGUMENT for unknown rule. Motors
+// are driven by relay (PID controllers and setpoint ramps are bypassed) in
+// positive direction until all tuned motors finish, `STOP` or `COMMAND` ends
+// run early. Result is sent in `AUTOTUNE_RESULT` (See. do_finish_autotune()).
+void on_received_msg_autotune_start(void)
+{
+	if (g_received_frame.len_bytes < 14)
+	{
+		do_on_link_error(LINK_ERROR_INVALID_LENGTH);
+		return;
+	}
+	
+	if (g_flag_command_running || g_sysid.state != SYSID_STATE_IDLE || g_autotune.is_running)
+	{
+		do_send_start_status(MSG_TYPE_AUTOTUNE_START, START_STATUS_BUSY);
+		return;
+	}
+	
+	if (g_received_frame.p_payload[2] > RELAY_AUTOTUNE_RULE_TYREUS_LUYBEN)
+	{
+		do_send_start_status(MSG_TYPE_AUTOTUNE_START, START_STATUS_INVALID_ARGUMENT);
+		return;
+	}
+	
+	const uint8_t* p_payload = g_received_frame.p_payload;
+	float setpoint_rps = 0;
+	float hysteresis_rps = 0;
+	
+	memcpy((void*)&setpoint_rps,	(const void*)(p_payload + 5), sizeof(float));
+	memcpy((void*)&hysteresis_rps,	(const void*)(p_payload + 9), sizeof(float));
+	
+	g_autotune.motor_mask = p_payload[0] & ((1 << MOTOR_COUNT) - 1);
+	g_autotune.flags = p_payload[1];
+	g_autotune.rule = p_payload[2];
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		relay_autotune_init(&g_autotune.tunes[i], setpoint_rps, (float)p_payload[3], (float)p_payload[4],
+			hysteresis_rps, 0, PID_OUTPUT_MAX, AUTOTUNE_SKIP_CYCLES, p_payload[13], AUTOTUNE_TIMEOUT_PID_TICKS);
+		g_motors[i]->duty_cycle = 0;
+	}
+	
+	// Only direction pins matter, controllers do not run during tuning
+	pidq_value_t directions[MOTOR_COUNT];
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		directions[i] = (g_autotune.motor_mask & (1 << i)) ? PIDQ_ONE : 0;
+	}
+	
+	apply_motor_setpoints(directions);
+	
+	g_pid_timing.has_previous_tick = 0;
+	
+	g_autotune.is_running = 1;
+	resume_pid_timer();
+	
+	do_send_start_status(MSG_TYPE_AUTOTUNE_START, START_STATUS_STARTED);
+}
+
+// Advances relays of tuned motors (runs instead of do_advance_pids() during
+// auto-tuning), finishes run when all relays are done.
+void do_advance_autotune(void)
+{
+#if defined(USE_QUADRATURE_ENCODER)
+	do_update_quadrature_estimates();
+#endif
+	
+	uint8_t is_any_running = 0;
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		if (!(g_autotune.motor_mask & (1 << i)))
+		{
+			continue;
+		}
+		
+		relay_autotune_t* h_tune = &g_autotune.tunes[i];
+		const float rps = PIDQ_TO_FLOAT(get_motor_feedback_rps(g_motors[i]));
+		
+		g_motors[i]->duty_cycle = (uint8_t)relay_autotune_advance(h_tune, rps);
+		
+		if (h_tune->state == RELAY_AUTOTUNE_STATE_RUNNING)
+		{
+			is_any_running = 1;
+		}
+	}
+	
+	if (!is_any_running)
+	{
+		do_finish_autotune();
+		return;
+	}
+	
+	do_write_motor_duty_cycles();
+}
+
+// Ends auto-tuning run (if running): stops motors and PID timer, computes
+// gains of motors which finished tuning, applies/saves them (by run flags)
+// and sends `AUTOTUNE_RESULT` message, payload is:
+// [0]     mask of motors with valid result
+// [1]     EEPROM status (PID_GAINS_EEPROM_* bits): SAVE_PENDING if gains are
+//         being saved, SAVE_REJECTED if AUTOTUNE_FLAG_SAVE was requested but
+//         previous save was still in progress (gains are applied anyway)
+// [2..49] 3 x { float Ku, float Pu [s], float Kp, float Ti } of motors 1, 2, 3
+//         (0 if result is not valid)
+void do_finish_autotune(void)
+{
+	if (!g_autotune.is_running)
+	{
+		return;
+	}
+	
+	g_autotune.is_running = 0;
+	
+	pause_pid_timer();
+	stop_motors();
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		g_motors[i]->duty_cycle = 0;
+	}
+	
+	motor_pwm_stop();
+	
+	uint8_t valid_mask = 0;
+	float results[MOTOR_COUNT][4];
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		float* p_result = results[i];
+		p_result[0] = p_result[1] = p_result[2] = p_result[3] = 0;
+		
+		if (!(g_autotune.motor_mask & (1 << i))
+			|| !relay_autotune_get_ultimate(&g_autotune.tunes[i], SAMPLE_TIME_S, &p_result[0], &p_result[1]))
+		{
+			continue;
+		}
+		
+		relay_autotune_compute_pi(p_result[0], p_result[1], g_autotune.rule, &p_result[2], &p_result[3]);
+		
+		if (!is_valid_pid_gains(p_result[2], p_result[3]))
+		{
+			continue;
+		}
+		
+		valid_mask |= (1 << i);
+		
+		if (g_autotune.flags & AUTOTUNE_FLAG_APPLY)
+		{
+			set_motor_pid_gains(i, p_result[2], p_result[3]);
+			g_pid_gains_source = PID_GAINS_SOURCE_RUNTIME;
+		}
+	}
+	
+	uint8_t eeprom_status = 0;
+	
+	if (valid_mask != 0 && (g_autotune.flags & AUTOTUNE_FLAG_APPLY) && (g_autotune.flags & AUTOTUNE_FLAG_SAVE))
+	{
+		// Tuned gains stay applied, host can save them again with `PID_GAINS`
+		eeprom_status = GainStore_Save(g_pid_gains, MOTOR_COUNT)
+			? PID_GAINS_EEPROM_SAVE_PENDING
+			: PID_GAINS_EEPROM_SAVE_REJECTED;
+	}
+	
+	stxetx_encoder_t encoder;
+	usart_frame_begin(&encoder, MSG_TYPE_AUTOTUNE_RESULT, 0);
+	stxetx_encoder_push_bytes(&encoder, &valid_mask, sizeof(uint8_t));
+	stxetx_encoder_push_bytes(&encoder, &eeprom_status, sizeof(uint8_t));
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)results, sizeof(results));
+	usart_frame_end(&encoder);
+}
+
+void on_received_msg_unknown(void)
+{
+	do_on_link_error(LINK_ERROR_UNKNOWN_TYPE);
+}
+
+
+void do_execute_command(void)
+{		
+	//// Ignore new command while current is being executed
+	//if(g_flag_command_running)
+	//{
+		//return;
+	//}	
+	
+	// Nodes share the bus, nobody answers broadcast frames
+	g_flag_transmit_muted = (g_frame_decoder.is_addressed && g_received_frame.address == STXETX_ADDRESS_BROADCAST);
+	
+	switch(g_received_frame.msg_type)
+	{
+		case MSG_TYPE_COMMAND:
+			on_received_msg_command();
+		break;
+		
+		case MSG_TYPE_SEGMENTS:
+			on_received_msg_segments();
+		break;
+		
+		case MSG_TYPE_STOP:
+			on_received_msg_stop();
+		break;
+		
+		case MSG_TYPE_SET_RAMP:
+			on_received_msg_set_ramp();
+		break;
+		
+		case MSG_TYPE_TELEMETRY_ARM:
+			on_received_msg_telemetry_arm();
+		break;
+		
+		case MSG_TYPE_TELEMETRY_DUMP:
+			on_received_msg_telemetry_dump();
+		break;
+		
+		case MSG_TYPE_EVENT_LOG_DUMP:
+			on_received_msg_event_log_dump();
+		break;
+		
+		case MSG_TYPE_STREAM_SUBSCRIBE:
+			on_received_msg_stream_subscribe();
+		break;
+		
+		case MSG_TYPE_PROFILER_QUERY:
+			on_received_msg_profiler_query();
+		break;
+		
+		case MSG_TYPE_DIAGNOSTICS:
+			on_received_msg_diagnostics();
+		break;
+		
+		case MSG_TYPE_SYSID_START:
+			on_received_msg_sysid_start();
+		break;
+		
+		case MSG_TYPE_PID_GAINS:
+			on_received_msg_pid_gains();
+		break;
+		
+		case MSG_TYPE_AUTOTUNE_START:
+			on_received_msg_autotune_start();
+		break;
+		
+		case MSG_TYPE_SYNC_APPLY:
+			on_received_msg_sync_apply();
+		break;
+		
+		case MSG_TYPE_SET_BAUD:
+			on_received_msg_set_baud();
+		break;
+		
+		case MSG_TYPE_MOVE_DISTANCE:
+			on_received_msg_move_distance();
+		break;
+		
+		case MSG_TYPE_KINEMATICS_CONFIG:
+			on_received_msg_kinematics_config();
+		break;
+		
+		case MSG_TYPE_BODY_VELOCITY:
+			on_received_msg_body_velocity();
+		break;
+		
+		case MSG_TYPE_POSE:
+			on_received_msg_pose();
+		break;
+		
+#if defined(USE_CURRENT_SENSING)
+		case MSG_TYPE_CURRENT_LIMIT:
+			on_received_msg_current_limit();
+		break;
+#endif
+		
+		default:
+			on_received_msg_unknown();
+		break;
+	}
+	
+	g_flag_transmit_muted = 0;
+}
+
+void do_broadcast_average_rps(void)
+{
+	float rps[MOTOR_COUNT];
+	
+#define GET_MOTOR_AVERAGE_RPS(N)	\
+	rps[BOARD_MOTOR_INDEX(N)] = PIDQ_TO_FLOAT(mean_accumulator_get_value(&g_motor_##N.hall_encoder.average_rps));
+	BOARD_FOR_EACH_MOTOR(GET_MOTOR_AVERAGE_RPS)
+	
+	const uint32_t now_ms = system_clock_get_ms();
+	const uint32_t timestamp_delta_ms = now_ms - g_odometry_last_broadcast_ms;
+	g_odometry_last_broadcast_ms = now_ms;
+	
+	// Payload is escaped directly into transmit queue
+	stxetx_encoder_t encoder;
+	usart_frame_begin(&encoder, MSG_TYPE_ODOMETRY, 0);
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)rps,					sizeof(rps));
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)&timestamp_delta_ms,	sizeof(uint32_t));
+#if defined(USE_QUADRATURE_ENCODER)
+	// Absolute signed tick counts are appended (exact odometry)
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		int32_t count = 0;
+		
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			count = g_motors[i]->quadrature_encoder.count;
+		}
+		
+		stxetx_encoder_push_bytes(&encoder, (const uint8_t*)&count, sizeof(int32_t));
+	}
+#endif
+	usart_frame_end(&encoder);
+}
+
+
+// Converts Q16.16 to Q8.8 (saturated to int16_t range, approx. +-128)
+int16_t convert_q16_16_to_q8_8(pidq_value_t value)
+{
+	const pidq_value_t q8_8 = value >> 8;
+	
+	if (q8_8 > INT16_MAX)
+	{
+		return INT16_MAX;
+	}
+	
+	if (q8_8 < INT16_MIN)
+	{
+		return INT16_MIN;
+	}
+	
+	return (int16_t)q8_8;
+}
+
+// Converts Q16.16 value to thousandths (e.g. m/s -> mm/s), saturated
+int16_t convert_q16_16_to_milli(pidq_value_t value)
+{
+	// Larger values saturate anyway, clamping first keeps product within int32_t
+	const pidq_value_t value_limit = (pidq_value_t)(((int64_t)INT16_MAX + 1) * PIDQ_ONE / 1000);
+	
+	if (value > value_limit)
+	{
+		return INT16_MAX;
+	}
+	
+	if (value < -value_limit)
+	{
+		return INT16_MIN;
+	}
+	
+	const int32_t milli = PIDQ_TO_INT(PIDQ_Multiply(value, PIDQ_FROM_INT(1000)));
+	
+	if (milli > INT16_MAX)
+	{
+		return INT16_MAX;
+	}
+	
+	if (milli < INT16_MIN)
+	{
+		return INT16_MIN;
+	}
+	
+	return (int16_t)milli;
+}
+
+#if defined(USE_COMPACT_ODOMETRY)
+// Sends `ODOMETRY_COMPACT` message, payload is:
+// [0]    sequence number (uint8_t, wraps)
+// [1..2] TIMER 1 timestamp of PID tick in microseconds (uint16_t, wraps every 65.536ms)
+// [3..8] signed speed of motors 1, 2, 3 in RPS (int16_t, Q8.8)
+// [9..14] (USE_QUADRATURE_ENCODER only) tick counts of motors 1, 2, 3 (int16_t, wraps)
+// Frame is 9 (15) bytes of payload against 16 (28) bytes of `ODOMETRY` and has
+// no floats, so escaping rarely makes it grow.
+void do_broadcast_compact_odometry(uint32_t tick_timestamp)
+{
+	const uint16_t timestamp_us = (uint16_t)(tick_timestamp / (F_CPU / 1000000UL));
+	
+	stxetx_encoder_t encoder;
+	usart_frame_begin(&encoder, MSG_TYPE_ODOMETRY_COMPACT, 0);
+	stxetx_encoder_push_bytes(&encoder, &g_odometry_compact_sequence, sizeof(uint8_t));
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)&timestamp_us, sizeof(uint16_t));
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		const int16_t rps_q8_8 = convert_q16_16_to_q8_8(get_motor_signed_rps(g_motors[i]));
+		stxetx_encoder_push_bytes(&encoder, (const uint8_t*)&rps_q8_8, sizeof(int16_t));
+	}
+	
+#if defined(USE_QUADRATURE_ENCODER)
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		int16_t count = 0;
+		
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			count = (int16_t)g_motors[i]->quadrature_encoder.count;
+		}
+		
+		stxetx_encoder_push_bytes(&encoder, (const uint8_t*)&count, sizeof(int16_t));
+	}
+#endif
+	
+	usart_frame_end(&encoder);
+	
+	++g_odometry_compact_sequence;
+}
+#endif
+
+// Sends `STREAM_DATA` message with subscribed channels which are due in this
+// PID tick, nothing if no channel is due. Payload is:
+// [0]    sequence number (uint8_t, wraps)
+// [1..2] TIMER 1 timestamp of PID tick in microseconds (uint16_t, wraps every 65.536ms)
+// [3]    mask of channels present in frame, bit c = stream_channel_e c
+// [4...] present channels in ascending order, motor channels contain one
+//        entry per motor in channel motor mask (ascending motor index):
+//        ODOMETRY    int16_t signed speed in RPS (Q8.8)
+//                    [USE_QUADRATURE_ENCODER] int16_t tick count (wraps)
+//        PID         int16_t setpoint, int16_t error in RPS (Q8.8), uint8_t duty cycle
+//        ENCODER     uint32_t last encoder period in TIMER 1 ticks
+//        DIAGNOSTICS uint16_t missed PID ticks, PID overruns, dropped received
+//                    bytes, dropped transmitted frames (See. DIAGNOSTICS message)
+//        CURRENT     uint16_t mean current over last PID tick [mA]
+//                    (0 without USE_CURRENT_SENSING)
+// Frame which does not fit in transmit queue is dropped (and counted).
+void do_broadcast_stream(uint32_t tick_timestamp)
+{
+	uint8_t channel_mask = 0;
+	
+	for (uint8_t c = 0; c < STREAM_CHANNEL_COUNT; c++)
+	{
+		if (g_stream.dividers[c] == 0 || ++g_stream.counters[c] < g_stream.dividers[c])
+		{
+			continue;
+		}
+		
+		g_stream.counters[c] = 0;
+		channel_mask |= (1 << c);
+	}
+	
+	if (channel_mask == 0)
+	{
+		return;
+	}
+	
+	const uint16_t timestamp_us = (uint16_t)(tick_timestamp / (F_CPU / 1000000UL));
+	
+	stxetx_encoder_t encoder;
+	usart_frame_begin(&encoder, MSG_TYPE_STREAM_DATA, 0);
+	stxetx_encoder_push_bytes(&encoder, &g_stream.sequence, sizeof(uint8_t));
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)&timestamp_us, sizeof(uint16_t));
+	stxetx_encoder_push_bytes(&encoder, &channel_mask, sizeof(uint8_t));
+	
+	if (channel_mask & (1 << STREAM_CHANNEL_ODOMETRY))
+	{
+		for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+		{
+			if (!(g_stream.motor_masks[STREAM_CHANNEL_ODOMETRY] & (1 << i)))
+			{
+				continue;
+			}
+			
+			const int16_t rps_q8_8 = convert_q16_16_to_q8_8(get_motor_signed_rps(g_motors[i]));
+			stxetx_encoder_push_bytes(&encoder, (const uint8_t*)&rps_q8_8, sizeof(int16_t));
+#if defined(USE_QUADRATURE_ENCODER)
+			int16_t count = 0;
+			
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+			{
+				count = (int16_t)g_motors[i]->quadrature_encoder.count;
+			}
+			
+			stxetx_encoder_push_bytes(&encoder, (const uint8_t*)&count, sizeof(int16_t));
+#endif
+		}
+	}
+	
+	if (channel_mask & (1 << STREAM_CHANNEL_PID))
+	{
+		for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+		{
+			if (!(g_stream.motor_masks[STREAM_CHANNEL_PID] & (1 << i)))
+			{
+				continue;
+			}
+			
+			// Same values as used by do_advance_pids() in this tick
+			const pidq_value_t rps = get_motor_feedback_rps(g_motors[i]);
+			const int16_t values[2] = {
+				convert_q16_16_to_q8_8(g_motors[i]->setpoint),
+				convert_q16_16_to_q8_8(g_motors[i]->setpoint - rps)
+			};
+			
+			stxetx_encoder_push_bytes(&encoder, (const uint8_t*)values, sizeof(values));
+			stxetx_encoder_push_bytes(&encoder, &g_motors[i]->duty_cycle, sizeof(uint8_t));
+		}
+	}
+	
+	if (channel_mask & (1 << STREAM_CHANNEL_ENCODER))
+	{
+		for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+		{
+			if (!(g_stream.motor_masks[STREAM_CHANNEL_ENCODER] & (1 << i)))
+			{
+				continue;
+			}
+			
+			uint32_t period_ticks = 0;
+			
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+			{
+				period_ticks = g_motors[i]->hall_encoder.captured_period_ticks;
+			}
+			
+			stxetx_encoder_push_bytes(&encoder, (const uint8_t*)&period_ticks, sizeof(uint32_t));
+		}
+	}
+	
+	if (channel_mask & (1 << STREAM_CHANNEL_DIAGNOSTICS))
+	{
+		uint16_t values[4] = {0};
+		
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			values[0] = g_pid_missed_ticks_count;
+			values[2] = g_receive_dropped_bytes_count;
+			values[3] = g_transmit_dropped_frames_count;
+		}
+		
+		values[1] = g_pid_timing.overrun_count;
+		
+		stxetx_encoder_push_bytes(&encoder, (const uint8_t*)values, sizeof(values));
+	}
+	
+	if (channel_mask & (1 << STREAM_CHANNEL_CURRENT))
+	{
+		for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+		{
+			if (!(g_stream.motor_masks[STREAM_CHANNEL_CURRENT] & (1 << i)))
+			{
+				continue;
+			}
+			
+#if defined(USE_CURRENT_SENSING)
+			const uint16_t current_ma = g_motors[i]->current_ma;
+#else
+			const uint16_t current_ma = 0;
+#endif
+			stxetx_encoder_push_bytes(&encoder, (const uint8_t*)&current_ma, sizeof(uint16_t));
+		}
+	}
+	
+	usart_frame_end(&encoder);
+	
+	++g_stream.sequence;
+}
+
+// Starts recording of armed telemetry capture if `event` is its trigger
+void do_on_telemetry_event(telemetry_trigger_e event)
+{
+	if (g_telemetry.state == TELEMETRY_STATE_ARMED && g_telemetry.trigger == event)
+	{
+		g_telemetry.state = TELEMETRY_STATE_RECORDING;
+	}
+}
+
+// Captures record of current PID tick into `g_telemetry_ring` (no UART traffic).
+// Unless capture is recording this costs only a few comparisons.
+void do_record_telemetry(uint32_t tick_timestamp)
+{
+	if (g_telemetry.state == TELEMETRY_STATE_ARMED && g_telemetry.trigger == TELEMETRY_TRIGGER_ERROR_ABOVE)
+	{
+		for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+		{
+			const pidq_value_t error = g_motors[i]->setpoint - get_motor_feedback_rps(g_motors[i]);
+			
+			if (((error < 0) ? -error : error) > g_telemetry.error_threshold)
+			{
+				g_telemetry.state = TELEMETRY_STATE_RECORDING;
+				break;
+			}
+		}
+	}
+	
+	if (g_telemetry.state != TELEMETRY_STATE_RECORDING)
+	{
+		return;
+	}
+	
+	if (++g_telemetry.decimation_counter < g_telemetry.decimation)
+	{
+		return;
+	}
+	
+	g_telemetry.decimation_counter = 0;
+	
+	telemetry_record_t record;
+	record.timestamp_us = (uint16_t)(tick_timestamp / (F_CPU / 1000000UL));
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		// Same values as used by do_advance_pids() in this tick
+		const pidq_value_t rps = get_motor_feedback_rps(g_motors[i]);
+		
+		record.motors[i].setpoint = convert_q16_16_to_q8_8(g_motors[i]->setpoint);
+		record.motors[i].rps = convert_q16_16_to_q8_8(rps);
+		record.motors[i].error = convert_q16_16_to_q8_8(g_motors[i]->setpoint - rps);
+		record.motors[i].duty_cycle = g_motors[i]->duty_cycle;
+	}
+	
+	telemetry_ring_push(&g_telemetry_ring, record);
+	
+	if (telemetry_ring_free_space(&g_telemetry_ring) == 0)
+	{
+		// Capture complete, waits for `TELEMETRY_DUMP`
+		g_telemetry.state = TELEMETRY_STATE_IDLE;
+	}
+}
+
+
+void do_on_command_complete(void)
+{
+	g_position.is_active = 0;
+	pause_pid_timer();
+	SoftTimer_Stop(&g_soft_timers, &g_command_timer);
+	SoftTimer_Stop(&g_soft_timers, &g_odometry_timer);
+	
+	// Stop motors by setting their speed to 0.
+	stop_motors();
+	
+	BOARD_FOR_EACH_MOTOR(RESET_MOTOR_AVERAGE_RPS)
+	
+	// Motors are stopped, pose is not integrated until next command
+	memset(g_kinematics.velocity, 0, sizeof(g_kinematics.velocity));
+	
+	motor_pwm_stop();
+	
+	clear_PID();
+#if defined(USE_CURRENT_SENSING)
+	reset_current_limits();
+#endif
+	
+	// Send `FINISHED` message, payload is:
+	// [0]    mask of motors that stalled during command
+	// [1..2] longest PID tick to PID task latency in microseconds (uint16_t, saturated)
+	const uint16_t latency_us_u16 = convert_pulse_ticks_to_us_u16(g_pid_wake_latency_max_ticks);
+	
+	uint8_t payload[sizeof(uint8_t) + sizeof(uint16_t)];
+	payload[0] = g_stalled_motors_mask;
+	memcpy((void*)(payload + 1), (const void*)&latency_us_u16, sizeof(uint16_t));
+	
+	stxetx_frame_t frame;
+	stxetx_init_empty_frame(&frame);
+	frame.msg_type = MSG_TYPE_FINISHED;
+	stxetx_add_payload(&frame, payload, sizeof(payload));
+	usart_send_frame(frame);
+}
+
+
+// Feeds received byte to the frame decoder. When a full valid frame is
+// received it is stored to `g_received_frame` and queued for execution.
+void do_on_command_byte_received(uint8_t byte_received)
+{
+	uint8_t is_frame_complete = 0;
+	
+	uint8_t status = stxetx_decoder_feed_byte(&g_frame_decoder, byte_received, &is_frame_complete);
+	if (status != STXETX_ERROR_NO_ERROR)
+	{
+		// Error state:
+		// Invalid frame is discarded, decoder waits for next STX
+		do_on_link_error(convert_stxetx_error_to_link_error(status));
+		
+		// Bytes between frames do not trigger fallback, only frames which fail
+		if (status != STXETX_ERROR_STX_MISSING)
+		{
+			do_on_usart_frame_error();
+			
+#if !defined(USE_BUS_ADDRESSING)
+			// Host which sends sequenced frames retransmits from expected one.
+			// On a bus the frame may have been addressed to another node.
+			if (g_flag_rx_sequence_synced)
+			{
+				do_send_frame_nak(status);
+			}
+#endif
+		}
+		return;
+	}
+	
+	if (is_frame_complete)
+	{
+		// Valid frame confirms link speed
+		g_usart_speed.is_switch_unconfirmed = 0;
+		SoftTimer_Stop(&g_soft_timers, &g_usart_speed_confirm_timer);
+		g_usart_speed.frame_error_streak = 0;
+		
+		stxetx_frame_t frame = g_frame_decoder.frame;
+		
+		if ((frame.flags & FLAG_SHOULD_ACK) && !do_accept_sequenced_frame(&frame))
+		{
+			return;
+		}
+		
+		g_received_frame = frame;
+		g_flag_command_in_queue = 1;
+		Scheduler_Post(&g_scheduler, TASK_EXECUTE_COMMAND);
+	}
+}
+
+// Checks sequence number (first payload byte) of frame with FLAG_SHOULD_ACK
+// and answers it right away, before it is executed. Sequence number is
+// stripped from `p_frame` payload, handlers see the same payload as without
+// FLAG_SHOULD_ACK. Returns 1 if frame should be executed:
+// - expected number: `FRAME_ACK`, frame is executed
+// - one of 127 numbers before expected one: duplicate (lost ACK),
+//   `FRAME_ACK` is repeated, frame is not executed again
+// - other numbers: frame(s) in between were lost, `FRAME_NAK` with
+//   expected number, frame is not executed (host goes back to expected one)
+// Host can keep up to 127 frames in flight.
+uint8_t do_accept_sequenced_frame(stxetx_frame_t* p_frame)
+{
+	if (p_frame->len_bytes == 0)
+	{
+		do_send_frame_nak(STXETX_ERROR_INVALID_LENGTH);
+		return 0;
+	}
+	
+	const uint8_t sequence = p_frame->p_payload[0];
+	++p_frame->p_payload;
+	--p_frame->len_bytes;
+	
+	if (!g_flag_rx_sequence_synced || (p_frame->flags & FLAG_SEQUENCE_RESET))
+	{
+		g_flag_rx_sequence_synced = 1;
+		g_rx_expected_sequence = sequence;
+	}
+	
+	// Nodes do not answer broadcast frames, host relies on duplicate suppression
+	const uint8_t is_broadcast = g_frame_decoder.is_addressed && p_frame->address == STXETX_ADDRESS_BROADCAST;
+	const uint8_t distance = (uint8_t)(sequence - g_rx_expected_sequence);
+	
+	if (distance == 0)
+	{
+		++g_rx_expected_sequence;
+		
+		if (!is_broadcast)
+		{
+			do_send_frame_ack(sequence);
+		}
+		return 1;
+	}
+	
+	if (!is_broadcast)
+	{
+		if (distance >= 0x80)
+		{
+			do_send_frame_ack(sequence);
+		}
+		else
+		{
+			do_send_frame_nak(STXETX_ERROR_NO_ERROR);
+		}
+	}
+	
+	return 0;
+}
+
+// Sends `FRAME_ACK`, payload is:
+// [0] sequence number of acknowledged frame
+void do_send_frame_ack(uint8_t sequence)
+{
+	stxetx_frame_t frame;
+	stxetx_init_empty_frame(&frame);
+	frame.msg_type = MSG_TYPE_FRAME_ACK;
+	stxetx_add_payload(&frame, &sequence, sizeof(sequence));
+	usart_send_frame(frame);
+}
+
+// Sends `FRAME_NAK`, payload is:
+// [0] expected sequence number (host retransmits from this frame on)
+// [1] stxetx_error_code_e of rejected frame (STXETX_ERROR_NO_ERROR = out of order)
+void do_send_frame_nak(uint8_t error)
+{
+	uint8_t payload[2];
+	payload[0] = g_rx_expected_sequence;
+	payload[1] = error;
+	
+	stxetx_frame_t frame;
+	stxetx_init_empty_frame(&frame);
+	frame.msg_type = MSG_TYPE_FRAME_NAK;
+	stxetx_add_payload(&frame, payload, sizeof(payload));
+	usart_send_frame(frame);
+}
+
+void setup_motors(void)
+{
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		g_motors[i]->hall_encoder.current_rps = 0;
+		mean_accumulator_reset(&g_motors[i]->hall_encoder.average_rps);
+		hall_encoder_configure_filters(&g_motors[i]->hall_encoder, RPS_MEDIAN_TAPS, RPS_AVERAGE_WINDOW_SHIFT);
+		g_motors[i]->hall_encoder.motor_index = i;
+		g_motors[i]->duty_cycle = 0;
+		g_motors[i]->direction = 1;
+		setpoint_ramp_init(&g_motors[i]->setpoint_ramp, 0, 0, 0);
+	}
+	
+	configure_setpoint_ramps(SETPOINT_RAMP_ACCELERATION, SETPOINT_RAMP_JERK);
+	
+	segment_queue_init(&g_segment_queue);
+	
+	telemetry_ring_init(&g_telemetry_ring);
+	g_telemetry.state = TELEMETRY_STATE_IDLE;
+	
+	sysid_ring_init(&g_sysid_ring);
+	g_sysid.state = SYSID_STATE_IDLE;
+	
+	g_autotune.is_running = 0;
+	
+	reset_pid_timing_stats();
+	g_pid_timing.has_previous_tick = 0;
+	
+	kinematics_init(&g_kinematics, SAMPLE_TIME_S);
+	g_kinematics_matrix_mask = 0;
+	
+#if defined(USE_QUADRATURE_ENCODER)
+#define INIT_MOTOR_QUADRATURE_ENCODER(N)													\
+	qenc_init(&g_motor_##N.quadrature_encoder, MOTOR_QUADRATURE_STATE(N),					\
+		QUADRATURE_TICKS_PER_ROTATION, SAMPLING_FREQUENCY, QUADRATURE_HYBRID_THRESHOLD_TICKS);
+	BOARD_FOR_EACH_MOTOR(INIT_MOTOR_QUADRATURE_ENCODER)
+#endif
+}
+
+void setup_scheduler(void)
+{
+	Scheduler_Init(&g_scheduler);
+	
+	// CPU sleeps when no task is ready, timers and USART keep running
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	
+	Scheduler_RegisterTask(&g_scheduler, TASK_UPDATE_ENCODERS,			task_update_encoders);
+	Scheduler_RegisterTask(&g_scheduler, TASK_ADVANCE_PIDS,				task_advance_pids);
+	Scheduler_RegisterTask(&g_scheduler, TASK_CHECK_ENCODER_TIMEOUTS,	task_check_encoder_timeouts);
+	Scheduler_RegisterTask(&g_scheduler, TASK_EXECUTE_COMMAND,			task_execute_command);
+	Scheduler_RegisterTask(&g_scheduler, TASK_RECEIVE,					task_receive);
+	Scheduler_RegisterTask(&g_scheduler, TASK_TASK_TIMERS,				task_task_timers);
+	Scheduler_RegisterTask(&g_scheduler, TASK_BULK_DUMP,				task_bulk_dump);
+	Scheduler_RegisterTask(&g_scheduler, TASK_SYSID_STREAM,				task_sysid_stream);
+}
+
+void task_update_encoders(void)
+{
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		if (g_motors[i]->hall_encoder.is_measurement_ready)
+		{
+			PROFILE_BEGIN(PROBE_UPDATE_RPS);
+			do_update_rps(&g_motors[i]->hall_encoder);
+			PROFILE_END(PROBE_UPDATE_RPS);
+		}
+	}
+}
+
+void task_advance_pids(void)
+{
+	if (g_sysid.state == SYSID_STATE_RUNNING)
+	{
+		do_advance_sysid();
+		return;
+	}
+	
+	if (g_autotune.is_running)
+	{
+		do_advance_autotune();
+		return;
+	}
+	
+	if (!g_flag_command_running)
+	{
+		return;
+	}
+	
+	uint32_t tick_timestamp = 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		tick_timestamp = g_pid_tick_timestamp;
+	}
+	
+	const uint32_t latency = PulseTickTimer_GetTimestamp() - tick_timestamp;
+	
+	if (latency > g_pid_wake_latency_max_ticks)
+	{
+		g_pid_wake_latency_max_ticks = latency;
+	}
+	
+	const uint32_t execution_start = PulseTickTimer_GetTimestamp();
+	
+	do_update_pid_timing(tick_timestamp);
+	
+	PROFILE_BEGIN(PROBE_ADVANCE_PIDS);
+	do_advance_pids();
+	PROFILE_END(PROBE_ADVANCE_PIDS);
+	
+	if (g_kinematics_matrix_mask & (1 << KINEMATICS_MATRIX_FORWARD))
+	{
+		do_advance_pose();
+	}
+	
+#if defined(USE_COMPACT_ODOMETRY)
+	if (++g_odometry_compact_decimation_counter >= ODOMETRY_COMPACT_DECIMATION)
+	{
+		g_odometry_compact_decimation_counter = 0;
+		do_broadcast_compact_odometry(tick_timestamp);
+	}
+#endif
+	
+	do_broadcast_stream(tick_timestamp);
+	do_record_telemetry(tick_timestamp);
+	
+	if (g_position.is_active && g_position.reached_mask == BOARD_MOTOR_MASK)
+	{
+		do_on_position_reached();
+	}
+	
+	const uint32_t execution_end = PulseTickTimer_GetTimestamp();
+	
+	if (execution_end - execution_start > g_pid_timing.execution_max_ticks)
+	{
+		g_pid_timing.execution_max_ticks = execution_end - execution_start;
+	}
+	
+	// Next tick was due before this one was handled
+	if (execution_end - tick_timestamp >= PID_TICK_PERIOD_PULSE_TICKS && g_pid_timing.overrun_count != UINT16_MAX)
+	{
+		++g_pid_timing.overrun_count;
+	}
+}
+
+void reset_pid_timing_stats(void)
+{
+	g_pid_timing.executed_count = 0;
+	g_pid_timing.overrun_count = 0;
+	g_pid_timing.dt_min_ticks = UINT32_MAX;
+	g_pid_timing.dt_max_ticks = 0;
+	g_pid_timing.execution_max_ticks = 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		g_pid_missed_ticks_count = 0;
+	}
+}
+
+// Measures time since previous PID execution (`tick_timestamp` is TIMER 1
+// timestamp of current PID tick) and, with USE_MEASURED_PID_TIMESTEP,
+// passes it to controllers.
+void do_update_pid_timing(uint32_t tick_timestamp)
+{
+	uint32_t dt = PID_TICK_PERIOD_PULSE_TICKS;
+	
+	if (g_pid_timing.has_previous_tick)
+	{
+		dt = tick_timestamp - g_pid_timing.previous_tick_timestamp;
+		
+		if (dt < g_pid_timing.dt_min_ticks)
+		{
+			g_pid_timing.dt_min_ticks = dt;
+		}
+		
+		if (dt > g_pid_timing.dt_max_ticks)
+		{
+			g_pid_timing.dt_max_ticks = dt;
+		}
+	}
+	
+	g_pid_timing.previous_tick_timestamp = tick_timestamp;
+	g_pid_timing.has_previous_tick = 1;
+	++g_pid_timing.executed_count;
+	
+#if defined(USE_MEASURED_PID_TIMESTEP)
+	do_set_pid_timestep(dt);
+#endif
+}
+
+#if defined(USE_MEASURED_PID_TIMESTEP)
+// Sets timestep of all PID controllers to `dt_ticks` TIMER 1 ticks
+// (limited to 4 PID periods, e.g. after long blocking)
+void do_set_pid_timestep(uint32_t dt_ticks)
+{
+	if (dt_ticks > 4 * PID_TICK_PERIOD_PULSE_TICKS)
+	{
+		dt_ticks = 4 * PID_TICK_PERIOD_PULSE_TICKS;
+	}
+	
+#if defined(USE_FIXED_POINT_PID)
+	// dt * 2^16 / F_CPU without 64-bit division (dt < 2^20, so dt << 12 fits)
+	const pidq_value_t timestep = (pidq_value_t)((dt_ticks << 12) / (F_CPU / 16));
+	
+	if (timestep != 0)
+	{
+		PIDBank_SetTimestep(&g_pid_bank, timestep);
+	}
+#else
+	const float timestep = (float)dt_ticks / (float)F_CPU;
+	
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		PID_SetTimestep(&g_motors[i]->pid, timestep);
+	}
+#endif
+}
+#endif
+
+void task_check_encoder_timeouts(void)
+{
+	do_check_encoder_timeouts();
+}
+
+void task_execute_command(void)
+{
+	if (!g_flag_command_in_queue)
+	{
+		return;
+	}
+	
+	do_execute_command();
+	g_flag_command_in_queue = 0;
+	
+	// Receiving was paused while command frame was in use
+	if (usart_rx_ring_count(&g_receive_buffer))
+	{
+		Scheduler_Post(&g_scheduler, TASK_RECEIVE);
+	}
+}
+
+void task_receive(void)
+{
+	// Decoded frame payload is overwritten by next byte, so
+	// stop at complete frame and wait until queued command is executed
+	while (!g_flag_command_in_queue)
+	{
+		// Bytes are decoded in place and released afterwards (zero-copy)
+		const uint8_t* p_span = NULL;
+		const uint8_t span_length = usart_rx_ring_peek_contiguous(&g_receive_buffer, &p_span);
+		
+		if (span_length == 0)
+		{
+			break;
+		}
+		
+		uint8_t n_consumed = 0;
+		
+		while (n_consumed < span_length && !g_flag_command_in_queue)
+		{
+			do_on_command_byte_received(p_span[n_consumed++]);
+		}
+		
+		usart_rx_ring_consume(&g_receive_buffer, n_consumed);
+	}
+}
+
+// Ends current segment, next queued segment starts right away
+// (motors are not stopped), otherwise command is complete
+void do_on_command_timer_expired(void)
+{
+	if (!g_flag_command_running)
+	{
+		return;
+	}
+	
+	// Timeout of `MOVE_DISTANCE` ends it short of target
+	g_position.is_active = 0;
+	
+	motion_segment_t segment;
+	
+	if (segment_queue_pop(&g_segment_queue, &segment))
+	{
+		do_continue_motion_segment(&segment);
+		return;
+	}
+	
+	g_flag_command_running = 0;
+	do_on_command_complete();
+}
+
+// Handles expired software timers (See. g_soft_timers)
+void task_task_timers(void)
+{
+	// When host did not follow link speed set by `SET_BAUD`
+	// (no valid frame received at new speed), speed is reverted
+	if (g_usart_speed.is_switch_unconfirmed)
+	{
+		g_usart_speed.is_switch_unconfirmed = 0;
+		SoftTimer_StartAt(&g_soft_timers, &g_usart_speed_confirm_timer, system_clock_get_ms() + USART_SPEED_CONFIRM_TIMEOUT_MS, 0);
+	}
+	
+	const uint32_t now_ms = system_clock_get_ms();
+	soft_timer_t* p_timer = NULL;
+	
+	while (NULL != (p_timer = SoftTimer_PopExpired(&g_soft_timers, now_ms)))
+	{
+		switch (p_timer->id)
+		{
+			case SOFT_TIMER_COMMAND:
+				do_on_command_timer_expired();
+			break;
+			
+			case SOFT_TIMER_ODOMETRY:
+				if (g_kinematics_matrix_mask & (1 << KINEMATICS_MATRIX_FORWARD))
+				{
+					do_send_pose();
+				}
+				else
+				{
+					do_broadcast_average_rps();
+				}
+			break;
+			
+			case SOFT_TIMER_USART_SPEED_CONFIRM:
+				do_set_usart_speed(g_usart_speed.previous_speed);
+			break;
+			
+			default:
+			break;
+		}
+	}
+}
+
+// Streams captured telemetry as `TELEMETRY_DATA` frames, one frame per call.
+// Task reposts itself until the ring is empty (CPU does not sleep while dumping),
+// every other task has higher priority. Waits while transmit queue has no room
+// for a frame, so odometry and replies are never dropped because of the dump.
+// Dump ends with frame that contains no records. Payload is:
+// [0]    number of records N (at most TELEMETRY_RECORDS_PER_FRAME)
+// [1...] N x telemetry_record_t (2 + 7 bytes per motor, oldest first)
+void do_dump_telemetry_frame(void)
+{
+	if (usart_tx_queue_get_free_space() < TELEMETRY_FRAME_MAX_ENCODED_SIZE)
+	{
+		return;
+	}
 	
-	//uint8_t a = calculate_oc_value_from_dc((uint32_t)input);
-	//usart_send(&a, 1);
+	uint8_t n_records = telemetry_ring_count(&g_telemetry_ring);
+	if (n_records > TELEMETRY_RECORDS_PER_FRAME)
+	{
+		n_records = TELEMETRY_RECORDS_PER_FRAME;
+	}
 	
+	stxetx_encoder_t encoder;
+	usart_frame_begin(&encoder, MSG_TYPE_TELEMETRY_DATA, 0);
+	stxetx_encoder_push_bytes(&encoder, &n_records, sizeof(uint8_t));
 	
-	//usart_send((unsigned char*)&input_1, sizeof(float));
-	//const float a = SAMPLE_TIME_S;
-	//usart_send((unsigned char*)&a, sizeof(float));
+	for (uint8_t i = 0; i < n_records; i++)
+	{
+		telemetry_record_t record;
+		telemetry_ring_pop(&g_telemetry_ring, &record);
+		stxetx_encoder_push_bytes(&encoder, (const uint8_t*)&record, sizeof(telemetry_record_t));
+	}
 	
-	//usart_send((unsigned char*)&g_motor_3.hall_encoder.current_rps, sizeof(float));
-	//usart_send((unsigned char*)&error_2, sizeof(float));
-	//usart_send((unsigned char*)&g_motor_2.setpoint, sizeof(float));
-	//////////////////////////////////////////////////////////////////////////
+	usart_frame_end(&encoder);
 	
+	if (n_records == 0)
+	{
+		g_telemetry.state = TELEMETRY_STATE_IDLE;
+	}
 }
 
-void on_received_msg_command(void)
-{		
-	uint32_t command_duration_ms = 0;
-	
-	if (g_received_frame.len_bytes < 3 * sizeof(float) + sizeof(uint32_t))
+// Streams valid event log records as `EVENT_LOG_DATA` frames, oldest first.
+// Waits while transmit queue has no room or EEPROM is being written
+// (reading EEPROM would block until write completes).
+// Dump ends with frame that contains no records. Payload is:
+// [0]    number of records N (at most EVENT_LOG_RECORDS_PER_FRAME)
+// [1...] N x event_log_record_t (17 bytes each, snapshot is event_snapshot_t)
+// Last frame instead carries (after N = 0):
+// [1..2] records dropped since start because write queue was full (uint16_t, saturated)
+void do_dump_event_log_frame(void)
+{
+	if (usart_tx_queue_get_free_space() < EVENT_LOG_FRAME_MAX_ENCODED_SIZE
+		|| EventLog_IsBusy()
+		|| GainStore_IsBusy())
 	{
-		// TODO: Add general errors
-		// TODO: Add info messages
-		do_handle_fatal_error();
+		return;
 	}
 	
-	float motor_1_rps_setpoint = 0;
-	float motor_2_rps_setpoint = 0;
-	float motor_3_rps_setpoint = 0;
-	
-	memcpy((void*)&motor_1_rps_setpoint,  (const void*)(g_received_frame.p_payload +  0), sizeof(float));
-	memcpy((void*)&motor_2_rps_setpoint,  (const void*)(g_received_frame.p_payload +  4), sizeof(float));
-	memcpy((void*)&motor_3_rps_setpoint,  (const void*)(g_received_frame.p_payload +  8), sizeof(float));
-	memcpy((void*)&command_duration_ms,   (const void*)(g_received_frame.p_payload + 12), sizeof(uint32_t));
+	event_log_record_t records[EVENT_LOG_RECORDS_PER_FRAME];
+	uint8_t n_records = 0;
+	uint8_t n_slots_read = 0;
 	
-	
-	// UINT32_MAX will be used in place of `float`'s INFINITY
-	// i.e. it will denote command that never stops, in this case
-	// a command that runs for UINT32_MAX * 50ms = 214748364750 ms (approx. 2485 days)
-	if (command_duration_ms == UINT32_MAX)
+	while (g_event_log_dump.slot_index < EVENT_LOG_SLOT_COUNT
+		&& n_records < EVENT_LOG_RECORDS_PER_FRAME
+		&& n_slots_read < EVENT_LOG_SLOTS_PER_DUMP_CALL)
 	{
-		g_target_command_duration__50ms_ticks = UINT32_MAX;
+		if (EventLog_Read(g_event_log_dump.slot_index, &records[n_records]))
+		{
+			++n_records;
+		}
+		
+		++g_event_log_dump.slot_index;
+		++n_slots_read;
 	}
-	else
+	
+	const uint8_t is_last_frame = (g_event_log_dump.slot_index >= EVENT_LOG_SLOT_COUNT) && (n_records == 0);
+	
+	if (n_records == 0 && !is_last_frame)
 	{
-		// Round command duration to nearest multiple of 50ms
-		g_target_command_duration__50ms_ticks = command_duration_ms / 50;
-		if((command_duration_ms % 50) > (50/2))
-		{
-			g_target_command_duration__50ms_ticks += 1;
-		}	
+		// Only erased slots so far, continue with next call
+		return;
 	}
-
-	cma_reset(&g_motor_1.hall_encoder.average_rps);
-	cma_reset(&g_motor_2.hall_encoder.average_rps);
-	cma_reset(&g_motor_3.hall_encoder.average_rps);
 	
-	configure_motors_for_action(motor_1_rps_setpoint, motor_2_rps_setpoint, motor_3_rps_setpoint);
+	stxetx_encoder_t encoder;
+	usart_frame_begin(&encoder, MSG_TYPE_EVENT_LOG_DATA, 0);
+	stxetx_encoder_push_bytes(&encoder, &n_records, sizeof(uint8_t));
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)records, n_records * sizeof(event_log_record_t));
 	
-	g_command_duration_counter__50ms_ticks = 0;
-	g_odometry_time_since_last_broadcast__50ms_ticks = 0;
+	if (is_last_frame)
+	{
+		const uint16_t dropped_count = EventLog_GetDroppedCount();
+		stxetx_encoder_push_bytes(&encoder, (const uint8_t*)&dropped_count, sizeof(uint16_t));
+		g_event_log_dump.is_dumping = 0;
+	}
 	
-	g_flag_command_running = 1;
-	resume_pid_timer();
-}
-
-void on_received_msg_stop(void)
-{
-	g_flag_command_running = 0;
-	do_on_command_complete();
+	usart_frame_end(&encoder);
 }
 
-void on_received_msg_unknown(void)
+// Streams bulk data requested by host, one frame per call. Runs at lowest
+// priority but one (See. task_id_e) and reposts itself until every dump ends.
+void task_bulk_dump(void)
 {
-	do_handle_fatal_error();
-}
-
-
-void do_execute_command(void)
-{		
-	//// Ignore new command while current is being executed
-	//if(g_flag_command_running)
-	//{
-		//return;
-	//}	
+	if (g_telemetry.state == TELEMETRY_STATE_DUMPING)
+	{
+		do_dump_telemetry_frame();
+	}
+	else if (g_event_log_dump.is_dumping)
+	{
+		do_dump_event_log_frame();
+	}
+	else
+	{
+		return;
+	}
 	
-	switch(g_received_frame.msg_type)
+	if (g_telemetry.state == TELEMETRY_STATE_DUMPING || g_event_log_dump.is_dumping)
 	{
-		case MSG_TYPE_COMMAND:
-			on_received_msg_command();
-		break;
-		
-		case MSG_TYPE_STOP:
-			on_received_msg_stop();
-		break;
-		
-		default:
-			on_received_msg_unknown();
-		break;
+		Scheduler_Post(&g_scheduler, TASK_BULK_DUMP);
 	}
 }
 
-void do_broadcast_average_rps(void)
+// Streams captured edges as `SYSID_DATA` frames, one frame per call.
+// While running only full frames are sent (encoder ISRs post the task),
+// after the run the rest is flushed and stream ends with frame that
+// contains no samples, followed by `SYSID_RESULT` (SYSID_FIT_MODEL).
+// Waits while transmit queue has no room (See. do_dump_telemetry_frame()),
+// edges which do not fit into `g_sysid_ring` meanwhile are counted as dropped.
+// Payload is:
+// [0..1] samples dropped since start of run (uint16_t, saturated)
+// [2]    number of samples N (at most SYSID_SAMPLES_PER_FRAME)
+// [3...] N x sysid_sample_t (6 bytes each, oldest first)
+void task_sysid_stream(void)
 {
-	// TODO: timestamp?
-	
-	const float motor_1_rps = cma_get_value(&g_motor_1.hall_encoder.average_rps);
-	const float motor_2_rps = cma_get_value(&g_motor_2.hall_encoder.average_rps);
-	const float motor_3_rps = cma_get_value(&g_motor_3.hall_encoder.average_rps);
-	
-	const uint32_t timestamp_delta_ms = g_odometry_time_since_last_broadcast__50ms_ticks * 50;
-	
-	stxetx_frame_t frame;
-	stxetx_init_empty_frame(&frame);
-	frame.msg_type = MSG_TYPE_ODOMETRY;
-	
-	uint8_t p_payload[16] = {0};
-	memcpy(p_payload + 0,	(const void*)&motor_1_rps,			sizeof(float));
-	memcpy(p_payload + 4,	(const void*)&motor_2_rps,			sizeof(float));
-	memcpy(p_payload + 8,	(const void*)&motor_3_rps,			sizeof(float));
-	memcpy(p_payload + 12,	(const void*)&timestamp_delta_ms,	sizeof(uint32_t));
+	if (g_sysid.state == SYSID_STATE_IDLE)
+	{
+		return;
+	}
 	
-	uint8_t ec = stxetx_add_payload(&frame, p_payload, 16);
+	uint8_t n_samples = sysid_ring_count(&g_sysid_ring);
 	
-	if (ec != STXETX_ERROR_NO_ERROR)
+	if (g_sysid.state == SYSID_STATE_RUNNING && n_samples < SYSID_SAMPLES_PER_FRAME)
 	{
-		do_handle_fatal_error_with_error_code(ec);
+		return;
 	}
 	
-	usart_send_frame(frame);
-}
-
-
-void do_on_command_complete(void)
-{
-	pause_pid_timer();
-	
-	// Stop motors by setting their speed to 0.
-	configure_motors_for_action(0, 0, 0);
+	size_t required_space = SYSID_DATA_FRAME_MAX_ENCODED_SIZE;
+#if defined(SYSID_FIT_MODEL)
+	if (n_samples == 0)
+	{
+		required_space += SYSID_RESULT_FRAME_MAX_ENCODED_SIZE;
+	}
+#endif
 	
-	cma_reset(&g_motor_1.hall_encoder.average_rps);
-	cma_reset(&g_motor_2.hall_encoder.average_rps);
-	cma_reset(&g_motor_3.hall_encoder.average_rps);
+	if (usart_tx_queue_get_free_space() < required_space)
+	{
+		Scheduler_Post(&g_scheduler, TASK_SYSID_STREAM);
+		return;
+	}
 	
-	// Clamp PWM to 0% duty cycle
-	OCR0B = 0xFF;
-	OCR2A = 0xFF;
-	OCR2B = 0xFF;
+	if (n_samples > SYSID_SAMPLES_PER_FRAME)
+	{
+		n_samples = SYSID_SAMPLES_PER_FRAME;
+	}
 	
-	PID_ClearAccumulatedValues(&g_motor_1.pid);
-	PID_ClearAccumulatedValues(&g_motor_2.pid);
-	PID_ClearAccumulatedValues(&g_motor_3.pid);
-	//debug_led_off();
+	uint16_t dropped_samples_count = 0;
 	
-	// Send `FINISHED` message
-	stxetx_frame_t frame;
-	stxetx_init_empty_frame(&frame);
-	frame.msg_type = MSG_TYPE_FINISHED;
-	usart_send_frame(frame);
-}
-
-
-inline void command_buffer_write_byte(uint8_t data_byte)
-{
-	g_frame_decode_buffer[g_frame_decode_buffer_length++] = data_byte;
-}
-
-inline void clear_command_buffer()
-{
-	g_frame_decode_buffer_length = 0;
-	memset(g_frame_decode_buffer, 0, FRAME_DECODE_BUFFER_SIZE);
-}
-
-
-void do_on_command_byte_received(uint8_t byte_received)
-{
-	switch (g_frame_receiver_state)
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		case CMD_RCV_IDLE:
-			if(stxetx_is_character_frame_start_delimiter(byte_received))
-			{
-				clear_command_buffer();
-				command_buffer_write_byte(byte_received);
-				g_frame_receiver_state = CMD_RCV_RECEIVING_IN_PROCESS;
-			}
-			else
-			{
-				// Error state:
-				// Invalid character received, expected STX character
-				// TODO Write error data to EEPROM
-				goto error;
-			}
-		break;
-		case CMD_RCV_RECEIVING_IN_PROCESS:
-			if (stxetx_is_character_frame_end_delimiter(byte_received))
-			{
-				command_buffer_write_byte(byte_received);
-				g_frame_receiver_state = CMD_RCV_FULL_FRAME_READ;
-				g_flag_frame_awaits_decoding = 1;
-			}
-			else if(stxetx_is_character_escape(byte_received))
-			{
-				command_buffer_write_byte(byte_received);
-				g_frame_receiver_state = CMD_RCV_ESCAPE_ACTIVE;
-			}
-			else if(stxetx_is_character_frame_start_delimiter(byte_received))
-			{
-				// Error state:
-				// Detected unescaped STX character in middle of a frame
-				goto error;
-			}
-			else if(g_frame_decode_buffer_length < FRAME_DECODE_BUFFER_SIZE)
-			{
-				command_buffer_write_byte(byte_received);
-			}
-			else
-			{
-				// Error state:
-				// Buffer Overflowed
-				goto error;
-			}
-		break;
-		case CMD_RCV_ESCAPE_ACTIVE:
-			if (g_frame_decode_buffer_length < FRAME_DECODE_BUFFER_SIZE)
-			{
-				command_buffer_write_byte(byte_received);
-				g_frame_receiver_state = CMD_RCV_RECEIVING_IN_PROCESS;
-			}
-			else
-			{
-				// Error state:
-				// Buffer Overflowed
-				goto error;
-			}
-		break;
-		case CMD_RCV_FULL_FRAME_READ:
-			// Always an error case
-			// Should be reset externally after reading command
-			goto error;
-		default:
-		// Error state:
-		// Unknown State
-		goto error;
+		dropped_samples_count = g_sysid.dropped_samples_count;
 	}
 	
-	return;
+	stxetx_encoder_t encoder;
+	usart_frame_begin(&encoder, MSG_TYPE_SYSID_DATA, 0);
+	stxetx_encoder_push_bytes(&encoder, (const uint8_t*)&dropped_samples_count, sizeof(uint16_t));
+	stxetx_encoder_push_bytes(&encoder, &n_samples, sizeof(uint8_t));
 	
-error:
-	g_frame_receiver_state = CMD_RCV_IDLE;
-	clear_command_buffer();
-	return;
-}
-
-void do_parse_received_frame(void)
-{
-	uint8_t payload_buffer[PAYLOAD_BUFFER_SIZE] = {0};
-	stxetx_init_empty_frame(&g_received_frame);
+	for (uint8_t i = 0; i < n_samples; i++)
+	{
+		sysid_sample_t sample;
+		sysid_ring_pop(&g_sysid_ring, &sample);
+		stxetx_encoder_push_bytes(&encoder, (const uint8_t*)&sample, sizeof(sysid_sample_t));
+	}
 	
-	uint8_t status = stxetx_decode_n(
-		g_frame_decode_buffer,
-		&g_received_frame,
-		g_frame_decode_buffer_length,
-		payload_buffer,
-		PAYLOAD_BUFFER_SIZE
-	);
+	usart_frame_end(&encoder);
 	
-	if (status != STXETX_ERROR_NO_ERROR)
+	if (n_samples == 0)
 	{
-		// Error State:
-		// TODO: Write to EEPROM
-		do_handle_fatal_error_with_error_code(status);
+#if defined(SYSID_FIT_MODEL)
+		do_send_sysid_result();
+#endif
+		g_sysid.state = SYSID_STATE_IDLE;
 		return;
 	}
-}								  
-
-void setup_motors(void)
-{
-	g_motor_1.hall_encoder.current_rps = 0;
-	g_motor_2.hall_encoder.current_rps = 0;
-	g_motor_3.hall_encoder.current_rps = 0;
 	
-	cma_init(&g_motor_1.hall_encoder.average_rps);
-	cma_init(&g_motor_2.hall_encoder.average_rps);
-	cma_init(&g_motor_3.hall_encoder.average_rps);
+	Scheduler_Post(&g_scheduler, TASK_SYSID_STREAM);
 }
 
 int main(void)
 {
+	// Reset cause is cleared, so next reset reports only its own
+	const uint8_t reset_flags = MCUSR;
+	MCUSR = 0;
 	
 	// Setup
 	setup_gpio_pins();
 	
-	configure_motor_pwm_timer();
-	setup_pid_timer();
-	setup_task_timer();
-	configure_pulse_tick_timer();
+	motor_pwm_init();
+	setup_system_clock();
+	setup_soft_timers();
+	PulseTickTimer_Init(on_pulse_tick_timer_overflow);
 	
 	setup_usart_receive();
+	setup_usart_transmit();
 	
 	setup_PID();
+#if defined(USE_CURRENT_SENSING)
+	setup_current_sensing();
+#endif
 	
 	enable_encoder_interrupt();
-	enable_pulse_tick_timer();
+	PulseTickTimer_Start();
+	
+	PROFILER_INIT();
 	
 	setup_motors();
+	setup_scheduler();
+	
+	EventLog_Init();
+	do_log_event(EVENT_CODE_BOOT, reset_flags);
 	
 	sei();
 
-	enable_pid_timer();
-	pause_pid_timer();
-	enable_task_timer();
-	
-	g_frame_receiver_state = CMD_RCV_IDLE;
+	enable_system_clock();
 	
     while (1) 
     {
-		if(g_motor_1.hall_encoder.is_measurement_ready)
-		{
-			do_update_rps(&g_motor_1.hall_encoder);
-			g_motor_1.hall_encoder.is_measurement_ready = 0;
-		}
-		
-		if(g_motor_2.hall_encoder.is_measurement_ready)
-		{
-			do_update_rps(&g_motor_2.hall_encoder);
-			g_motor_2.hall_encoder.is_measurement_ready = 0;
-		}
-		
-		if(g_motor_3.hall_encoder.is_measurement_ready)
-		{
-			do_update_rps(&g_motor_3.hall_encoder);
-			g_motor_3.hall_encoder.is_measurement_ready = 0;
-		}
-		
-		if(g_flag_pid && g_flag_command_running)
-		{
-			do_advance_pids();
-			g_flag_pid = 0;
-		}
-		
-		if(CBuf_AvailableForRead(g_receive_buffer) && g_frame_receiver_state != CMD_RCV_FULL_FRAME_READ)
-		{
-			uint8_t value;
-			uint8_t error = CBuf_Read(&g_receive_buffer, &value);
-			if (error == STXETX_ERROR_NO_ERROR)
-			{
-				do_on_command_byte_received(value);
-			}
-			else
-			{
-				do_handle_fatal_error_with_error_code(error);
-			}
-		}
-
-		if(g_flag_frame_awaits_decoding && !g_flag_command_in_queue)
-		{	
-			do_parse_received_frame();
-			g_flag_frame_awaits_decoding = 0;
-			g_flag_command_in_queue = 1;
-			g_frame_receiver_state = CMD_RCV_IDLE;
-		}
-		
-		if (g_flag_command_in_queue)
-		{
-			do_execute_command();
-			
-			//WRITE_PIN(MOTOR_1_PWM, 0);
-			//
-			//g_motor_1.setpoint = 0;
-			//SET_MOTOR_DIRECTION_FORWARD(MOTOR_1_IN_A, MOTOR_1_IN_B);
-			//g_motor_2.setpoint = 0;
-			//SET_MOTOR_DIRECTION_STOP(MOTOR_2_IN_A, MOTOR_2_IN_B);
-			//g_motor_3.setpoint = 0;
-			//SET_MOTOR_DIRECTION_STOP(MOTOR_3_IN_A, MOTOR_3_IN_B);
-			//
-			//g_flag_command_running = 1;
-			//g_command_duration_counter__50ms_ticks = 0;
-			
-			//resume_pid_timer();
-			
-			g_flag_command_in_queue = 0;
-		}
-		
-		if(g_flag_command_running
-			&& g_odometry_time_since_last_broadcast__50ms_ticks >= odometry_broadcast_period__50ms_ticks)
-		{
-			do_broadcast_average_rps();
-			g_odometry_time_since_last_broadcast__50ms_ticks = 0;
-		}
-		
-		if(g_flag_command_running
-			&& g_command_duration_counter__50ms_ticks >= g_target_command_duration__50ms_ticks)
-		{
-			do_on_command_complete();
-			g_flag_command_running = 0;
-			g_command_duration_counter__50ms_ticks = 0;
-		}
+		Scheduler_RunNextOrSleep(&g_scheduler);
     }
 }
 
@@ -1425,84 +5143,211 @@ int main(void)
  *	Start Signal Handlers
  */
 
-ISR(INT4_vect)
+#if defined(USE_INPUT_CAPTURE_ENCODER)
+ISR(MOTOR_1_ENCODER_ISR)
 {
-	hall_encoder_do_save_timer_value(&g_motor_1.hall_encoder);
+	hall_encoder_do_save_capture_value(&g_motor_1.hall_encoder, ICR4, capture_timer_4_high_nibble, IS_BIT_SET(TIFR4, TOV4));
 }
 
-ISR(INT5_vect)
+ISR(MOTOR_2_ENCODER_ISR)
 {
-	hall_encoder_do_save_timer_value(&g_motor_2.hall_encoder);
+	hall_encoder_do_save_capture_value(&g_motor_2.hall_encoder, ICR5, capture_timer_5_high_nibble, IS_BIT_SET(TIFR5, TOV5));
 }
 
-ISR(INT2_vect)
+ISR(TIMER4_OVF_vect)
 {
-	hall_encoder_do_save_timer_value(&g_motor_3.hall_encoder);
+	++capture_timer_4_high_nibble;
 }
 
-ISR(TIMER1_OVF_vect)
+ISR(TIMER5_OVF_vect)
 {
-	++pulse_tick_counter_high_nibble;
+	++capture_timer_5_high_nibble;
 }
+#endif
 
-ISR(TIMER4_COMPA_vect)
-{	
-	// Signal the loop that PID is waiting for next calculation
-	if (g_flag_command_running)
-	{
-		g_flag_pid = 1;
-	}
+// Channel A of motors on external interrupts (See. board_config.h)
+#if defined(USE_QUADRATURE_ENCODER)
+#define DEFINE_MOTOR_ENCODER_ISR(N)	\
+	ISR(MOTOR_##N##_ENCODER_ISR) { motor_do_on_quadrature_edge(&g_motor_##N, MOTOR_QUADRATURE_STATE(N), 1); }
+#else
+#define DEFINE_MOTOR_ENCODER_ISR(N)	\
+	ISR(MOTOR_##N##_ENCODER_ISR) { hall_encoder_do_save_timer_value(&g_motor_##N.hall_encoder); }
+#endif
+BOARD_FOR_EACH_EXT_INT_MOTOR(DEFINE_MOTOR_ENCODER_ISR)
+
+#if defined(USE_QUADRATURE_ENCODER)
+// Channel B of all motors (unchanged motors decode as zero step)
+ISR(PCINT2_vect)
+{
+#define ON_MOTOR_CHANNEL_B_EDGE(N)	\
+	motor_do_on_quadrature_edge(&g_motor_##N, MOTOR_QUADRATURE_STATE(N), 0);
+	BOARD_FOR_EACH_MOTOR(ON_MOTOR_CHANNEL_B_EDGE)
 }
+#endif
 
 ISR(TIMER3_COMPA_vect)
 {
-	// Increment task timers
+	const uint32_t now_ms = ++g_system_clock_ms;
 	
-	// ONLY If command is being executed:
-	if (g_flag_command_running)
+	if (g_flag_pid_tick_enabled && now_ms == g_pid_tick_deadline_ms)
+	{
+		// Next tick is scheduled from this deadline (no drift)
+		g_pid_tick_deadline_ms = now_ms + PID_TICK_PERIOD_MS;
+		
+		// Signal the loop that PID is waiting for next calculation
+		// (identification and auto-tuning runs use PID tick for excitation)
+		if (g_flag_command_running || g_sysid.state == SYSID_STATE_RUNNING || g_autotune.is_running)
+		{
+			// Previous tick was not handled yet, it is merged with this one
+			if (Scheduler_IsPostedFromISR(&g_scheduler, TASK_ADVANCE_PIDS) && g_pid_missed_ticks_count != UINT16_MAX)
+			{
+				++g_pid_missed_ticks_count;
+			}
+			
+			g_pid_tick_timestamp = PulseTickTimer_GetTimestampFromISR();
+			Scheduler_PostFromISR(&g_scheduler, TASK_ADVANCE_PIDS);
+		}
+	}
+	
+	if (SoftTimer_IsDueFromISR(&g_soft_timers, now_ms))
+	{
+		Scheduler_PostFromISR(&g_scheduler, TASK_TASK_TIMERS);
+	}
+}
+
+ISR(EE_READY_vect)
+{
+	// Enabled only while PID gains or event log records are being saved,
+	// gains are written first
+	if (GainStore_IsBusy())
 	{
-		// Increment command duration counter
-		++g_command_duration_counter__50ms_ticks;
+		GainStore_OnEepromReady();
 		
-		// Increment odometry counter
-		++g_odometry_time_since_last_broadcast__50ms_ticks;
+		if (EventLog_IsBusy())
+		{
+			// Gain store disables interrupt when it is done
+			SET_BIT(EECR, EERIE);
+		}
+		return;
 	}
 	
+	EventLog_OnEepromReady();
+}
 
+#if defined(USE_CURRENT_SENSING)
+// Conversion of current sense output complete, next conversion is
+// started by trigger (See. motor_current.h)
+ISR(ADC_vect)
+{
+	const uint16_t sample = ADC;
+	volatile current_scan_t* p_scan = &g_current_scans[g_current_scan_converting];
+	
+	if (p_scan->count < CURRENT_SCAN_MAX_SAMPLES)
+	{
+		p_scan->sum += sample;
+		++p_scan->count;
+	}
+	
+	const uint8_t next = (g_current_scan_selected + 1 < MOTOR_COUNT) ? g_current_scan_selected + 1 : 0;
+	
+#if MOTOR_CURRENT_FREE_RUNNING
+	// Conversion in progress already uses selected channel
+	g_current_scan_converting = g_current_scan_selected;
+#else
+	g_current_scan_converting = next;
+#endif
+	g_current_scan_selected = next;
+	
+	ADMUX = MOTOR_CURRENT_ADMUX(g_current_adc_channels[next]);
+	motor_current_rearm_trigger_isr();
 }
+#endif
 
 ISR(USART0_RX_vect)
 {
-	if (
-		IS_BIT_SET(UCSR0A, RXC0)
-		&& CBuf_AvailableForWrite(g_receive_buffer)
-		/* && !g_flag_command_running */
-		)
+	PROFILE_BEGIN(PROBE_USART0_RX);
+	
+	// Reading UDR0 clears RX flag, byte is discarded if queue is full
+	const uint8_t byte_received = UDR0;
+	
+#if defined(USE_BUS_ADDRESSING)
+	// Frames of other nodes are dropped here, they never wake up receive task
+	uint8_t bytes_accepted[STXETX_ADDRESS_FILTER_MAX_OUTPUT];
+	const uint8_t n_accepted = stxetx_address_filter_feed(&g_receive_address_filter, byte_received, bytes_accepted);
+	
+	for (uint8_t i = 0; i < n_accepted; i++)
+	{
+		if (usart_rx_ring_push(&g_receive_buffer, bytes_accepted[i]))
+		{
+			Scheduler_PostFromISR(&g_scheduler, TASK_RECEIVE);
+		}
+		else
+		{
+			++g_receive_dropped_bytes_count;
+		}
+	}
+#else
+	if (usart_rx_ring_push(&g_receive_buffer, byte_received))
+	{
+		Scheduler_PostFromISR(&g_scheduler, TASK_RECEIVE);
+	}
+	else
+	{
+		++g_receive_dropped_bytes_count;
+	}
+#endif
+	
+	PROFILE_END(PROBE_USART0_RX);
+}
+
+ISR(USART0_UDRE_vect)
+{
+	uint8_t byte_to_send;
+	uint8_t is_byte_sent = 0;
+	
+	if (CBuf_Read(&g_transmit_buffer, &byte_to_send) == CBUF_ERROR_NO_ERROR)
 	{
-		uint8_t byte_received = UDR0;
-		
-		// For some reason, MSB is always 1
-		//byte_received &= 0x7F;
+		UDR0 = byte_to_send;
+		is_byte_sent = 1;
+	}
+	
+	// Transmit queue drained, stop interrupt until next usart_tx_queue_write()
+	if (!CBuf_AvailableForRead(&g_transmit_buffer))
+	{
+		CLR_BIT(UCSR0B, UDRIE0);
 		
-		uint8_t error = CBuf_Write(&g_receive_buffer, byte_received);
-		if (error != CBUF_ERROR_NO_ERROR)
+		// Speed switch waits until the last byte (just written) is shifted out
+		if (is_byte_sent && g_usart_speed.pending_speed != USART_SPEED_COUNT)
 		{
-			do_handle_fatal_error_with_error_code(error);
+			UCSR0A = _BV(U2X0) | _BV(TXC0);
+			SET_BIT(UCSR0B, TXCIE0);
 		}
-		
-		// // Loopback
-		//while (!IS_BIT_SET(UCSR0A, UDRE0))
-		//{
-			//;
-		//}
-		//UDR0 = byte_received;
 	}
-	else
+}
+
+ISR(USART0_TX_vect)
+{
+	// Last byte left shift register
+	if (g_usart_speed.pending_speed != USART_SPEED_COUNT)
+	{
+		g_usart_speed.previous_speed = g_usart_speed.speed;
+		g_usart_speed.speed = g_usart_speed.pending_speed;
+		g_usart_speed.pending_speed = USART_SPEED_COUNT;
+		g_usart_speed.is_switch_unconfirmed = 1;
+		usart_write_speed_registers(g_usart_speed.speed);
+		Scheduler_PostFromISR(&g_scheduler, TASK_TASK_TIMERS);
+	}
+	
+#if defined(USE_BUS_ADDRESSING)
+	// Release the bus unless another frame was queued meanwhile
+	if (!CBuf_AvailableForRead(&g_transmit_buffer))
 	{
-		// Read to clear RX flag
-		volatile uint8_t discard = UDR0;
-		UNUSED(discard);
+		WRITE_PIN(RS485_DE, 0);
 	}
+#else
+	// Enabled only for speed switch
+	CLR_BIT(UCSR0B, TXCIE0);
+#endif
 }
 
 /*
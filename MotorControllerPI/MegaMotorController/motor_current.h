@@ -0,0 +1,112 @@
+/*
+ * motor_current.h
+ *
+ * Current sense (CS) outputs of the three motor drivers, read by the ADC.
+ * Conversions are started by hardware and the ADC ISR only stores result
+ * and selects CS channel of next motor (round-robin scan), so the scan
+ * runs without any polling from main loop.
+ *
+ * Trigger depends on MOTOR_PWM_BACKEND (See. motor_pwm.h):
+ * - MOTOR_PWM_BACKEND_TIMER_0_2: TIMER 0 compare match A with OCR0A = TOP,
+ *                                PWM outputs are high around TOP, so every
+ *                                motor is sampled in the middle of its PWM
+ *                                pulse (one conversion per PWM period, 3.9 kHz).
+ *                                Sample is taken ~12us after TOP, pulses
+ *                                shorter than ~10% duty read low.
+ * - MOTOR_PWM_BACKEND_TIMER_5:   TIMER 5 can not trigger ADC, ADC runs
+ *                                free (~9.6 kHz, not synchronized to PWM)
+ * ADC clock is F_CPU / 128 (125 kHz at 16 MHz), reference is AVCC.
+ */
+
+
+#ifndef MOTOR_CURRENT_H_
+#define MOTOR_CURRENT_H_
+
+#include <stdint.h>
+#include <avr/io.h>
+#include "utils_bitops.h"
+
+#ifndef MOTOR_PWM_BACKEND
+	#error "Include motor_pwm.h before motor_current.h"
+#endif
+
+// VNH2SP30 sources 1/11370 of output current from CS pin, common boards
+// load it with 1.5 kOhm, which gives 0.13 V/A
+#ifndef MOTOR_CURRENT_SENSE_MV_PER_A
+#define MOTOR_CURRENT_SENSE_MV_PER_A 130UL
+#endif
+
+// ADC reference (AVCC)
+#define MOTOR_CURRENT_VREF_MV 5000UL
+
+// Current per ADC step in mA, Q8.8 (37.6 mA with defaults)
+#define MOTOR_CURRENT_MA_PER_LSB_Q8 \
+	((uint32_t)((MOTOR_CURRENT_VREF_MV * 1000UL * 256UL) / (1024UL * MOTOR_CURRENT_SENSE_MV_PER_A)))
+
+#if MOTOR_PWM_BACKEND == MOTOR_PWM_BACKEND_TIMER_0_2
+	// Conversion starts on trigger after ADC ISR, channel selected
+	// in ISR applies to the next conversion
+	#define MOTOR_CURRENT_FREE_RUNNING 0
+#else
+	// Next conversion starts as soon as one completes, channel selected
+	// in ISR applies to the conversion after the next one
+	#define MOTOR_CURRENT_FREE_RUNNING 1
+#endif
+
+// ADMUX of single ended input `channel` (ADC0..ADC7), right adjusted result
+#define MOTOR_CURRENT_ADMUX(CHANNEL) ((uint8_t)(_BV(REFS0) | ((CHANNEL) & 0x07)))
+
+// Configures ADC to convert `first_channel` on every trigger and enables
+// ADC interrupt. `channel_mask` selects ADC0..ADC7 pins used as CS inputs
+// (their digital input buffers are disabled).
+static inline void motor_current_init(uint8_t first_channel, uint8_t channel_mask)
+{
+	DIDR0 |= channel_mask;
+
+	ADMUX = MOTOR_CURRENT_ADMUX(first_channel);
+
+	// MUX5 = 0, single ended ADC0..ADC7
+	ADCSRB = 0;
+
+#if MOTOR_PWM_BACKEND == MOTOR_PWM_BACKEND_TIMER_0_2
+	// TIMER 0 compare match A at TOP (OC0A pin is not driven)
+	OCR0A = 0xFF;
+
+	// Auto trigger source: TIMER 0 compare match A (ADTS = 011)
+	SET_BIT(ADCSRB, ADTS0);
+	SET_BIT(ADCSRB, ADTS1);
+#endif
+	// else: auto trigger source free running (ADTS = 000)
+
+	// Enable ADC, auto trigger and interrupt, prescaler 128 (ADPS = 111)
+	ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+
+#if MOTOR_CURRENT_FREE_RUNNING
+	// Free running mode needs first conversion to be started
+	SET_BIT(ADCSRA, ADSC);
+#endif
+}
+
+// Re-arms trigger after conversion. MUST be called from ADC ISR.
+// Conversion starts on rising edge of trigger flag, which is not cleared
+// by hardware (TIMER 0 compare match A interrupt is not enabled).
+static inline void motor_current_rearm_trigger_isr(void)
+{
+#if MOTOR_PWM_BACKEND == MOTOR_PWM_BACKEND_TIMER_0_2
+	TIFR0 = _BV(OCF0A);
+#endif
+}
+
+// Converts sum of `count` ADC samples to mean current in mA (0 if count is 0)
+static inline uint16_t motor_current_convert_to_ma(uint16_t sum, uint8_t count)
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	// Sum is at most 64 samples (65472), product fits in 32 bits
+	return (uint16_t)((((uint32_t)sum * MOTOR_CURRENT_MA_PER_LSB_Q8) / count) >> 8);
+}
+
+#endif /* MOTOR_CURRENT_H_ */
@@ -315,8 +315,8 @@ PRIVATE volatile command_receiver_state_e g_frame_receiver_state = CMD_RCV_IDLE;
 												  
 													   
 
-PRIVATE volatile uint8_t g_receive_buffer_internal_[RECEIVE_BUFFER_SIZE] = {0};
-PRIVATE volatile circular_buffer_t g_receive_buffer;
+PRIVATE uint8_t g_receive_buffer_internal_[RECEIVE_BUFFER_SIZE] = {0};
+PRIVATE circular_buffer_t g_receive_buffer;
 
 
 /*
@@ -804,7 +804,7 @@ int main(void)
     while (1) 
     {
 	
-		if(CBuf_AvailableForRead(g_receive_buffer) && g_frame_receiver_state != CMD_RCV_FULL_FRAME_READ)
+		if(CBuf_AvailableForRead(&g_receive_buffer) && g_frame_receiver_state != CMD_RCV_FULL_FRAME_READ)
 		{
 			uint8_t value;
 			uint8_t error = CBuf_Read(&g_receive_buffer, &value);
@@ -880,7 +880,7 @@ ISR(USART_RX_vect)
 {
 	if (
 		IS_BIT_SET(UCSR0A, RXC0)
-		&& CBuf_AvailableForWrite(g_receive_buffer)
+		&& CBuf_AvailableForWrite(&g_receive_buffer)
 		/* && !g_flag_command_running */
 		)
 	{
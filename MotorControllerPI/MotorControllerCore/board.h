@@ -0,0 +1,70 @@
+/*
+ * board.h
+ *
+ * Compile-time board descriptor shared by all controller projects.
+ * Every project provides "board_config.h" next to its main.c, which defines:
+ * - BOARD_MOTOR_COUNT          number of motors (1..8, motor masks are 8-bit)
+ * - BOARD_FOR_EACH_MOTOR(X)    expands X(1) X(2) ... X(BOARD_MOTOR_COUNT)
+ * - MOTOR_<N>_IN_A, MOTOR_<N>_IN_B, MOTOR_<N>_PWM, MOTOR_<N>_HCHA
+ *                              pins of motor N (PIN_xn, See. util_pindefs.h),
+ *                              IN B only if BOARD_MOTOR_HAS_IN_B is not 0
+ *                              (See. board_motor.h)
+ * - MOTOR_<N>_HCHB             encoder channel B (quadrature builds only)
+ * - MOTOR_<N>_ENCODER_ISR      vector of encoder channel A interrupt
+ * - BOARD_FOR_EACH_EXT_INT_MOTOR(X), BOARD_FOR_EACH_PCINT_MOTOR(X)
+ *                              motors whose channel A is on INTn or on a
+ *                              pin change interrupt and their interrupt bits
+ *                              (optional, See. board_motor.h)
+ * - MOTOR_<N>_PWM_OCR, ...     PWM compare output of motor N and timers
+ *                              used by MOTOR_PWM_BACKEND (See. motor_pwm.h)
+ * - MOTOR_<N>_CS_ADC          ADC channel (0..7) of driver current sense
+ *                              output (current sensing builds only)
+ * - ONBOARD_LED
+ * - PROFILER_GPIO_PIN          scope probe pin of PROFILER_MODE_GPIO, must not
+ *                              be ONBOARD_LED (See. profiler.h)
+ * Boards without motor drivers (protocol sandboxes) only need the motor
+ * count, BOARD_FOR_EACH_MOTOR and ONBOARD_LED, pin entries are only needed by
+ * the modules which use them.
+ *
+ * Per-motor code is written as a macro of motor number N and expanded with
+ * BOARD_FOR_EACH_MOTOR, so pins, structures and array indices are compile
+ * time constants (single SBI/CBI per pin write, no pointer table or loop).
+ * A board with fewer motors generates no code for the missing ones.
+ */
+
+
+#ifndef BOARD_H_
+#define BOARD_H_
+
+#include "util_pindefs.h"
+
+// PWM backends of motor_pwm.h. Board descriptor may depend on the backend,
+// so MOTOR_PWM_BACKEND is set before board_config.h is included.
+#define MOTOR_PWM_BACKEND_TIMER_0_2	0
+#define MOTOR_PWM_BACKEND_TIMER_5	1
+
+#ifndef MOTOR_PWM_BACKEND
+#define MOTOR_PWM_BACKEND MOTOR_PWM_BACKEND_TIMER_0_2
+#endif
+
+#include "board_config.h"
+
+#if !defined(BOARD_MOTOR_COUNT) || (BOARD_MOTOR_COUNT < 1) || (BOARD_MOTOR_COUNT > 8)
+	#error "board_config.h must define BOARD_MOTOR_COUNT (1..8)"
+#endif
+
+#if !defined(BOARD_FOR_EACH_MOTOR)
+	#error "board_config.h must define BOARD_FOR_EACH_MOTOR(X)"
+#endif
+
+#if !defined(ONBOARD_LED)
+	#error "board_config.h must define ONBOARD_LED"
+#endif
+
+// Array index of motor number `N` (motor 1 has index 0)
+#define BOARD_MOTOR_INDEX(N)	((N) - 1)
+
+// Mask with bit of every motor index set
+#define BOARD_MOTOR_MASK		((uint8_t)((1U << BOARD_MOTOR_COUNT) - 1))
+
+#endif /* BOARD_H_ */
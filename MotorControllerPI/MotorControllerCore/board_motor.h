@@ -0,0 +1,107 @@
+/*
+ * board_motor.h
+ *
+ * VNH2SP30 driver pins and Hall encoder interrupts of the board descriptor
+ * (See. board.h). Per-motor macros take motor number N and are expanded with
+ * BOARD_FOR_EACH_MOTOR, so every pin write is a single SBI/CBI.
+ *
+ * Driver inputs: IN A & ~IN B = forward (clockwise), ~IN A & IN B = backward,
+ * both low = brake to GND. Boards with IN B tied to GND define
+ * BOARD_MOTOR_HAS_IN_B as 0, their motors only turn forward (BACKWARD is
+ * not defined, so using it fails the build).
+ *
+ * Encoder channel A interrupts on rising edges (IG32E). Motors on external
+ * interrupt INTn are listed by BOARD_FOR_EACH_EXT_INT_MOTOR, motors on pin
+ * change interrupts by BOARD_FOR_EACH_PCINT_MOTOR (ISR must check level of
+ * MOTOR_<N>_HCHA, pin change interrupts fire on both edges).
+ */
+
+
+#ifndef BOARD_MOTOR_H_
+#define BOARD_MOTOR_H_
+
+#include <avr/io.h>
+#include "utils_bitops.h"
+#include "board.h"
+
+#if !defined(BOARD_MOTOR_HAS_IN_B)
+#define BOARD_MOTOR_HAS_IN_B 1
+#endif
+
+#if BOARD_MOTOR_HAS_IN_B
+// Configures driver outputs and encoder input of motor N
+#define BOARD_MOTOR_SETUP_PINS(N)			\
+	PIN_MODE_OUTPUT(MOTOR_##N##_IN_A);		\
+	PIN_MODE_OUTPUT(MOTOR_##N##_IN_B);		\
+	PIN_MODE_OUTPUT(MOTOR_##N##_PWM);		\
+	PIN_MODE_INPUT(MOTOR_##N##_HCHA);
+
+#define BOARD_MOTOR_SET_FORWARD(N)			\
+	do {									\
+		WRITE_PIN(MOTOR_##N##_IN_A, 1);		\
+		WRITE_PIN(MOTOR_##N##_IN_B, 0);		\
+	} while (0)
+
+#define BOARD_MOTOR_SET_BACKWARD(N)			\
+	do {									\
+		WRITE_PIN(MOTOR_##N##_IN_A, 0);		\
+		WRITE_PIN(MOTOR_##N##_IN_B, 1);		\
+	} while (0)
+
+#define BOARD_MOTOR_SET_STOP(N)				\
+	do {									\
+		WRITE_PIN(MOTOR_##N##_IN_A, 0);		\
+		WRITE_PIN(MOTOR_##N##_IN_B, 0);		\
+	} while (0)
+#else
+#define BOARD_MOTOR_SETUP_PINS(N)			\
+	PIN_MODE_OUTPUT(MOTOR_##N##_IN_A);		\
+	PIN_MODE_OUTPUT(MOTOR_##N##_PWM);		\
+	PIN_MODE_INPUT(MOTOR_##N##_HCHA);
+
+#define BOARD_MOTOR_SET_FORWARD(N)	WRITE_PIN(MOTOR_##N##_IN_A, 1)
+#define BOARD_MOTOR_SET_STOP(N)		WRITE_PIN(MOTOR_##N##_IN_A, 0)
+#endif
+
+// Enables pullup (IG32E Hall encoder docs require 1k external pullup),
+// rising edge mode (ISCn1:0 = 11) and external interrupt of channel A
+#define BOARD_MOTOR_ENABLE_EXT_INT(N)				\
+	ENABLE_PULLUP(MOTOR_##N##_HCHA);				\
+	SET_BIT(MOTOR_##N##_EICR, MOTOR_##N##_ISC0);	\
+	SET_BIT(MOTOR_##N##_EICR, MOTOR_##N##_ISC1);	\
+	EIFR = _BV(MOTOR_##N##_EXT_INTF);				\
+	SET_BIT(EIMSK, MOTOR_##N##_EXT_INT);
+
+// Enables pullup and pin change interrupt of channel A
+#define BOARD_MOTOR_ENABLE_PCINT(N)					\
+	ENABLE_PULLUP(MOTOR_##N##_HCHA);				\
+	SET_BIT(MOTOR_##N##_PCMSK, MOTOR_##N##_PCINT);	\
+	SET_BIT(PCICR, MOTOR_##N##_PCIE);
+
+// Configures motor pins of every motor of the board, drivers start braked.
+static inline void board_motor_setup_pins(void)
+{
+#define BOARD_MOTOR_SETUP_STOPPED(N)	\
+	BOARD_MOTOR_SET_STOP(N);			\
+	BOARD_MOTOR_SETUP_PINS(N)
+	BOARD_FOR_EACH_MOTOR(BOARD_MOTOR_SETUP_STOPPED)
+#undef BOARD_MOTOR_SETUP_STOPPED
+}
+
+// Enables channel A interrupts of encoders on INTn and pin change interrupts.
+// Encoders timestamped otherwise (e.g. input capture) are set up by the board.
+static inline void board_motor_enable_encoder_interrupts(void)
+{
+	// Enable Pullups (Disable pullup blockade)
+	CLR_BIT(MCUCR, PUD);
+
+#if defined(BOARD_FOR_EACH_EXT_INT_MOTOR)
+	BOARD_FOR_EACH_EXT_INT_MOTOR(BOARD_MOTOR_ENABLE_EXT_INT)
+#endif
+
+#if defined(BOARD_FOR_EACH_PCINT_MOTOR)
+	BOARD_FOR_EACH_PCINT_MOTOR(BOARD_MOTOR_ENABLE_PCINT)
+#endif
+}
+
+#endif /* BOARD_MOTOR_H_ */
@@ -0,0 +1,291 @@
+/*
+ * circular_buffer.c
+ *
+ * Created: 6/14/2023 4:22:40 PM
+ *  Author: KASO
+ */ 
+
+#include "circular_buffer.h"
+#include <string.h> // memcpy
+
+#ifndef NULL
+#define NULL (void*)0x00
+#endif
+
+// Prevents compiler from moving buffer accesses across index update,
+// so the other side never sees an index before the data it covers
+#define CBUF_MEMORY_BARRIER_() __asm__ __volatile__("" ::: "memory")
+
+// Number of bytes in buffer
+#define CBUF_COUNT_(H) ((uint8_t)((H)->head - (H)->tail))
+
+// Initializes circular array to buffer `p_buffer` with maximal size of `buffer_size` bytes.
+// Returns circular_buffer_error_e
+uint8_t CBuf_Init(circular_buffer_t* h_circ_buffer, uint8_t* p_buffer, size_t buffer_size)
+{
+	if (h_circ_buffer == NULL)
+	{
+		return CBUF_ERROR_INVALID_HANDLE;
+	}
+	
+	if (p_buffer == NULL)
+	{
+		return CBUF_ERROR_INVALID_BUFFER_POINTER;
+	}
+	
+	// Power of two, so free-running indices can be wrapped with a mask
+	if (buffer_size == 0 || buffer_size > CBUF_MAX_SIZE || (buffer_size & (buffer_size - 1)) != 0)
+	{
+		return CBUF_ERROR_INVALID_SIZE;
+	}
+	
+	h_circ_buffer->p_buffer = p_buffer;
+	h_circ_buffer->buffer_size = buffer_size;
+	h_circ_buffer->index_mask = (uint8_t)(buffer_size - 1);
+	h_circ_buffer->head = 0;
+	h_circ_buffer->tail = 0;
+	
+	return CBUF_ERROR_NO_ERROR;
+}
+
+// Write `value` byte to the end of the buffer.
+uint8_t CBuf_Write(circular_buffer_t* h_circ_buffer, uint8_t value)
+{
+	if (h_circ_buffer == NULL)
+	{
+		return CBUF_ERROR_INVALID_HANDLE;
+	}
+	
+	const uint8_t head = h_circ_buffer->head;
+	
+	if ((uint8_t)(head - h_circ_buffer->tail) >= h_circ_buffer->buffer_size)
+	{
+		return CBUF_ERROR_BUFFER_FULL;
+	}
+	
+	h_circ_buffer->p_buffer[head & h_circ_buffer->index_mask] = value;
+	
+	CBUF_MEMORY_BARRIER_();
+	h_circ_buffer->head = head + 1;
+	
+	return CBUF_ERROR_NO_ERROR;
+}
+
+// Write `n` bytes from `p_src` to the end of the buffer (all-or-nothing).
+uint8_t CBuf_WriteN(circular_buffer_t* h_circ_buffer, const uint8_t* p_src, size_t n)
+{
+	if (h_circ_buffer == NULL)
+	{
+		return CBUF_ERROR_INVALID_HANDLE;
+	}
+	
+	if (p_src == NULL)
+	{
+		return CBUF_ERROR_INVALID_BUFFER_POINTER;
+	}
+	
+	if (CBuf_GetFreeSpace(h_circ_buffer) < n)
+	{
+		return CBUF_ERROR_BUFFER_FULL;
+	}
+	
+	// Data may wrap around end of the raw buffer, so copy it in (at most) two chunks
+	const uint8_t head = h_circ_buffer->head;
+	const size_t head_index = head & h_circ_buffer->index_mask;
+	size_t first_chunk_size = h_circ_buffer->buffer_size - head_index;
+	if (first_chunk_size > n)
+	{
+		first_chunk_size = n;
+	}
+	
+	memcpy(&h_circ_buffer->p_buffer[head_index], p_src, first_chunk_size);
+	memcpy(h_circ_buffer->p_buffer, p_src + first_chunk_size, n - first_chunk_size);
+	
+	CBUF_MEMORY_BARRIER_();
+	h_circ_buffer->head = (uint8_t)(head + n);
+	
+	return CBUF_ERROR_NO_ERROR;
+}
+
+// Returns pointer to the free byte `offset` bytes after the end of the buffer.
+uint8_t* CBuf_GetWriteSlot(circular_buffer_t* h_circ_buffer, size_t offset)
+{
+	if (h_circ_buffer == NULL || offset >= h_circ_buffer->buffer_size)
+	{
+		return NULL;
+	}
+	
+	return &h_circ_buffer->p_buffer[(uint8_t)(h_circ_buffer->head + offset) & h_circ_buffer->index_mask];
+}
+
+// Returns number of free bytes reserved `offset` bytes after the end of the buffer without wrapping.
+size_t CBuf_GetWriteSpan(circular_buffer_t* h_circ_buffer, size_t offset, uint8_t** pp_span)
+{
+	if (h_circ_buffer == NULL || pp_span == NULL)
+	{
+		return 0;
+	}
+	
+	const size_t free_space = CBuf_GetFreeSpace(h_circ_buffer);
+	if (offset >= free_space)
+	{
+		return 0;
+	}
+	
+	const size_t head_index = (uint8_t)(h_circ_buffer->head + offset) & h_circ_buffer->index_mask;
+	const size_t until_end = h_circ_buffer->buffer_size - head_index;
+	const size_t available = free_space - offset;
+	
+	*pp_span = &h_circ_buffer->p_buffer[head_index];
+	
+	return (available < until_end) ? available : until_end;
+}
+
+// Publishes `n` bytes previously filled through `CBuf_GetWriteSlot()` or `CBuf_GetWriteSpan()`.
+uint8_t CBuf_CommitWrite(circular_buffer_t* h_circ_buffer, size_t n)
+{
+	if (h_circ_buffer == NULL)
+	{
+		return CBUF_ERROR_INVALID_HANDLE;
+	}
+	
+	if (CBuf_GetFreeSpace(h_circ_buffer) < n)
+	{
+		return CBUF_ERROR_BUFFER_FULL;
+	}
+	
+	CBUF_MEMORY_BARRIER_();
+	h_circ_buffer->head = (uint8_t)(h_circ_buffer->head + n);
+	
+	return CBUF_ERROR_NO_ERROR;
+}
+
+// Return `value` byte from the front of the buffer.
+uint8_t CBuf_Read(circular_buffer_t* h_circ_buffer, uint8_t* p_dest)
+{
+	if (h_circ_buffer == NULL)
+	{
+		return CBUF_ERROR_INVALID_HANDLE;
+	}
+	
+	const uint8_t tail = h_circ_buffer->tail;
+	
+	if (h_circ_buffer->head == tail)
+	{
+		return CBUF_ERROR_BUFFER_EMPTY;
+	}
+	
+	if (p_dest == NULL)
+	{
+		return CBUF_ERROR_DESTINATION_BUFFER_INVALID;
+	}
+	
+	CBUF_MEMORY_BARRIER_();
+	*p_dest = h_circ_buffer->p_buffer[tail & h_circ_buffer->index_mask];
+	
+	CBUF_MEMORY_BARRIER_();
+	h_circ_buffer->tail = tail + 1;
+	
+	return CBUF_ERROR_NO_ERROR;
+}
+
+// Read up to `n` bytes from the front of the buffer.
+uint8_t CBuf_ReadN(circular_buffer_t* h_circ_buffer, uint8_t* p_dest, size_t n, size_t* p_n_read)
+{
+	if (h_circ_buffer == NULL)
+	{
+		return CBUF_ERROR_INVALID_HANDLE;
+	}
+	
+	if (p_dest == NULL || p_n_read == NULL)
+	{
+		return CBUF_ERROR_DESTINATION_BUFFER_INVALID;
+	}
+	
+	*p_n_read = 0;
+	
+	const size_t available = CBuf_AvailableForRead(h_circ_buffer);
+	if (available == 0)
+	{
+		return CBUF_ERROR_BUFFER_EMPTY;
+	}
+	
+	if (n > available)
+	{
+		n = available;
+	}
+	
+	// Data may wrap around end of the raw buffer, so copy it in (at most) two chunks
+	const uint8_t tail = h_circ_buffer->tail;
+	const size_t tail_index = tail & h_circ_buffer->index_mask;
+	size_t first_chunk_size = h_circ_buffer->buffer_size - tail_index;
+	if (first_chunk_size > n)
+	{
+		first_chunk_size = n;
+	}
+	
+	CBUF_MEMORY_BARRIER_();
+	memcpy(p_dest, &h_circ_buffer->p_buffer[tail_index], first_chunk_size);
+	memcpy(p_dest + first_chunk_size, h_circ_buffer->p_buffer, n - first_chunk_size);
+	
+	CBUF_MEMORY_BARRIER_();
+	h_circ_buffer->tail = (uint8_t)(tail + n);
+	*p_n_read = n;
+	
+	return CBUF_ERROR_NO_ERROR;
+}
+
+// Returns contiguous readable span at the front of the buffer.
+size_t CBuf_PeekContiguous(const circular_buffer_t* h_circ_buffer, const uint8_t** pp_span)
+{
+	if (h_circ_buffer == NULL || pp_span == NULL)
+	{
+		return 0;
+	}
+	
+	const size_t available = CBuf_AvailableForRead(h_circ_buffer);
+	const size_t tail_index = h_circ_buffer->tail & h_circ_buffer->index_mask;
+	const size_t until_end = h_circ_buffer->buffer_size - tail_index;
+	
+	CBUF_MEMORY_BARRIER_();
+	*pp_span = &h_circ_buffer->p_buffer[tail_index];
+	
+	return (available < until_end) ? available : until_end;
+}
+
+// Releases `n` bytes from the front of the buffer.
+uint8_t CBuf_Consume(circular_buffer_t* h_circ_buffer, size_t n)
+{
+	if (h_circ_buffer == NULL)
+	{
+		return CBUF_ERROR_INVALID_HANDLE;
+	}
+	
+	if (CBuf_AvailableForRead(h_circ_buffer) < n)
+	{
+		return CBUF_ERROR_BUFFER_EMPTY;
+	}
+	
+	CBUF_MEMORY_BARRIER_();
+	h_circ_buffer->tail = (uint8_t)(h_circ_buffer->tail + n);
+	
+	return CBUF_ERROR_NO_ERROR;
+}
+
+// Returns number of bytes that can be read from the buffer
+size_t CBuf_AvailableForRead(const circular_buffer_t* h_circ_buffer)
+{
+	return CBUF_COUNT_(h_circ_buffer);
+}
+
+// Returns non-zero if byte can be written to the buffer
+uint8_t CBuf_AvailableForWrite(const circular_buffer_t* h_circ_buffer)
+{
+	return CBUF_COUNT_(h_circ_buffer) < h_circ_buffer->buffer_size;
+}
+
+// Returns number of bytes that can still be written to the buffer
+size_t CBuf_GetFreeSpace(const circular_buffer_t* h_circ_buffer)
+{
+	return h_circ_buffer->buffer_size - CBUF_COUNT_(h_circ_buffer);
+}
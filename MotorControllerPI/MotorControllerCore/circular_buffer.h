@@ -0,0 +1,117 @@
+/*
+ * circular_buffer.h
+ *
+ * Created: 6/14/2023 4:10:47 PM
+ *  Author: KASO
+ */ 
+
+
+#ifndef CIRCULAR_BUFFER_H_
+#define CIRCULAR_BUFFER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Single-producer/single-consumer byte ring.
+// Producer only modifies `head`, consumer only modifies `tail`; both are
+// 8-bit (read and written in one instruction on AVR), so an ISR and main
+// loop can use opposite ends of the buffer without disabling interrupts.
+// Indices are free-running and wrapped with `index_mask`, so buffer size
+// must be a power of two and at most CBUF_MAX_SIZE bytes.
+
+// Maximal buffer size (count `head - tail` must fit into 8 bits)
+#define CBUF_MAX_SIZE 128
+
+typedef struct {
+	// Pointer to raw buffer
+	uint8_t* p_buffer;
+	// Buffer size in bytes (power of two)
+	size_t buffer_size;
+	// `buffer_size - 1`, wraps free-running indices into `p_buffer`
+	uint8_t index_mask;
+	// Free-running index of the next byte to be written (modified only by producer)
+	volatile uint8_t head;
+	// Free-running index of the next byte to be read (modified only by consumer)
+	volatile uint8_t tail;
+} circular_buffer_t;
+
+typedef enum {
+	CBUF_ERROR_NO_ERROR = 0,
+	CBUF_ERROR_INVALID_HANDLE = 20,
+	CBUF_ERROR_INVALID_BUFFER_POINTER = 21,
+	CBUF_ERROR_BUFFER_EMPTY = 23,
+	CBUF_ERROR_BUFFER_FULL = 24,
+	CBUF_ERROR_DESTINATION_BUFFER_INVALID = 25,
+	CBUF_ERROR_INVALID_SIZE = 26
+} circular_buffer_error_e;
+
+// Initializes circular array to buffer `p_buffer` with maximal size of `buffer_size` bytes.
+// `buffer_size` must be a power of two, not larger than CBUF_MAX_SIZE.
+// Returns circular_buffer_error_e
+uint8_t CBuf_Init(circular_buffer_t* h_circ_buffer, uint8_t* p_buffer, size_t buffer_size);
+
+//////////////////////////////////////////////////////////////////////////
+// Producer side
+
+// Write `value` byte to the end of the buffer.
+// Returns circular_buffer_error_e
+// If data is written it returns CBUF_ERROR_NO_ERROR else CBUF_ERROR_BUFFER_FULL or another error.
+uint8_t CBuf_Write(circular_buffer_t* h_circ_buffer, uint8_t value);
+
+// Write `n` bytes from `p_src` to the end of the buffer.
+// Returns circular_buffer_error_e
+// Write is all-or-nothing: if there is not enough free space for all `n` bytes,
+// nothing is written and CBUF_ERROR_BUFFER_FULL is returned.
+uint8_t CBuf_WriteN(circular_buffer_t* h_circ_buffer, const uint8_t* p_src, size_t n);
+
+// Returns pointer to the free byte `offset` bytes after the end of the buffer
+// (two-phase write: fill reserved bytes in place, then publish them with `CBuf_CommitWrite()`).
+// Returns NULL if `offset` is outside of buffer. Caller must ensure that `offset`
+// is smaller than free space. Reserved bytes are not visible to the reader until committed.
+uint8_t* CBuf_GetWriteSlot(circular_buffer_t* h_circ_buffer, size_t offset);
+
+// Returns number of free bytes that can be reserved `offset` bytes after the end
+// of the buffer without wrapping around the end of the raw buffer, and points
+// `pp_span` to the first of them (two-phase write of a block, See. `CBuf_GetWriteSlot()`).
+// Returns 0 if `offset` is not smaller than free space.
+size_t CBuf_GetWriteSpan(circular_buffer_t* h_circ_buffer, size_t offset, uint8_t** pp_span);
+
+// Publishes `n` bytes previously filled through `CBuf_GetWriteSlot()` or `CBuf_GetWriteSpan()`.
+// Returns circular_buffer_error_e
+// If `n` is larger than free space, nothing is committed and CBUF_ERROR_BUFFER_FULL is returned.
+uint8_t CBuf_CommitWrite(circular_buffer_t* h_circ_buffer, size_t n);
+
+// Returns number of bytes that can still be written to the buffer
+size_t CBuf_GetFreeSpace(const circular_buffer_t* h_circ_buffer);
+
+// Returns non-zero if byte can be written to the buffer
+uint8_t CBuf_AvailableForWrite(const circular_buffer_t* h_circ_buffer);
+
+//////////////////////////////////////////////////////////////////////////
+// Consumer side
+
+// Read `value` byte from the front of the buffer.
+// Returns circular_buffer_error_e
+// If data is read it returns CBUF_ERROR_NO_ERROR else CBUF_ERROR_BUFFER_EMPTY or another error.
+uint8_t CBuf_Read(circular_buffer_t* h_circ_buffer, uint8_t* p_dest);
+
+// Read up to `n` bytes from the front of the buffer to `p_dest`.
+// Number of bytes read is written to `p_n_read`.
+// Returns circular_buffer_error_e (CBUF_ERROR_BUFFER_EMPTY if nothing was read)
+uint8_t CBuf_ReadN(circular_buffer_t* h_circ_buffer, uint8_t* p_dest, size_t n, size_t* p_n_read);
+
+// Returns number of bytes that can be read without wrapping around the end
+// of the raw buffer, and points `pp_span` to the first of them (zero-copy read).
+// Bytes stay in buffer until released with `CBuf_Consume()`.
+size_t CBuf_PeekContiguous(const circular_buffer_t* h_circ_buffer, const uint8_t** pp_span);
+
+// Releases `n` bytes from the front of the buffer (after `CBuf_PeekContiguous()`).
+// Returns circular_buffer_error_e
+// If `n` is larger than number of bytes in buffer, nothing is released and
+// CBUF_ERROR_BUFFER_EMPTY is returned.
+uint8_t CBuf_Consume(circular_buffer_t* h_circ_buffer, size_t n);
+
+// Returns number of bytes that can be read from the buffer
+size_t CBuf_AvailableForRead(const circular_buffer_t* h_circ_buffer);
+
+#endif /* CIRCULAR_BUFFER_H_ */
@@ -0,0 +1,211 @@
+/*
+ * event_log.c
+ *
+ * Implementation of event_log.h
+ */ 
+
+#include "event_log.h"
+#include "stxetx_protocol.h" // stxetx_crc8_update
+
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include <util/atomic.h>
+#include <string.h> // memcpy
+
+#ifndef NULL
+#define NULL (void*)0x00
+#endif
+
+// Sequence numbers wrap without skipping a slot
+#if (65536UL % EVENT_LOG_SLOT_COUNT) != 0 || (EVENT_LOG_QUEUE_SIZE & (EVENT_LOG_QUEUE_SIZE - 1)) != 0
+	#error "EVENT_LOG_SLOT_COUNT and EVENT_LOG_QUEUE_SIZE must be powers of two"
+#endif
+
+static event_log_record_t EEMEM g_event_log_eeprom[EVENT_LOG_SLOT_COUNT];
+
+// Records waiting for EEPROM, `queue_tail` is being written
+static event_log_record_t g_event_log_queue[EVENT_LOG_QUEUE_SIZE];
+static volatile uint8_t g_event_log_queue_head = 0;
+static volatile uint8_t g_event_log_queue_tail = 0;
+
+// Byte of record at `queue_tail` written next
+static volatile uint8_t g_event_log_write_offset = 0;
+
+// Sequence number of next record, it is stored in slot
+// `sequence % EVENT_LOG_SLOT_COUNT` (slot after newest record)
+static uint16_t g_event_log_next_sequence = 0;
+
+static volatile uint16_t g_event_log_dropped_count = 0;
+
+static uint8_t event_log_calculate_crc(const event_log_record_t* p_record)
+{
+	const uint8_t* p_bytes = (const uint8_t*)p_record;
+	uint8_t crc = 0;
+	
+	for (uint8_t i = 0; i < sizeof(event_log_record_t) - 1; i++)
+	{
+		crc = stxetx_crc8_update(crc, p_bytes[i]);
+	}
+	
+	return crc;
+}
+
+static uint8_t event_log_is_valid(const event_log_record_t* p_record)
+{
+	return p_record->code != EVENT_LOG_CODE_ERASED && p_record->crc == event_log_calculate_crc(p_record);
+}
+
+// Writes next byte of record at queue tail, returns 0 if queue is empty.
+// MUST be called with interrupts disabled.
+static uint8_t event_log_write_next_byte(void)
+{
+	if (g_event_log_queue_head == g_event_log_queue_tail)
+	{
+		return 0;
+	}
+	
+	const uint8_t i_record = g_event_log_queue_tail & (EVENT_LOG_QUEUE_SIZE - 1);
+	const event_log_record_t* p_record = &g_event_log_queue[i_record];
+	uint8_t* p_eeprom = (uint8_t*)&g_event_log_eeprom[p_record->sequence % EVENT_LOG_SLOT_COUNT];
+	const uint8_t offset = g_event_log_write_offset;
+	
+	// Unchanged bytes are not written (no wait for next interrupt).
+	// CRC is written last, so record becomes valid when it is complete.
+	eeprom_update_byte(p_eeprom + offset, ((const uint8_t*)p_record)[offset]);
+	
+	if ((uint8_t)(offset + 1) < sizeof(event_log_record_t))
+	{
+		g_event_log_write_offset = offset + 1;
+	}
+	else
+	{
+		g_event_log_write_offset = 0;
+		++g_event_log_queue_tail;
+	}
+	
+	return 1;
+}
+
+void EventLog_Init(void)
+{
+	uint8_t has_newest = 0;
+	uint16_t newest_sequence = 0;
+	
+	for (uint8_t slot = 0; slot < EVENT_LOG_SLOT_COUNT; slot++)
+	{
+		event_log_record_t record;
+		eeprom_read_block((void*)&record, (const void*)&g_event_log_eeprom[slot], sizeof(event_log_record_t));
+		
+		// Record with sequence S is always stored in slot S % EVENT_LOG_SLOT_COUNT
+		if (!event_log_is_valid(&record) || (record.sequence % EVENT_LOG_SLOT_COUNT) != slot)
+		{
+			continue;
+		}
+		
+		if (!has_newest || (int16_t)(record.sequence - newest_sequence) > 0)
+		{
+			has_newest = 1;
+			newest_sequence = record.sequence;
+		}
+	}
+	
+	g_event_log_next_sequence = has_newest ? (uint16_t)(newest_sequence + 1) : 0;
+}
+
+uint8_t EventLog_Append(uint32_t timestamp_ms, uint8_t code, uint8_t detail, const uint8_t* snapshot)
+{
+	uint8_t is_queued = 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (code != EVENT_LOG_CODE_ERASED
+			&& (uint8_t)(g_event_log_queue_head - g_event_log_queue_tail) < EVENT_LOG_QUEUE_SIZE)
+		{
+			event_log_record_t* p_record = &g_event_log_queue[g_event_log_queue_head & (EVENT_LOG_QUEUE_SIZE - 1)];
+			
+			p_record->sequence = g_event_log_next_sequence++;
+			p_record->timestamp_ms = timestamp_ms;
+			p_record->code = code;
+			p_record->detail = detail;
+			
+			if (NULL != snapshot)
+			{
+				memcpy((void*)p_record->snapshot, (const void*)snapshot, EVENT_LOG_SNAPSHOT_SIZE);
+			}
+			else
+			{
+				memset((void*)p_record->snapshot, 0, EVENT_LOG_SNAPSHOT_SIZE);
+			}
+			
+			p_record->crc = event_log_calculate_crc(p_record);
+			
+			++g_event_log_queue_head;
+			is_queued = 1;
+			
+			// Interrupt fires as soon as EEPROM is ready
+			EECR |= _BV(EERIE);
+		}
+		else if (g_event_log_dropped_count != UINT16_MAX)
+		{
+			++g_event_log_dropped_count;
+		}
+	}
+	
+	return is_queued;
+}
+
+uint8_t EventLog_Read(uint8_t index, event_log_record_t* p_record)
+{
+	if (NULL == p_record || index >= EVENT_LOG_SLOT_COUNT)
+	{
+		return 0;
+	}
+	
+	uint8_t slot = 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		// Next slot to be written holds oldest record
+		slot = (uint8_t)((g_event_log_next_sequence + index) % EVENT_LOG_SLOT_COUNT);
+	}
+	
+	eeprom_read_block((void*)p_record, (const void*)&g_event_log_eeprom[slot], sizeof(event_log_record_t));
+	
+	return event_log_is_valid(p_record) && (p_record->sequence % EVENT_LOG_SLOT_COUNT) == slot;
+}
+
+uint8_t EventLog_IsBusy(void)
+{
+	return g_event_log_queue_head != g_event_log_queue_tail;
+}
+
+uint16_t EventLog_GetDroppedCount(void)
+{
+	uint16_t dropped_count = 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		dropped_count = g_event_log_dropped_count;
+	}
+	
+	return dropped_count;
+}
+
+void EventLog_Flush(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		// eeprom_update_byte() waits for previous write
+		while (event_log_write_next_byte())
+		{
+		}
+	}
+}
+
+void EventLog_OnEepromReady(void)
+{
+	if (!event_log_write_next_byte())
+	{
+		EECR &= ~_BV(EERIE);
+	}
+}
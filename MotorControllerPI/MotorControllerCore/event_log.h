@@ -0,0 +1,74 @@
+/*
+ * event_log.h
+ *
+ * Persistent fault/event log in EEPROM.
+ * Records are written round-robin into a ring of EVENT_LOG_SLOT_COUNT slots,
+ * so every slot is rewritten only once per EVENT_LOG_SLOT_COUNT events
+ * (wear leveling). Newest record is found at boot by its sequence number,
+ * records carry CRC-8 so erased and torn slots are skipped.
+ * Appending does not block: records wait in a small RAM queue and are
+ * written one byte per EE_READY interrupt (about 3.4ms each) while control
+ * loop keeps running. PID gains (gain_store.h) have priority over the log.
+ */ 
+
+
+#ifndef EVENT_LOG_H_
+#define EVENT_LOG_H_
+
+#include <stdint.h>
+
+// Slots of ring in EEPROM (EVENT_LOG_SLOT_COUNT * sizeof(event_log_record_t) bytes)
+#define EVENT_LOG_SLOT_COUNT 64
+
+// Bytes of owner defined state snapshot in every record
+#define EVENT_LOG_SNAPSHOT_SIZE 8
+
+// Records which can wait for EEPROM (power of two)
+#define EVENT_LOG_QUEUE_SIZE 4
+
+// Code of erased slot, not accepted by EventLog_Append()
+#define EVENT_LOG_CODE_ERASED 0xFF
+
+// Record as stored in EEPROM (and sent to host), little endian, no padding
+typedef struct {
+	// Incremented with every record (wraps), orders records of the ring
+	uint16_t sequence;
+	uint32_t timestamp_ms;
+	// Owner defined event code and its detail (e.g. error code)
+	uint8_t code;
+	uint8_t detail;
+	uint8_t snapshot[EVENT_LOG_SNAPSHOT_SIZE];
+	// CRC-8 of all preceding bytes, written last
+	uint8_t crc;
+} event_log_record_t;
+
+// Finds newest record in EEPROM, next record is written behind it.
+// Blocks while EEPROM is read (call once at boot, before interrupts are enabled).
+void EventLog_Init(void);
+
+// Queues record, `snapshot` is copied (NULL = zeros).
+// Returns 1 if record was queued, 0 if queue is full or `code` is EVENT_LOG_CODE_ERASED
+// (record is dropped and counted, See. EventLog_GetDroppedCount()).
+// Can be called from main loop, tasks or ISRs.
+uint8_t EventLog_Append(uint32_t timestamp_ms, uint8_t code, uint8_t detail, const uint8_t* snapshot);
+
+// Reads slot `index` counted from oldest slot (0) to newest (EVENT_LOG_SLOT_COUNT - 1).
+// Returns 1 if slot holds valid record, 0 if it is erased or torn.
+// Blocks while EEPROM write is in progress (check EventLog_IsBusy() first).
+uint8_t EventLog_Read(uint8_t index, event_log_record_t* p_record);
+
+// Returns 1 while queued records are being written.
+uint8_t EventLog_IsBusy(void);
+
+// Returns number of records dropped because queue was full (saturated).
+uint16_t EventLog_GetDroppedCount(void);
+
+// Writes all queued records synchronously (e.g. before halting on fatal error).
+// Works with interrupts disabled.
+void EventLog_Flush(void);
+
+// Writes next byte of queued records. MUST be called from ISR(EE_READY_vect)
+// when no gain record is being saved, disables the interrupt when queue is empty.
+void EventLog_OnEepromReady(void);
+
+#endif /* EVENT_LOG_H_ */
@@ -0,0 +1,273 @@
+/*
+ * filter.c
+ *
+ * Implementation of filter.h
+ */ 
+
+#include "filter.h"
+
+#include <math.h>
+#include <stddef.h>
+
+#include "pid.h"
+
+//////////////////////////////////////////////////////////////////////////
+// Moving average
+
+void moving_average_init(moving_average_t* h_ma, uint8_t window_shift)
+{
+	if (h_ma == NULL)
+	{
+		return;
+	}
+
+	h_ma->window_shift = (window_shift > FILTER_MOVING_AVERAGE_MAX_SHIFT) ? FILTER_MOVING_AVERAGE_MAX_SHIFT : window_shift;
+	moving_average_reset(h_ma);
+}
+
+void moving_average_reset(moving_average_t* h_ma)
+{
+	if (h_ma == NULL)
+	{
+		return;
+	}
+
+	// Empty window is marked with it_oldest = 0xFF,
+	// first fed sample fills the window (See. moving_average_feed)
+	h_ma->sum = 0;
+	h_ma->it_oldest = 0xFF;
+}
+
+int32_t moving_average_feed(moving_average_t* h_ma, int32_t x)
+{
+	if (h_ma == NULL)
+	{
+		return 0;
+	}
+
+	const uint8_t window = 1 << h_ma->window_shift;
+
+	if (h_ma->it_oldest == 0xFF)
+	{
+		// First sample after reset fills the whole window
+		for (uint8_t i = 0; i < window; i++)
+		{
+			h_ma->samples[i] = x;
+		}
+
+		h_ma->sum = x * window;
+		h_ma->it_oldest = 0;
+		return x;
+	}
+
+	h_ma->sum += x - h_ma->samples[h_ma->it_oldest];
+	h_ma->samples[h_ma->it_oldest] = x;
+	h_ma->it_oldest = (h_ma->it_oldest + 1) & (window - 1);
+
+	return h_ma->sum >> h_ma->window_shift;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Median
+
+void median_filter_init(median_filter_t* h_median, uint8_t n_taps)
+{
+	if (h_median == NULL)
+	{
+		return;
+	}
+
+	h_median->n_taps = (n_taps >= FILTER_MEDIAN_MAX_TAPS) ? FILTER_MEDIAN_MAX_TAPS : ((n_taps >= 3) ? 3 : 0);
+	median_filter_reset(h_median);
+}
+
+void median_filter_reset(median_filter_t* h_median)
+{
+	if (h_median == NULL)
+	{
+		return;
+	}
+
+	h_median->it_next = 0;
+	h_median->is_empty = 1;
+}
+
+int32_t median_filter_feed(median_filter_t* h_median, int32_t x)
+{
+	if (h_median == NULL)
+	{
+		return 0;
+	}
+
+	const uint8_t n = h_median->n_taps;
+
+	if (n == 0)
+	{
+		return x;
+	}
+
+	if (h_median->is_empty)
+	{
+		for (uint8_t i = 0; i < n; i++)
+		{
+			h_median->samples[i] = x;
+		}
+
+		h_median->is_empty = 0;
+	}
+
+	h_median->samples[h_median->it_next] = x;
+	h_median->it_next = (h_median->it_next + 1 == n) ? 0 : h_median->it_next + 1;
+
+	// Insertion sort of at most 5 elements
+	int32_t sorted[FILTER_MEDIAN_MAX_TAPS];
+
+	for (uint8_t i = 0; i < n; i++)
+	{
+		const int32_t value = h_median->samples[i];
+		uint8_t j = i;
+
+		while (j > 0 && sorted[j - 1] > value)
+		{
+			sorted[j] = sorted[j - 1];
+			--j;
+		}
+
+		sorted[j] = value;
+	}
+
+	return sorted[n / 2];
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Biquad
+
+void biquad_init_lowpass(biquad_t* h_biquad, float cutoff_ratio)
+{
+	if (h_biquad == NULL)
+	{
+		return;
+	}
+
+	if (cutoff_ratio < FILTER_BIQUAD_MIN_CUTOFF_RATIO)
+	{
+		cutoff_ratio = FILTER_BIQUAD_MIN_CUTOFF_RATIO;
+	}
+	else if (cutoff_ratio >= 0.5f)
+	{
+		cutoff_ratio = 0.499f;
+	}
+
+	// Bilinear transform of 2nd order Butterworth low-pass
+	const float w0 = 2.0f * (float)M_PI * cutoff_ratio;
+	const float cos_w0 = cosf(w0);
+	const float alpha = sinf(w0) / (2.0f * 0.70710678f);
+	const float a0 = 1.0f + alpha;
+
+	h_biquad->b0 = PIDQ_FROM_FLOAT(((1.0f - cos_w0) / 2.0f) / a0);
+	h_biquad->b2 = h_biquad->b0;
+	h_biquad->a1 = PIDQ_FROM_FLOAT((-2.0f * cos_w0) / a0);
+	h_biquad->a2 = PIDQ_FROM_FLOAT((1.0f - alpha) / a0);
+	// b0 + b1 + b2 = 1 + a1 + a2 keeps unity DC gain despite rounding
+	h_biquad->b1 = PIDQ_ONE + h_biquad->a1 + h_biquad->a2 - 2 * h_biquad->b0;
+
+	biquad_reset(h_biquad);
+}
+
+void biquad_reset(biquad_t* h_biquad)
+{
+	if (h_biquad == NULL)
+	{
+		return;
+	}
+
+	h_biquad->x1 = 0;
+	h_biquad->x2 = 0;
+	h_biquad->y1 = 0;
+	h_biquad->y2 = 0;
+	h_biquad->is_empty = 1;
+}
+
+int32_t biquad_feed(biquad_t* h_biquad, int32_t x)
+{
+	if (h_biquad == NULL)
+	{
+		return 0;
+	}
+
+	if (h_biquad->is_empty)
+	{
+		// Start in steady state (unity DC gain), avoids slow start from 0
+		h_biquad->x1 = x;
+		h_biquad->x2 = x;
+		h_biquad->y1 = x;
+		h_biquad->y2 = x;
+		h_biquad->is_empty = 0;
+	}
+
+	// Sum is wider than products, so saturation below sees the true value
+	int64_t acc = (int64_t)PIDQ_Multiply(h_biquad->b0, x)
+		+ PIDQ_Multiply(h_biquad->b1, h_biquad->x1)
+		+ PIDQ_Multiply(h_biquad->b2, h_biquad->x2)
+		- PIDQ_Multiply(h_biquad->a1, h_biquad->y1)
+		- PIDQ_Multiply(h_biquad->a2, h_biquad->y2);
+
+	if (acc > INT32_MAX)
+	{
+		acc = INT32_MAX;
+	}
+	else if (acc < INT32_MIN)
+	{
+		acc = INT32_MIN;
+	}
+
+	const int32_t y = (int32_t)acc;
+
+	h_biquad->x2 = h_biquad->x1;
+	h_biquad->x1 = x;
+	h_biquad->y2 = h_biquad->y1;
+	h_biquad->y1 = y;
+
+	return y;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Mean accumulator
+
+void mean_accumulator_reset(mean_accumulator_t* h_mean)
+{
+	if (h_mean == NULL)
+	{
+		return;
+	}
+
+	h_mean->sum = 0;
+	h_mean->n_samples = 0;
+}
+
+void mean_accumulator_feed(mean_accumulator_t* h_mean, int32_t x)
+{
+	if (h_mean == NULL)
+	{
+		return;
+	}
+
+	// Sample count would overflow, further samples are ignored
+	if (h_mean->n_samples == UINT32_MAX)
+	{
+		return;
+	}
+
+	h_mean->sum += x;
+	++h_mean->n_samples;
+}
+
+int32_t mean_accumulator_get_value(mean_accumulator_t* h_mean)
+{
+	if (h_mean == NULL || h_mean->n_samples == 0)
+	{
+		return 0;
+	}
+
+	return (int32_t)(h_mean->sum / h_mean->n_samples);
+}
@@ -0,0 +1,116 @@
+/*
+ * filter.h
+ *
+ * Integer signal filters. Samples are `int32_t` in any fixed-point format
+ * (e.g. Q16.16), filters do not depend on position of the binary point.
+ * None of the filters divides per sample.
+ */ 
+
+
+#ifndef FILTER_H_
+#define FILTER_H_
+
+#include <stdint.h>
+
+// Maximal moving average window is 2^FILTER_MOVING_AVERAGE_MAX_SHIFT samples
+#ifndef FILTER_MOVING_AVERAGE_MAX_SHIFT
+#define FILTER_MOVING_AVERAGE_MAX_SHIFT 3
+#endif
+#define FILTER_MOVING_AVERAGE_MAX_WINDOW (1 << FILTER_MOVING_AVERAGE_MAX_SHIFT)
+
+// Maximal number of median filter taps
+#define FILTER_MEDIAN_MAX_TAPS 5
+
+// Lowest biquad cutoff ratio, below it Q16.16 coefficients are too coarse
+#define FILTER_BIQUAD_MIN_CUTOFF_RATIO 0.01f
+
+typedef struct
+{
+	int32_t samples[FILTER_MOVING_AVERAGE_MAX_WINDOW];
+	int32_t sum;
+	uint8_t it_oldest;
+	// Window size is 2^window_shift samples
+	uint8_t window_shift;
+} moving_average_t;
+
+typedef struct
+{
+	int32_t samples[FILTER_MEDIAN_MAX_TAPS];
+	uint8_t it_next;
+	// 0 or 1 disables filter, otherwise 3 or 5
+	uint8_t n_taps;
+	uint8_t is_empty;
+} median_filter_t;
+
+typedef struct
+{
+	// Coefficients (normalized by a0), Q16.16 (See. PIDQ_Multiply())
+	int32_t b0, b1, b2, a1, a2;
+	// Direct Form I state
+	int32_t x1, x2, y1, y2;
+	uint8_t is_empty;
+} biquad_t;
+
+typedef struct
+{
+	int64_t sum;
+	uint32_t n_samples;
+} mean_accumulator_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Moving average
+
+// Initializes moving average over 2^`window_shift` samples (clamped to
+// FILTER_MOVING_AVERAGE_MAX_SHIFT). Running sum is kept, so feeding is O(1).
+void moving_average_init(moving_average_t* h_ma, uint8_t window_shift);
+
+// Resets window, next sample fills the whole window.
+void moving_average_reset(moving_average_t* h_ma);
+
+// Feeds sample `x` and returns average of the last window.
+int32_t moving_average_feed(moving_average_t* h_ma, int32_t x);
+
+//////////////////////////////////////////////////////////////////////////
+// Median (spike rejection)
+
+// Initializes median filter over last `n_taps` samples.
+// `n_taps` is 3 or 5. 0 or 1 makes the filter pass samples through.
+void median_filter_init(median_filter_t* h_median, uint8_t n_taps);
+
+// Resets filter, next sample fills the whole window.
+void median_filter_reset(median_filter_t* h_median);
+
+// Feeds sample `x` and returns median of the last `n_taps` samples.
+int32_t median_filter_feed(median_filter_t* h_median, int32_t x);
+
+//////////////////////////////////////////////////////////////////////////
+// Biquad low-pass
+
+// Initializes 2nd order Butterworth low-pass (Q = 1/sqrt(2)) filter.
+// `cutoff_ratio` - cutoff frequency divided by sampling frequency
+//                  [FILTER_BIQUAD_MIN_CUTOFF_RATIO, 0.5)
+// NOTE: Coefficients are computed in floating point, call once at setup.
+// DC gain is exactly 1 after coefficients are rounded.
+void biquad_init_lowpass(biquad_t* h_biquad, float cutoff_ratio);
+
+// Resets filter state, next sample sets steady state.
+void biquad_reset(biquad_t* h_biquad);
+
+// Feeds sample `x` and returns filtered value (saturated to int32_t).
+// Products are 32-bit PIDQ_Multiply() products (no 64-bit multiply).
+int32_t biquad_feed(biquad_t* h_biquad, int32_t x);
+
+//////////////////////////////////////////////////////////////////////////
+// Mean accumulator (replaces cma.h, divides only when value is read)
+
+// Resets accumulated mean to zero.
+void mean_accumulator_reset(mean_accumulator_t* h_mean);
+
+// Adds sample `x`.
+void mean_accumulator_feed(mean_accumulator_t* h_mean, int32_t x);
+
+// Returns mean of all samples fed after `mean_accumulator_reset()` call
+// (0 if no samples were fed).
+int32_t mean_accumulator_get_value(mean_accumulator_t* h_mean);
+
+#endif /* FILTER_H_ */
@@ -0,0 +1,145 @@
+/*
+ * gain_store.c
+ *
+ * Implementation of gain_store.h
+ */ 
+
+#include "gain_store.h"
+#include "stxetx_protocol.h" // stxetx_crc8_update
+
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include <stddef.h> // offsetof
+#include <string.h> // memcpy
+
+#ifndef NULL
+#define NULL (void*)0x00
+#endif
+
+#define GAIN_STORE_MAGIC 0xA5
+
+// Any value other than GAIN_STORE_MAGIC
+#define GAIN_STORE_MAGIC_INVALID 0xFF
+
+typedef struct {
+	uint8_t magic;
+	uint8_t version;
+	uint8_t n_gains;
+	// CRC-8 of `version`, `n_gains` and all GAIN_STORE_MAX_GAINS gains
+	uint8_t crc;
+	pid_gains_t gains[GAIN_STORE_MAX_GAINS];
+} gain_store_record_t;
+
+static gain_store_record_t EEMEM g_gain_store_record_eeprom;
+
+// Record being saved
+static gain_store_record_t g_gain_store_pending;
+
+// Step of pending save (See. GainStore_OnEepromReady()), 0 = not saving
+static volatile uint8_t g_gain_store_write_step = 0;
+
+static uint8_t gain_store_calculate_crc(const gain_store_record_t* p_record)
+{
+	const uint8_t* p_bytes = (const uint8_t*)p_record;
+	uint8_t crc = 0;
+	
+	for (uint8_t i = 0; i < sizeof(gain_store_record_t); i++)
+	{
+		if (i == offsetof(gain_store_record_t, magic) || i == offsetof(gain_store_record_t, crc))
+		{
+			continue;
+		}
+		
+		crc = stxetx_crc8_update(crc, p_bytes[i]);
+	}
+	
+	return crc;
+}
+
+uint8_t GainStore_Load(pid_gains_t gains[], uint8_t n_gains)
+{
+	if (NULL == gains || n_gains == 0 || n_gains > GAIN_STORE_MAX_GAINS)
+	{
+		return 0;
+	}
+	
+	while (GainStore_IsBusy())
+	{
+	}
+	
+	gain_store_record_t record;
+	eeprom_read_block((void*)&record, (const void*)&g_gain_store_record_eeprom, sizeof(gain_store_record_t));
+	
+	if (record.magic != GAIN_STORE_MAGIC
+		|| record.version != GAIN_STORE_VERSION
+		|| record.n_gains != n_gains
+		|| record.crc != gain_store_calculate_crc(&record))
+	{
+		return 0;
+	}
+	
+	memcpy((void*)gains, (const void*)record.gains, n_gains * sizeof(pid_gains_t));
+	return 1;
+}
+
+uint8_t GainStore_Save(const pid_gains_t gains[], uint8_t n_gains)
+{
+	if (NULL == gains || n_gains == 0 || n_gains > GAIN_STORE_MAX_GAINS || GainStore_IsBusy())
+	{
+		return 0;
+	}
+	
+	memset((void*)&g_gain_store_pending, 0, sizeof(gain_store_record_t));
+	memcpy((void*)g_gain_store_pending.gains, (const void*)gains, n_gains * sizeof(pid_gains_t));
+	
+	g_gain_store_pending.magic = GAIN_STORE_MAGIC;
+	g_gain_store_pending.version = GAIN_STORE_VERSION;
+	g_gain_store_pending.n_gains = n_gains;
+	g_gain_store_pending.crc = gain_store_calculate_crc(&g_gain_store_pending);
+	
+	g_gain_store_write_step = 1;
+	
+	// Interrupt fires as soon as EEPROM is ready
+	EECR |= _BV(EERIE);
+	return 1;
+}
+
+uint8_t GainStore_IsBusy(void)
+{
+	return g_gain_store_write_step != 0;
+}
+
+void GainStore_OnEepromReady(void)
+{
+	// Steps (record of N bytes):
+	// 1       invalidate magic, so torn record is never accepted
+	// 2..N    bytes 1..N-1
+	// N+1     magic
+	const uint8_t step = g_gain_store_write_step;
+	uint8_t* p_eeprom = (uint8_t*)&g_gain_store_record_eeprom;
+	
+	if (step == 0)
+	{
+		EECR &= ~_BV(EERIE);
+		return;
+	}
+	
+	if (step == 1)
+	{
+		eeprom_update_byte(p_eeprom, GAIN_STORE_MAGIC_INVALID);
+	}
+	else if (step <= sizeof(gain_store_record_t))
+	{
+		// Unchanged bytes are not written (no wait for next interrupt)
+		eeprom_update_byte(p_eeprom + (step - 1), ((const uint8_t*)&g_gain_store_pending)[step - 1]);
+	}
+	else
+	{
+		eeprom_update_byte(p_eeprom, GAIN_STORE_MAGIC);
+		g_gain_store_write_step = 0;
+		EECR &= ~_BV(EERIE);
+		return;
+	}
+	
+	g_gain_store_write_step = step + 1;
+}
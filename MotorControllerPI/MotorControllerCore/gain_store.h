@@ -0,0 +1,47 @@
+/*
+ * gain_store.h
+ *
+ * PI controller gains stored in EEPROM.
+ * Record has a header (magic, layout version, number of controllers and
+ * CRC-8 of header and gains) so erased, torn or old-layout records are
+ * rejected at boot and defaults are used instead.
+ * Saving does not block: bytes are written one per EE_READY interrupt
+ * (about 3.4ms each) while control loop keeps running.
+ */ 
+
+
+#ifndef GAIN_STORE_H_
+#define GAIN_STORE_H_
+
+#include <stdint.h>
+
+// Gains of controllers kept in one record
+#define GAIN_STORE_MAX_GAINS 3
+
+// Incremented whenever layout of the record changes (old records are rejected)
+#define GAIN_STORE_VERSION 1
+
+// Gains of one PI controller, in the form used by pid.h / pid_bank.h
+typedef struct {
+	float Kp;
+	float Ti;
+} pid_gains_t;
+
+// Reads `n_gains` gains (at most GAIN_STORE_MAX_GAINS) from EEPROM into `gains`.
+// Returns 1 if record is valid and holds exactly `n_gains` gains, 0 otherwise
+// (`gains` is not modified). Blocks until pending save finishes.
+uint8_t GainStore_Load(pid_gains_t gains[], uint8_t n_gains);
+
+// Starts saving `n_gains` gains (at most GAIN_STORE_MAX_GAINS), gains are copied.
+// Returns 1 if saving started, 0 if previous save is still in progress or `n_gains` is invalid.
+// Record stays invalid until the last byte is written.
+uint8_t GainStore_Save(const pid_gains_t gains[], uint8_t n_gains);
+
+// Returns 1 while save is in progress.
+uint8_t GainStore_IsBusy(void);
+
+// Writes next byte of pending save. MUST be called from ISR(EE_READY_vect),
+// disables the interrupt when record is complete.
+void GainStore_OnEepromReady(void);
+
+#endif /* GAIN_STORE_H_ */
@@ -0,0 +1,481 @@
+/*
+ * bench.c
+ *
+ * Host throughput benchmark of MotorControllerCore hot paths:
+ * - STXETX encoding (stxetx_encoder_*) and decoding (stxetx_decoder_feed_byte())
+ *   of random payloads and of worst-case payloads where most bytes need escaping
+ * - ring buffer throughput (circular_buffer.h) of USART queues: byte path
+ *   (CBuf_Write() / CBuf_Read()), block path (CBuf_WriteN() / CBuf_ReadN())
+ *   and zero-copy read (CBuf_PeekContiguous() / CBuf_Consume())
+ * - Q16.16 multiplication (PIDQ_Multiply() against 64-bit product)
+ * - three PI controllers: PIDBank_Advance() / PIDBank_AdvanceWithFeedforward(),
+ *   PIDQ_AdvanceFixedRate() and floating point PID_AdvanceFixedRate() /
+ *   PID_AdvanceFixedRateWithFeedforward()
+ * - median, moving average and biquad filter feeds
+ *
+ * Numbers are host nanoseconds, only meant to compare builds of the same
+ * machine (e.g. before and after a change, `make bench`). Host has an FPU,
+ * float against fixed point is measured on target with PROBE_PID_CONTROLLERS
+ * of MegaMotorController (See. PROFILER_MODE).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "circular_buffer.h"
+#include "stxetx_protocol.h"
+#include "pid_bank.h"
+#include "filter.h"
+#include "bench_clock.h"
+
+// Largest payload which always fits into a frame (every byte escaped)
+#define PAYLOAD_SIZE 120
+
+// Room for header, escaped payload, checksum and ETX
+#define FRAME_BUFFER_SIZE 256
+
+#define FRAME_ITERATIONS 200000UL
+#define RING_ITERATIONS 1000000UL
+#define SAMPLE_ITERATIONS 5000000UL
+
+// Controllers of the bank (one per motor of MegaMotorController)
+#define MOTOR_COUNT 3
+
+// Keeps results alive, so benchmarked calls are not optimized away
+static volatile uint32_t g_sink_;
+
+// Payload generator (xorshift32, fixed seed: every run benchmarks the same payloads).
+// stdlib.h is not used, glibc declares its own `pid_t` there (See. bench_clock.h).
+static uint32_t g_random_state_ = 1;
+
+static uint32_t random_next_(void)
+{
+	g_random_state_ ^= g_random_state_ << 13;
+	g_random_state_ ^= g_random_state_ >> 17;
+	g_random_state_ ^= g_random_state_ << 5;
+	return g_random_state_;
+}
+
+static void report_(const char* name, double elapsed_ns, unsigned long n_iterations, unsigned long n_bytes_per_iteration)
+{
+	const double ns_per_iteration = elapsed_ns / (double)n_iterations;
+
+	if (n_bytes_per_iteration != 0)
+	{
+		printf("%-40s %10.1f ns/op %10.2f ns/byte %8.1f MB/s\n", name, ns_per_iteration,
+			ns_per_iteration / (double)n_bytes_per_iteration,
+			(double)n_bytes_per_iteration * 1e3 / ns_per_iteration);
+	}
+	else
+	{
+		printf("%-40s %10.1f ns/op\n", name, ns_per_iteration);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// STXETX
+
+// Destination of encoder: linear buffer (same as stxetx_encode_n())
+typedef struct {
+	uint8_t* it_write;
+	uint8_t* it_end;
+} bench_sink_t;
+
+static uint8_t* bench_sink_reserve_span_(void* p_context, uint8_t n, uint8_t* p_n_reserved)
+{
+	bench_sink_t* p_sink = (bench_sink_t*)p_context;
+	const size_t n_free = (size_t)(p_sink->it_end - p_sink->it_write);
+
+	*p_n_reserved = (n < n_free) ? n : (uint8_t)n_free;
+
+	if (*p_n_reserved == 0)
+	{
+		return NULL;
+	}
+
+	uint8_t* p_span = p_sink->it_write;
+	p_sink->it_write += *p_n_reserved;
+
+	return p_span;
+}
+
+// Encodes `p_payload` into `p_frame`, returns encoded length (0 on error)
+static uint8_t encode_frame_(const uint8_t* p_payload, uint8_t n, uint8_t* p_frame)
+{
+	bench_sink_t sink = { p_frame, p_frame + FRAME_BUFFER_SIZE };
+	stxetx_encoder_t encoder;
+
+	stxetx_encoder_begin(&encoder, bench_sink_reserve_span_, &sink, 0x10, 0);
+	stxetx_encoder_push_bytes(&encoder, p_payload, n);
+
+	if (stxetx_encoder_end(&encoder) != STXETX_ERROR_NO_ERROR)
+	{
+		return 0;
+	}
+
+	return (uint8_t)(sink.it_write - p_frame);
+}
+
+// Returns 0 if frame does not fit or does not decode back to `p_payload`
+static int bench_stxetx_(const char* name, const uint8_t* p_payload, uint8_t n)
+{
+	uint8_t frame[FRAME_BUFFER_SIZE];
+	char label[64];
+
+	double start_ns = bench_clock_now_ns();
+	for (unsigned long i = 0; i < FRAME_ITERATIONS; i++)
+	{
+		g_sink_ += encode_frame_(p_payload, n, frame);
+	}
+	snprintf(label, sizeof(label), "encode %s", name);
+	report_(label, bench_clock_now_ns() - start_ns, FRAME_ITERATIONS, n);
+
+	const uint8_t frame_length = encode_frame_(p_payload, n, frame);
+	if (frame_length == 0)
+	{
+		printf("%s: frame does not fit\n", name);
+		return 0;
+	}
+
+	uint8_t payload_buffer[PAYLOAD_SIZE];
+	stxetx_decoder_t decoder;
+	stxetx_decoder_init(&decoder, payload_buffer, sizeof(payload_buffer));
+
+	start_ns = bench_clock_now_ns();
+	for (unsigned long i = 0; i < FRAME_ITERATIONS; i++)
+	{
+		for (uint8_t j = 0; j < frame_length; j++)
+		{
+			uint8_t is_frame_complete = 0;
+			stxetx_decoder_feed_byte(&decoder, frame[j], &is_frame_complete);
+			g_sink_ += is_frame_complete;
+		}
+	}
+	snprintf(label, sizeof(label), "decode %s", name);
+	report_(label, bench_clock_now_ns() - start_ns, FRAME_ITERATIONS, n);
+
+	// Round trip check, so a broken codec does not produce nice numbers
+	uint8_t is_frame_complete = 0;
+	for (uint8_t j = 0; j < frame_length; j++)
+	{
+		stxetx_decoder_feed_byte(&decoder, frame[j], &is_frame_complete);
+	}
+
+	if (!is_frame_complete || decoder.frame.len_bytes != n || memcmp(decoder.frame.p_payload, p_payload, n) != 0)
+	{
+		printf("%s: decoded payload differs\n", name);
+		return 0;
+	}
+	
+	return 1;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Ring buffer
+
+// Bytes moved per iteration, does not divide CBUF_MAX_SIZE so spans wrap at
+// every offset of the raw buffer
+#define RING_CHUNK_SIZE 48
+
+// Moves `RING_CHUNK_SIZE` bytes of `p_src` through `h_ring` into `p_dest` with
+// method `method` (0: byte, 1: block, 2: zero-copy read), returns bytes read
+static size_t ring_transfer_(circular_buffer_t* h_ring, const uint8_t* p_src, uint8_t* p_dest, int method)
+{
+	size_t n_read = 0;
+
+	if (method == 0)
+	{
+		for (size_t i = 0; i < RING_CHUNK_SIZE; i++)
+		{
+			CBuf_Write(h_ring, p_src[i]);
+		}
+
+		while (CBuf_Read(h_ring, &p_dest[n_read]) == CBUF_ERROR_NO_ERROR)
+		{
+			++n_read;
+		}
+
+		return n_read;
+	}
+
+	CBuf_WriteN(h_ring, p_src, RING_CHUNK_SIZE);
+
+	if (method == 1)
+	{
+		CBuf_ReadN(h_ring, p_dest, RING_CHUNK_SIZE, &n_read);
+		return n_read;
+	}
+
+	const uint8_t* p_span = NULL;
+	size_t n_span = 0;
+
+	while ((n_span = CBuf_PeekContiguous(h_ring, &p_span)) != 0)
+	{
+		memcpy(&p_dest[n_read], p_span, n_span);
+		CBuf_Consume(h_ring, n_span);
+		n_read += n_span;
+	}
+
+	return n_read;
+}
+
+// Returns 0 if bytes read from ring differ from bytes written
+static int bench_ring_buffer_(const uint8_t* p_data)
+{
+	static const char* const names[] = {
+		"ring CBuf_Write / CBuf_Read",
+		"ring CBuf_WriteN / CBuf_ReadN",
+		"ring CBuf_WriteN / CBuf_PeekContiguous",
+	};
+
+	uint8_t raw_buffer[CBUF_MAX_SIZE];
+	uint8_t received[RING_CHUNK_SIZE];
+	circular_buffer_t ring;
+
+	for (int method = 0; method < 3; method++)
+	{
+		CBuf_Init(&ring, raw_buffer, sizeof(raw_buffer));
+
+		double start_ns = bench_clock_now_ns();
+		for (unsigned long i = 0; i < RING_ITERATIONS; i++)
+		{
+			g_sink_ += (uint32_t)ring_transfer_(&ring, p_data, received, method);
+		}
+		report_(names[method], bench_clock_now_ns() - start_ns, RING_ITERATIONS, RING_CHUNK_SIZE);
+
+		// Round trip check at every wrap offset, so a broken ring does not produce nice numbers
+		for (size_t i = 0; i < CBUF_MAX_SIZE; i++)
+		{
+			memset(received, 0, sizeof(received));
+
+			if (ring_transfer_(&ring, p_data, received, method) != RING_CHUNK_SIZE
+				|| memcmp(received, p_data, RING_CHUNK_SIZE) != 0)
+			{
+				printf("%s: bytes read differ from bytes written\n", names[method]);
+				return 0;
+			}
+		}
+	}
+
+	return 1;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// PI controllers
+
+// Error of controller `j` in iteration `i`, alternates sign so outputs do not stay saturated
+static float bench_error_(unsigned long i, uint8_t j)
+{
+	return (i & 1) ? (float)(j + 1) : -(float)(j + 1);
+}
+
+// Returns 0 if PIDQ_Multiply() differs from the 64-bit product
+static int bench_pidq_multiply_(void)
+{
+	enum { N_OPERANDS = 256 };
+	pidq_value_t operands[N_OPERANDS];
+
+	for (size_t i = 0; i < N_OPERANDS; i++)
+	{
+		operands[i] = (pidq_value_t)random_next_();
+	}
+
+	for (size_t i = 0; i < N_OPERANDS; i++)
+	{
+		for (size_t j = 0; j < N_OPERANDS; j++)
+		{
+			const pidq_value_t expected = (pidq_value_t)(((int64_t)operands[i] * operands[j]) >> PIDQ_FRACTION_BITS);
+
+			if (PIDQ_Multiply(operands[i], operands[j]) != expected)
+			{
+				printf("PIDQ_Multiply(%ld, %ld) differs from 64-bit product\n", (long)operands[i], (long)operands[j]);
+				return 0;
+			}
+		}
+	}
+
+	double start_ns = bench_clock_now_ns();
+	for (unsigned long i = 0; i < SAMPLE_ITERATIONS; i++)
+	{
+		g_sink_ += (uint32_t)PIDQ_Multiply(operands[i % N_OPERANDS], operands[(i + 1) % N_OPERANDS]);
+	}
+	report_("PIDQ_Multiply", bench_clock_now_ns() - start_ns, SAMPLE_ITERATIONS, 0);
+
+	start_ns = bench_clock_now_ns();
+	for (unsigned long i = 0; i < SAMPLE_ITERATIONS; i++)
+	{
+		g_sink_ += (uint32_t)(((int64_t)operands[i % N_OPERANDS] * operands[(i + 1) % N_OPERANDS]) >> PIDQ_FRACTION_BITS);
+	}
+	report_("64-bit product >> 16", bench_clock_now_ns() - start_ns, SAMPLE_ITERATIONS, 0);
+
+	return 1;
+}
+
+static void bench_pid_float_(void)
+{
+	pid_t pids[MOTOR_COUNT];
+	const float feedforwards[MOTOR_COUNT] = { 10, 20, 30 };
+
+	for (uint8_t j = 0; j < MOTOR_COUNT; j++)
+	{
+		PID_InitFixedRate(&pids[j], 4.0f, 0, 128.8773f, 0.016f, 0, 95);
+		PID_SetAntiWindup(&pids[j], PID_ANTI_WINDUP_CONDITIONAL);
+	}
+
+	double start_ns = bench_clock_now_ns();
+	for (unsigned long i = 0; i < SAMPLE_ITERATIONS; i++)
+	{
+		for (uint8_t j = 0; j < MOTOR_COUNT; j++)
+		{
+			g_sink_ += (uint32_t)PID_AdvanceFixedRate(&pids[j], bench_error_(i, j));
+		}
+	}
+	report_("PID_AdvanceFixedRate (3 controllers)", bench_clock_now_ns() - start_ns, SAMPLE_ITERATIONS, 0);
+
+	start_ns = bench_clock_now_ns();
+	for (unsigned long i = 0; i < SAMPLE_ITERATIONS; i++)
+	{
+		for (uint8_t j = 0; j < MOTOR_COUNT; j++)
+		{
+			g_sink_ += (uint32_t)PID_AdvanceFixedRateWithFeedforward(&pids[j], bench_error_(i, j), feedforwards[j]);
+		}
+	}
+	report_("PID_AdvanceFixedRateWithFeedforward (3)", bench_clock_now_ns() - start_ns, SAMPLE_ITERATIONS, 0);
+}
+
+static void bench_pidq_(void)
+{
+	pidq_t pids[MOTOR_COUNT];
+
+	for (uint8_t j = 0; j < MOTOR_COUNT; j++)
+	{
+		PIDQ_InitFixedRate(&pids[j], 4.0f, 128.8773f, 0.016f, 0, 95);
+		PIDQ_SetAntiWindup(&pids[j], PID_ANTI_WINDUP_CONDITIONAL);
+	}
+
+	double start_ns = bench_clock_now_ns();
+	for (unsigned long i = 0; i < SAMPLE_ITERATIONS; i++)
+	{
+		for (uint8_t j = 0; j < MOTOR_COUNT; j++)
+		{
+			g_sink_ += (uint32_t)PIDQ_AdvanceFixedRate(&pids[j], PIDQ_FROM_FLOAT(bench_error_(i, j)));
+		}
+	}
+	report_("PIDQ_AdvanceFixedRate (3 controllers)", bench_clock_now_ns() - start_ns, SAMPLE_ITERATIONS, 0);
+}
+
+static void bench_pid_bank_(void)
+{
+	pid_bank_t bank;
+	PIDBank_Init(&bank, MOTOR_COUNT, 4.0f, 128.8773f, 0.016f, 0, 95);
+	PIDBank_SetAntiWindup(&bank, PID_ANTI_WINDUP_CONDITIONAL);
+
+	pidq_value_t errors[MOTOR_COUNT];
+	pidq_value_t feedforwards[MOTOR_COUNT] = { PIDQ_FROM_INT(10), PIDQ_FROM_INT(20), PIDQ_FROM_INT(30) };
+	pidq_value_t outputs[MOTOR_COUNT];
+
+	double start_ns = bench_clock_now_ns();
+	for (unsigned long i = 0; i < SAMPLE_ITERATIONS; i++)
+	{
+		// Error alternates sign, so outputs do not stay saturated
+		for (uint8_t j = 0; j < MOTOR_COUNT; j++)
+		{
+			errors[j] = (i & 1) ? PIDQ_FROM_INT(j + 1) : -PIDQ_FROM_INT(j + 1);
+		}
+
+		PIDBank_Advance(&bank, errors, outputs);
+		g_sink_ += (uint32_t)outputs[0];
+	}
+	report_("PIDBank_Advance (3 controllers)", bench_clock_now_ns() - start_ns, SAMPLE_ITERATIONS, 0);
+
+	start_ns = bench_clock_now_ns();
+	for (unsigned long i = 0; i < SAMPLE_ITERATIONS; i++)
+	{
+		for (uint8_t j = 0; j < MOTOR_COUNT; j++)
+		{
+			errors[j] = (i & 1) ? PIDQ_FROM_INT(j + 1) : -PIDQ_FROM_INT(j + 1);
+		}
+
+		PIDBank_AdvanceWithFeedforward(&bank, errors, feedforwards, outputs);
+		g_sink_ += (uint32_t)outputs[0];
+	}
+	report_("PIDBank_AdvanceWithFeedforward (3)", bench_clock_now_ns() - start_ns, SAMPLE_ITERATIONS, 0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Filters
+
+static void bench_filters_(const int32_t* p_samples, size_t n_samples)
+{
+	median_filter_t median;
+	moving_average_t average;
+	biquad_t biquad;
+
+	median_filter_init(&median, FILTER_MEDIAN_MAX_TAPS);
+	moving_average_init(&average, FILTER_MOVING_AVERAGE_MAX_SHIFT);
+	biquad_init_lowpass(&biquad, 0.1f);
+
+	double start_ns = bench_clock_now_ns();
+	for (unsigned long i = 0; i < SAMPLE_ITERATIONS; i++)
+	{
+		g_sink_ += (uint32_t)median_filter_feed(&median, p_samples[i % n_samples]);
+	}
+	report_("median_filter_feed (5 taps)", bench_clock_now_ns() - start_ns, SAMPLE_ITERATIONS, 0);
+
+	start_ns = bench_clock_now_ns();
+	for (unsigned long i = 0; i < SAMPLE_ITERATIONS; i++)
+	{
+		g_sink_ += (uint32_t)moving_average_feed(&average, p_samples[i % n_samples]);
+	}
+	report_("moving_average_feed (max window)", bench_clock_now_ns() - start_ns, SAMPLE_ITERATIONS, 0);
+
+	start_ns = bench_clock_now_ns();
+	for (unsigned long i = 0; i < SAMPLE_ITERATIONS; i++)
+	{
+		g_sink_ += (uint32_t)biquad_feed(&biquad, p_samples[i % n_samples]);
+	}
+	report_("biquad_feed (lowpass)", bench_clock_now_ns() - start_ns, SAMPLE_ITERATIONS, 0);
+}
+
+int main(void)
+{
+	uint8_t payload[PAYLOAD_SIZE];
+	int is_passed = 1;
+
+	for (size_t i = 0; i < sizeof(payload); i++)
+	{
+		payload[i] = (uint8_t)random_next_();
+	}
+	is_passed &= bench_stxetx_("random payload", payload, sizeof(payload));
+
+	// STX, ETX and ESCAPE only, every byte is escaped
+	static const uint8_t control_characters[] = { 0x02, 0x03, (uint8_t)'%' };
+	for (size_t i = 0; i < sizeof(payload); i++)
+	{
+		payload[i] = control_characters[random_next_() % sizeof(control_characters)];
+	}
+	is_passed &= bench_stxetx_("escape-only payload", payload, sizeof(payload));
+
+	// Every other byte is escaped (shortest runs of ordinary bytes)
+	for (size_t i = 0; i < sizeof(payload); i++)
+	{
+		payload[i] = (i & 1) ? control_characters[random_next_() % sizeof(control_characters)] : (uint8_t)(0x40 + (i & 0x3F));
+	}
+	is_passed &= bench_stxetx_("escape-heavy payload", payload, sizeof(payload));
+
+	is_passed &= bench_ring_buffer_(payload);
+
+	is_passed &= bench_pidq_multiply_();
+	bench_pid_float_();
+	bench_pidq_();
+	bench_pid_bank_();
+
+	// Noisy Q16.16 speed around 3 rps
+	int32_t samples[256];
+	for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++)
+	{
+		samples[i] = PIDQ_FROM_INT(3) + (int32_t)(random_next_() % PIDQ_ONE) - PIDQ_ONE / 2;
+	}
+	bench_filters_(samples, sizeof(samples) / sizeof(samples[0]));
+
+	return is_passed ? 0 : 1;
+}
@@ -0,0 +1,9 @@
+#include "bench_clock.h"
+#include <time.h>
+
+double bench_clock_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
@@ -0,0 +1,15 @@
+/*
+ * bench_clock.h
+ *
+ * Monotonic host clock of bench.c. Kept in its own translation unit, because
+ * time.h of glibc declares its own `pid_t`, which conflicts with pid.h.
+ */
+
+
+#ifndef BENCH_CLOCK_H_
+#define BENCH_CLOCK_H_
+
+// Returns monotonic time in nanoseconds (arbitrary origin)
+double bench_clock_now_ns(void);
+
+#endif /* BENCH_CLOCK_H_ */
@@ -0,0 +1,199 @@
+/*
+ * test_closed_loop.c
+ *
+ * Host closed-loop test of the speed controllers of MegaMotorController:
+ * PIDBank_AdvanceWithFeedforward() with every feedforward mode drives
+ * FirstOrderPlant of UART_Reader/pid_tester.py (A = 0.04924, B = 0.2617)
+ *   y[k] = A * u[k-1] + B * y[k-1]    (u = duty cycle [%], y = speed [rps])
+ * Controller configuration mirrors MegaMotorController/main.c (PID_KP, PID_TI,
+ * PID_TICK_PERIOD_MS, PID_OUTPUT_MAX, PID_ANTI_WINDUP_MODE), PI error is taken
+ * against feedforward reference and duty cycle is quantized to PWM compare
+ * counts like in do_advance_pids().
+ *
+ * Requirement (same for every feedforward mode, setpoint ramp and setpoint):
+ * - overshoot at most REQUIRED_MAX_OVERSHOOT_PERCENT of setpoint, so speed
+ *   never leaves the settling band above the setpoint
+ * - speed stays within SETTLING_BAND of setpoint from REQUIRED_SETTLING_TIME_S
+ *   after the (ramped) setpoint reached its final value
+ * Fails (exit code 1) if any controller of any case misses the requirement.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "pid.h"
+#include "pid_bank.h"
+
+#define PLANT_A			0.04924f
+#define PLANT_B			0.2617f
+
+#define PID_KP			4.0f
+#define PID_TI			128.8773f
+#define PID_TIMESTEP	0.016f
+#define PID_OUTPUT_MAX	95
+
+// PWM resolution (See. motor_pwm.h)
+#define PWM_TOP 255
+#define PWM_COUNTS_PER_PERCENT_Q8 ((PWM_TOP * 256UL + 50) / 100)
+
+// Default setpoint ramp of MegaMotorController [rps/s]
+#define SETPOINT_RAMP_ACCELERATION 20.0f
+
+// Simulated PID ticks per case (2 s)
+#define STEPS 125
+
+// Settling band relative to setpoint (same as pid_tester.py)
+#define SETTLING_BAND 0.02f
+
+// Requirement, See. top of file. Settling time is 10 PID ticks.
+#define REQUIRED_MAX_OVERSHOOT_PERCENT	(SETTLING_BAND * 100.0f)
+#define REQUIRED_SETTLING_TIME_S		(10 * PID_TIMESTEP)
+
+// Steady state speed [rps] at PID_OUTPUT_MAX, setpoints must be below it
+#define PLANT_RPS_MAX ((PLANT_A * PID_OUTPUT_MAX) / (1.0f - PLANT_B))
+
+// Controllers of the bank (one per motor of MegaMotorController)
+#define MOTOR_COUNT 3
+
+typedef struct {
+	const char* name;
+	pid_feedforward_mode_e feedforward_mode;
+	// Setpoint ramp rate [rps/s] (0 = step)
+	float ramp_rate;
+} closed_loop_case_t;
+
+// Setpoints of the controllers of the bank, every case runs all of them
+static const float setpoints_[MOTOR_COUNT] = { 1.0f, 3.0f, 5.0f };
+
+// Firmware ramps setpoints, steps cover commands with ramp disabled (See. SET_RAMP message)
+static const closed_loop_case_t cases_[] = {
+	{ "ramp, inverse model feedforward", PID_FEEDFORWARD_INVERSE_MODEL, SETPOINT_RAMP_ACCELERATION },
+	{ "ramp, static gain feedforward", PID_FEEDFORWARD_STATIC_GAIN, SETPOINT_RAMP_ACCELERATION },
+	{ "ramp, feedback only", PID_FEEDFORWARD_NONE, SETPOINT_RAMP_ACCELERATION },
+	{ "step, inverse model feedforward", PID_FEEDFORWARD_INVERSE_MODEL, 0.0f },
+	{ "step, static gain feedforward", PID_FEEDFORWARD_STATIC_GAIN, 0.0f },
+	{ "step, feedback only", PID_FEEDFORWARD_NONE, 0.0f },
+};
+
+#define CASE_COUNT (sizeof(cases_) / sizeof(cases_[0]))
+
+// Duty cycle [%] applied by PWM of PI output `duty` (same quantization as
+// motor_pwm_compare_from_duty() of 8-bit MOTOR_PWM_BACKEND_TIMER_0_2)
+static float pwm_duty_(pidq_value_t duty)
+{
+	if (duty < 0)
+	{
+		duty = 0;
+	}
+
+	const uint32_t counts = ((uint32_t)(duty >> 8) * PWM_COUNTS_PER_PERCENT_Q8) >> 16;
+
+	return (float)counts * 100.0f / PWM_TOP;
+}
+
+// Runs one case, returns non-zero if all controllers met the requirement
+static int run_case_(const closed_loop_case_t* p_case)
+{
+	pid_bank_t bank;
+	pidq_feedforward_t feedforwards[MOTOR_COUNT];
+
+	PIDBank_Init(&bank, MOTOR_COUNT, PID_KP, PID_TI, PID_TIMESTEP, 0, PID_OUTPUT_MAX);
+	PIDBank_SetAntiWindup(&bank, PID_ANTI_WINDUP_CONDITIONAL);
+
+	float y[MOTOR_COUNT] = { 0 };
+	float u[MOTOR_COUNT] = { 0 };
+	float peak[MOTOR_COUNT] = { 0 };
+	int settling_index[MOTOR_COUNT] = { 0 };
+	int final_setpoint_index[MOTOR_COUNT] = { 0 };
+
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		PIDQ_FeedforwardInit(&feedforwards[i], p_case->feedforward_mode, PLANT_A, PLANT_B, 0);
+	}
+
+	for (int k = 1; k < STEPS; k++)
+	{
+		pidq_value_t errors[MOTOR_COUNT];
+		pidq_value_t ff[MOTOR_COUNT];
+		pidq_value_t outputs[MOTOR_COUNT];
+
+		for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+		{
+			float setpoint = setpoints_[i];
+			const float ramped = p_case->ramp_rate * PID_TIMESTEP * k;
+
+			if (p_case->ramp_rate > 0 && ramped < setpoint)
+			{
+				setpoint = ramped;
+				final_setpoint_index[i] = k + 1;
+			}
+
+			// Plant responds to output of previous tick, PI sees speed measured in this tick
+			y[i] = PLANT_A * u[i] + PLANT_B * y[i];
+			ff[i] = PIDQ_FeedforwardAdvance(&feedforwards[i], PIDQ_FROM_FLOAT(setpoint));
+			errors[i] = feedforwards[i].reference - PIDQ_FROM_FLOAT(y[i]);
+		}
+
+		PIDBank_AdvanceWithFeedforward(&bank, errors, ff, outputs);
+
+		for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+		{
+			u[i] = pwm_duty_(outputs[i]);
+
+			if (y[i] > peak[i])
+			{
+				peak[i] = y[i];
+			}
+
+			if (fabsf(y[i] - setpoints_[i]) > SETTLING_BAND * setpoints_[i])
+			{
+				settling_index[i] = k + 1;
+			}
+		}
+	}
+
+	int is_passed = 1;
+
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		const float setpoint = setpoints_[i];
+		const float overshoot = (peak[i] > setpoint) ? (peak[i] - setpoint) / setpoint * 100.0f : 0.0f;
+		// Measured from the tick in which setpoint reached its final value
+		const float settling_time = (settling_index[i] - final_setpoint_index[i]) * PID_TIMESTEP;
+		const int is_within_limits = overshoot <= REQUIRED_MAX_OVERSHOOT_PERCENT
+			&& settling_time <= REQUIRED_SETTLING_TIME_S
+			&& settling_index[i] < STEPS;
+
+		printf("%-36s %.1f rps: overshoot %5.2f %%, settling time %.3f s %s\n",
+			p_case->name, setpoint, overshoot, settling_time, is_within_limits ? "ok" : "FAIL");
+
+		is_passed &= is_within_limits;
+	}
+
+	return is_passed;
+}
+
+int main(void)
+{
+	int n_failed = 0;
+
+	for (uint8_t i = 0; i < MOTOR_COUNT; i++)
+	{
+		if (setpoints_[i] >= PLANT_RPS_MAX)
+		{
+			printf("setpoint %.1f rps is not reachable\n", setpoints_[i]);
+			return 1;
+		}
+	}
+
+	printf("requirement: overshoot <= %.2f %%, settling time (%.0f %% band) <= %.3f s\n",
+		REQUIRED_MAX_OVERSHOOT_PERCENT, SETTLING_BAND * 100.0f, REQUIRED_SETTLING_TIME_S);
+
+	for (unsigned i = 0; i < CASE_COUNT; i++)
+	{
+		n_failed += !run_case_(&cases_[i]);
+	}
+
+	printf("%s (%d of %u cases failed)\n", n_failed ? "FAILED" : "PASSED", n_failed, (unsigned)CASE_COUNT);
+
+	return n_failed ? 1 : 0;
+}
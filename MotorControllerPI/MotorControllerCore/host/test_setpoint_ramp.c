@@ -0,0 +1,155 @@
+/*
+ * test_setpoint_ramp.c
+ *
+ * Host test of setpoint_ramp_advance(). Every case ramps from rest at
+ * `value` to `target` and is compared step by step against a reference
+ * which takes the S-curve braking decision with 64-bit products, so an
+ * overflowing 32-bit comparison shows up as a mismatch. Cases cover Q16.16
+ * speeds of MegaMotorController and errors and rates close to int32_t range.
+ *
+ * Requirement (every case):
+ * - output equals reference output in every step
+ * - output never steps past target and reaches it within MAX_STEPS
+ * - |rate| never exceeds max_rate
+ * Fails (exit code 1) if any case misses the requirement.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "setpoint_ramp.h"
+
+// Limit of steps per case, longest case ramps int32_t range with jerk 1
+#define MAX_STEPS 1000000L
+
+typedef struct {
+	const char* name;
+	int32_t value;
+	int32_t target;
+	int32_t max_rate;
+	int32_t max_rate_change;
+} ramp_case_t;
+
+static const ramp_case_t cases_[] = {
+	{ "Q16.16 5 rps, 20 rps/s",		0, 5 << 16, 20971, 0 },
+	{ "Q16.16 5 rps, S-curve",		0, 5 << 16, 20971, 1048 },
+	{ "Q16.16 -5 rps, S-curve",		3 << 16, -(5 << 16), 20971, 1048 },
+	{ "full range, large jerk",		-(1L << 30), (1L << 30) - 1, 1L << 29, 1L << 24 },
+	{ "full range, jerk 1",			-(1L << 30), (1L << 30) - 1, 1L << 20, 1 },
+	{ "full range down, large rate",	(1L << 30) - 1, -(1L << 30), (1L << 30) - 1, 1L << 20 },
+	{ "jerk above max rate",		0, 1L << 20, 1000, 1L << 30 },
+};
+
+#define CASE_COUNT (sizeof(cases_) / sizeof(cases_[0]))
+
+// setpoint_ramp_advance() with 64-bit braking distance (host only)
+static int32_t reference_advance_(setpoint_ramp_t* h_ramp)
+{
+	const int32_t error = h_ramp->target - h_ramp->value;
+
+	if (error == 0 || h_ramp->max_rate == 0)
+	{
+		h_ramp->value = h_ramp->target;
+		h_ramp->rate = 0;
+		return h_ramp->value;
+	}
+
+	int32_t rate = h_ramp->rate;
+
+	if (h_ramp->max_rate_change == 0)
+	{
+		rate = (error > h_ramp->max_rate) ? h_ramp->max_rate : (error < -h_ramp->max_rate) ? -h_ramp->max_rate : error;
+	}
+	else
+	{
+		const int32_t jerk = (error > 0) ? h_ramp->max_rate_change : -h_ramp->max_rate_change;
+		const int64_t abs_rate = (rate < 0) ? -(int64_t)rate : rate;
+		const int64_t abs_error = (error < 0) ? -(int64_t)error : error;
+		const int64_t braking_distance = abs_rate * (abs_rate + h_ramp->max_rate_change) / (2 * (int64_t)h_ramp->max_rate_change);
+
+		if ((rate > 0) == (error > 0) && rate != 0 && braking_distance >= abs_error)
+		{
+			rate -= jerk;
+			if ((rate > 0) != (error > 0))
+			{
+				rate = 0;
+			}
+		}
+		else
+		{
+			rate += jerk;
+		}
+
+		rate = (rate > h_ramp->max_rate) ? h_ramp->max_rate : (rate < -h_ramp->max_rate) ? -h_ramp->max_rate : rate;
+	}
+
+	if ((error > 0 && rate >= error) || (error < 0 && rate <= error))
+	{
+		h_ramp->value = h_ramp->target;
+		h_ramp->rate = 0;
+		return h_ramp->value;
+	}
+
+	h_ramp->value += rate;
+	h_ramp->rate = rate;
+	return h_ramp->value;
+}
+
+// Runs one case, returns non-zero if the requirement is met
+static int run_case_(const ramp_case_t* p_case)
+{
+	setpoint_ramp_t ramp;
+	setpoint_ramp_t reference;
+
+	setpoint_ramp_init(&ramp, p_case->value, p_case->max_rate, p_case->max_rate_change);
+	setpoint_ramp_init(&reference, p_case->value, p_case->max_rate, p_case->max_rate_change);
+	setpoint_ramp_set_target(&ramp, p_case->target);
+	setpoint_ramp_set_target(&reference, p_case->target);
+
+	const int is_rising = p_case->target > p_case->value;
+	long step = 0;
+
+	for (step = 0; step < MAX_STEPS && ramp.value != p_case->target; step++)
+	{
+		const int32_t value = setpoint_ramp_advance(&ramp);
+		const int32_t expected = reference_advance_(&reference);
+
+		if (value != expected || ramp.rate != reference.rate)
+		{
+			printf("%-32s step %ld: output %ld, expected %ld FAIL\n",
+				p_case->name, step, (long)value, (long)expected);
+			return 0;
+		}
+
+		if ((is_rising && value > p_case->target) || (!is_rising && value < p_case->target))
+		{
+			printf("%-32s step %ld: output %ld is past target FAIL\n", p_case->name, step, (long)value);
+			return 0;
+		}
+
+		if (ramp.rate > p_case->max_rate || ramp.rate < -p_case->max_rate)
+		{
+			printf("%-32s step %ld: rate %ld above limit FAIL\n", p_case->name, step, (long)ramp.rate);
+			return 0;
+		}
+	}
+
+	const int is_passed = ramp.value == p_case->target;
+
+	printf("%-32s %7ld steps %s\n", p_case->name, step, is_passed ? "ok" : "FAIL");
+
+	return is_passed;
+}
+
+int main(void)
+{
+	int n_failed = 0;
+
+	for (unsigned i = 0; i < CASE_COUNT; i++)
+	{
+		n_failed += !run_case_(&cases_[i]);
+	}
+
+	printf("%s (%d of %u cases failed)\n", n_failed ? "FAILED" : "PASSED", n_failed, (unsigned)CASE_COUNT);
+
+	return n_failed ? 1 : 0;
+}
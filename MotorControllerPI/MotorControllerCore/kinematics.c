@@ -0,0 +1,183 @@
+/*
+ * kinematics.c
+ *
+ * Implementation of kinematics.h
+ */ 
+
+#include "kinematics.h"
+
+#include <string.h> // memcpy, memset
+
+#if defined(__AVR__)
+	#include <avr/pgmspace.h>
+#else
+	#define PROGMEM
+	#define pgm_read_word(ADDRESS) (*(const uint16_t*)(ADDRESS))
+#endif
+
+// sin(i * pi / 128) for i = 0..64 (quarter wave), Q1.15
+static const int16_t kinematics_sin_table_[65] PROGMEM = {
+	0, 804, 1608, 2410, 3212, 4011, 4808, 5602,
+	6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+	12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+	18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+	23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+	27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+	30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+	32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+	32767
+};
+
+// Returns sine of `angle` (65536 = full turn), Q1.15.
+// Table is interpolated linearly, error is below 2e-5.
+static int16_t kinematics_sin_(uint16_t angle)
+{
+	const uint8_t quadrant = (uint8_t)(angle >> 14);
+	uint16_t phase = angle & 0x3FFF;
+
+	// Second and fourth quadrant mirror the table
+	if (quadrant & 0x01)
+	{
+		phase = 0x4000 - phase;
+	}
+
+	const uint8_t index = (uint8_t)(phase >> 8);
+	const uint8_t fraction = (uint8_t)(phase & 0xFF);
+
+	int16_t value = (int16_t)pgm_read_word(&kinematics_sin_table_[index]);
+
+	if (index < 64)
+	{
+		const int16_t next = (int16_t)pgm_read_word(&kinematics_sin_table_[index + 1]);
+		value += (int16_t)(((int32_t)(next - value) * fraction) >> 8);
+	}
+
+	return (quadrant & 0x02) ? -value : value;
+}
+
+// Limits sum of Q16.16 products to Q16.16 range (same as PI output sums, See. pid.c)
+static pidq_value_t kinematics_saturate_(int64_t sum)
+{
+	if (sum > INT32_MAX)
+	{
+		return INT32_MAX;
+	}
+
+	if (sum < INT32_MIN)
+	{
+		return INT32_MIN;
+	}
+
+	return (pidq_value_t)sum;
+}
+
+
+void kinematics_init(kinematics_t* h_kin, float step_s)
+{
+	if (h_kin == NULL)
+	{
+		return;
+	}
+
+	memset(h_kin->inverse, 0, sizeof(h_kin->inverse));
+	memset(h_kin->forward, 0, sizeof(h_kin->forward));
+
+	h_kin->step_s = (int32_t)(step_s * 16777216.0f + 0.5f);
+	// rad -> 2^32 per turn is 2^32 / (2 * pi), Q16.16 keeps 2^16 of it
+	h_kin->heading_per_omega = PIDQ_FROM_FLOAT(step_s * (65536.0f / 6.28318531f));
+
+	kinematics_reset_pose(h_kin);
+}
+
+void kinematics_set_inverse(kinematics_t* h_kin, const pidq_value_t inverse[KINEMATICS_WHEEL_COUNT][3])
+{
+	if (h_kin == NULL || inverse == NULL)
+	{
+		return;
+	}
+
+	memcpy(h_kin->inverse, inverse, sizeof(h_kin->inverse));
+}
+
+void kinematics_set_forward(kinematics_t* h_kin, const pidq_value_t forward[3][KINEMATICS_WHEEL_COUNT])
+{
+	if (h_kin == NULL || forward == NULL)
+	{
+		return;
+	}
+
+	memcpy(h_kin->forward, forward, sizeof(h_kin->forward));
+}
+
+void kinematics_reset_pose(kinematics_t* h_kin)
+{
+	if (h_kin == NULL)
+	{
+		return;
+	}
+
+	memset(h_kin->velocity, 0, sizeof(h_kin->velocity));
+	h_kin->position[KINEMATICS_X] = 0;
+	h_kin->position[KINEMATICS_Y] = 0;
+	h_kin->heading = 0;
+}
+
+void kinematics_get_wheel_rps(const kinematics_t* h_kin, const pidq_value_t velocity[3], pidq_value_t wheel_rps[KINEMATICS_WHEEL_COUNT])
+{
+	if (h_kin == NULL || velocity == NULL || wheel_rps == NULL)
+	{
+		return;
+	}
+
+	for (uint8_t i = 0; i < KINEMATICS_WHEEL_COUNT; i++)
+	{
+		int64_t sum = 0;
+
+		for (uint8_t j = 0; j < 3; j++)
+		{
+			sum += PIDQ_Multiply(h_kin->inverse[i][j], velocity[j]);
+		}
+
+		wheel_rps[i] = kinematics_saturate_(sum);
+	}
+}
+
+void kinematics_advance(kinematics_t* h_kin, const pidq_value_t wheel_rps[KINEMATICS_WHEEL_COUNT])
+{
+	if (h_kin == NULL || wheel_rps == NULL)
+	{
+		return;
+	}
+
+	for (uint8_t j = 0; j < 3; j++)
+	{
+		int64_t sum = 0;
+
+		for (uint8_t i = 0; i < KINEMATICS_WHEEL_COUNT; i++)
+		{
+			sum += PIDQ_Multiply(h_kin->forward[j][i], wheel_rps[i]);
+		}
+
+		h_kin->velocity[j] = kinematics_saturate_(sum);
+	}
+
+	const uint32_t heading_change = (uint32_t)PIDQ_Multiply(h_kin->velocity[KINEMATICS_OMEGA], h_kin->heading_per_omega);
+
+	// Midpoint heading (exact for constant velocity over straight part of step)
+	const uint16_t angle = (uint16_t)((h_kin->heading + (uint32_t)((int32_t)heading_change / 2)) >> 16);
+	// Q1.15 -> Q16.16
+	const pidq_value_t sin_q16 = (pidq_value_t)kinematics_sin_(angle) << 1;
+	const pidq_value_t cos_q16 = (pidq_value_t)kinematics_sin_(angle + 0x4000) << 1;
+
+	const pidq_value_t vx = h_kin->velocity[KINEMATICS_X];
+	const pidq_value_t vy = h_kin->velocity[KINEMATICS_Y];
+
+	// Body frame -> world frame
+	const pidq_value_t world_vx = kinematics_saturate_((int64_t)PIDQ_Multiply(vx, cos_q16) - PIDQ_Multiply(vy, sin_q16));
+	const pidq_value_t world_vy = kinematics_saturate_((int64_t)PIDQ_Multiply(vx, sin_q16) + PIDQ_Multiply(vy, cos_q16));
+
+	// Q16.16 * Q8.24 >> 16 = distance of step, Q8.24
+	h_kin->position[KINEMATICS_X] += PIDQ_Multiply(world_vx, h_kin->step_s);
+	h_kin->position[KINEMATICS_Y] += PIDQ_Multiply(world_vy, h_kin->step_s);
+	h_kin->heading += heading_change;
+}
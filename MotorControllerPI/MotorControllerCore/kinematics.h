@@ -0,0 +1,72 @@
+/*
+ * kinematics.h
+ *
+ * Body kinematics of a three wheel base (e.g. omni-wheel base).
+ * Body velocity is (vx, vy, omega) in m/s, m/s and rad/s, wheel speeds
+ * are signed RPS, all values are Q16.16 fixed-point (`pidq_value_t`).
+ * Both matrices are precomputed by host, so the MCU only multiplies:
+ *      wheel_rps     = inverse * body_velocity   (inverse kinematics)
+ *      body_velocity = forward * wheel_rps       (forward kinematics)
+ * Forward kinematics is integrated into world frame pose once per step.
+ */ 
+
+
+#ifndef KINEMATICS_H_
+#define KINEMATICS_H_
+
+#include <stdint.h>
+#include "pid.h"
+
+#define KINEMATICS_WHEEL_COUNT 3
+
+// Index of body velocity component and pose coordinate
+#define KINEMATICS_X 0
+#define KINEMATICS_Y 1
+#define KINEMATICS_OMEGA 2
+
+// Position of `axis` (KINEMATICS_X or KINEMATICS_Y) in world frame [m], Q16.16
+#define KINEMATICS_GET_POSITION(H_KIN, AXIS) ((pidq_value_t)((H_KIN)->position[(AXIS)] >> 8))
+
+typedef struct
+{
+	/* PARAMETERS */
+	// inverse[wheel][axis], wheel RPS per unit of body velocity, Q16.16
+	pidq_value_t inverse[KINEMATICS_WHEEL_COUNT][3];
+	// forward[axis][wheel], body velocity per wheel RPS, Q16.16
+	pidq_value_t forward[3][KINEMATICS_WHEEL_COUNT];
+	// Step length [s], Q8.24 (Q16.16 would make distance of every
+	// step up to 0.05% off, the error does not average out)
+	int32_t step_s;
+	// Heading change per step and rad/s of omega (2^32 = full turn), Q16.16
+	pidq_value_t heading_per_omega;
+
+	/* STATE */
+	// Body velocity of last step (body frame), Q16.16
+	pidq_value_t velocity[3];
+	// Position in world frame [m], Q40.24 (fraction of every step is kept,
+	// See. KINEMATICS_GET_POSITION()). Distance of one step must stay
+	// below 128 m, truncation error is below 2^-24 m per step.
+	int64_t position[2];
+	// Heading, counter-clockwise, 2^32 = full turn (wraps)
+	uint32_t heading;
+} kinematics_t;
+
+// Initializes kinematics with zero matrices and pose at origin.
+// `step_s` is time between two kinematics_advance() calls.
+void kinematics_init(kinematics_t* h_kin, float step_s);
+
+// Sets matrices, row-major order as in kinematics_t.
+void kinematics_set_inverse(kinematics_t* h_kin, const pidq_value_t inverse[KINEMATICS_WHEEL_COUNT][3]);
+void kinematics_set_forward(kinematics_t* h_kin, const pidq_value_t forward[3][KINEMATICS_WHEEL_COUNT]);
+
+// Moves pose to origin, heading 0.
+void kinematics_reset_pose(kinematics_t* h_kin);
+
+// Computes wheel speeds of body velocity (inverse kinematics).
+void kinematics_get_wheel_rps(const kinematics_t* h_kin, const pidq_value_t velocity[3], pidq_value_t wheel_rps[KINEMATICS_WHEEL_COUNT]);
+
+// Computes body velocity from measured wheel speeds and integrates it
+// into pose over one step (velocity is rotated by heading in middle of step).
+void kinematics_advance(kinematics_t* h_kin, const pidq_value_t wheel_rps[KINEMATICS_WHEEL_COUNT]);
+
+#endif /* KINEMATICS_H_ */
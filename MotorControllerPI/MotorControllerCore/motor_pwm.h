@@ -0,0 +1,231 @@
+/*
+ * motor_pwm.h
+ *
+ * PWM outputs of the motor drivers of the board descriptor (See. board.h).
+ * Duty cycles are Q16.16 percent (same format as PID outputs), so the
+ * fraction of PI output is kept down to the resolution of the timer.
+ * motor_pwm_write() is the only update path: one compare register write
+ * per motor, called once at the end of PID step.
+ *
+ * MOTOR_PWM_BACKEND (define before including board.h, default in board.h):
+ * - MOTOR_PWM_BACKEND_TIMER_0_2: 8-bit TIMER 0 and/or TIMER 2, phase correct,
+ *                                inverted compare (0xFF = 0%), 3.9 kHz, 0.4% steps
+ * - MOTOR_PWM_BACKEND_TIMER_5:   16-bit TIMER 5 of ATmega2560, phase correct
+ *                                with TOP = ICR5, MOTOR_PWM_FREQUENCY_HZ
+ *                                (20 kHz = 400 steps, 0.25%). TIMER 5 can not
+ *                                be used for input capture then.
+ * Board descriptor gives the compare output of every motor:
+ * - MOTOR_<N>_PWM_OCR          compare register (e.g. OCR0B)
+ * - MOTOR_<N>_PWM_TCCRA        control register A of its timer (e.g. TCCR0A)
+ * - MOTOR_<N>_PWM_COM0, MOTOR_<N>_PWM_COM1
+ *                              compare output mode bits (e.g. COM0B0, COM0B1)
+ * and, with MOTOR_PWM_BACKEND_TIMER_0_2, which timers to configure:
+ * - BOARD_PWM_USES_TIMER_0, BOARD_PWM_USES_TIMER_2   (0 or 1)
+ * Only listed timers and compare outputs are touched, so boards use the
+ * remaining timers and channels for other purposes (e.g. PID tick).
+ */ 
+
+
+#ifndef MOTOR_PWM_H_
+#define MOTOR_PWM_H_
+
+#include <stdint.h>
+#include <avr/io.h>
+#include "utils_bitops.h"
+#include "pid.h" // pidq_value_t
+#include "board.h"
+
+#if MOTOR_PWM_BACKEND == MOTOR_PWM_BACKEND_TIMER_5
+	// Above audible range, VNH2SP30 allows at most 20 kHz
+	#ifndef MOTOR_PWM_FREQUENCY_HZ
+	#define MOTOR_PWM_FREQUENCY_HZ 20000UL
+	#endif
+
+	// Phase correct PWM counts up and down, no prescaler
+	#define MOTOR_PWM_TOP ((uint16_t)(F_CPU / (2 * MOTOR_PWM_FREQUENCY_HZ)))
+
+	#if (F_CPU / (2 * MOTOR_PWM_FREQUENCY_HZ)) < 100 || (F_CPU / (2 * MOTOR_PWM_FREQUENCY_HZ)) > 0xFFFF
+		#error "MOTOR_PWM_FREQUENCY_HZ gives TOP out of 100..65535"
+	#endif
+
+	typedef uint16_t motor_pwm_compare_t;
+#elif MOTOR_PWM_BACKEND == MOTOR_PWM_BACKEND_TIMER_0_2
+	#define MOTOR_PWM_TOP ((uint16_t)0xFF)
+
+	#if !defined(BOARD_PWM_USES_TIMER_0) || !defined(BOARD_PWM_USES_TIMER_2)
+		#error "board_config.h must define BOARD_PWM_USES_TIMER_0 and BOARD_PWM_USES_TIMER_2"
+	#endif
+
+	typedef uint8_t motor_pwm_compare_t;
+#else
+	#error "Unknown MOTOR_PWM_BACKEND"
+#endif
+
+// Timer counts per 1% of duty cycle, Q8.8 (rounded)
+#define MOTOR_PWM_COUNTS_PER_PERCENT_Q8 ((uint32_t)(((uint32_t)MOTOR_PWM_TOP * 256UL + 50) / 100))
+
+// Configures timer(s) of the backend, outputs start at 0% duty cycle.
+// PWM pins must be set as outputs by caller.
+static inline void motor_pwm_init(void);
+
+// Converts duty cycle (Q16.16 percent, limited to 0..100) to compare value.
+static inline motor_pwm_compare_t motor_pwm_compare_from_duty(pidq_value_t duty_percent)
+{
+	if (duty_percent <= 0)
+	{
+		duty_percent = 0;
+	}
+	
+	if (duty_percent > PIDQ_FROM_INT(100))
+	{
+		duty_percent = PIDQ_FROM_INT(100);
+	}
+	
+	// Q8.8 duty (at most 25600) keeps the product in 32 bits
+	const uint16_t counts = (uint16_t)(((uint32_t)(duty_percent >> 8) * MOTOR_PWM_COUNTS_PER_PERCENT_Q8) >> 16);
+	
+#if MOTOR_PWM_BACKEND == MOTOR_PWM_BACKEND_TIMER_0_2
+	// Set on upcount, clear on downcount
+	return (motor_pwm_compare_t)(MOTOR_PWM_TOP - counts);
+#else
+	return (motor_pwm_compare_t)counts;
+#endif
+}
+
+// Applies compare values of motors (`compares[BOARD_MOTOR_INDEX(N)]` of motor N,
+// See. motor_pwm_compare_from_duty()).
+// Inlined, so compares of caller's local array stay in registers.
+// MUST be called from main loop only (16-bit compare registers share TEMP register).
+static inline void motor_pwm_write(const motor_pwm_compare_t compares[BOARD_MOTOR_COUNT])
+{
+#define MOTOR_PWM_WRITE_COMPARE(N)	\
+	MOTOR_##N##_PWM_OCR = compares[BOARD_MOTOR_INDEX(N)];
+	BOARD_FOR_EACH_MOTOR(MOTOR_PWM_WRITE_COMPARE)
+#undef MOTOR_PWM_WRITE_COMPARE
+	
+	// TIMER 5 compare registers are double buffered (updated at TOP), no glitches.
+	// 8-bit timers are reset for correct transition between duty cycles.
+#if MOTOR_PWM_BACKEND == MOTOR_PWM_BACKEND_TIMER_0_2
+#if BOARD_PWM_USES_TIMER_0
+	TCNT0 = 0;
+#endif
+#if BOARD_PWM_USES_TIMER_2
+	TCNT2 = 0;
+#endif
+#endif
+}
+
+// Sets 0% duty cycle on all motors.
+static inline void motor_pwm_stop(void)
+{
+	motor_pwm_compare_t compares[BOARD_MOTOR_COUNT];
+	
+	for (uint8_t i = 0; i < BOARD_MOTOR_COUNT; i++)
+	{
+		compares[i] = motor_pwm_compare_from_duty(0);
+	}
+	
+	motor_pwm_write(compares);
+}
+
+static inline void motor_pwm_init(void)
+{
+#if MOTOR_PWM_BACKEND == MOTOR_PWM_BACKEND_TIMER_0_2
+	//////////////////////////////////////////////////////////////////////////
+	// One PWM channel (Output Compare Register) per motor on
+	// 8 bit TIMER 0 and/or TIMER 2 (See. board_config.h)
+	//////////////////////////////////////////////////////////////////////////
+	
+	motor_pwm_stop();
+	
+#if BOARD_PWM_USES_TIMER_0
+	//////////////////////////////////////////////////////////////////////////
+	// -- Timer 0
+	// Phase corrected PWM mode
+	
+	// Set phase corrected PWM mode of operation
+	SET_BIT(TCCR0A, WGM00);
+	CLR_BIT(TCCR0A, WGM01);
+	CLR_BIT(TCCR0B, WGM02);
+	
+	// Set clock prescaler to 1/8
+	// Which gives 16MHz/(8 * 510) = 3.9 kHz PWM frequency
+	CLR_BIT(TCCR0B, CS00);
+	SET_BIT(TCCR0B, CS01);
+	CLR_BIT(TCCR0B, CS02);
+	
+	// Disable interrupts
+	// Overflow
+	CLR_BIT(TIMSK0, TOIE0);
+	// Output Compare A, B Match
+	CLR_BIT(TIMSK0, OCIE0A);
+	CLR_BIT(TIMSK0, OCIE0B);
+	//////////////////////////////////////////////////////////////////////////
+#endif
+	
+#if BOARD_PWM_USES_TIMER_2
+	//////////////////////////////////////////////////////////////////////////
+	// -- Timer 2
+	// Phase corrected PWM mode
+	
+	// Set phase corrected PWM mode of operation
+	SET_BIT(TCCR2A, WGM20);
+	CLR_BIT(TCCR2A, WGM21);
+	CLR_BIT(TCCR2B, WGM22);
+	
+	// Set clock prescaler to 1/8
+	// Which gives 16MHz/(8 * 510) = 3.9 kHz PWM frequency
+	CLR_BIT(TCCR2B, CS20);
+	SET_BIT(TCCR2B, CS21);
+	CLR_BIT(TCCR2B, CS22);
+	
+	// Disable interrupts
+	// Overflow
+	CLR_BIT(TIMSK2, TOIE2);
+	// Output Compare A, B Match
+	CLR_BIT(TIMSK2, OCIE2A);
+	CLR_BIT(TIMSK2, OCIE2B);
+	//////////////////////////////////////////////////////////////////////////
+#endif
+	
+	// Set on upcount, clear on downcount
+#define MOTOR_PWM_ENABLE_OUTPUT(N)						\
+	SET_BIT(MOTOR_##N##_PWM_TCCRA, MOTOR_##N##_PWM_COM0);	\
+	SET_BIT(MOTOR_##N##_PWM_TCCRA, MOTOR_##N##_PWM_COM1);
+	BOARD_FOR_EACH_MOTOR(MOTOR_PWM_ENABLE_OUTPUT)
+#undef MOTOR_PWM_ENABLE_OUTPUT
+#else
+	//////////////////////////////////////////////////////////////////////////
+	// -- Timer 5
+	// Phase correct PWM, TOP = ICR5 (mode 10)
+	TCCR5A = 0;
+	TCCR5B = 0;
+	
+	ICR5 = MOTOR_PWM_TOP;
+	TCNT5 = 0;
+	
+	motor_pwm_stop();
+	
+	SET_BIT(TCCR5A, WGM51);
+	CLR_BIT(TCCR5A, WGM50);
+	CLR_BIT(TCCR5B, WGM52);
+	SET_BIT(TCCR5B, WGM53);
+	
+	// Clear on upcount, set on downcount (OCR5x = 0 is constant low)
+#define MOTOR_PWM_ENABLE_OUTPUT(N)	\
+	SET_BIT(MOTOR_##N##_PWM_TCCRA, MOTOR_##N##_PWM_COM1);
+	BOARD_FOR_EACH_MOTOR(MOTOR_PWM_ENABLE_OUTPUT)
+#undef MOTOR_PWM_ENABLE_OUTPUT
+	
+	// Disable interrupts
+	TIMSK5 = 0;
+	
+	// No prescaler, F_CPU / (2 * TOP) PWM frequency
+	SET_BIT(TCCR5B, CS50);
+	CLR_BIT(TCCR5B, CS51);
+	CLR_BIT(TCCR5B, CS52);
+	//////////////////////////////////////////////////////////////////////////
+#endif
+}
+
+#endif /* MOTOR_PWM_H_ */
@@ -0,0 +1,763 @@
+/*
+ * pid.c
+ *
+ * Created: 4/24/2023 8:59:13 PM
+ *  Author: KASO
+ */ 
+
+#include "pid.h"
+
+#ifndef NULL
+#define NULL (void*)0x00
+#endif
+
+#ifndef PRIVATE
+#define PRIVATE static
+#endif
+
+PRIVATE void PID_SetError(pid_t* hPID, pid_error_state_e error)
+{
+	if(NULL == hPID)
+	{
+		return;
+	}
+
+	hPID->bIsError = TRUE;
+	hPID->error_state = error;
+}
+
+void PID_Init(pid_t* hPID, float Kp, float Td, float Ti, float output_min, float output_max)
+{
+	if (NULL == hPID)
+	{
+		return;
+	}
+
+	hPID->current_output = 0;
+	hPID->previous_output = 0;
+	hPID->current_error = 0;
+	hPID->previous_error = 0;
+	hPID->pre_previous_error = 0;
+	hPID->current_time_delta = 0;
+	hPID->current_integral_error = 0;
+	hPID->saturation = 0;
+
+	hPID->Kp = Kp;
+	hPID->Td = Td;
+	hPID->Ti = Ti;
+
+	hPID->output_min = output_min;
+	hPID->output_max = output_max;
+
+	hPID->anti_windup = PID_ANTI_WINDUP_CLAMP;
+
+	hPID->fixed_time_delta = 0;
+	hPID->current_error_coefficient = 0;
+	hPID->previous_error_coefficient = 0;
+	hPID->bCoefficientsOutdated = TRUE;
+
+	hPID->bIsError = FALSE;
+	hPID->error_state = PID_ERROR_NO_ERROR;
+
+	if(output_max <= output_min)
+	{
+		PID_SetError(hPID, PID_ERROR_OUTPUT_MAX_MIN);
+	}
+
+	if (Ti == 0)
+	{
+		PID_SetError(hPID, PID_ERROR_TI_ZERO_DIV);
+	}
+	
+}
+
+float PID_Advance(pid_t* hPID, float timestep, float error)
+{
+	if (NULL == hPID || hPID->bIsError)
+	{
+		return 0;
+	}
+
+	if(PID_CheckError(hPID, NULL))
+	{
+		return 0;
+	}
+
+	if (timestep == 0)
+	{
+		PID_SetError(hPID, PID_ERROR_TIMESTEP_ZERO_DIV);
+	}
+
+	hPID->current_time_delta = timestep;
+	
+	hPID->pre_previous_error = hPID->previous_error;
+	hPID->previous_error = hPID->current_error;
+	hPID->current_error = error;
+
+	hPID->previous_output = hPID->current_output;
+
+	float current_error_term = hPID->Kp * (1 + hPID->Ti * hPID->current_time_delta);
+	float previous_error_term = -1 * hPID->Kp;
+
+	hPID->current_output = current_error_term * hPID->current_error 
+		+ previous_error_term * hPID->previous_error
+		+ hPID->previous_output;
+		
+	//float current_error_term = hPID->Kp * (1 + hPID->current_time_delta / hPID->Ti);
+	//float previous_error_term = -1 * hPID->Kp;
+	//
+	//hPID->current_output = current_error_term * hPID->current_error
+	//+ previous_error_term * hPID->previous_error
+	//+ hPID->previous_output;
+
+	if (hPID->current_output > hPID->output_max)
+	{
+		hPID->current_output = hPID->output_max;
+	}
+	
+	if (hPID->current_output < hPID->output_min)
+	{
+		hPID->current_output = hPID->output_min;
+	}
+
+	return hPID->current_output;
+}
+
+bool PID_CheckError(pid_t* hPID, pid_error_state_e* p_error_container)
+{
+	if (NULL == hPID)
+	{
+		return TRUE;
+	}
+	else if (NULL == p_error_container)
+	{
+		return hPID->bIsError;
+	}
+
+	*p_error_container = hPID->error_state;
+	return hPID->bIsError;
+}
+
+// Recalculates fixed-rate mode coefficients.
+// Returns FALSE if controller is in error state (coefficients stay outdated).
+PRIVATE bool PID_UpdateCoefficients(pid_t* hPID)
+{
+	if (NULL == hPID || hPID->bIsError)
+	{
+		return FALSE;
+	}
+
+	if (hPID->fixed_time_delta == 0)
+	{
+		PID_SetError(hPID, PID_ERROR_TIMESTEP_ZERO_DIV);
+		return FALSE;
+	}
+
+	hPID->current_error_coefficient = hPID->Kp * (1 + hPID->Ti * hPID->fixed_time_delta);
+	hPID->previous_error_coefficient = -1 * hPID->Kp;
+	hPID->bCoefficientsOutdated = FALSE;
+
+	return TRUE;
+}
+
+void PID_InitFixedRate(pid_t* hPID, float Kp, float Td, float Ti, float timestep, float output_min, float output_max)
+{
+	if (NULL == hPID)
+	{
+		return;
+	}
+
+	PID_Init(hPID, Kp, Td, Ti, output_min, output_max);
+
+	hPID->fixed_time_delta = timestep;
+	PID_UpdateCoefficients(hPID);
+}
+
+float PID_AdvanceFixedRate(pid_t* hPID, float error)
+{
+	return PID_AdvanceFixedRateWithFeedforward(hPID, error, 0);
+}
+
+float PID_AdvanceFixedRateWithFeedforward(pid_t* hPID, float error, float feedforward)
+{
+	// Only one check in the hot path, errors are detected when coefficients are calculated
+	if (hPID->bCoefficientsOutdated && !PID_UpdateCoefficients(hPID))
+	{
+		return 0;
+	}
+
+	hPID->previous_error = hPID->current_error;
+	hPID->current_error = error;
+
+	hPID->previous_output = hPID->current_output;
+
+	// Kp * (1 + Ti * dt) = Kp (proportional) + Kp * Ti * dt (integral)
+	float current_error_coefficient = hPID->current_error_coefficient;
+
+	if (hPID->anti_windup == PID_ANTI_WINDUP_CONDITIONAL
+		&& ((hPID->saturation > 0 && error > 0) || (hPID->saturation < 0 && error < 0)))
+	{
+		// Proportional part only
+		current_error_coefficient = -hPID->previous_error_coefficient;
+	}
+
+	// `current_output` holds PI part only
+	hPID->current_output = current_error_coefficient * hPID->current_error
+		+ hPID->previous_error_coefficient * hPID->previous_error
+		+ hPID->previous_output;
+
+	hPID->saturation = 0;
+
+	if (hPID->current_output + feedforward > hPID->output_max)
+	{
+		hPID->current_output = hPID->output_max - feedforward;
+		hPID->saturation = 1;
+	}
+
+	if (hPID->current_output + feedforward < hPID->output_min)
+	{
+		hPID->current_output = hPID->output_min - feedforward;
+		hPID->saturation = -1;
+	}
+
+	return hPID->current_output + feedforward;
+}
+
+void PID_SetGains(pid_t* hPID, float Kp, float Ti)
+{
+	if (NULL == hPID)
+	{
+		return;
+	}
+
+	hPID->Kp = Kp;
+	hPID->Ti = Ti;
+	hPID->bCoefficientsOutdated = TRUE;
+
+	if (Ti == 0)
+	{
+		PID_SetError(hPID, PID_ERROR_TI_ZERO_DIV);
+	}
+}
+
+void PID_SetTimestep(pid_t* hPID, float timestep)
+{
+	if (NULL == hPID)
+	{
+		return;
+	}
+
+	hPID->fixed_time_delta = timestep;
+	hPID->bCoefficientsOutdated = TRUE;
+}
+
+void PID_SetAntiWindup(pid_t* hPID, pid_anti_windup_e mode)
+{
+	if (NULL == hPID)
+	{
+		return;
+	}
+
+	hPID->anti_windup = mode;
+}
+
+void PID_SetOutputMax(pid_t* hPID, float output_max)
+{
+	if (NULL == hPID || output_max <= hPID->output_min)
+	{
+		return;
+	}
+
+	hPID->output_max = output_max;
+}
+
+void PID_SetState(pid_t* hPID, float output, float feedforward, float error)
+{
+	if (NULL == hPID)
+	{
+		return;
+	}
+
+	if (output + feedforward > hPID->output_max)
+	{
+		output = hPID->output_max - feedforward;
+	}
+
+	if (output + feedforward < hPID->output_min)
+	{
+		output = hPID->output_min - feedforward;
+	}
+
+	hPID->current_output = output;
+	hPID->previous_output = output;
+	hPID->current_error = error;
+	hPID->previous_error = error;
+	hPID->pre_previous_error = error;
+	hPID->saturation = 0;
+}
+
+void PID_ClearAccumulatedValues(pid_t* hPID)
+{
+	if (NULL == hPID)
+	{
+		return;
+	}
+	
+	hPID->current_output = 0;
+	hPID->previous_output = 0;
+	hPID->current_error = 0;
+	hPID->previous_error = 0;
+	hPID->pre_previous_error = 0;
+	hPID->current_time_delta = 0;
+	hPID->current_integral_error = 0;
+	hPID->saturation = 0;
+}
+
+/*
+ * Fixed-point (Q16.16) PI controller
+ */
+
+PRIVATE void PIDQ_SetError(pidq_t* hPID, pid_error_state_e error)
+{
+	if(NULL == hPID)
+	{
+		return;
+	}
+
+	hPID->bIsError = TRUE;
+	hPID->error_state = error;
+}
+
+void PIDQ_Init(pidq_t* hPID, float Kp, float Ti, float output_min, float output_max)
+{
+	if (NULL == hPID)
+	{
+		return;
+	}
+
+	PIDQ_ClearAccumulatedValues(hPID);
+
+	hPID->Kp = PIDQ_FROM_FLOAT(Kp);
+	hPID->Ti = PIDQ_FROM_FLOAT(Ti);
+
+	hPID->output_min = PIDQ_FROM_FLOAT(output_min);
+	hPID->output_max = PIDQ_FROM_FLOAT(output_max);
+
+	hPID->anti_windup = PID_ANTI_WINDUP_CLAMP;
+
+	hPID->fixed_time_delta = 0;
+	hPID->current_error_coefficient = 0;
+	hPID->previous_error_coefficient = 0;
+	hPID->bCoefficientsOutdated = TRUE;
+
+	hPID->bIsError = FALSE;
+	hPID->error_state = PID_ERROR_NO_ERROR;
+
+	if(output_max <= output_min)
+	{
+		PIDQ_SetError(hPID, PID_ERROR_OUTPUT_MAX_MIN);
+	}
+
+	if (hPID->Ti == 0)
+	{
+		PIDQ_SetError(hPID, PID_ERROR_TI_ZERO_DIV);
+	}
+}
+
+pidq_value_t PIDQ_Advance(pidq_t* hPID, pidq_value_t timestep, pidq_value_t error)
+{
+	if (NULL == hPID || hPID->bIsError)
+	{
+		return 0;
+	}
+
+	if (timestep == 0)
+	{
+		PIDQ_SetError(hPID, PID_ERROR_TIMESTEP_ZERO_DIV);
+	}
+
+	hPID->current_time_delta = timestep;
+
+	hPID->previous_error = hPID->current_error;
+	hPID->current_error = error;
+
+	hPID->previous_output = hPID->current_output;
+
+	// Kp * (1 + Ti * dt) and -Kp, see PID_Advance()
+	pidq_value_t current_error_term = hPID->Kp + PIDQ_Multiply(hPID->Kp, PIDQ_Multiply(hPID->Ti, timestep));
+	pidq_value_t previous_error_term = -hPID->Kp;
+
+	// Accumulate in 64 bits so that saturation below sees the true value
+	int64_t output = (int64_t)PIDQ_Multiply(current_error_term, hPID->current_error)
+		+ PIDQ_Multiply(previous_error_term, hPID->previous_error)
+		+ hPID->previous_output;
+
+	if (output > hPID->output_max)
+	{
+		output = hPID->output_max;
+	}
+
+	if (output < hPID->output_min)
+	{
+		output = hPID->output_min;
+	}
+
+	hPID->current_output = (pidq_value_t)output;
+
+	return hPID->current_output;
+}
+
+bool PIDQ_CheckError(pidq_t* hPID, pid_error_state_e* p_error_container)
+{
+	if (NULL == hPID)
+	{
+		return TRUE;
+	}
+	else if (NULL == p_error_container)
+	{
+		return hPID->bIsError;
+	}
+
+	*p_error_container = hPID->error_state;
+	return hPID->bIsError;
+}
+
+void PIDQ_ClearAccumulatedValues(pidq_t* hPID)
+{
+	if (NULL == hPID)
+	{
+		return;
+	}
+
+	hPID->current_output = 0;
+	hPID->previous_output = 0;
+	hPID->current_error = 0;
+	hPID->previous_error = 0;
+	hPID->current_time_delta = 0;
+	hPID->saturation = 0;
+}
+
+// Recalculates fixed-rate mode coefficients.
+// Returns FALSE if controller is in error state (coefficients stay outdated).
+PRIVATE bool PIDQ_UpdateCoefficients(pidq_t* hPID)
+{
+	if (NULL == hPID || hPID->bIsError)
+	{
+		return FALSE;
+	}
+
+	if (hPID->fixed_time_delta == 0)
+	{
+		PIDQ_SetError(hPID, PID_ERROR_TIMESTEP_ZERO_DIV);
+		return FALSE;
+	}
+
+	hPID->current_error_coefficient = hPID->Kp + PIDQ_Multiply(hPID->Kp, PIDQ_Multiply(hPID->Ti, hPID->fixed_time_delta));
+	hPID->previous_error_coefficient = -hPID->Kp;
+	hPID->bCoefficientsOutdated = FALSE;
+
+	return TRUE;
+}
+
+void PIDQ_InitFixedRate(pidq_t* hPID, float Kp, float Ti, float timestep, float output_min, float output_max)
+{
+	if (NULL == hPID)
+	{
+		return;
+	}
+
+	PIDQ_Init(hPID, Kp, Ti, output_min, output_max);
+
+	hPID->fixed_time_delta = PIDQ_FROM_FLOAT(timestep);
+	PIDQ_UpdateCoefficients(hPID);
+}
+
+pidq_value_t PIDQ_AdvanceFixedRate(pidq_t* hPID, pidq_value_t error)
+{
+	return PIDQ_AdvanceFixedRateWithFeedforward(hPID, error, 0);
+}
+
+pidq_value_t PIDQ_AdvanceFixedRateWithFeedforward(pidq_t* hPID, pidq_value_t error, pidq_value_t feedforward)
+{
+	// Only one check in the hot path, errors are detected when coefficients are calculated
+	if (hPID->bCoefficientsOutdated && !PIDQ_UpdateCoefficients(hPID))
+	{
+		return 0;
+	}
+
+	hPID->previous_error = hPID->current_error;
+	hPID->current_error = error;
+
+	hPID->previous_output = hPID->current_output;
+
+	// Conditional integration, See. PID_AdvanceFixedRateWithFeedforward()
+	pidq_value_t current_error_coefficient = hPID->current_error_coefficient;
+
+	if (hPID->anti_windup == PID_ANTI_WINDUP_CONDITIONAL
+		&& ((hPID->saturation > 0 && error > 0) || (hPID->saturation < 0 && error < 0)))
+	{
+		current_error_coefficient = -hPID->previous_error_coefficient;
+	}
+
+	// PI part only, limits apply to PI + feedforward
+	int64_t output = (int64_t)PIDQ_Multiply(current_error_coefficient, hPID->current_error)
+		+ PIDQ_Multiply(hPID->previous_error_coefficient, hPID->previous_error)
+		+ hPID->previous_output;
+
+	hPID->saturation = 0;
+
+	if (output + feedforward > hPID->output_max)
+	{
+		output = (int64_t)hPID->output_max - feedforward;
+		hPID->saturation = 1;
+	}
+
+	if (output + feedforward < hPID->output_min)
+	{
+		output = (int64_t)hPID->output_min - feedforward;
+		hPID->saturation = -1;
+	}
+
+	hPID->current_output = (pidq_value_t)output;
+
+	return hPID->current_output + feedforward;
+}
+
+void PIDQ_SetGains(pidq_t* hPID, float Kp, float Ti)
+{
+	if (NULL == hPID)
+	{
+		return;
+	}
+
+	hPID->Kp = PIDQ_FROM_FLOAT(Kp);
+	hPID->Ti = PIDQ_FROM_FLOAT(Ti);
+	hPID->bCoefficientsOutdated = TRUE;
+
+	if (hPID->Ti == 0)
+	{
+		PIDQ_SetError(hPID, PID_ERROR_TI_ZERO_DIV);
+	}
+}
+
+void PIDQ_SetTimestep(pidq_t* hPID, float timestep)
+{
+	if (NULL == hPID)
+	{
+		return;
+	}
+
+	hPID->fixed_time_delta = PIDQ_FROM_FLOAT(timestep);
+	hPID->bCoefficientsOutdated = TRUE;
+}
+
+void PIDQ_SetAntiWindup(pidq_t* hPID, pid_anti_windup_e mode)
+{
+	if (NULL == hPID)
+	{
+		return;
+	}
+
+	hPID->anti_windup = mode;
+}
+
+void PIDQ_SetState(pidq_t* hPID, pidq_value_t output, pidq_value_t feedforward, pidq_value_t error)
+{
+	if (NULL == hPID)
+	{
+		return;
+	}
+
+	if ((int64_t)output + feedforward > hPID->output_max)
+	{
+		output = hPID->output_max - feedforward;
+	}
+
+	if ((int64_t)output + feedforward < hPID->output_min)
+	{
+		output = hPID->output_min - feedforward;
+	}
+
+	hPID->current_output = output;
+	hPID->previous_output = output;
+	hPID->current_error = error;
+	hPID->previous_error = error;
+	hPID->saturation = 0;
+}
+
+/*
+ * Feedforward
+ */
+
+// Calculates c0, c1 (See. pid.h). Returns FALSE if feedforward is disabled.
+PRIVATE bool PID_FeedforwardCoefficients(pid_feedforward_mode_e mode, float A, float B, float* p_c0, float* p_c1)
+{
+	*p_c0 = 0;
+	*p_c1 = 0;
+
+	if (A == 0)
+	{
+		return FALSE;
+	}
+
+	switch (mode)
+	{
+		case PID_FEEDFORWARD_STATIC_GAIN:
+			*p_c0 = (1 - B) / A;
+		return TRUE;
+
+		case PID_FEEDFORWARD_INVERSE_MODEL:
+			*p_c0 = 1 / A;
+			*p_c1 = -B / A;
+		return TRUE;
+
+		default:
+		return FALSE;
+	}
+}
+
+void PID_FeedforwardInit(pid_feedforward_t* hFF, pid_feedforward_mode_e mode, float A, float B, float offset)
+{
+	if (NULL == hFF)
+	{
+		return;
+	}
+
+	const bool bEnabled = PID_FeedforwardCoefficients(mode, A, B,
+		&hFF->current_setpoint_coefficient, &hFF->previous_setpoint_coefficient);
+
+	hFF->offset = bEnabled ? offset : 0;
+	hFF->model_A = bEnabled ? A : 0;
+	hFF->model_B = bEnabled ? B : 0;
+	PID_FeedforwardClear(hFF);
+}
+
+float PID_FeedforwardAdvance(pid_feedforward_t* hFF, float setpoint)
+{
+	// Model responds to output of previous sample, offset only covers unmodeled friction
+	hFF->reference = (hFF->model_A == 0) ? setpoint
+		: hFF->model_A * hFF->previous_output + hFF->model_B * hFF->reference;
+
+	float output = hFF->current_setpoint_coefficient * setpoint
+		+ hFF->previous_setpoint_coefficient * hFF->previous_setpoint;
+
+	hFF->previous_output = output;
+
+	if (setpoint != 0)
+	{
+		output += hFF->offset;
+	}
+
+	hFF->previous_setpoint = setpoint;
+
+	return output;
+}
+
+void PID_FeedforwardClear(pid_feedforward_t* hFF)
+{
+	if (NULL == hFF)
+	{
+		return;
+	}
+
+	hFF->previous_setpoint = 0;
+	hFF->previous_output = 0;
+	hFF->reference = 0;
+}
+
+float PID_FeedforwardSeed(pid_feedforward_t* hFF, float setpoint)
+{
+	if (NULL == hFF)
+	{
+		return 0;
+	}
+
+	hFF->previous_setpoint = setpoint;
+
+	float output = (hFF->current_setpoint_coefficient + hFF->previous_setpoint_coefficient) * setpoint;
+
+	// Steady state: model output holds `setpoint`
+	hFF->previous_output = output;
+	hFF->reference = setpoint;
+
+	if (setpoint != 0)
+	{
+		output += hFF->offset;
+	}
+
+	return output;
+}
+
+void PIDQ_FeedforwardInit(pidq_feedforward_t* hFF, pid_feedforward_mode_e mode, float A, float B, float offset)
+{
+	if (NULL == hFF)
+	{
+		return;
+	}
+
+	float c0 = 0;
+	float c1 = 0;
+	const bool bEnabled = PID_FeedforwardCoefficients(mode, A, B, &c0, &c1);
+
+	hFF->current_setpoint_coefficient = PIDQ_FROM_FLOAT(c0);
+	hFF->previous_setpoint_coefficient = PIDQ_FROM_FLOAT(c1);
+	hFF->offset = bEnabled ? PIDQ_FROM_FLOAT(offset) : 0;
+	hFF->model_A = bEnabled ? PIDQ_FROM_FLOAT(A) : 0;
+	hFF->model_B = bEnabled ? PIDQ_FROM_FLOAT(B) : 0;
+	PIDQ_FeedforwardClear(hFF);
+}
+
+pidq_value_t PIDQ_FeedforwardAdvance(pidq_feedforward_t* hFF, pidq_value_t setpoint)
+{
+	// See. PID_FeedforwardAdvance()
+	hFF->reference = (hFF->model_A == 0) ? setpoint
+		: PIDQ_Multiply(hFF->model_A, hFF->previous_output) + PIDQ_Multiply(hFF->model_B, hFF->reference);
+
+	pidq_value_t output = PIDQ_Multiply(hFF->current_setpoint_coefficient, setpoint)
+		+ PIDQ_Multiply(hFF->previous_setpoint_coefficient, hFF->previous_setpoint);
+
+	hFF->previous_output = output;
+
+	if (setpoint != 0)
+	{
+		output += hFF->offset;
+	}
+
+	hFF->previous_setpoint = setpoint;
+
+	return output;
+}
+
+void PIDQ_FeedforwardClear(pidq_feedforward_t* hFF)
+{
+	if (NULL == hFF)
+	{
+		return;
+	}
+
+	hFF->previous_setpoint = 0;
+	hFF->previous_output = 0;
+	hFF->reference = 0;
+}
+
+pidq_value_t PIDQ_FeedforwardSeed(pidq_feedforward_t* hFF, pidq_value_t setpoint)
+{
+	if (NULL == hFF)
+	{
+		return 0;
+	}
+
+	hFF->previous_setpoint = setpoint;
+
+	pidq_value_t output = PIDQ_Multiply(hFF->current_setpoint_coefficient + hFF->previous_setpoint_coefficient, setpoint);
+
+	hFF->previous_output = output;
+	hFF->reference = setpoint;
+
+	if (setpoint != 0)
+	{
+		output += hFF->offset;
+	}
+
+	return output;
+}
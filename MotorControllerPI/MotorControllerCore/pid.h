@@ -0,0 +1,261 @@
+/*
+ * pid.h
+ *
+ * Created: 4/24/2023 8:58:17 PM
+ *  Author: KASO
+ */ 
+
+
+#ifndef PID_H_
+#define PID_H_
+
+#include <stdint.h>
+
+#ifndef bool
+#define bool char
+#endif
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+typedef enum {
+	PID_ERROR_INVALID_HANDLE = -1,
+	PID_ERROR_NO_ERROR = 0,
+	PID_ERROR_TIMESTEP_ZERO_DIV = 1,
+	PID_ERROR_TI_ZERO_DIV = 2,
+	PID_ERROR_OUTPUT_MAX_MIN = 3
+} pid_error_state_e;
+
+// Anti-windup of fixed-rate mode controllers (See. PID_SetAntiWindup()).
+// PID_Advance()/PIDQ_Advance() always clamp.
+// - PID_ANTI_WINDUP_CLAMP:       output is clamped to limits. Integral increments
+//                                keep output at the limit until they are outweighed
+//                                by decrease of proportional part.
+// - PID_ANTI_WINDUP_CONDITIONAL: integral increment is skipped while output was
+//                                saturated in previous step and error drives it
+//                                further into saturation, output leaves the limit
+//                                as soon as error starts to decrease (less overshoot)
+typedef enum {
+	PID_ANTI_WINDUP_CLAMP = 0,
+	PID_ANTI_WINDUP_CONDITIONAL = 1
+} pid_anti_windup_e;
+
+typedef struct{
+	/* STATE */
+	float current_output;
+	float previous_output;
+	float current_error;
+	float previous_error;
+	float pre_previous_error;
+	float current_time_delta;
+	float current_integral_error;
+	// +1/-1 if output was clamped to maximum/minimum in last advance, 0 otherwise
+	int8_t saturation;
+
+	/* PARAMETERS */
+	float Kp;
+	float Td;
+	float Ti;
+
+	float output_max;
+	float output_min;
+
+	// pid_anti_windup_e (PID_ANTI_WINDUP_CLAMP after init)
+	uint8_t anti_windup;
+
+	/* FIXED-RATE MODE (See. PID_InitFixedRate) */
+	float fixed_time_delta;
+	float current_error_coefficient;
+	float previous_error_coefficient;
+	bool bCoefficientsOutdated;
+
+	/* ERROR */
+	bool bIsError;
+	pid_error_state_e error_state;
+
+} pid_t;
+
+void PID_Init(pid_t* hPID, float Kp, float Td, float Ti, float output_min, float output_max);
+float PID_Advance(pid_t* hPID, float timestep, float error);
+bool PID_CheckError(pid_t* hPID, pid_error_state_e* p_error_container);
+void PID_ClearAccumulatedValues(pid_t* hPID);
+
+// Fixed-rate mode: controller is always advanced by the same `timestep`, so
+// difference equation coefficients are calculated once (and again only after
+// PID_SetGains()/PID_SetTimestep()). PID_AdvanceFixedRate() does not validate
+// `hPID`, errors are checked only when coefficients are (re)calculated.
+void PID_InitFixedRate(pid_t* hPID, float Kp, float Td, float Ti, float timestep, float output_min, float output_max);
+float PID_AdvanceFixedRate(pid_t* hPID, float error);
+void PID_SetGains(pid_t* hPID, float Kp, float Ti);
+void PID_SetTimestep(pid_t* hPID, float timestep);
+void PID_SetAntiWindup(pid_t* hPID, pid_anti_windup_e mode);
+// Changes upper output limit (e.g. external current limit), ignored unless above `output_min`.
+// Output is limited from next advance, anti-windup applies to the new limit.
+void PID_SetOutputMax(pid_t* hPID, float output_max);
+
+// Bumpless transfer: seeds state so that next fixed-rate advance continues from
+// PI output `output` (feedforward not included, limited so that PI + `feedforward`
+// stays within output limits) with `error` as previous error, i.e. output only
+// changes by the proportional reaction to change of error.
+void PID_SetState(pid_t* hPID, float output, float feedforward, float error);
+
+/*
+ * Feedforward from identified first-order plant
+ *   y[k] = A * u[k-1] + B * y[k-1]    (u = controller output, y = measured value)
+ * (See. FirstOrderPlant in UART_Reader/pid_tester.py).
+ * Baseline output is computed from setpoint `r` and PI controller only corrects the residual:
+ *   u_ff[k] = c0 * r[k] + c1 * r[k-1] + offset    (offset is added only if r[k] != 0)
+ * - PID_FEEDFORWARD_STATIC_GAIN:   c0 = (1 - B) / A, c1 = 0 (steady state gain map)
+ * - PID_FEEDFORWARD_INVERSE_MODEL: c0 = 1 / A, c1 = -B / A (plant follows r with one sample delay,
+ *                                  meant for ramped setpoints, steps saturate the output)
+ * Model response to the feedforward outputs is kept in `reference`:
+ *   reference[k] = A * (u_ff[k-1] - offset) + B * reference[k-1]    (reference = r with feedforward disabled)
+ * PI error must be `reference - y`. Error against `r` makes PI react to the response delay that
+ * feedforward already accounts for, e.g. a step with inverse model overshoots by more than 50%.
+ */
+typedef enum {
+	PID_FEEDFORWARD_NONE = 0,
+	PID_FEEDFORWARD_STATIC_GAIN = 1,
+	PID_FEEDFORWARD_INVERSE_MODEL = 2
+} pid_feedforward_mode_e;
+
+typedef struct{
+	float current_setpoint_coefficient;
+	float previous_setpoint_coefficient;
+	float offset;
+	float previous_setpoint;
+	// Motor model, A = 0 if feedforward is disabled
+	float model_A;
+	float model_B;
+	float previous_output;
+	// Expected measured value of this sample (updated by PID_FeedforwardAdvance())
+	float reference;
+} pid_feedforward_t;
+
+// `A` must not be zero (feedforward is disabled then).
+void PID_FeedforwardInit(pid_feedforward_t* hFF, pid_feedforward_mode_e mode, float A, float B, float offset);
+float PID_FeedforwardAdvance(pid_feedforward_t* hFF, float setpoint);
+void PID_FeedforwardClear(pid_feedforward_t* hFF);
+
+// Bumpless transfer: `setpoint` becomes the previous setpoint and `reference`.
+// Returns output of next advance if setpoint stays at `setpoint` (steady state).
+float PID_FeedforwardSeed(pid_feedforward_t* hFF, float setpoint);
+
+// Same as PID_AdvanceFixedRate() but `feedforward` is added to the output.
+// Accumulated PI output is limited so that the sum stays within output limits.
+float PID_AdvanceFixedRateWithFeedforward(pid_t* hPID, float error, float feedforward);
+
+/*
+ * Fixed-point (Q16.16) PI controller.
+ * Same velocity form difference equation as PID_Advance() but without
+ * any floating point operations in PIDQ_Advance() (MCUs without FPU).
+ */
+
+// Q16.16 signed fixed-point number (range approx. +-32768, resolution 1/65536)
+typedef int32_t pidq_value_t;
+
+#define PIDQ_FRACTION_BITS 16
+#define PIDQ_ONE ((pidq_value_t)1 << PIDQ_FRACTION_BITS)
+
+// Conversions between Q16.16 and float/integer types.
+// Float conversions are meant for initialization and debugging, not for the hot path.
+#define PIDQ_FROM_FLOAT(X)	((pidq_value_t)((X) * (float)PIDQ_ONE + (((X) >= 0) ? 0.5f : -0.5f)))
+#define PIDQ_TO_FLOAT(X)	((float)(X) / (float)PIDQ_ONE)
+#define PIDQ_FROM_INT(X)	((pidq_value_t)(X) * PIDQ_ONE)
+#define PIDQ_TO_INT(X)		((int32_t)((X) >> PIDQ_FRACTION_BITS))
+
+// Q16.16 multiplication, same result as (pidq_value_t)(((int64_t)a * b) >> 16).
+// Product is built from 16x16 -> 32 bit partial products, avr-gcc would call
+// 64x64 bit __muldi3 for the int64_t product (AVR only multiplies 8x8 bits).
+static inline pidq_value_t PIDQ_Multiply(pidq_value_t a, pidq_value_t b)
+{
+	const int16_t a_high = (int16_t)(a >> PIDQ_FRACTION_BITS);
+	const uint16_t a_low = (uint16_t)a;
+	const int16_t b_high = (int16_t)(b >> PIDQ_FRACTION_BITS);
+	const uint16_t b_low = (uint16_t)b;
+
+	// Modulo 2^32 sum, fraction bits of low x low product are dropped (truncation)
+	uint32_t product = ((uint32_t)a_low * b_low) >> PIDQ_FRACTION_BITS;
+	product += (uint32_t)((int32_t)a_high * b_low);
+	product += (uint32_t)((int32_t)b_high * a_low);
+	product += (uint32_t)((int32_t)a_high * b_high) << PIDQ_FRACTION_BITS;
+
+	return (pidq_value_t)product;
+}
+
+typedef struct{
+	/* STATE */
+	pidq_value_t current_output;
+	pidq_value_t previous_output;
+	pidq_value_t current_error;
+	pidq_value_t previous_error;
+	pidq_value_t current_time_delta;
+	// See. pid_t
+	int8_t saturation;
+
+	/* PARAMETERS */
+	pidq_value_t Kp;
+	pidq_value_t Ti;
+
+	pidq_value_t output_max;
+	pidq_value_t output_min;
+
+	// pid_anti_windup_e
+	uint8_t anti_windup;
+
+	/* FIXED-RATE MODE (See. PIDQ_InitFixedRate) */
+	pidq_value_t fixed_time_delta;
+	pidq_value_t current_error_coefficient;
+	pidq_value_t previous_error_coefficient;
+	bool bCoefficientsOutdated;
+
+	/* ERROR */
+	bool bIsError;
+	pid_error_state_e error_state;
+
+} pidq_t;
+
+void PIDQ_Init(pidq_t* hPID, float Kp, float Ti, float output_min, float output_max);
+pidq_value_t PIDQ_Advance(pidq_t* hPID, pidq_value_t timestep, pidq_value_t error);
+bool PIDQ_CheckError(pidq_t* hPID, pid_error_state_e* p_error_container);
+void PIDQ_ClearAccumulatedValues(pidq_t* hPID);
+
+// Fixed-rate mode, See. PID_InitFixedRate()
+void PIDQ_InitFixedRate(pidq_t* hPID, float Kp, float Ti, float timestep, float output_min, float output_max);
+pidq_value_t PIDQ_AdvanceFixedRate(pidq_t* hPID, pidq_value_t error);
+void PIDQ_SetGains(pidq_t* hPID, float Kp, float Ti);
+void PIDQ_SetTimestep(pidq_t* hPID, float timestep);
+void PIDQ_SetAntiWindup(pidq_t* hPID, pid_anti_windup_e mode);
+
+// See. PID_SetState()
+void PIDQ_SetState(pidq_t* hPID, pidq_value_t output, pidq_value_t feedforward, pidq_value_t error);
+
+// Fixed-point feedforward, See. pid_feedforward_t
+typedef struct{
+	pidq_value_t current_setpoint_coefficient;
+	pidq_value_t previous_setpoint_coefficient;
+	pidq_value_t offset;
+	pidq_value_t previous_setpoint;
+	pidq_value_t model_A;
+	pidq_value_t model_B;
+	pidq_value_t previous_output;
+	pidq_value_t reference;
+} pidq_feedforward_t;
+
+void PIDQ_FeedforwardInit(pidq_feedforward_t* hFF, pid_feedforward_mode_e mode, float A, float B, float offset);
+pidq_value_t PIDQ_FeedforwardAdvance(pidq_feedforward_t* hFF, pidq_value_t setpoint);
+void PIDQ_FeedforwardClear(pidq_feedforward_t* hFF);
+
+// See. PID_FeedforwardSeed()
+pidq_value_t PIDQ_FeedforwardSeed(pidq_feedforward_t* hFF, pidq_value_t setpoint);
+
+// See. PID_AdvanceFixedRateWithFeedforward()
+pidq_value_t PIDQ_AdvanceFixedRateWithFeedforward(pidq_t* hPID, pidq_value_t error, pidq_value_t feedforward);
+
+
+#endif /* PID_H_ */
\ No newline at end of file
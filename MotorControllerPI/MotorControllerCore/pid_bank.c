@@ -0,0 +1,256 @@
+/*
+ * pid_bank.c
+ *
+ * Batched fixed-point (Q16.16) PI controllers.
+ */ 
+
+#include "pid_bank.h"
+
+#ifndef NULL
+#define NULL (void*)0x00
+#endif
+
+#ifndef PRIVATE
+#define PRIVATE static
+#endif
+
+PRIVATE void PIDBank_SetError(pid_bank_t* hBank, pid_error_state_e error)
+{
+	if(NULL == hBank)
+	{
+		return;
+	}
+
+	hBank->bIsError = TRUE;
+	hBank->error_state = error;
+}
+
+// Recalculates coefficients of all controllers.
+// Returns FALSE if bank is in error state (coefficients stay outdated).
+PRIVATE bool PIDBank_UpdateCoefficients(pid_bank_t* hBank)
+{
+	if (NULL == hBank || hBank->bIsError)
+	{
+		return FALSE;
+	}
+
+	if (hBank->fixed_time_delta == 0)
+	{
+		PIDBank_SetError(hBank, PID_ERROR_TIMESTEP_ZERO_DIV);
+		return FALSE;
+	}
+
+	for (uint8_t i = 0; i < hBank->n_controllers; i++)
+	{
+		// Kp * (1 + Ti * dt) and -Kp, see PID_Advance()
+		hBank->current_error_coefficient[i] = hBank->Kp[i]
+			+ PIDQ_Multiply(hBank->Kp[i], PIDQ_Multiply(hBank->Ti[i], hBank->fixed_time_delta));
+		hBank->previous_error_coefficient[i] = -hBank->Kp[i];
+	}
+
+	hBank->bCoefficientsOutdated = FALSE;
+
+	return TRUE;
+}
+
+void PIDBank_Init(pid_bank_t* hBank, uint8_t n_controllers, float Kp, float Ti, float timestep, float output_min, float output_max)
+{
+	if (NULL == hBank)
+	{
+		return;
+	}
+
+	hBank->bIsError = FALSE;
+	hBank->error_state = PID_ERROR_NO_ERROR;
+
+	if (n_controllers > PID_BANK_MAX_CONTROLLERS)
+	{
+		n_controllers = PID_BANK_MAX_CONTROLLERS;
+	}
+
+	hBank->n_controllers = n_controllers;
+	hBank->fixed_time_delta = PIDQ_FROM_FLOAT(timestep);
+	hBank->anti_windup = PID_ANTI_WINDUP_CLAMP;
+
+	for (uint8_t i = 0; i < n_controllers; i++)
+	{
+		hBank->Kp[i] = PIDQ_FROM_FLOAT(Kp);
+		hBank->Ti[i] = PIDQ_FROM_FLOAT(Ti);
+		hBank->output_min[i] = PIDQ_FROM_FLOAT(output_min);
+		hBank->output_max[i] = PIDQ_FROM_FLOAT(output_max);
+	}
+
+	PIDBank_ClearAccumulatedValues(hBank);
+
+	if(output_max <= output_min)
+	{
+		PIDBank_SetError(hBank, PID_ERROR_OUTPUT_MAX_MIN);
+	}
+
+	if (hBank->Ti[0] == 0)
+	{
+		PIDBank_SetError(hBank, PID_ERROR_TI_ZERO_DIV);
+	}
+
+	hBank->bCoefficientsOutdated = TRUE;
+	PIDBank_UpdateCoefficients(hBank);
+}
+
+void PIDBank_Advance(pid_bank_t* hBank, const pidq_value_t errors[], pidq_value_t outputs[])
+{
+	PIDBank_AdvanceWithFeedforward(hBank, errors, NULL, outputs);
+}
+
+void PIDBank_AdvanceWithFeedforward(pid_bank_t* hBank, const pidq_value_t errors[], const pidq_value_t feedforwards[], pidq_value_t outputs[])
+{
+	// Only one check in the hot path, errors are detected when coefficients are calculated
+	if (hBank->bCoefficientsOutdated && !PIDBank_UpdateCoefficients(hBank))
+	{
+		for (uint8_t i = 0; i < hBank->n_controllers; i++)
+		{
+			outputs[i] = 0;
+		}
+
+		return;
+	}
+
+	const bool bConditional = (hBank->anti_windup == PID_ANTI_WINDUP_CONDITIONAL);
+
+	for (uint8_t i = 0; i < hBank->n_controllers; i++)
+	{
+		const pidq_value_t feedforward = (NULL == feedforwards) ? 0 : feedforwards[i];
+
+		hBank->previous_error[i] = hBank->current_error[i];
+		hBank->current_error[i] = errors[i];
+
+		// Conditional integration drops integral increment, See. PID_AdvanceFixedRateWithFeedforward()
+		const pidq_value_t current_error_coefficient = (bConditional
+			&& ((hBank->saturation[i] > 0 && errors[i] > 0) || (hBank->saturation[i] < 0 && errors[i] < 0)))
+			? -hBank->previous_error_coefficient[i]
+			: hBank->current_error_coefficient[i];
+
+		// PI part only, limits apply to PI + feedforward
+		int64_t output = (int64_t)PIDQ_Multiply(current_error_coefficient, hBank->current_error[i])
+			+ PIDQ_Multiply(hBank->previous_error_coefficient[i], hBank->previous_error[i])
+			+ hBank->current_output[i];
+
+		hBank->saturation[i] = 0;
+
+		if (output + feedforward > hBank->output_max[i])
+		{
+			output = (int64_t)hBank->output_max[i] - feedforward;
+			hBank->saturation[i] = 1;
+		}
+
+		if (output + feedforward < hBank->output_min[i])
+		{
+			output = (int64_t)hBank->output_min[i] - feedforward;
+			hBank->saturation[i] = -1;
+		}
+
+		hBank->current_output[i] = (pidq_value_t)output;
+		outputs[i] = hBank->current_output[i] + feedforward;
+	}
+}
+
+void PIDBank_SetGains(pid_bank_t* hBank, uint8_t index, float Kp, float Ti)
+{
+	if (NULL == hBank || index >= hBank->n_controllers)
+	{
+		return;
+	}
+
+	hBank->Kp[index] = PIDQ_FROM_FLOAT(Kp);
+	hBank->Ti[index] = PIDQ_FROM_FLOAT(Ti);
+	hBank->bCoefficientsOutdated = TRUE;
+
+	if (hBank->Ti[index] == 0)
+	{
+		PIDBank_SetError(hBank, PID_ERROR_TI_ZERO_DIV);
+	}
+}
+
+void PIDBank_SetTimestep(pid_bank_t* hBank, pidq_value_t timestep)
+{
+	if (NULL == hBank || hBank->fixed_time_delta == timestep)
+	{
+		return;
+	}
+
+	hBank->fixed_time_delta = timestep;
+	hBank->bCoefficientsOutdated = TRUE;
+}
+
+void PIDBank_SetAntiWindup(pid_bank_t* hBank, pid_anti_windup_e mode)
+{
+	if (NULL == hBank)
+	{
+		return;
+	}
+
+	hBank->anti_windup = mode;
+}
+
+void PIDBank_SetOutputMax(pid_bank_t* hBank, uint8_t index, pidq_value_t output_max)
+{
+	if (NULL == hBank || index >= hBank->n_controllers || output_max <= hBank->output_min[index])
+	{
+		return;
+	}
+
+	hBank->output_max[index] = output_max;
+}
+
+void PIDBank_SetState(pid_bank_t* hBank, uint8_t index, pidq_value_t output, pidq_value_t feedforward, pidq_value_t error)
+{
+	if (NULL == hBank || index >= hBank->n_controllers)
+	{
+		return;
+	}
+
+	if ((int64_t)output + feedforward > hBank->output_max[index])
+	{
+		output = hBank->output_max[index] - feedforward;
+	}
+
+	if ((int64_t)output + feedforward < hBank->output_min[index])
+	{
+		output = hBank->output_min[index] - feedforward;
+	}
+
+	hBank->current_output[index] = output;
+	hBank->current_error[index] = error;
+	hBank->previous_error[index] = error;
+	hBank->saturation[index] = 0;
+}
+
+bool PIDBank_CheckError(pid_bank_t* hBank, pid_error_state_e* p_error_container)
+{
+	if (NULL == hBank)
+	{
+		return TRUE;
+	}
+	else if (NULL == p_error_container)
+	{
+		return hBank->bIsError;
+	}
+
+	*p_error_container = hBank->error_state;
+	return hBank->bIsError;
+}
+
+void PIDBank_ClearAccumulatedValues(pid_bank_t* hBank)
+{
+	if (NULL == hBank)
+	{
+		return;
+	}
+
+	for (uint8_t i = 0; i < PID_BANK_MAX_CONTROLLERS; i++)
+	{
+		hBank->current_output[i] = 0;
+		hBank->current_error[i] = 0;
+		hBank->previous_error[i] = 0;
+		hBank->saturation[i] = 0;
+	}
+}
@@ -0,0 +1,89 @@
+/*
+ * pid_bank.h
+ *
+ * Batched fixed-point (Q16.16) PI controllers.
+ * N controllers are stored as parallel arrays (struct-of-arrays) and
+ * advanced with one PIDBank_Advance() call. Difference equation is the
+ * same as in PIDQ_AdvanceFixedRate() (See. pid.h).
+ */ 
+
+
+#ifndef PID_BANK_H_
+#define PID_BANK_H_
+
+#include <stdint.h>
+#include "pid.h"
+
+// Maximal number of controllers in one bank (sizes the state arrays).
+// Projects with more motors than the default define it as compiler symbol,
+// so pid_bank.c is built with the same value (See. BOARD_MOTOR_COUNT).
+#ifndef PID_BANK_MAX_CONTROLLERS
+#define PID_BANK_MAX_CONTROLLERS 3
+#endif
+
+typedef struct{
+	/* STATE */
+	pidq_value_t current_output[PID_BANK_MAX_CONTROLLERS];
+	pidq_value_t current_error[PID_BANK_MAX_CONTROLLERS];
+	pidq_value_t previous_error[PID_BANK_MAX_CONTROLLERS];
+	// +1/-1 if output was clamped to maximum/minimum in last advance, 0 otherwise
+	int8_t saturation[PID_BANK_MAX_CONTROLLERS];
+
+	/* PARAMETERS */
+	pidq_value_t Kp[PID_BANK_MAX_CONTROLLERS];
+	pidq_value_t Ti[PID_BANK_MAX_CONTROLLERS];
+
+	pidq_value_t output_max[PID_BANK_MAX_CONTROLLERS];
+	pidq_value_t output_min[PID_BANK_MAX_CONTROLLERS];
+
+	// Shared by all controllers in the bank
+	pidq_value_t fixed_time_delta;
+	// pid_anti_windup_e, shared by all controllers (PID_ANTI_WINDUP_CLAMP after init)
+	uint8_t anti_windup;
+
+	/* CACHED COEFFICIENTS */
+	pidq_value_t current_error_coefficient[PID_BANK_MAX_CONTROLLERS];
+	pidq_value_t previous_error_coefficient[PID_BANK_MAX_CONTROLLERS];
+	bool bCoefficientsOutdated;
+
+	uint8_t n_controllers;
+
+	/* ERROR */
+	bool bIsError;
+	pid_error_state_e error_state;
+
+} pid_bank_t;
+
+// Initializes `n_controllers` controllers with the same parameters, advanced every `timestep` seconds.
+void PIDBank_Init(pid_bank_t* hBank, uint8_t n_controllers, float Kp, float Ti, float timestep, float output_min, float output_max);
+
+// Advances all controllers by one sample.
+// `errors` and `outputs` must hold `n_controllers` values (index = controller).
+// Handle is not validated, errors are checked only when coefficients are (re)calculated.
+void PIDBank_Advance(pid_bank_t* hBank, const pidq_value_t errors[], pidq_value_t outputs[]);
+
+// Same as PIDBank_Advance() with `feedforwards[i]` added to output of controller i
+// (See. PIDQ_AdvanceFixedRateWithFeedforward()). `feedforwards` may be NULL.
+void PIDBank_AdvanceWithFeedforward(pid_bank_t* hBank, const pidq_value_t errors[], const pidq_value_t feedforwards[], pidq_value_t outputs[]);
+
+// Changes gains of controller `index` (coefficients are recalculated on next advance).
+void PIDBank_SetGains(pid_bank_t* hBank, uint8_t index, float Kp, float Ti);
+
+// Changes timestep of all controllers (Q16.16 seconds, e.g. measured time between advances).
+// Coefficients are recalculated on next advance only if timestep changed.
+void PIDBank_SetTimestep(pid_bank_t* hBank, pidq_value_t timestep);
+
+// Changes anti-windup of all controllers (See. pid_anti_windup_e).
+void PIDBank_SetAntiWindup(pid_bank_t* hBank, pid_anti_windup_e mode);
+
+// Changes upper output limit of controller `index` (See. PID_SetOutputMax()).
+void PIDBank_SetOutputMax(pid_bank_t* hBank, uint8_t index, pidq_value_t output_max);
+
+// Seeds state of controller `index` for bumpless transfer (See. PID_SetState()).
+void PIDBank_SetState(pid_bank_t* hBank, uint8_t index, pidq_value_t output, pidq_value_t feedforward, pidq_value_t error);
+
+bool PIDBank_CheckError(pid_bank_t* hBank, pid_error_state_e* p_error_container);
+void PIDBank_ClearAccumulatedValues(pid_bank_t* hBank);
+
+
+#endif /* PID_BANK_H_ */
@@ -0,0 +1,88 @@
+/*
+ * profiler.c
+ *
+ * Hot path instrumentation, See. profiler.h
+ */ 
+
+#include "profiler.h"
+
+#ifndef NULL
+#define NULL (void*)0x00
+#endif
+
+profiler_probe_t g_profiler_probes[PROFILER_MAX_PROBES];
+uint16_t g_profiler_overhead_cycles = 0;
+
+void Profiler_Init(void)
+{
+	g_profiler_overhead_cycles = 0;
+	Profiler_Reset();
+
+	// Empty section measures cost of the instrumentation itself
+	const uint16_t start_cycles = Profiler_Now();
+	Profiler_Record(0, start_cycles);
+	g_profiler_overhead_cycles = g_profiler_probes[0].min_cycles;
+
+	Profiler_Reset();
+}
+
+void Profiler_Reset(void)
+{
+	for (uint8_t i = 0; i < PROFILER_MAX_PROBES; i++)
+	{
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			g_profiler_probes[i].min_cycles = UINT16_MAX;
+			g_profiler_probes[i].max_cycles = 0;
+			g_profiler_probes[i].total_cycles = 0;
+			g_profiler_probes[i].n_samples = 0;
+		}
+	}
+}
+
+void Profiler_GetProbe(uint8_t id, profiler_probe_t* p_probe)
+{
+	if (NULL == p_probe || id >= PROFILER_MAX_PROBES)
+	{
+		return;
+	}
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		*p_probe = g_profiler_probes[id];
+	}
+}
+
+void Profiler_Record(uint8_t id, uint16_t start_cycles)
+{
+	// Unsigned difference is correct across one TIMER 1 overflow
+	uint16_t cycles = (uint16_t)(Profiler_Now() - start_cycles);
+
+	if (id >= PROFILER_MAX_PROBES)
+	{
+		return;
+	}
+
+	cycles = (cycles > g_profiler_overhead_cycles) ? (uint16_t)(cycles - g_profiler_overhead_cycles) : 0;
+
+	profiler_probe_t* p_probe = &g_profiler_probes[id];
+
+	if (cycles < p_probe->min_cycles)
+	{
+		p_probe->min_cycles = cycles;
+	}
+
+	if (cycles > p_probe->max_cycles)
+	{
+		p_probe->max_cycles = cycles;
+	}
+
+	if (p_probe->n_samples == UINT16_MAX)
+	{
+		p_probe->total_cycles >>= 1;
+		p_probe->n_samples >>= 1;
+	}
+
+	p_probe->total_cycles += cycles;
+	++p_probe->n_samples;
+}
@@ -0,0 +1,111 @@
+/*
+ * profiler.h
+ *
+ * Hot path instrumentation. Code between PROFILE_BEGIN(ID) and PROFILE_END(ID)
+ * is measured with free-running TIMER 1 (clocked by F_CPU, 1 tick = 1 cycle)
+ * and min/max/mean cycle count is kept per probe ID.
+ *
+ * PROFILER_MODE (define before including this header):
+ * - PROFILER_MODE_DISABLED: macros compile to nothing
+ * - PROFILER_MODE_CYCLES:   cycle counts are accumulated in `g_profiler_probes`
+ * - PROFILER_MODE_GPIO:     pin PROFILER_GPIO_PIN of board_config.h is high while
+ *                           probe PROFILER_GPIO_PROBE runs (for scope measurement)
+ *
+ * Every probe ID must be used from one context only (one ISR or main loop).
+ * Measured sections must be shorter than 65536 cycles (4ms).
+ */ 
+
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+
+#define PROFILER_MODE_DISABLED	0
+#define PROFILER_MODE_CYCLES	1
+#define PROFILER_MODE_GPIO		2
+
+#ifndef PROFILER_MODE
+#define PROFILER_MODE PROFILER_MODE_DISABLED
+#endif
+
+// Size of `g_profiler_probes` table
+#ifndef PROFILER_MAX_PROBES
+#define PROFILER_MAX_PROBES 8
+#endif
+
+// Probe pin is board specific (See. board.h). It must not be ONBOARD_LED,
+// fatal error handler blinks it.
+#if PROFILER_MODE == PROFILER_MODE_GPIO
+#include "board.h"
+#if !defined(PROFILER_GPIO_PIN)
+	#error "board_config.h must define PROFILER_GPIO_PIN for PROFILER_MODE_GPIO"
+#elif PIN_ID(PROFILER_GPIO_PIN) == PIN_ID(ONBOARD_LED)
+	#error "PROFILER_GPIO_PIN must not be ONBOARD_LED"
+#endif
+#endif
+
+#ifndef PROFILER_GPIO_PROBE
+#define PROFILER_GPIO_PROBE 0
+#endif
+
+typedef struct {
+	uint16_t min_cycles;
+	uint16_t max_cycles;
+	// Sum and count are halved together when count saturates (mean is kept)
+	uint32_t total_cycles;
+	uint16_t n_samples;
+} profiler_probe_t;
+
+extern profiler_probe_t g_profiler_probes[PROFILER_MAX_PROBES];
+
+// Cycles spent by PROFILE_BEGIN/PROFILE_END themselves, subtracted from every sample
+extern uint16_t g_profiler_overhead_cycles;
+
+// Resets all probes and measures instrumentation overhead.
+// Call PROFILER_INIT() instead, it also works in other modes.
+void Profiler_Init(void);
+
+// Clears statistics of all probes.
+void Profiler_Reset(void);
+
+// Copies statistics of probe `id` (atomic with respect to ISR probes).
+// Mean is returned in `p_probe->total_cycles` divided by `n_samples`.
+void Profiler_GetProbe(uint8_t id, profiler_probe_t* p_probe);
+
+// Adds sample of probe `id` which started at `start_cycles` (See. PROFILE_END)
+void Profiler_Record(uint8_t id, uint16_t start_cycles);
+
+// Current TIMER 1 value. 16-bit register read is made atomic, because ISRs
+// which read TIMER 1 would corrupt shared TEMP register.
+static inline uint16_t Profiler_Now(void)
+{
+	uint16_t now = 0;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		now = TCNT1;
+	}
+
+	return now;
+}
+
+// Sets profiler up for PROFILER_MODE of including file (TIMER 1 must be running)
+#if PROFILER_MODE == PROFILER_MODE_CYCLES
+	#define PROFILER_INIT()		Profiler_Init()
+	#define PROFILE_BEGIN(ID)	const uint16_t profiler_start_##ID = Profiler_Now()
+	#define PROFILE_END(ID)		Profiler_Record((ID), profiler_start_##ID)
+#elif PROFILER_MODE == PROFILER_MODE_GPIO
+	#define PROFILER_INIT()		do { WRITE_PIN(PROFILER_GPIO_PIN, 0); PIN_MODE_OUTPUT(PROFILER_GPIO_PIN); } while(0)
+	#define PROFILE_BEGIN(ID)	do { if ((ID) == PROFILER_GPIO_PROBE) { WRITE_PIN(PROFILER_GPIO_PIN, 1); } } while(0)
+	#define PROFILE_END(ID)		do { if ((ID) == PROFILER_GPIO_PROBE) { WRITE_PIN(PROFILER_GPIO_PIN, 0); } } while(0)
+#else
+	#define PROFILER_INIT()		do {} while(0)
+	#define PROFILE_BEGIN(ID)	do {} while(0)
+	#define PROFILE_END(ID)		do {} while(0)
+#endif
+
+
+#endif /* PROFILER_H_ */
@@ -0,0 +1,76 @@
+/*
+ * pulse_tick_timer.c
+ *
+ * Implementation of pulse_tick_timer.h
+ */
+
+#include "pulse_tick_timer.h"
+
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#ifndef NULL
+#define NULL (void*)0x00
+#endif
+
+volatile uint16_t g_pulse_tick_timer_overflow_count = 0;
+
+static pulse_tick_timer_overflow_fn on_overflow_ = NULL;
+
+void PulseTickTimer_Init(pulse_tick_timer_overflow_fn on_overflow)
+{
+	on_overflow_ = on_overflow;
+
+	// Normal mode of operation, output compare pins disconnected, clock stopped
+	TCCR1A = 0;
+	TCCR1B = 0;
+
+	TCNT1 = 0;
+	g_pulse_tick_timer_overflow_count = 0;
+
+	// Clear stale overflow
+	TIFR1 = _BV(TOV1);
+}
+
+void PulseTickTimer_Start(void)
+{
+	// Enable overflow interrupt
+	TIMSK1 |= _BV(TOIE1);
+
+	// Enable clock (no prescaler)
+	TCCR1B = (TCCR1B & ~(_BV(CS12) | _BV(CS11))) | _BV(CS10);
+}
+
+uint32_t PulseTickTimer_GetTimestamp(void)
+{
+	uint32_t timestamp = 0;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		timestamp = PulseTickTimer_GetTimestampFromISR();
+	}
+
+	return timestamp;
+}
+
+uint16_t PulseTickTimer_GetOverflowCount(void)
+{
+	uint16_t overflow_count = 0;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		overflow_count = g_pulse_tick_timer_overflow_count;
+	}
+
+	return overflow_count;
+}
+
+ISR(TIMER1_OVF_vect)
+{
+	++g_pulse_tick_timer_overflow_count;
+
+	if (NULL != on_overflow_)
+	{
+		on_overflow_();
+	}
+}
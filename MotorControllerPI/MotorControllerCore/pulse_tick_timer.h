@@ -0,0 +1,63 @@
+/*
+ * pulse_tick_timer.h
+ *
+ * Free running 16-bit TIMER 1 without prescaler (1 tick = 1/F_CPU s),
+ * extended to 32-bit timestamps by counting overflows in TIMER1_OVF_vect
+ * (See. pulse_tick_timer.c). Encoder ISRs timestamp Hall pulses with it,
+ * timestamps wrap after 2^32 ticks (268 s at 16 MHz), so periods are taken
+ * as unsigned differences.
+ * TIMER 1 and its overflow vector belong to this module.
+ */
+
+
+#ifndef PULSE_TICK_TIMER_H_
+#define PULSE_TICK_TIMER_H_
+
+#include <stdint.h>
+#include <avr/io.h>
+
+// Called from TIMER1_OVF_vect after overflow count was incremented
+typedef void (*pulse_tick_timer_overflow_fn)(void);
+
+// High 16 bits of timestamp, incremented by TIMER1_OVF_vect.
+// Use accessors below, value is only consistent with TCNT1 in atomic blocks.
+extern volatile uint16_t g_pulse_tick_timer_overflow_count;
+
+// Sets normal mode with stopped clock and clears timer.
+// `on_overflow` is called from TIMER1_OVF_vect, NULL if not used.
+void PulseTickTimer_Init(pulse_tick_timer_overflow_fn on_overflow);
+
+// Enables overflow interrupt and starts clock.
+void PulseTickTimer_Start(void);
+
+// Returns 32-bit timestamp, can be called from main loop.
+uint32_t PulseTickTimer_GetTimestamp(void);
+
+// Returns overflow count (high 16 bits of timestamp), can be called from main loop.
+uint16_t PulseTickTimer_GetOverflowCount(void);
+
+// Returns 32-bit timestamp (TCNT1 extended with overflow count).
+// MUST be called with interrupts disabled (i.e. from ISR), no checks are made.
+static inline uint32_t PulseTickTimer_GetTimestampFromISR(void)
+{
+	const uint16_t low = TCNT1;
+	uint16_t high = g_pulse_tick_timer_overflow_count;
+
+	// TIMER 1 overflowed, but TIMER1_OVF_vect has not run yet (interrupts are disabled).
+	// If TCNT1 is small, it was read after overflow, so account for it here.
+	if ((TIFR1 & _BV(TOV1)) && low < 0x8000)
+	{
+		high++;
+	}
+
+	return ((uint32_t)high << 16) | low;
+}
+
+// Returns overflow count (high 16 bits of timestamp).
+// MUST be called with interrupts disabled (i.e. from ISR), no checks are made.
+static inline uint16_t PulseTickTimer_GetOverflowCountFromISR(void)
+{
+	return g_pulse_tick_timer_overflow_count;
+}
+
+#endif /* PULSE_TICK_TIMER_H_ */
@@ -0,0 +1,76 @@
+/*
+ * quadrature_encoder.c
+ *
+ * Implementation of quadrature_encoder.h
+ */ 
+
+#include "quadrature_encoder.h"
+
+#include <stddef.h>
+
+#define X QENC_INVALID_TRANSITION
+
+// Forward sequence (A leads B): 00 -> 01 -> 11 -> 10 -> 00
+const int8_t qenc_transition_table[16] = {
+	/* 00 -> */  0, +1, -1,  X,
+	/* 01 -> */ -1,  0,  X, +1,
+	/* 10 -> */ +1,  X,  0, -1,
+	/* 11 -> */  X, -1, +1,  0
+};
+
+#undef X
+
+void qenc_init(quadrature_encoder_t* h_qenc, uint8_t initial_state, uint16_t ticks_per_rotation, float window_frequency, uint16_t hybrid_threshold_ticks)
+{
+	if (h_qenc == NULL || ticks_per_rotation == 0)
+	{
+		return;
+	}
+
+	h_qenc->state = initial_state & 0x03;
+	h_qenc->direction = 1;
+	h_qenc->invalid_transition_count = 0;
+
+	h_qenc->rps_per_window_tick = PIDQ_FROM_FLOAT(window_frequency / ticks_per_rotation);
+	h_qenc->hybrid_threshold_ticks = hybrid_threshold_ticks;
+
+	qenc_reset(h_qenc);
+}
+
+void qenc_reset(quadrature_encoder_t* h_qenc)
+{
+	if (h_qenc == NULL)
+	{
+		return;
+	}
+
+	h_qenc->count = 0;
+	h_qenc->window_start_count = 0;
+	h_qenc->rps = 0;
+}
+
+pidq_value_t qenc_estimate_rps(quadrature_encoder_t* h_qenc, int32_t count, pidq_value_t period_rps)
+{
+	if (h_qenc == NULL)
+	{
+		return 0;
+	}
+
+	const int32_t window_ticks = count - h_qenc->window_start_count;
+	h_qenc->window_start_count = count;
+
+	const int32_t abs_window_ticks = (window_ticks < 0) ? -window_ticks : window_ticks;
+
+	if (abs_window_ticks >= h_qenc->hybrid_threshold_ticks)
+	{
+		// High speed: enough ticks in window for good resolution
+		h_qenc->rps = window_ticks * h_qenc->rps_per_window_tick;
+	}
+	else
+	{
+		// Low speed: period measurement has better resolution
+		h_qenc->rps = (h_qenc->direction < 0) ? -period_rps : period_rps;
+	}
+
+	return h_qenc->rps;
+}
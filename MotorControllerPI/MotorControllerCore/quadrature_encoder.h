@@ -0,0 +1,92 @@
+/*
+ * quadrature_encoder.h
+ *
+ * Quadrature (channel A + B) decoder with signed 32-bit tick count.
+ * Every edge of A and B is decoded with a 16 entry state transition table,
+ * so one rotation gives 4 * (pulses per rotation) ticks.
+ *
+ * Speed is estimated with a hybrid method: at high speed ticks counted
+ * in a fixed window are used (M method), at low speed speed measured from
+ * pulse period is used (T method) and only direction is taken from ticks.
+ */ 
+
+
+#ifndef QUADRATURE_ENCODER_H_
+#define QUADRATURE_ENCODER_H_
+
+#include <stdint.h>
+#include "pid.h"
+
+// Builds state from channel levels (1 or 0)
+#define QENC_STATE(A, B) ((uint8_t)(((A) << 1) | (B)))
+// Channel A bit in state
+#define QENC_CHANNEL_A 0x02
+
+// Marks invalid transition in `qenc_transition_table` (both channels changed)
+#define QENC_INVALID_TRANSITION 2
+
+typedef struct
+{
+	/* STATE (written by encoder ISRs) */
+	volatile int32_t count;
+	// Last channel levels (A = bit 1, B = bit 0)
+	volatile uint8_t state;
+	// Direction of last valid step (+1 or -1)
+	volatile int8_t direction;
+	// Number of missed edges (both channels changed between two ISRs)
+	volatile uint8_t invalid_transition_count;
+
+	/* HYBRID ESTIMATOR (written by main loop) */
+	int32_t window_start_count;
+	// Last estimated speed in RPS, signed, Q16.16 fixed-point
+	pidq_value_t rps;
+
+	/* PARAMETERS */
+	// RPS that corresponds to one tick per estimation window, Q16.16
+	pidq_value_t rps_per_window_tick;
+	// Ticks per window at (and above) which count based estimate is used
+	uint16_t hybrid_threshold_ticks;
+} quadrature_encoder_t;
+
+// Indexed by (previous state << 2) | current state. Values are -1, 0, +1
+// or QENC_INVALID_TRANSITION.
+extern const int8_t qenc_transition_table[16];
+
+// Initializes `quadrature_encoder_t` structure.
+// `initial_state` - channel levels at startup (A = bit 1, B = bit 0)
+// `ticks_per_rotation` - ticks per one rotation (4 * pulses per rotation)
+// `window_frequency` - frequency of qenc_estimate_rps() calls in Hz
+// `hybrid_threshold_ticks` - ticks per window above which count based estimate is used
+void qenc_init(quadrature_encoder_t* h_qenc, uint8_t initial_state, uint16_t ticks_per_rotation, float window_frequency, uint16_t hybrid_threshold_ticks);
+
+// Resets tick count and speed estimate to zero.
+// NOTE: Must not be interrupted by qenc_update() (e.g. called with interrupts disabled)
+void qenc_reset(quadrature_encoder_t* h_qenc);
+
+// Decodes new channel levels `state` (A = bit 1, B = bit 0).
+// Intended to be called from pin change ISRs, so no handle checks are made.
+static inline void qenc_update(quadrature_encoder_t* h_qenc, uint8_t state)
+{
+	const int8_t step = qenc_transition_table[(h_qenc->state << 2) | state];
+	h_qenc->state = state;
+
+	if (QENC_INVALID_TRANSITION == step)
+	{
+		++h_qenc->invalid_transition_count;
+		return;
+	}
+
+	if (step != 0)
+	{
+		h_qenc->count += step;
+		h_qenc->direction = step;
+	}
+}
+
+// Estimates speed, must be called once per estimation window.
+// `count` - snapshot of `h_qenc->count` (taken atomically by the caller)
+// `period_rps` - absolute speed measured from pulse period (Q16.16), used at low speed
+// Returns signed speed estimate in RPS (Q16.16), also saved in `h_qenc->rps`.
+pidq_value_t qenc_estimate_rps(quadrature_encoder_t* h_qenc, int32_t count, pidq_value_t period_rps);
+
+#endif /* QUADRATURE_ENCODER_H_ */
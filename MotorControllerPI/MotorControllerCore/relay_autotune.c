@@ -0,0 +1,170 @@
+/*
+ * relay_autotune.c
+ *
+ * Implementation of relay_autotune.h
+ */ 
+
+#include "relay_autotune.h"
+
+#include <math.h>
+#include <stddef.h>
+
+#define RELAY_AUTOTUNE_PI 3.14159265f
+
+static float relay_autotune_clamp(const relay_autotune_t* h_tune, float u)
+{
+	if (u > h_tune->output_max)
+	{
+		return h_tune->output_max;
+	}
+
+	if (u < h_tune->output_min)
+	{
+		return h_tune->output_min;
+	}
+
+	return u;
+}
+
+void relay_autotune_init(relay_autotune_t* h_tune, float setpoint, float bias, float amplitude, float hysteresis,
+	float output_min, float output_max, uint8_t skip_cycles, uint8_t measure_cycles, uint16_t max_steps)
+{
+	if (h_tune == NULL)
+	{
+		return;
+	}
+
+	h_tune->setpoint = setpoint;
+	h_tune->bias = bias;
+	h_tune->amplitude = fabsf(amplitude);
+	h_tune->hysteresis = fabsf(hysteresis);
+	h_tune->output_min = output_min;
+	h_tune->output_max = output_max;
+	h_tune->skip_cycles = skip_cycles;
+	h_tune->measure_cycles = (measure_cycles == 0) ? 1 : measure_cycles;
+	h_tune->max_steps = max_steps;
+
+	h_tune->state = RELAY_AUTOTUNE_STATE_RUNNING;
+	// Loop starts below setpoint
+	h_tune->is_output_high = 1;
+	h_tune->n_boundaries = 0;
+	h_tune->n_steps = 0;
+	h_tune->last_boundary_step = 0;
+	h_tune->y_max = 0;
+	h_tune->y_min = 0;
+	h_tune->period_steps_sum = 0;
+	h_tune->amplitude_sum = 0;
+}
+
+float relay_autotune_advance(relay_autotune_t* h_tune, float y)
+{
+	if (h_tune == NULL)
+	{
+		return 0;
+	}
+
+	if (h_tune->state != RELAY_AUTOTUNE_STATE_RUNNING)
+	{
+		return relay_autotune_clamp(h_tune, h_tune->bias);
+	}
+
+	if (y > h_tune->y_max)
+	{
+		h_tune->y_max = y;
+	}
+
+	if (y < h_tune->y_min)
+	{
+		h_tune->y_min = y;
+	}
+
+	if (h_tune->is_output_high && y > h_tune->setpoint + h_tune->hysteresis)
+	{
+		h_tune->is_output_high = 0;
+
+		// Cycle between this and previous boundary is complete
+		if (h_tune->n_boundaries > h_tune->skip_cycles)
+		{
+			h_tune->period_steps_sum += (uint16_t)(h_tune->n_steps - h_tune->last_boundary_step);
+			h_tune->amplitude_sum += 0.5f * (h_tune->y_max - h_tune->y_min);
+		}
+
+		if (h_tune->n_boundaries < UINT8_MAX)
+		{
+			++h_tune->n_boundaries;
+		}
+
+		h_tune->last_boundary_step = h_tune->n_steps;
+		h_tune->y_max = y;
+		h_tune->y_min = y;
+
+		if (h_tune->n_boundaries > h_tune->skip_cycles + h_tune->measure_cycles)
+		{
+			h_tune->state = RELAY_AUTOTUNE_STATE_DONE;
+			return relay_autotune_clamp(h_tune, h_tune->bias);
+		}
+	}
+	else if (!h_tune->is_output_high && y < h_tune->setpoint - h_tune->hysteresis)
+	{
+		h_tune->is_output_high = 1;
+	}
+
+	if (++h_tune->n_steps >= h_tune->max_steps)
+	{
+		h_tune->state = RELAY_AUTOTUNE_STATE_TIMEOUT;
+		return relay_autotune_clamp(h_tune, h_tune->bias);
+	}
+
+	const float u = h_tune->is_output_high
+		? h_tune->bias + h_tune->amplitude
+		: h_tune->bias - h_tune->amplitude;
+
+	return relay_autotune_clamp(h_tune, u);
+}
+
+uint8_t relay_autotune_get_ultimate(const relay_autotune_t* h_tune, float timestep, float* p_ku, float* p_pu)
+{
+	if (h_tune == NULL || p_ku == NULL || p_pu == NULL)
+	{
+		return 0;
+	}
+
+	if (h_tune->state != RELAY_AUTOTUNE_STATE_DONE)
+	{
+		return 0;
+	}
+
+	const float a = h_tune->amplitude_sum / h_tune->measure_cycles;
+	const float h = h_tune->hysteresis;
+
+	if (!(a > h) || h_tune->period_steps_sum == 0)
+	{
+		return 0;
+	}
+
+	// Relay amplitude as limited by output range (bias may be near a limit)
+	const float d = 0.5f * (relay_autotune_clamp(h_tune, h_tune->bias + h_tune->amplitude)
+		- relay_autotune_clamp(h_tune, h_tune->bias - h_tune->amplitude));
+
+	*p_ku = 4.0f * d / (RELAY_AUTOTUNE_PI * sqrtf(a * a - h * h));
+	*p_pu = timestep * (float)h_tune->period_steps_sum / h_tune->measure_cycles;
+	return 1;
+}
+
+void relay_autotune_compute_pi(float ku, float pu, uint8_t rule, float* p_kp, float* p_ti)
+{
+	if (p_kp == NULL || p_ti == NULL)
+	{
+		return;
+	}
+
+	if (rule == RELAY_AUTOTUNE_RULE_TYREUS_LUYBEN)
+	{
+		*p_kp = ku / 3.2f;
+		*p_ti = 1.0f / (2.2f * pu);
+		return;
+	}
+
+	*p_kp = 0.45f * ku;
+	*p_ti = 1.2f / pu;
+}
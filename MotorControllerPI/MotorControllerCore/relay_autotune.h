@@ -0,0 +1,81 @@
+/*
+ * relay_autotune.h
+ *
+ * Relay feedback (Astrom-Hagglund) auto-tuning of one PI controlled loop.
+ * Controller is replaced by relay with hysteresis around `bias`:
+ *     u = bias + amplitude   while y < setpoint - hysteresis
+ *     u = bias - amplitude   while y > setpoint + hysteresis
+ * which makes the loop oscillate at its ultimate period Pu. Amplitude `a`
+ * of the oscillation gives ultimate gain Ku = 4 * d / (pi * sqrt(a^2 - h^2)).
+ * Cycles are delimited by switches to low output, the first `skip_cycles`
+ * are not measured (settling), then period and amplitude are averaged
+ * over `measure_cycles` cycles.
+ */ 
+
+
+#ifndef RELAY_AUTOTUNE_H_
+#define RELAY_AUTOTUNE_H_
+
+#include <stdint.h>
+
+typedef enum
+{
+	RELAY_AUTOTUNE_STATE_RUNNING = 0,
+	RELAY_AUTOTUNE_STATE_DONE = 1,
+	RELAY_AUTOTUNE_STATE_TIMEOUT = 2,      // Not enough cycles within `max_steps`
+} relay_autotune_state_e;
+
+// PI tuning rules from (Ku, Pu)
+typedef enum
+{
+	RELAY_AUTOTUNE_RULE_ZIEGLER_NICHOLS = 0,   // Kp = 0.45 Ku, Ti = Pu / 1.2
+	RELAY_AUTOTUNE_RULE_TYREUS_LUYBEN = 1,     // Kp = Ku / 3.2, Ti = 2.2 Pu (less overshoot)
+} relay_autotune_rule_e;
+
+typedef struct
+{
+	/* PARAMETERS */
+	float setpoint;
+	float bias;
+	float amplitude;
+	float hysteresis;
+	float output_min;
+	float output_max;
+	uint8_t skip_cycles;
+	uint8_t measure_cycles;
+	uint16_t max_steps;
+
+	/* STATE */
+	uint8_t state;
+	uint8_t is_output_high;
+	// Switches to low output so far (cycle boundaries)
+	uint8_t n_boundaries;
+	uint16_t n_steps;
+	uint16_t last_boundary_step;
+	// Extremes of `y` since last cycle boundary
+	float y_max;
+	float y_min;
+	// Sums over measured cycles
+	uint32_t period_steps_sum;
+	float amplitude_sum;
+} relay_autotune_t;
+
+// Starts tuning, output is limited to [`output_min`, `output_max`].
+void relay_autotune_init(relay_autotune_t* h_tune, float setpoint, float bias, float amplitude, float hysteresis,
+	float output_min, float output_max, uint8_t skip_cycles, uint8_t measure_cycles, uint16_t max_steps);
+
+// Advances relay by one step with measured output `y` and returns new input.
+// Returns `bias` once tuning is not running.
+float relay_autotune_advance(relay_autotune_t* h_tune, float y);
+
+// Returns ultimate gain and ultimate period (`timestep` is time of one step).
+// Returns 1 on success, 0 if tuning did not finish or oscillation stayed
+// within hysteresis band.
+uint8_t relay_autotune_get_ultimate(const relay_autotune_t* h_tune, float timestep, float* p_ku, float* p_pu);
+
+// Computes PI gains from ultimate gain and period with `rule` (relay_autotune_rule_e).
+// `p_ti` is integral gain in the form used by pid.h (output = Kp * (1 + Ti * dt) ...),
+// i.e. reciprocal of integral time.
+void relay_autotune_compute_pi(float ku, float pu, uint8_t rule, float* p_kp, float* p_ti);
+
+#endif /* RELAY_AUTOTUNE_H_ */
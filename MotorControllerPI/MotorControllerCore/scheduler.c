@@ -0,0 +1,143 @@
+/*
+ * scheduler.c
+ *
+ * Implementation of scheduler.h
+ */ 
+
+#include "scheduler.h"
+
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+
+#ifndef NULL
+#define NULL (void*)0x00
+#endif
+
+uint8_t Scheduler_Init(scheduler_t* h_scheduler)
+{
+	if (NULL == h_scheduler)
+	{
+		return SCHEDULER_ERROR_INVALID_HANDLE;
+	}
+	
+	h_scheduler->ready_mask = 0;
+	
+	for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++)
+	{
+		h_scheduler->tasks[i] = NULL;
+	}
+	
+	return SCHEDULER_ERROR_NO_ERROR;
+}
+
+uint8_t Scheduler_RegisterTask(scheduler_t* h_scheduler, uint8_t task_id, scheduler_task_fn task)
+{
+	if (NULL == h_scheduler)
+	{
+		return SCHEDULER_ERROR_INVALID_HANDLE;
+	}
+	
+	if (task_id >= SCHEDULER_MAX_TASKS)
+	{
+		return SCHEDULER_ERROR_INVALID_TASK_ID;
+	}
+	
+	h_scheduler->tasks[task_id] = task;
+	
+	return SCHEDULER_ERROR_NO_ERROR;
+}
+
+uint8_t Scheduler_Post(scheduler_t* h_scheduler, uint8_t task_id)
+{
+	if (NULL == h_scheduler)
+	{
+		return SCHEDULER_ERROR_INVALID_HANDLE;
+	}
+	
+	if (task_id >= SCHEDULER_MAX_TASKS)
+	{
+		return SCHEDULER_ERROR_INVALID_TASK_ID;
+	}
+	
+	// Read-modify-write of `ready_mask` would race with ISRs
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Scheduler_PostFromISR(h_scheduler, task_id);
+	}
+	
+	return SCHEDULER_ERROR_NO_ERROR;
+}
+
+uint8_t Scheduler_RunNext(scheduler_t* h_scheduler)
+{
+	if (NULL == h_scheduler)
+	{
+		return 0;
+	}
+	
+	uint8_t task_id = 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		const uint8_t ready_mask = h_scheduler->ready_mask;
+		
+		if (0 == ready_mask)
+		{
+			return 0;
+		}
+		
+		// Lowest set bit is highest priority
+		while (!(ready_mask & (1 << task_id)))
+		{
+			++task_id;
+		}
+		
+		// Cleared before running, so ISR can post the task again while it runs
+		h_scheduler->ready_mask = ready_mask & (uint8_t)~(1 << task_id);
+	}
+	
+	const scheduler_task_fn task = h_scheduler->tasks[task_id];
+	
+	if (NULL != task)
+	{
+		task();
+	}
+	
+	return 1;
+}
+
+uint8_t Scheduler_RunNextOrSleep(scheduler_t* h_scheduler)
+{
+	if (NULL == h_scheduler)
+	{
+		return 0;
+	}
+	
+	cli();
+	
+	if (0 == h_scheduler->ready_mask)
+	{
+		// Instruction after `sei` is always executed before pending interrupt,
+		// so an ISR that posts a task between the check and `sleep` wakes CPU
+		sleep_enable();
+		sei();
+		sleep_cpu();
+		sleep_disable();
+		return 0;
+	}
+	
+	sei();
+	
+	return Scheduler_RunNext(h_scheduler);
+}
+
+uint8_t Scheduler_IsIdle(scheduler_t* h_scheduler)
+{
+	if (NULL == h_scheduler)
+	{
+		return 1;
+	}
+	
+	return 0 == h_scheduler->ready_mask;
+}
@@ -0,0 +1,74 @@
+/*
+ * scheduler.h
+ *
+ * Run-to-completion cooperative task scheduler.
+ * Every task has its own priority (task id, 0 is highest) and one bit in
+ * ready mask. ISRs post tasks, main loop runs highest priority ready task.
+ * Higher priority tasks "preempt" lower priority ones at task boundaries.
+ */ 
+
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <stdint.h>
+
+// One bit of `ready_mask` per task
+#define SCHEDULER_MAX_TASKS 8
+
+typedef void (*scheduler_task_fn)(void);
+
+typedef struct {
+	// Bit n is set if task with id n is ready to run
+	volatile uint8_t ready_mask;
+	// Task with id n, NULL if slot is not used
+	scheduler_task_fn tasks[SCHEDULER_MAX_TASKS];
+} scheduler_t;
+
+typedef enum {
+	SCHEDULER_ERROR_NO_ERROR = 0,
+	SCHEDULER_ERROR_INVALID_HANDLE = 30,
+	SCHEDULER_ERROR_INVALID_TASK_ID = 31
+} scheduler_error_e;
+
+// Initializes scheduler with no tasks.
+// Returns scheduler_error_e
+uint8_t Scheduler_Init(scheduler_t* h_scheduler);
+
+// Registers `task` with priority `task_id` (0 is highest, SCHEDULER_MAX_TASKS - 1 lowest).
+// Returns scheduler_error_e
+uint8_t Scheduler_RegisterTask(scheduler_t* h_scheduler, uint8_t task_id, scheduler_task_fn task);
+
+// Marks task `task_id` as ready. Posting already ready task has no effect.
+// MUST be called with interrupts disabled (i.e. from ISR), no checks are made.
+static inline void Scheduler_PostFromISR(scheduler_t* h_scheduler, uint8_t task_id)
+{
+	h_scheduler->ready_mask |= (uint8_t)(1 << task_id);
+}
+
+// Returns 1 if task `task_id` is posted and has not started yet.
+// MUST be called with interrupts disabled (i.e. from ISR), no checks are made.
+static inline uint8_t Scheduler_IsPostedFromISR(scheduler_t* h_scheduler, uint8_t task_id)
+{
+	return (uint8_t)((h_scheduler->ready_mask >> task_id) & 1);
+}
+
+// Marks task `task_id` as ready, can be called from main loop or tasks.
+// Returns scheduler_error_e
+uint8_t Scheduler_Post(scheduler_t* h_scheduler, uint8_t task_id);
+
+// Runs highest priority ready task to completion.
+// Returns 1 if a task was run, 0 if no task is ready.
+uint8_t Scheduler_RunNext(scheduler_t* h_scheduler);
+
+// Runs highest priority ready task to completion. If no task is ready,
+// CPU sleeps (in mode set by set_sleep_mode()) until next interrupt.
+// Returns 1 if a task was run, 0 if CPU was sleeping.
+// NOTE: Every event that posts a task must come from an interrupt that wakes CPU.
+uint8_t Scheduler_RunNextOrSleep(scheduler_t* h_scheduler);
+
+// Returns 1 if no task is ready.
+// NOTE: Result is stale as soon as interrupts are enabled.
+uint8_t Scheduler_IsIdle(scheduler_t* h_scheduler);
+
+#endif /* SCHEDULER_H_ */
@@ -0,0 +1,176 @@
+/*
+ * setpoint_ramp.c
+ *
+ * Implementation of setpoint_ramp.h
+ */ 
+
+#include "setpoint_ramp.h"
+
+#include <stddef.h>
+
+static int32_t setpoint_ramp_clamp(int32_t x, int32_t limit)
+{
+	if (x > limit)
+	{
+		return limit;
+	}
+
+	if (x < -limit)
+	{
+		return -limit;
+	}
+
+	return x;
+}
+
+void setpoint_ramp_init(setpoint_ramp_t* h_ramp, int32_t value, int32_t max_rate, int32_t max_rate_change)
+{
+	if (h_ramp == NULL)
+	{
+		return;
+	}
+
+	setpoint_ramp_set_limits(h_ramp, max_rate, max_rate_change);
+	setpoint_ramp_reset(h_ramp, value);
+}
+
+void setpoint_ramp_set_limits(setpoint_ramp_t* h_ramp, int32_t max_rate, int32_t max_rate_change)
+{
+	if (h_ramp == NULL)
+	{
+		return;
+	}
+
+	h_ramp->max_rate = (max_rate < 0) ? -max_rate : max_rate;
+	h_ramp->max_rate_change = (max_rate_change < 0) ? -max_rate_change : max_rate_change;
+}
+
+void setpoint_ramp_reset(setpoint_ramp_t* h_ramp, int32_t value)
+{
+	if (h_ramp == NULL)
+	{
+		return;
+	}
+
+	h_ramp->target = value;
+	h_ramp->value = value;
+	h_ramp->rate = 0;
+}
+
+void setpoint_ramp_set_target(setpoint_ramp_t* h_ramp, int32_t target)
+{
+	if (h_ramp == NULL)
+	{
+		return;
+	}
+
+	h_ramp->target = target;
+}
+
+// Sets `p_high`:`p_low` to 64-bit product of `a` and `b` from 16 x 16 bit
+// partial products, so AVR does not call 64-bit multiply (See. PIDQ_Multiply())
+static void setpoint_ramp_multiply(uint32_t a, uint32_t b, uint32_t* p_high, uint32_t* p_low)
+{
+	const uint16_t a_high = (uint16_t)(a >> 16);
+	const uint16_t a_low = (uint16_t)a;
+	const uint16_t b_high = (uint16_t)(b >> 16);
+	const uint16_t b_low = (uint16_t)b;
+
+	const uint32_t low_low = (uint32_t)a_low * b_low;
+	const uint32_t high_low = (uint32_t)a_high * b_low;
+	const uint32_t low_high = (uint32_t)a_low * b_high;
+
+	// Sum of three 16-bit values, carry goes to high word
+	const uint32_t middle = (low_low >> 16) + (high_low & 0xFFFF) + (low_high & 0xFFFF);
+
+	*p_low = (middle << 16) | (low_low & 0xFFFF);
+	*p_high = (uint32_t)a_high * b_high + (high_low >> 16) + (low_high >> 16) + (middle >> 16);
+}
+
+// Returns 1 if `a` * `b` >= `c` * `d`
+static uint8_t setpoint_ramp_is_product_at_least(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+	uint32_t left_high, left_low, right_high, right_low;
+	setpoint_ramp_multiply(a, b, &left_high, &left_low);
+	setpoint_ramp_multiply(c, d, &right_high, &right_low);
+
+	if (left_high != right_high)
+	{
+		return left_high > right_high;
+	}
+
+	return left_low >= right_low;
+}
+
+int32_t setpoint_ramp_advance(setpoint_ramp_t* h_ramp)
+{
+	if (h_ramp == NULL)
+	{
+		return 0;
+	}
+
+	const int32_t error = h_ramp->target - h_ramp->value;
+
+	if (error == 0 || h_ramp->max_rate == 0)
+	{
+		h_ramp->value = h_ramp->target;
+		h_ramp->rate = 0;
+		return h_ramp->value;
+	}
+
+	int32_t rate = 0;
+
+	if (h_ramp->max_rate_change == 0)
+	{
+		// Trapezoidal: constant rate until target is reached
+		rate = setpoint_ramp_clamp(error, h_ramp->max_rate);
+	}
+	else
+	{
+		// S-curve: rate changes by at most `max_rate_change` per step
+		const int32_t jerk = (error > 0) ? h_ramp->max_rate_change : -h_ramp->max_rate_change;
+		rate = h_ramp->rate;
+
+		if ((rate > 0) == (error > 0) && rate != 0)
+		{
+			// Distance covered while |rate| is decreased to zero:
+			// |rate| + (|rate| - jerk) + ... + jerk = |rate| * (|rate| + |jerk|) / (2 * |jerk|)
+			// Compared as |rate| * (|rate| + |jerk|) >= 2 * |jerk| * |error| to avoid division
+			const uint32_t abs_rate = (rate < 0) ? -(uint32_t)rate : (uint32_t)rate;
+			const uint32_t abs_error = (error < 0) ? -(uint32_t)error : (uint32_t)error;
+
+			if (setpoint_ramp_is_product_at_least(abs_rate, abs_rate + (uint32_t)h_ramp->max_rate_change,
+				2 * (uint32_t)h_ramp->max_rate_change, abs_error))
+			{
+				// Start braking, rate does not change sign while braking
+				rate -= jerk;
+				if ((rate > 0) != (error > 0))
+				{
+					rate = 0;
+				}
+			}
+			else
+			{
+				rate += jerk;
+			}
+		}
+		else
+		{
+			rate += jerk;
+		}
+
+		rate = setpoint_ramp_clamp(rate, h_ramp->max_rate);
+	}
+
+	// Never step past target
+	if ((error > 0 && rate >= error) || (error < 0 && rate <= error))
+	{
+		h_ramp->value = h_ramp->target;
+		h_ramp->rate = 0;
+		return h_ramp->value;
+	}
+
+	h_ramp->value += rate;
+	h_ramp->rate = rate;
+	return h_ramp->value;
+}
@@ -0,0 +1,45 @@
+/*
+ * setpoint_ramp.h
+ *
+ * Setpoint profile generator. Output approaches target with limited
+ * rate of change per step (trapezoidal profile) and optionally with
+ * limited change of the rate per step (jerk-limited, S-curve profile).
+ * Values are `int32_t` in any fixed-point format (e.g. Q16.16), all
+ * limits must use the same format as the values.
+ */ 
+
+
+#ifndef SETPOINT_RAMP_H_
+#define SETPOINT_RAMP_H_
+
+#include <stdint.h>
+
+typedef struct
+{
+	int32_t target;
+	int32_t value;
+	// Change of `value` in last step (acceleration when ramping speed)
+	int32_t rate;
+	// Maximal |rate|, 0 = no limit (output follows target immediately)
+	int32_t max_rate;
+	// Maximal change of `rate` per step, 0 = no limit (trapezoidal profile)
+	int32_t max_rate_change;
+} setpoint_ramp_t;
+
+// Initializes ramp at rest at `value` with given limits (See. setpoint_ramp_set_limits()).
+void setpoint_ramp_init(setpoint_ramp_t* h_ramp, int32_t value, int32_t max_rate, int32_t max_rate_change);
+
+// Changes limits, current output and rate are kept.
+// Negative limits are treated as their absolute values.
+void setpoint_ramp_set_limits(setpoint_ramp_t* h_ramp, int32_t max_rate, int32_t max_rate_change);
+
+// Jumps output and target to `value` and stops ramping.
+void setpoint_ramp_reset(setpoint_ramp_t* h_ramp, int32_t value);
+
+// Sets value which output should approach.
+void setpoint_ramp_set_target(setpoint_ramp_t* h_ramp, int32_t target);
+
+// Advances profile by one step and returns new output.
+int32_t setpoint_ramp_advance(setpoint_ramp_t* h_ramp);
+
+#endif /* SETPOINT_RAMP_H_ */
@@ -0,0 +1,160 @@
+/*
+ * soft_timer.c
+ *
+ * Implementation of soft_timer.h
+ */ 
+
+#include "soft_timer.h"
+
+#include <util/atomic.h>
+
+#ifndef NULL
+#define NULL (void*)0x00
+#endif
+
+// Publishes deadline of first timer to clock ISR
+static void update_next_deadline_(soft_timer_queue_t* h_queue)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		h_queue->is_armed = (NULL != h_queue->p_head);
+		
+		if (h_queue->is_armed)
+		{
+			h_queue->next_deadline_ms = h_queue->p_head->deadline_ms;
+		}
+	}
+}
+
+// Unlinks `h_timer` from queue, returns 1 if it was queued
+static uint8_t unlink_(soft_timer_queue_t* h_queue, soft_timer_t* h_timer)
+{
+	soft_timer_t** pp_it = &h_queue->p_head;
+	
+	while (NULL != *pp_it)
+	{
+		if (*pp_it == h_timer)
+		{
+			*pp_it = h_timer->p_next;
+			h_timer->p_next = NULL;
+			h_timer->is_running = 0;
+			return 1;
+		}
+		
+		pp_it = &(*pp_it)->p_next;
+	}
+	
+	return 0;
+}
+
+// Inserts `h_timer` behind all timers with earlier or equal deadline
+static void insert_(soft_timer_queue_t* h_queue, soft_timer_t* h_timer)
+{
+	soft_timer_t** pp_it = &h_queue->p_head;
+	
+	// Deadlines are ordered by their distance from the first one
+	const uint32_t origin = (NULL != h_queue->p_head) ? h_queue->p_head->deadline_ms : h_timer->deadline_ms;
+	const int32_t distance = (int32_t)(h_timer->deadline_ms - origin);
+	
+	while (NULL != *pp_it && (int32_t)((*pp_it)->deadline_ms - origin) <= distance)
+	{
+		pp_it = &(*pp_it)->p_next;
+	}
+	
+	h_timer->p_next = *pp_it;
+	h_timer->is_running = 1;
+	*pp_it = h_timer;
+}
+
+uint8_t SoftTimer_InitQueue(soft_timer_queue_t* h_queue)
+{
+	if (NULL == h_queue)
+	{
+		return SOFT_TIMER_ERROR_INVALID_HANDLE;
+	}
+	
+	h_queue->p_head = NULL;
+	h_queue->next_deadline_ms = 0;
+	h_queue->is_armed = 0;
+	
+	return SOFT_TIMER_ERROR_NO_ERROR;
+}
+
+uint8_t SoftTimer_Init(soft_timer_t* h_timer, uint8_t id)
+{
+	if (NULL == h_timer)
+	{
+		return SOFT_TIMER_ERROR_INVALID_HANDLE;
+	}
+	
+	h_timer->deadline_ms = 0;
+	h_timer->period_ms = 0;
+	h_timer->p_next = NULL;
+	h_timer->is_running = 0;
+	h_timer->id = id;
+	
+	return SOFT_TIMER_ERROR_NO_ERROR;
+}
+
+uint8_t SoftTimer_StartAt(soft_timer_queue_t* h_queue, soft_timer_t* h_timer, uint32_t deadline_ms, uint32_t period_ms)
+{
+	if (NULL == h_queue || NULL == h_timer)
+	{
+		return SOFT_TIMER_ERROR_INVALID_HANDLE;
+	}
+	
+	if (period_ms > INT32_MAX)
+	{
+		return SOFT_TIMER_ERROR_INVALID_DELAY;
+	}
+	
+	unlink_(h_queue, h_timer);
+	
+	h_timer->deadline_ms = deadline_ms;
+	h_timer->period_ms = period_ms;
+	insert_(h_queue, h_timer);
+	
+	update_next_deadline_(h_queue);
+	
+	return SOFT_TIMER_ERROR_NO_ERROR;
+}
+
+void SoftTimer_Stop(soft_timer_queue_t* h_queue, soft_timer_t* h_timer)
+{
+	if (NULL == h_queue || NULL == h_timer || !h_timer->is_running)
+	{
+		return;
+	}
+	
+	unlink_(h_queue, h_timer);
+	update_next_deadline_(h_queue);
+}
+
+soft_timer_t* SoftTimer_PopExpired(soft_timer_queue_t* h_queue, uint32_t now_ms)
+{
+	if (NULL == h_queue)
+	{
+		return NULL;
+	}
+	
+	soft_timer_t* p_timer = h_queue->p_head;
+	
+	if (NULL == p_timer || (int32_t)(now_ms - p_timer->deadline_ms) < 0)
+	{
+		return NULL;
+	}
+	
+	h_queue->p_head = p_timer->p_next;
+	p_timer->p_next = NULL;
+	p_timer->is_running = 0;
+	
+	if (p_timer->period_ms != 0)
+	{
+		p_timer->deadline_ms += p_timer->period_ms;
+		insert_(h_queue, p_timer);
+	}
+	
+	update_next_deadline_(h_queue);
+	
+	return p_timer;
+}
@@ -0,0 +1,82 @@
+/*
+ * soft_timer.h
+ *
+ * Software timers on a shared millisecond clock.
+ * Running timers are kept in a list sorted by deadline, so the clock ISR
+ * only compares the current time with the deadline of the first timer
+ * (See. SoftTimer_IsDueFromISR()) and posts a task, which then takes the
+ * expired timers with SoftTimer_PopExpired().
+ * Periodic timers are re-armed relative to their previous deadline, so
+ * they do not drift when the task runs late.
+ * Deadlines are compared modulo 2^32, delays must be below 2^31 ms (~24 days).
+ */ 
+
+
+#ifndef SOFT_TIMER_H_
+#define SOFT_TIMER_H_
+
+#include <stdint.h>
+
+typedef struct soft_timer_s {
+	// Clock time at which timer expires
+	uint32_t deadline_ms;
+	// Re-arm period, 0 = one-shot
+	uint32_t period_ms;
+	// Next timer in queue (later or equal deadline)
+	struct soft_timer_s* p_next;
+	uint8_t is_running;
+	// Identifies timer to its owner (e.g. which task handles it)
+	uint8_t id;
+} soft_timer_t;
+
+typedef struct {
+	// Running timers sorted by deadline, NULL if none is running
+	soft_timer_t* p_head;
+	// Copy of `p_head->deadline_ms` for clock ISR, valid if `is_armed`
+	volatile uint32_t next_deadline_ms;
+	volatile uint8_t is_armed;
+} soft_timer_queue_t;
+
+typedef enum {
+	SOFT_TIMER_ERROR_NO_ERROR = 0,
+	SOFT_TIMER_ERROR_INVALID_HANDLE = 40,
+	SOFT_TIMER_ERROR_INVALID_DELAY = 41
+} soft_timer_error_e;
+
+// Initializes empty queue.
+// Returns soft_timer_error_e
+uint8_t SoftTimer_InitQueue(soft_timer_queue_t* h_queue);
+
+// Initializes stopped timer with owner defined `id`.
+// Returns soft_timer_error_e
+uint8_t SoftTimer_Init(soft_timer_t* h_timer, uint8_t id);
+
+// Starts (or restarts) `h_timer` to expire at `deadline_ms`, then every
+// `period_ms` after that (0 = one-shot). Deadline may already be in the past,
+// timer then expires at next clock tick. Can be called from main loop or tasks.
+// Returns soft_timer_error_e
+uint8_t SoftTimer_StartAt(soft_timer_queue_t* h_queue, soft_timer_t* h_timer, uint32_t deadline_ms, uint32_t period_ms);
+
+// Stops `h_timer`, stopping timer which is not running has no effect.
+// Can be called from main loop or tasks.
+void SoftTimer_Stop(soft_timer_queue_t* h_queue, soft_timer_t* h_timer);
+
+// Removes first timer which expired at or before `now_ms` and returns it,
+// NULL if no timer expired. Periodic timers are put back with next deadline.
+// Can be called from main loop or tasks.
+soft_timer_t* SoftTimer_PopExpired(soft_timer_queue_t* h_queue, uint32_t now_ms);
+
+// Returns 1 if timer is running
+static inline uint8_t SoftTimer_IsRunning(const soft_timer_t* h_timer)
+{
+	return h_timer->is_running;
+}
+
+// Returns 1 if first timer expired at or before `now_ms`.
+// MUST be called with interrupts disabled (i.e. from ISR), no checks are made.
+static inline uint8_t SoftTimer_IsDueFromISR(const soft_timer_queue_t* h_queue, uint32_t now_ms)
+{
+	return h_queue->is_armed && (int32_t)(now_ms - h_queue->next_deadline_ms) >= 0;
+}
+
+#endif /* SOFT_TIMER_H_ */
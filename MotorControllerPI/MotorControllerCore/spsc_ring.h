@@ -0,0 +1,111 @@
+/*
+ * spsc_ring.h
+ *
+ * Header-only single-producer/single-consumer ring, instantiated at compile time:
+ *
+ *     SPSC_RING_DEFINE(rx_ring, uint8_t, 128)
+ *
+ * defines type `rx_ring_t` and static inline functions `rx_ring_init()`,
+ * `rx_ring_push()`, `rx_ring_pop()`, ... for 128 elements of `uint8_t`.
+ *
+ * Producer only modifies `head`, consumer only modifies `tail`. Both are
+ * 8-bit, so on AVR each side reads the other index in one instruction and
+ * neither side has to disable interrupts (e.g. ISR pushes, main loop pops).
+ * Size is a power of two (at most 128), so wrapping is a constant mask.
+ */ 
+
+
+#ifndef SPSC_RING_H_
+#define SPSC_RING_H_
+
+#include <stdint.h>
+
+// Prevents compiler from moving element accesses across index update
+#define SPSC_RING_MEMORY_BARRIER_() __asm__ __volatile__("" ::: "memory")
+
+#define SPSC_RING_DEFINE(NAME, TYPE, SIZE)																\
+																										\
+_Static_assert((SIZE) > 0 && (SIZE) <= 128 && ((SIZE) & ((SIZE) - 1)) == 0,								\
+	#NAME ": size must be a power of two, at most 128");												\
+																										\
+typedef struct {																						\
+	TYPE buffer[SIZE];																					\
+	/* Free-running index of next element to write (modified only by producer) */						\
+	volatile uint8_t head;																				\
+	/* Free-running index of next element to read (modified only by consumer) */						\
+	volatile uint8_t tail;																				\
+} NAME##_t;																								\
+																										\
+/* Empties the ring. NOTE: Must not run concurrently with producer or consumer */						\
+static inline void NAME##_init(NAME##_t* h_ring)														\
+{																										\
+	h_ring->head = 0;																					\
+	h_ring->tail = 0;																					\
+}																										\
+																										\
+/* Returns number of elements in ring */																\
+static inline uint8_t NAME##_count(const NAME##_t* h_ring)												\
+{																										\
+	return (uint8_t)(h_ring->head - h_ring->tail);														\
+}																										\
+																										\
+/* [PRODUCER] Appends `value`. Returns 1 if written, 0 if ring is full */								\
+static inline uint8_t NAME##_push(NAME##_t* h_ring, TYPE value)											\
+{																										\
+	const uint8_t head = h_ring->head;																	\
+																										\
+	if ((uint8_t)(head - h_ring->tail) >= (SIZE))														\
+	{																									\
+		return 0;																						\
+	}																									\
+																										\
+	h_ring->buffer[head & ((SIZE) - 1)] = value;														\
+	SPSC_RING_MEMORY_BARRIER_();																		\
+	h_ring->head = (uint8_t)(head + 1);																	\
+	return 1;																							\
+}																										\
+																										\
+/* [PRODUCER] Returns number of elements that can still be pushed */									\
+static inline uint8_t NAME##_free_space(const NAME##_t* h_ring)											\
+{																										\
+	return (uint8_t)((SIZE) - NAME##_count(h_ring));													\
+}																										\
+																										\
+/* [CONSUMER] Removes oldest element into `p_value`. Returns 1 if read, 0 if ring is empty */			\
+static inline uint8_t NAME##_pop(NAME##_t* h_ring, TYPE* p_value)										\
+{																										\
+	const uint8_t tail = h_ring->tail;																	\
+																										\
+	if (h_ring->head == tail)																			\
+	{																									\
+		return 0;																						\
+	}																									\
+																										\
+	SPSC_RING_MEMORY_BARRIER_();																		\
+	*p_value = h_ring->buffer[tail & ((SIZE) - 1)];														\
+	SPSC_RING_MEMORY_BARRIER_();																		\
+	h_ring->tail = (uint8_t)(tail + 1);																	\
+	return 1;																							\
+}																										\
+																										\
+/* [CONSUMER] Points `pp_span` to oldest elements, returns how many of them */							\
+/* are contiguous in memory. Elements stay in ring until `consume()` */									\
+static inline uint8_t NAME##_peek_contiguous(const NAME##_t* h_ring, const TYPE** pp_span)				\
+{																										\
+	const uint8_t count = NAME##_count(h_ring);															\
+	const uint8_t tail_index = h_ring->tail & ((SIZE) - 1);												\
+	const uint8_t until_end = (uint8_t)((SIZE) - tail_index);											\
+																										\
+	SPSC_RING_MEMORY_BARRIER_();																		\
+	*pp_span = &h_ring->buffer[tail_index];																\
+	return (count < until_end) ? count : until_end;														\
+}																										\
+																										\
+/* [CONSUMER] Releases `n` oldest elements (n <= count) */												\
+static inline void NAME##_consume(NAME##_t* h_ring, uint8_t n)											\
+{																										\
+	SPSC_RING_MEMORY_BARRIER_();																		\
+	h_ring->tail = (uint8_t)(h_ring->tail + n);															\
+}
+
+#endif /* SPSC_RING_H_ */
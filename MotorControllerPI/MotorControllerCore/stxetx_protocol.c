@@ -0,0 +1,760 @@
+#include "stxetx_protocol.h"
+#include <string.h> // memcpy
+
+#if defined(__AVR__)
+	#include <avr/pgmspace.h>
+#else
+	#define PROGMEM
+	#define pgm_read_byte(ADDRESS) (*(const uint8_t*)(ADDRESS))
+#endif
+
+#define ASCII_STX 0x02
+#define ASCII_ETX 0x03
+#define ASCII_ESCAPE (uint8_t)'%'
+
+#ifndef NULL
+#define NULL (void*)0x00
+#endif
+
+// Frame Format
+//  0                   1                   2                   3
+//  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// |      STX      |      TYPE     |     FLAGS     |     LENGTH    |
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// |   PAYLOAD[0]  |   PAYLOAD[1]  |      ...      | PAYLOAD[LEN-1]|
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// |    CHECKSUM   |       ETX     |
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//
+// Addressed Frame Format (multi-drop bus)
+//  0                   1                   2                   3
+//  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// |      STX      |    ADDRESS    |      TYPE     |     FLAGS     |
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// |     LENGTH    |   PAYLOAD[0]  |      ...      |    CHECKSUM   |
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// |       ETX     |
+// +-+-+-+-+-+-+-+-+
+
+// CRC-8 lookup table (polynomial 0x07), stored in flash
+static const uint8_t crc8_table_[256] PROGMEM = {
+	0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15, 0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D,
+	0x70, 0x77, 0x7E, 0x79, 0x6C, 0x6B, 0x62, 0x65, 0x48, 0x4F, 0x46, 0x41, 0x54, 0x53, 0x5A, 0x5D,
+	0xE0, 0xE7, 0xEE, 0xE9, 0xFC, 0xFB, 0xF2, 0xF5, 0xD8, 0xDF, 0xD6, 0xD1, 0xC4, 0xC3, 0xCA, 0xCD,
+	0x90, 0x97, 0x9E, 0x99, 0x8C, 0x8B, 0x82, 0x85, 0xA8, 0xAF, 0xA6, 0xA1, 0xB4, 0xB3, 0xBA, 0xBD,
+	0xC7, 0xC0, 0xC9, 0xCE, 0xDB, 0xDC, 0xD5, 0xD2, 0xFF, 0xF8, 0xF1, 0xF6, 0xE3, 0xE4, 0xED, 0xEA,
+	0xB7, 0xB0, 0xB9, 0xBE, 0xAB, 0xAC, 0xA5, 0xA2, 0x8F, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9D, 0x9A,
+	0x27, 0x20, 0x29, 0x2E, 0x3B, 0x3C, 0x35, 0x32, 0x1F, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0D, 0x0A,
+	0x57, 0x50, 0x59, 0x5E, 0x4B, 0x4C, 0x45, 0x42, 0x6F, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7D, 0x7A,
+	0x89, 0x8E, 0x87, 0x80, 0x95, 0x92, 0x9B, 0x9C, 0xB1, 0xB6, 0xBF, 0xB8, 0xAD, 0xAA, 0xA3, 0xA4,
+	0xF9, 0xFE, 0xF7, 0xF0, 0xE5, 0xE2, 0xEB, 0xEC, 0xC1, 0xC6, 0xCF, 0xC8, 0xDD, 0xDA, 0xD3, 0xD4,
+	0x69, 0x6E, 0x67, 0x60, 0x75, 0x72, 0x7B, 0x7C, 0x51, 0x56, 0x5F, 0x58, 0x4D, 0x4A, 0x43, 0x44,
+	0x19, 0x1E, 0x17, 0x10, 0x05, 0x02, 0x0B, 0x0C, 0x21, 0x26, 0x2F, 0x28, 0x3D, 0x3A, 0x33, 0x34,
+	0x4E, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5C, 0x5B, 0x76, 0x71, 0x78, 0x7F, 0x6A, 0x6D, 0x64, 0x63,
+	0x3E, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2C, 0x2B, 0x06, 0x01, 0x08, 0x0F, 0x1A, 0x1D, 0x14, 0x13,
+	0xAE, 0xA9, 0xA0, 0xA7, 0xB2, 0xB5, 0xBC, 0xBB, 0x96, 0x91, 0x98, 0x9F, 0x8A, 0x8D, 0x84, 0x83,
+	0xDE, 0xD9, 0xD0, 0xD7, 0xC2, 0xC5, 0xCC, 0xCB, 0xE6, 0xE1, 0xE8, 0xEF, 0xFA, 0xFD, 0xF4, 0xF3
+};
+
+// Control character bitmap (bit `c & 7` of byte `c >> 3` is set for STX, ETX
+// and ESCAPE), stored in flash. One lookup classifies a byte instead of
+// three comparisons.
+static const uint8_t control_character_bitmap_[32] PROGMEM = {
+	(1 << ASCII_STX) | (1 << ASCII_ETX), 0x00, 0x00, 0x00, (1 << (ASCII_ESCAPE & 7)), 0x00, 0x00, 0x00,	// ASCII_ESCAPE is 0x25
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+uint8_t stxetx_crc8_update(uint8_t crc, uint8_t byte_)
+{
+	return pgm_read_byte(&crc8_table_[crc ^ byte_]);
+}
+
+uint8_t stxetx_is_character_escape(uint8_t character)
+{
+	return character == ASCII_ESCAPE;
+}
+
+uint8_t stxetx_is_character_frame_start_delimiter(uint8_t character)
+{
+	return character == ASCII_STX;
+}
+
+uint8_t stxetx_is_character_frame_end_delimiter(uint8_t character)
+{
+	return character == ASCII_ETX;
+}
+
+static inline uint8_t is_control_character_(uint8_t character)
+{
+	return pgm_read_byte(&control_character_bitmap_[character >> 3]) & (1 << (character & 7));
+}
+
+// Reserves one destination byte (NULL and sticky error if the destination is full)
+static inline uint8_t* encoder_reserve_byte_(stxetx_encoder_t* h_encoder)
+{
+	uint8_t n_reserved = 0;
+	uint8_t* p_slot = h_encoder->reserve_span(h_encoder->p_context, 1, &n_reserved);
+	
+	if (NULL == p_slot || n_reserved == 0)
+	{
+		h_encoder->error = STXETX_ERROR_BUFFER_TOO_SMALL;
+		return NULL;
+	}
+	
+	return p_slot;
+}
+
+// Writes one byte to the destination without escaping it
+static inline uint8_t encoder_write_raw_byte_(stxetx_encoder_t* h_encoder, uint8_t byte_)
+{
+	uint8_t* p_slot = encoder_reserve_byte_(h_encoder);
+	
+	if (NULL == p_slot)
+	{
+		return h_encoder->error;
+	}
+	
+	*p_slot = byte_;
+	
+	return STXETX_ERROR_NO_ERROR;
+}
+
+// Writes one byte to the destination, preceded by escape character if needed.
+// Returns number of bytes written (0 on error).
+static inline uint8_t encoder_write_byte_(stxetx_encoder_t* h_encoder, uint8_t byte_)
+{
+	uint8_t bytes_written = 0;
+	
+	if (is_control_character_(byte_))
+	{
+		if (encoder_write_raw_byte_(h_encoder, ASCII_ESCAPE) != STXETX_ERROR_NO_ERROR)
+		{
+			return 0;
+		}
+		
+		bytes_written++;
+	}
+	
+	if (encoder_write_raw_byte_(h_encoder, byte_) != STXETX_ERROR_NO_ERROR)
+	{
+		return 0;
+	}
+	
+	return bytes_written + 1;
+}
+
+// Copies `n` bytes to the destination without escaping them, one memcpy
+// per contiguous destination span (at most two for a ring buffer)
+static uint8_t encoder_write_raw_bytes_(stxetx_encoder_t* h_encoder, const uint8_t* p_data, uint8_t n)
+{
+	while (n > 0)
+	{
+		uint8_t n_reserved = 0;
+		uint8_t* p_span = h_encoder->reserve_span(h_encoder->p_context, n, &n_reserved);
+		
+		if (NULL == p_span || n_reserved == 0)
+		{
+			h_encoder->error = STXETX_ERROR_BUFFER_TOO_SMALL;
+			return h_encoder->error;
+		}
+		
+		memcpy(p_span, p_data, n_reserved);
+		p_data += n_reserved;
+		n -= n_reserved;
+	}
+	
+	return STXETX_ERROR_NO_ERROR;
+}
+
+// Starts frame, `p_address` is NULL for frames without address field
+static uint8_t encoder_begin_(
+	stxetx_encoder_t* h_encoder,
+	stxetx_reserve_span_fn reserve_span,
+	void* p_context,
+	const uint8_t* p_address,
+	uint8_t msg_type,
+	uint8_t flags
+)
+{
+	if (NULL == h_encoder || NULL == reserve_span)
+	{
+		return STXETX_ERROR_INVALID_HANDLE;
+	}
+	
+	h_encoder->reserve_span = reserve_span;
+	h_encoder->p_context = p_context;
+	h_encoder->it_length_field = NULL;
+	h_encoder->payload_length = 0;
+	h_encoder->flags = flags;
+	h_encoder->checksum = 0x00;
+	h_encoder->error = STXETX_ERROR_NO_ERROR;
+	
+	// Do not do: encoder_write_byte_(h_encoder, ASCII_STX);
+	// STX at the beginning and ETX at the end must not be escaped
+	encoder_write_raw_byte_(h_encoder, ASCII_STX);
+	
+	if (NULL != p_address)
+	{
+		encoder_write_byte_(h_encoder, *p_address);
+		h_encoder->checksum = stxetx_crc8_update(h_encoder->checksum, *p_address);
+	}
+	
+	encoder_write_byte_(h_encoder, msg_type);
+	encoder_write_byte_(h_encoder, flags);
+	
+	h_encoder->checksum = stxetx_crc8_update(h_encoder->checksum, msg_type);
+	h_encoder->checksum = stxetx_crc8_update(h_encoder->checksum, flags);
+	
+	// Since payload length has to be calculated after writing
+	// payload, because length can be a special character (STX, ETX, ESC)
+	// Preemptively escape length field (has no effect other than adding another byte)
+	encoder_write_raw_byte_(h_encoder, ASCII_ESCAPE);
+	
+	// Reserve length field, it is written in stxetx_encoder_end()
+	if (h_encoder->error == STXETX_ERROR_NO_ERROR)
+	{
+		h_encoder->it_length_field = encoder_reserve_byte_(h_encoder);
+	}
+	
+	return h_encoder->error;
+}
+
+uint8_t stxetx_encoder_begin(
+	stxetx_encoder_t* h_encoder,
+	stxetx_reserve_span_fn reserve_span,
+	void* p_context,
+	uint8_t msg_type,
+	uint8_t flags
+)
+{
+	return encoder_begin_(h_encoder, reserve_span, p_context, NULL, msg_type, flags);
+}
+
+uint8_t stxetx_encoder_begin_addressed(
+	stxetx_encoder_t* h_encoder,
+	stxetx_reserve_span_fn reserve_span,
+	void* p_context,
+	uint8_t address,
+	uint8_t msg_type,
+	uint8_t flags
+)
+{
+	return encoder_begin_(h_encoder, reserve_span, p_context, &address, msg_type, flags);
+}
+
+uint8_t stxetx_encoder_push_bytes(stxetx_encoder_t* h_encoder, const uint8_t* p_data, uint8_t n)
+{
+	if (NULL == h_encoder)
+	{
+		return STXETX_ERROR_INVALID_HANDLE;
+	}
+	
+	if (n != 0 && NULL == p_data)
+	{
+		h_encoder->error = STXETX_ERROR_INVALID_HANDLE;
+	}
+	
+	if (h_encoder->error != STXETX_ERROR_NO_ERROR)
+	{
+		return h_encoder->error;
+	}
+	
+	uint8_t i = 0;
+	
+	while (i < n && h_encoder->error == STXETX_ERROR_NO_ERROR)
+	{
+		// Control character: escaped one byte at a time
+		if (is_control_character_(p_data[i]))
+		{
+			h_encoder->payload_length += encoder_write_byte_(h_encoder, p_data[i]);
+			h_encoder->checksum = stxetx_crc8_update(h_encoder->checksum, p_data[i]);
+			i++;
+			continue;
+		}
+		
+		// Run of ordinary bytes: only checksum is updated per byte,
+		// run is copied into reserved destination spans
+		uint8_t checksum = stxetx_crc8_update(h_encoder->checksum, p_data[i]);
+		uint8_t run_end = i + 1;
+		while (run_end < n && !is_control_character_(p_data[run_end]))
+		{
+			checksum = stxetx_crc8_update(checksum, p_data[run_end]);
+			run_end++;
+		}
+		
+		const uint8_t run_length = run_end - i;
+		
+		if (encoder_write_raw_bytes_(h_encoder, &p_data[i], run_length) != STXETX_ERROR_NO_ERROR)
+		{
+			break;
+		}
+		
+		h_encoder->checksum = checksum;
+		h_encoder->payload_length += run_length;
+		i = run_end;
+	}
+	
+	// Length field is one byte wide (length after adding escapes)
+	if (h_encoder->payload_length > UINT8_MAX)
+	{
+		h_encoder->error = STXETX_ERROR_BUFFER_TOO_SMALL;
+	}
+	
+	return h_encoder->error;
+}
+
+uint8_t stxetx_encoder_end(stxetx_encoder_t* h_encoder)
+{
+	if (NULL == h_encoder)
+	{
+		return STXETX_ERROR_INVALID_HANDLE;
+	}
+	
+	if (h_encoder->error != STXETX_ERROR_NO_ERROR)
+	{
+		return h_encoder->error;
+	}
+	
+	if (h_encoder->flags & FLAG_IGNORE_CHECKSUM)
+	{
+		encoder_write_byte_(h_encoder, 0x00);
+	}
+	else
+	{
+		encoder_write_byte_(h_encoder, h_encoder->checksum);
+	}
+	
+	// Do not do: encoder_write_byte_(h_encoder, ASCII_ETX);
+	// STX at the beginning and ETX at the end must not be escaped
+	encoder_write_raw_byte_(h_encoder, ASCII_ETX);
+	
+	if (h_encoder->error == STXETX_ERROR_NO_ERROR)
+	{
+		*(h_encoder->it_length_field) = (uint8_t)h_encoder->payload_length;
+	}
+	
+	return h_encoder->error;
+}
+
+// Destination for `stxetx_encode_n()`: plain linear buffer
+typedef struct {
+	uint8_t* it_write;
+	uint8_t* it_end;
+} linear_buffer_sink_t;
+
+static uint8_t* linear_buffer_reserve_span_(void* p_context, uint8_t n, uint8_t* p_n_reserved)
+{
+	linear_buffer_sink_t* p_sink = (linear_buffer_sink_t*)p_context;
+	const size_t n_free = (size_t)(p_sink->it_end - p_sink->it_write);
+	
+	*p_n_reserved = (n < n_free) ? n : (uint8_t)n_free;
+	
+	if (*p_n_reserved == 0)
+	{
+		return NULL;
+	}
+	
+	uint8_t* p_span = p_sink->it_write;
+	p_sink->it_write += *p_n_reserved;
+	
+	return p_span;
+}
+
+uint8_t stxetx_encode_n(uint8_t* p_dest_buffer, stxetx_frame_t source, uint32_t n, uint8_t* p_bytes_written)
+{
+	if (NULL == p_dest_buffer)
+	{
+		return STXETX_ERROR_INVALID_HANDLE;
+	}
+
+	// Initialize to avoid confusion
+	if (NULL != p_bytes_written)
+	{
+		*p_bytes_written = 0;
+	}
+
+	if (source.len_bytes != 0 && NULL == source.p_payload)
+	{
+		return STXETX_ERROR_INVALID_HANDLE;
+	}
+	
+	// Number of bytes written is reported as uint8_t
+	if (n > UINT8_MAX)
+	{
+		n = UINT8_MAX;
+	}
+	
+	linear_buffer_sink_t sink = { p_dest_buffer, p_dest_buffer + n };
+	stxetx_encoder_t encoder;
+	
+	stxetx_encoder_begin(&encoder, linear_buffer_reserve_span_, &sink, source.msg_type, source.flags);
+	stxetx_encoder_push_bytes(&encoder, source.p_payload, source.len_bytes);
+	
+	uint8_t error = stxetx_encoder_end(&encoder);
+	if (error != STXETX_ERROR_NO_ERROR)
+	{
+		return error;
+	}
+	
+	if (NULL != p_bytes_written)
+	{
+		*p_bytes_written =  (uint8_t)(sink.it_write - p_dest_buffer);
+	}
+
+	return STXETX_ERROR_NO_ERROR;
+
+}
+
+uint8_t stxetx_decoder_init(stxetx_decoder_t* h_decoder, uint8_t* p_payload_buffer, uint8_t payload_buffer_size)
+{
+	if (NULL == h_decoder || NULL == p_payload_buffer)
+	{
+		return STXETX_ERROR_INVALID_HANDLE;
+	}
+	
+	h_decoder->p_payload_buffer = p_payload_buffer;
+	h_decoder->payload_buffer_size = payload_buffer_size;
+	h_decoder->is_addressed = 0;
+	stxetx_decoder_reset(h_decoder);
+	
+	return STXETX_ERROR_NO_ERROR;
+}
+
+void stxetx_decoder_reset(stxetx_decoder_t* h_decoder)
+{
+	if (NULL == h_decoder)
+	{
+		return;
+	}
+	
+	h_decoder->state = STXETX_DECODER_WAIT_STX;
+	h_decoder->is_escape_active = 0;
+	h_decoder->payload_bytes_remaining = 0;
+}
+
+void stxetx_decoder_set_addressed(stxetx_decoder_t* h_decoder, uint8_t is_addressed)
+{
+	if (NULL == h_decoder)
+	{
+		return;
+	}
+	
+	h_decoder->is_addressed = is_addressed ? 1 : 0;
+	stxetx_decoder_reset(h_decoder);
+}
+
+// Discards current frame and returns `error`
+static inline uint8_t decoder_abort_frame_(stxetx_decoder_t* h_decoder, uint8_t error)
+{
+	stxetx_decoder_reset(h_decoder);
+	return error;
+}
+
+// Starts decoding new frame (STX was received)
+static inline void decoder_start_frame_(stxetx_decoder_t* h_decoder)
+{
+	stxetx_init_empty_frame(&h_decoder->frame);
+	h_decoder->state = h_decoder->is_addressed ? STXETX_DECODER_ADDRESS : STXETX_DECODER_TYPE;
+	h_decoder->is_escape_active = 0;
+	h_decoder->checksum = 0x00;
+}
+
+uint8_t stxetx_decoder_feed_byte(stxetx_decoder_t* h_decoder, uint8_t byte_, uint8_t* p_is_frame_complete)
+{
+	if (NULL == h_decoder || NULL == p_is_frame_complete)
+	{
+		return STXETX_ERROR_INVALID_HANDLE;
+	}
+	
+	*p_is_frame_complete = 0;
+	
+	if (h_decoder->state == STXETX_DECODER_WAIT_STX)
+	{
+		if (!stxetx_is_character_frame_start_delimiter(byte_))
+		{
+			// Invalid character received, expected STX character
+			return STXETX_ERROR_STX_MISSING;
+		}
+		
+		decoder_start_frame_(h_decoder);
+		return STXETX_ERROR_NO_ERROR;
+	}
+	
+	// Payload length includes escape characters
+	if (h_decoder->state == STXETX_DECODER_PAYLOAD)
+	{
+		h_decoder->payload_bytes_remaining--;
+	}
+	
+	// Ordinary bytes (and escaped bytes) skip control character handling
+	if (!h_decoder->is_escape_active && is_control_character_(byte_))
+	{
+		if (stxetx_is_character_escape(byte_))
+		{
+			// Escape must be followed by escaped byte inside of payload
+			if (h_decoder->state == STXETX_DECODER_PAYLOAD && h_decoder->payload_bytes_remaining == 0)
+			{
+				return decoder_abort_frame_(h_decoder, STXETX_ERROR_INVALID_LENGTH);
+			}
+			
+			h_decoder->is_escape_active = 1;
+			return STXETX_ERROR_NO_ERROR;
+		}
+		
+		if (stxetx_is_character_frame_start_delimiter(byte_))
+		{
+			// Unescaped STX in middle of a frame: previous frame was
+			// cut short, resynchronize to the new frame
+			decoder_start_frame_(h_decoder);
+			return STXETX_ERROR_ETX_MISSING;
+		}
+		
+		if (stxetx_is_character_frame_end_delimiter(byte_))
+		{
+			if (h_decoder->state != STXETX_DECODER_ETX)
+			{
+				// Frame ended before all fields were received
+				return decoder_abort_frame_(h_decoder, STXETX_ERROR_INVALID_LENGTH);
+			}
+			
+			stxetx_decoder_reset(h_decoder);
+			*p_is_frame_complete = 1;
+			return STXETX_ERROR_NO_ERROR;
+		}
+	}
+	
+	h_decoder->is_escape_active = 0;
+	
+	switch (h_decoder->state)
+	{
+		case STXETX_DECODER_ADDRESS:
+			h_decoder->checksum = stxetx_crc8_update(h_decoder->checksum, byte_);
+			h_decoder->frame.address = byte_;
+			h_decoder->state = STXETX_DECODER_TYPE;
+		break;
+		
+		case STXETX_DECODER_TYPE:
+			h_decoder->checksum = stxetx_crc8_update(h_decoder->checksum, byte_);
+			h_decoder->frame.msg_type = byte_;
+			h_decoder->state = STXETX_DECODER_FLAGS;
+		break;
+		
+		case STXETX_DECODER_FLAGS:
+			h_decoder->checksum = stxetx_crc8_update(h_decoder->checksum, byte_);
+			h_decoder->frame.flags = byte_;
+			h_decoder->state = STXETX_DECODER_LENGTH;
+		break;
+		
+		case STXETX_DECODER_LENGTH:
+			h_decoder->payload_bytes_remaining = byte_;
+			if (byte_ > 0)
+			{
+				h_decoder->frame.p_payload = h_decoder->p_payload_buffer;
+				h_decoder->state = STXETX_DECODER_PAYLOAD;
+			}
+			else
+			{
+				h_decoder->state = STXETX_DECODER_CHECKSUM;
+			}
+		break;
+		
+		case STXETX_DECODER_PAYLOAD:
+			if (h_decoder->frame.len_bytes >= h_decoder->payload_buffer_size)
+			{
+				return decoder_abort_frame_(h_decoder, STXETX_ERROR_BUFFER_TOO_SMALL);
+			}
+			
+			h_decoder->checksum = stxetx_crc8_update(h_decoder->checksum, byte_);
+			h_decoder->p_payload_buffer[h_decoder->frame.len_bytes++] = byte_;
+			
+			if (h_decoder->payload_bytes_remaining == 0)
+			{
+				h_decoder->state = STXETX_DECODER_CHECKSUM;
+			}
+		break;
+		
+		case STXETX_DECODER_CHECKSUM:
+			// Reject corrupted frame early (before waiting for ETX)
+			if (!(h_decoder->frame.flags & FLAG_IGNORE_CHECKSUM) && byte_ != h_decoder->checksum)
+			{
+				return decoder_abort_frame_(h_decoder, STXETX_ERROR_CHECKSUM_MISMATCH);
+			}
+			
+			h_decoder->frame.checksum = byte_;
+			h_decoder->state = STXETX_DECODER_ETX;
+		break;
+		
+		case STXETX_DECODER_ETX:
+			// Check if last byte is ETX
+			return decoder_abort_frame_(h_decoder, STXETX_ERROR_ETX_MISSING);
+		
+		default:
+			// Unknown state
+			return decoder_abort_frame_(h_decoder, STXETX_ERROR_INVALID_HANDLE);
+	}
+	
+	return STXETX_ERROR_NO_ERROR;
+}
+
+void stxetx_address_filter_init(stxetx_address_filter_t* h_filter, uint8_t node_address)
+{
+	if (NULL == h_filter)
+	{
+		return;
+	}
+	
+	h_filter->node_address = node_address;
+	h_filter->state = STXETX_ADDRESS_FILTER_PASS;
+	h_filter->is_escape_active = 0;
+}
+
+uint8_t stxetx_address_filter_feed(stxetx_address_filter_t* h_filter, uint8_t byte_, uint8_t* p_output)
+{
+	const uint8_t is_escaped = h_filter->is_escape_active;
+	h_filter->is_escape_active = !is_escaped && stxetx_is_character_escape(byte_);
+	
+	// Unescaped STX always starts a new frame (even inside of skipped one)
+	if (!is_escaped && stxetx_is_character_frame_start_delimiter(byte_))
+	{
+		h_filter->state = STXETX_ADDRESS_FILTER_ADDRESS;
+		return 0;
+	}
+	
+	switch (h_filter->state)
+	{
+		case STXETX_ADDRESS_FILTER_ADDRESS:
+			if (h_filter->is_escape_active)
+			{
+				// Escaped address, wait for the address itself
+				return 0;
+			}
+			
+			if (byte_ != h_filter->node_address && byte_ != STXETX_ADDRESS_BROADCAST)
+			{
+				h_filter->state = STXETX_ADDRESS_FILTER_SKIP;
+				return 0;
+			}
+			
+			h_filter->state = STXETX_ADDRESS_FILTER_PASS;
+			
+			// Release held back bytes
+			p_output[0] = ASCII_STX;
+			if (is_escaped)
+			{
+				p_output[1] = ASCII_ESCAPE;
+				p_output[2] = byte_;
+				return 3;
+			}
+			
+			p_output[1] = byte_;
+			return 2;
+		
+		case STXETX_ADDRESS_FILTER_SKIP:
+			return 0;
+		
+		default:
+			p_output[0] = byte_;
+			return 1;
+	}
+}
+
+uint8_t stxetx_decode_n(
+uint8_t* p_src_buffer,
+stxetx_frame_t* p_dest_obj,
+uint32_t n_src,
+uint8_t* p_payload_buffer,
+uint8_t n_payload
+)
+{
+	if (NULL == p_src_buffer || NULL == p_dest_obj)
+	{
+		return STXETX_ERROR_INVALID_HANDLE;
+	}
+
+	// Frame requires buffer of at least 6 bytes
+	if (n_src < 6)
+	{
+		return STXETX_ERROR_BUFFER_TOO_SMALL;
+	}
+	
+	// Check if first byte is STX
+	if (!stxetx_is_character_frame_start_delimiter(p_src_buffer[0]))
+	{
+		return STXETX_ERROR_STX_MISSING;
+	}
+	
+	// Payload buffer is not needed for frames without payload
+	uint8_t unused_payload_buffer;
+	if (NULL == p_payload_buffer)
+	{
+		p_payload_buffer = &unused_payload_buffer;
+		n_payload = 0;
+	}
+	
+	stxetx_decoder_t decoder;
+	stxetx_decoder_init(&decoder, p_payload_buffer, n_payload);
+	
+	for (uint32_t i = 0; i < n_src; i++)
+	{
+		uint8_t is_frame_complete = 0;
+		uint8_t error = stxetx_decoder_feed_byte(&decoder, p_src_buffer[i], &is_frame_complete);
+		
+		if (error != STXETX_ERROR_NO_ERROR)
+		{
+			return error;
+		}
+		
+		if (is_frame_complete)
+		{
+			*p_dest_obj = decoder.frame;
+			return STXETX_ERROR_NO_ERROR;
+		}
+	}
+	
+	// All bytes read, but ETX was not found
+	return STXETX_ERROR_ETX_MISSING;
+}
+
+
+uint8_t stxetx_init_empty_frame(stxetx_frame_t* p_frame)
+{
+	if (NULL == p_frame)
+	{
+		return STXETX_ERROR_INVALID_HANDLE;
+	}
+
+	p_frame->msg_type = -1;
+	p_frame->flags = 0;
+	p_frame->len_bytes = 0;
+	p_frame->p_payload = NULL;
+	p_frame->checksum = 0;
+	p_frame->address = 0;
+
+	return STXETX_ERROR_NO_ERROR;
+}
+
+
+uint8_t stxetx_add_payload(stxetx_frame_t* p_frame, uint8_t* p_payload, uint8_t n)
+{
+	if (NULL == p_frame || NULL == p_payload)
+	{
+		return STXETX_ERROR_INVALID_HANDLE;
+	}
+
+	if (n < 1)
+	{
+		p_frame->len_bytes = 0;
+		p_frame->p_payload = NULL;
+
+		return STXETX_ERROR_BUFFER_TOO_SMALL;
+	}
+
+	p_frame->len_bytes = n;
+	p_frame->p_payload = p_payload;
+
+	return STXETX_ERROR_NO_ERROR;
+}
\ No newline at end of file
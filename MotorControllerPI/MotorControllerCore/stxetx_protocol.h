@@ -0,0 +1,276 @@
+#ifndef _TYPES_H
+#define _TYPES_H
+
+#include <inttypes.h>
+
+/*  ************************************************************
+    * Parameter direction convention:
+    *   [IN] - Will not be changed dby callee (function)
+    *   [OUT] - Need not be initialized, will be provided by callee
+    *   [INOUT] - Must be allocated by caller, will be populated by callee
+    *   [OPT]   - Optional, can be NULL
+    ************************************************************ */
+
+/* ************************************************************ */
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+typedef enum {
+    MSG_TYPE_EMPTY = -1,
+    MSG_TYPE_ACK = 1,
+    MSG_TYPE_COMMAND = 2,
+	MSG_TYPE_STOP = 3,
+	MSG_TYPE_FINISHED = 4,
+	MSG_TYPE_ODOMETRY = 5,
+	MSG_TYPE_INFO_STRING = 6,
+	MSG_TYPE_SEGMENTS = 7,
+	MSG_TYPE_SET_RAMP = 8,
+	MSG_TYPE_ODOMETRY_COMPACT = 9,
+	MSG_TYPE_TELEMETRY_ARM = 10,
+	MSG_TYPE_TELEMETRY_DUMP = 11,
+	MSG_TYPE_TELEMETRY_DATA = 12,
+	MSG_TYPE_PROFILER_QUERY = 13,
+	MSG_TYPE_PROFILER_DATA = 14,
+	MSG_TYPE_DIAGNOSTICS = 15,
+	MSG_TYPE_SYSID_START = 16,
+	MSG_TYPE_SYSID_DATA = 17,
+	MSG_TYPE_SYSID_RESULT = 18,
+	MSG_TYPE_PID_GAINS = 19,
+	MSG_TYPE_AUTOTUNE_START = 20,
+	MSG_TYPE_AUTOTUNE_RESULT = 21,
+	MSG_TYPE_SYNC_APPLY = 22,
+	MSG_TYPE_SET_BAUD = 23,
+	MSG_TYPE_FRAME_ACK = 24,
+	MSG_TYPE_FRAME_NAK = 25,
+	MSG_TYPE_LINK_ERROR = 26,
+	MSG_TYPE_STREAM_SUBSCRIBE = 27,
+	MSG_TYPE_STREAM_DATA = 28,
+	MSG_TYPE_EVENT_LOG_DUMP = 29,
+	MSG_TYPE_EVENT_LOG_DATA = 30,
+	MSG_TYPE_MOVE_DISTANCE = 31,
+	MSG_TYPE_KINEMATICS_CONFIG = 32,
+	MSG_TYPE_BODY_VELOCITY = 33,
+	MSG_TYPE_POSE = 34,
+	MSG_TYPE_CURRENT_LIMIT = 35
+} msg_type_e;
+
+typedef enum {
+    STXETX_ERROR_NO_ERROR = 0,
+    STXETX_ERROR_INVALID_HANDLE = 10,
+    STXETX_ERROR_BUFFER_TOO_SMALL = 11,
+    STXETX_ERROR_STX_MISSING = 12,
+	STXETX_ERROR_ETX_MISSING = 13,
+	STXETX_ERROR_INVALID_LENGTH = 14,
+	STXETX_ERROR_CHECKSUM_MISMATCH = 15
+} stxetx_error_code_e;
+
+/* ************************************************************ */
+
+// STXETX Protocol Frame Flags
+typedef enum {
+    FLAG_SHOULD_ACK = (1 << 0),         /* Message must be acknowledged upon reception, first
+                                           payload byte is sequence number (`FRAME_ACK`/`FRAME_NAK`) */
+    FLAG_IGNORE_CHECKSUM = (1 << 1),    /* Do not check checksum on reception */
+    FLAG_SYNC = (1 << 2),               /* Message is staged and executed by next `SYNC_APPLY` */
+    FLAG_SEQUENCE_RESET = (1 << 3)      /* Sequence number of this FLAG_SHOULD_ACK message
+                                           restarts duplicate detection */
+} stxetx_flag_e;
+
+// Address of addressed frames which is accepted by every node
+#define STXETX_ADDRESS_BROADCAST 0xFF
+
+// STXETX Protocol Frame
+typedef struct {
+    uint8_t msg_type;       /* Message type */
+    uint8_t flags;          /* See. flag_e enum */
+    uint8_t len_bytes;      /* Length of payload in bytes */
+    uint8_t checksum;       /* CRC-8 of [ADDRESS], TYPE, FLAGS and raw PAYLOAD (See. stxetx_crc8_update) */
+    uint8_t* p_payload;     /* Payload contains raw, unescaped data */
+    uint8_t address;        /* Node address (addressed frames only, See. stxetx_encoder_begin_addressed) */
+} stxetx_frame_t;
+
+// Streaming encoder destination callback.
+// Reserves 1 to `n` contiguous free destination bytes (`n` >= 1), writes their number
+// to `p_n_reserved` and returns pointer to the first of them, or NULL if the destination is full.
+// Returned bytes must stay valid (and must not be transmitted) until `stxetx_encoder_end()`
+// because encoder writes payload length back into the header after payload is written.
+typedef uint8_t* (*stxetx_reserve_span_fn)(void* p_context, uint8_t n, uint8_t* p_n_reserved);
+
+// Streaming (zero-copy) STXETX frame encoder state.
+// Usage: stxetx_encoder_begin(), stxetx_encoder_push_bytes() (any number of times),
+// stxetx_encoder_end(). Bytes are escaped directly into the destination.
+typedef struct {
+    stxetx_reserve_span_fn reserve_span;    /* Destination callback                     */
+    void* p_context;                        /* Passed to `reserve_span`                 */
+    uint8_t* it_length_field;               /* Reserved header byte for payload length  */
+    uint16_t payload_length;                /* Payload length including escape bytes    */
+    uint8_t flags;                          /* Frame flags (See. flag_e enum)           */
+    uint8_t checksum;                       /* Running CRC-8 of encoded bytes           */
+    uint8_t error;                          /* First error encountered (sticky)         */
+} stxetx_encoder_t;
+
+// Starts encoding a frame of `msg_type` with `flags` (writes STX and frame header).
+uint8_t stxetx_encoder_begin(
+    stxetx_encoder_t* h_encoder,            /* [INOUT]  Encoder state                               */
+    stxetx_reserve_span_fn reserve_span,    /* [IN]     Destination callback                        */
+    void* p_context,                        /* [IN]     [OPT] Passed to `reserve_span`              */
+    uint8_t msg_type,                       /* [IN]     Message type                                */
+    uint8_t flags                           /* [IN]     See. flag_e enum                            */
+);
+
+// Starts encoding an addressed (multi-drop bus) frame. Address byte follows STX
+// and is covered by the checksum: STX, ADDRESS, TYPE, FLAGS, LENGTH, ..., ETX.
+uint8_t stxetx_encoder_begin_addressed(
+    stxetx_encoder_t* h_encoder,            /* [INOUT]  Encoder state                               */
+    stxetx_reserve_span_fn reserve_span,    /* [IN]     Destination callback                        */
+    void* p_context,                        /* [IN]     [OPT] Passed to `reserve_span`              */
+    uint8_t address,                        /* [IN]     Destination (host) or source (node) address */
+    uint8_t msg_type,                       /* [IN]     Message type                                */
+    uint8_t flags                           /* [IN]     See. flag_e enum                            */
+);
+
+// Escapes and appends `n` raw payload bytes to the frame.
+uint8_t stxetx_encoder_push_bytes(
+    stxetx_encoder_t* h_encoder,            /* [INOUT]  Encoder state                               */
+    const uint8_t* p_data,                  /* [IN]     Raw payload bytes                           */
+    uint8_t n                               /* [IN]     Number of bytes in `p_data`                 */
+);
+
+// Finishes the frame (writes checksum, ETX and payload length).
+// Checksum is calculated while bytes are pushed (zero if FLAG_IGNORE_CHECKSUM is set).
+// Returns first error which occurred since `stxetx_encoder_begin()`.
+// If error is returned, reserved destination bytes contain an incomplete frame and must be discarded.
+uint8_t stxetx_encoder_end(
+    stxetx_encoder_t* h_encoder             /* [INOUT]  Encoder state                               */
+);
+
+// Updates running frame checksum `crc` with `byte_`.
+// Checksum is CRC-8 (polynomial 0x07, initial value 0x00, no reflection)
+// calculated over raw TYPE, FLAGS and PAYLOAD bytes (in that order, without escapes).
+uint8_t stxetx_crc8_update(uint8_t crc, uint8_t byte_);
+
+// Takes `frame_t` object and encodes it into bytes (to `p_dest_buffer`)
+// Frame checksum is calculated by the encoder (`source.checksum` is ignored).
+// Argument `n` limits the number of bytes that can be read from `p_dest_buffer`
+// Argument `p_bytes_written` is used as output parameter for number of bytes written.
+uint8_t stxetx_encode_n(
+    uint8_t* p_dest_buffer,         /* [INOUT]  Buffer where encoded frame will be stored    */
+    stxetx_frame_t source,          /* [IN]     Frame that will be encoded into bytes        */
+    uint32_t n,                     /* [IN]     Max number of bytes that can be written 
+                                                                          to `p_dest_buffer` */
+    uint8_t* p_bytes_written        /* [INOUT]  [OPT] Pointer to a buffer where number of 
+                                                                written bytes will be stored */
+);
+
+// Incremental STXETX frame decoder states
+typedef enum {
+    STXETX_DECODER_WAIT_STX = 0,
+    STXETX_DECODER_TYPE = 1,
+    STXETX_DECODER_FLAGS = 2,
+    STXETX_DECODER_LENGTH = 3,
+    STXETX_DECODER_PAYLOAD = 4,
+    STXETX_DECODER_CHECKSUM = 5,
+    STXETX_DECODER_ETX = 6,
+    STXETX_DECODER_ADDRESS = 7
+} stxetx_decoder_state_e;
+
+// Incremental (single pass) STXETX frame decoder state.
+// Bytes are fed one by one with `stxetx_decoder_feed_byte()`, they are
+// un-escaped as they arrive directly into the payload buffer.
+typedef struct {
+    stxetx_frame_t frame;               /* Frame being decoded, valid once completed                */
+    uint8_t* p_payload_buffer;          /* Buffer where un-escaped payload is stored                */
+    uint8_t payload_buffer_size;        /* Size of `p_payload_buffer` in bytes                      */
+    uint8_t payload_bytes_remaining;    /* Payload bytes (including escapes) yet to be received     */
+    uint8_t state;                      /* See. stxetx_decoder_state_e enum                         */
+    uint8_t is_escape_active;           /* Previous byte was an escape character                    */
+    uint8_t checksum;                   /* Running CRC-8 of received bytes                          */
+    uint8_t is_addressed;               /* Frames carry address byte after STX                      */
+} stxetx_decoder_t;
+
+// Initializes decoder which stores decoded payloads into `p_payload_buffer`.
+uint8_t stxetx_decoder_init(
+    stxetx_decoder_t* h_decoder,        /* [INOUT]  Decoder state                                   */
+    uint8_t* p_payload_buffer,          /* [INOUT]  Buffer used to store decoded payload            */
+    uint8_t payload_buffer_size         /* [IN]     Max number of bytes in `p_payload_buffer`       */
+);
+
+// Discards partially received frame and waits for next STX.
+void stxetx_decoder_reset(stxetx_decoder_t* h_decoder);
+
+// Selects addressed (multi-drop bus) frame format, address of decoded frame is
+// stored to `frame.address`. Frames of other nodes should not reach the decoder
+// (See. stxetx_address_filter_t), decoder does not check addresses.
+void stxetx_decoder_set_addressed(stxetx_decoder_t* h_decoder, uint8_t is_addressed);
+
+// Feeds one received byte to the decoder.
+// On error, current frame is discarded, decoder is reset and error code is returned.
+// Checksum is verified when checksum byte arrives (unless FLAG_IGNORE_CHECKSUM is set),
+// mismatching frames are rejected with STXETX_ERROR_CHECKSUM_MISMATCH.
+// When last byte (ETX) of a valid frame is received, `*p_is_frame_complete` is set and
+// `h_decoder->frame` holds decoded frame. Frame payload stays valid until next byte is fed.
+uint8_t stxetx_decoder_feed_byte(
+    stxetx_decoder_t* h_decoder,        /* [INOUT]  Decoder state                                   */
+    uint8_t byte_,                      /* [IN]     Received (raw, escaped) byte                    */
+    uint8_t* p_is_frame_complete        /* [OUT]    Set to 1 if frame is complete, 0 otherwise      */
+);
+
+// Receive side pre-filter of multi-drop bus, meant to run in the RX ISR.
+// Frames addressed to other nodes are dropped byte by byte (without escaping
+// payloads or calculating checksums), so they never reach the receive queue.
+// STX (and escape) of every frame is held back until address is known.
+typedef struct {
+    uint8_t node_address;               /* Address of this node                                     */
+    uint8_t state;                      /* See. stxetx_address_filter_state_e enum                  */
+    uint8_t is_escape_active;           /* Previous byte was an escape character                    */
+} stxetx_address_filter_t;
+
+typedef enum {
+    STXETX_ADDRESS_FILTER_PASS = 0,     /* Inside accepted frame (or before first STX)              */
+    STXETX_ADDRESS_FILTER_ADDRESS = 1,  /* STX received, waiting for address                        */
+    STXETX_ADDRESS_FILTER_SKIP = 2      /* Inside frame of other node                               */
+} stxetx_address_filter_state_e;
+
+// Max number of bytes returned by one stxetx_address_filter_feed() call
+#define STXETX_ADDRESS_FILTER_MAX_OUTPUT 3
+
+// Initializes filter which accepts frames of `node_address` and broadcast frames.
+void stxetx_address_filter_init(stxetx_address_filter_t* h_filter, uint8_t node_address);
+
+// Feeds one received byte to the filter. Bytes to be passed on to the decoder
+// (in order) are written to `p_output`, their number (0..STXETX_ADDRESS_FILTER_MAX_OUTPUT)
+// is returned.
+uint8_t stxetx_address_filter_feed(
+    stxetx_address_filter_t* h_filter,  /* [INOUT]  Filter state                                    */
+    uint8_t byte_,                      /* [IN]     Received (raw, escaped) byte                    */
+    uint8_t* p_output                   /* [OUT]    At least STXETX_ADDRESS_FILTER_MAX_OUTPUT bytes */
+);
+
+// Takes an array of bytes `p_src_buffer` and decodes `frame_t` structure from it.
+// Argument `n_src` limits the number of bytes that can be read from `p_src_buffer`
+uint8_t stxetx_decode_n(
+    uint8_t* p_src_buffer,          /* [IN]     Buffer where raw, encoded frame is stored                       */
+    stxetx_frame_t* p_dest_obj,     /* [INOUT]  Empty frame which will be populated after decoding              */
+    uint32_t n_src,                 /* [IN]     Max number of bytes that can be read from `p_src_buffer`        */
+    uint8_t* p_payload_buffer,      /* [INOUT]  Allocated buffer that will be used to store decoded payload
+                                            handle will be passed to the `p_dest_obj` frame's `p_payload`       */
+    uint8_t n_payload               /* [IN]     Max number of bytes that can be written to `p_payload_buffer`   */
+);
+
+// Initializes `stxetx_frame_t` structure with default values.
+uint8_t stxetx_init_empty_frame(stxetx_frame_t* p_frame);
+
+// Adds payload data to the frame.
+uint8_t stxetx_add_payload(stxetx_frame_t* p_frame, uint8_t* p_payload, uint8_t n);
+
+uint8_t stxetx_is_character_escape(uint8_t character);
+uint8_t stxetx_is_character_frame_start_delimiter(uint8_t character);
+uint8_t stxetx_is_character_frame_end_delimiter(uint8_t character);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif
\ No newline at end of file
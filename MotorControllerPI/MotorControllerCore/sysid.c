@@ -0,0 +1,94 @@
+/*
+ * sysid.c
+ *
+ * Implementation of sysid.h
+ */ 
+
+#include "sysid.h"
+
+#include <stddef.h>
+
+// Relative size of normal matrix determinant below which fit is rejected
+#define SYSID_FIT_MIN_RELATIVE_DETERMINANT 1e-4f
+
+uint8_t sysid_prbs_next(uint8_t* p_state)
+{
+	if (p_state == NULL)
+	{
+		return 0;
+	}
+
+	const uint8_t state = *p_state;
+	const uint8_t bit = ((state >> 6) ^ (state >> 5)) & 0x01;
+
+	*p_state = ((state << 1) | bit) & 0x7F;
+	return bit;
+}
+
+void sysid_fit_init(sysid_fit_t* h_fit)
+{
+	if (h_fit == NULL)
+	{
+		return;
+	}
+
+	h_fit->s_uu = 0;
+	h_fit->s_uy = 0;
+	h_fit->s_yy = 0;
+	h_fit->s_u_out = 0;
+	h_fit->s_y_out = 0;
+	h_fit->previous_u = 0;
+	h_fit->previous_y = 0;
+	h_fit->n_samples = 0;
+	h_fit->has_previous = 0;
+}
+
+void sysid_fit_feed(sysid_fit_t* h_fit, float u, float y)
+{
+	if (h_fit == NULL)
+	{
+		return;
+	}
+
+	if (h_fit->has_previous && h_fit->n_samples != UINT16_MAX)
+	{
+		const float u1 = h_fit->previous_u;
+		const float y1 = h_fit->previous_y;
+
+		h_fit->s_uu += u1 * u1;
+		h_fit->s_uy += u1 * y1;
+		h_fit->s_yy += y1 * y1;
+		h_fit->s_u_out += u1 * y;
+		h_fit->s_y_out += y1 * y;
+		++h_fit->n_samples;
+	}
+
+	h_fit->previous_u = u * 0.01f;
+	h_fit->previous_y = y;
+	h_fit->has_previous = 1;
+}
+
+uint8_t sysid_fit_solve(const sysid_fit_t* h_fit, float* p_a, float* p_b)
+{
+	if (h_fit == NULL || p_a == NULL || p_b == NULL)
+	{
+		return 0;
+	}
+
+	if (h_fit->n_samples < 2)
+	{
+		return 0;
+	}
+
+	const float det = h_fit->s_uu * h_fit->s_yy - h_fit->s_uy * h_fit->s_uy;
+
+	if (!(det > SYSID_FIT_MIN_RELATIVE_DETERMINANT * h_fit->s_uu * h_fit->s_yy))
+	{
+		return 0;
+	}
+
+	// Cramer's rule, A is scaled back to input in %
+	*p_a = 0.01f * (h_fit->s_u_out * h_fit->s_yy - h_fit->s_uy * h_fit->s_y_out) / det;
+	*p_b = (h_fit->s_uu * h_fit->s_y_out - h_fit->s_uy * h_fit->s_u_out) / det;
+	return 1;
+}
@@ -0,0 +1,49 @@
+/*
+ * sysid.h
+ *
+ * System identification helpers:
+ * - PRBS (pseudo random binary sequence) excitation from 7-bit LFSR
+ *   (x^7 + x^6 + 1, period 127 bits). Sequences started from different
+ *   non-zero seeds are shifted copies of the same m-sequence, so they are
+ *   uncorrelated and several motors can be excited at the same time.
+ * - Least squares fit of first-order discrete model
+ *       y[k] = A * u[k-1] + B * y[k-1]
+ *   (same model as MOTOR_MODEL_A/MOTOR_MODEL_B, u in %, y in rps)
+ */ 
+
+
+#ifndef SYSID_H_
+#define SYSID_H_
+
+#include <stdint.h>
+
+// Returns next PRBS bit (0 or 1) and advances `p_state` (must be non-zero, 7 bits).
+uint8_t sysid_prbs_next(uint8_t* p_state);
+
+typedef struct
+{
+	// Sums of products of regressors (u[k-1] / 100, y[k-1]) and output y[k].
+	// Input is scaled to 0..1 so that sums keep float precision.
+	float s_uu;
+	float s_uy;
+	float s_yy;
+	float s_u_out;
+	float s_y_out;
+	float previous_u;
+	float previous_y;
+	uint16_t n_samples;
+	uint8_t has_previous;
+} sysid_fit_t;
+
+// Clears accumulated samples.
+void sysid_fit_init(sysid_fit_t* h_fit);
+
+// Adds sample: `y` output measured now, `u` input [%] applied from now
+// until next sample.
+void sysid_fit_feed(sysid_fit_t* h_fit, float u, float y);
+
+// Solves model parameters. Returns 1 on success, 0 if samples do not
+// determine both parameters (too few samples or input without variation).
+uint8_t sysid_fit_solve(const sysid_fit_t* h_fit, float* p_a, float* p_b);
+
+#endif /* SYSID_H_ */
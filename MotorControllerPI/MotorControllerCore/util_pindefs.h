@@ -38,6 +38,12 @@
 
 #define TOGGLE_PIN(PIN_T)	(PORT_REG_(PIN_T) ^= (1 << PORT_BIT_(PIN_T)))
 
+// Read level (1 or 0) of pin PIN_T. E.g. READ_PIN(PIN_A2)
+#define READ_PIN(PIN_T)	((PIN_REG_(PIN_T) >> PIN_BIT_(PIN_T)) & 0x01)
+
+// Unique number of PIN_T, usable in #if. E.g. PIN_ID(PIN_A2) == PIN_ID(PIN_B7)
+#define PIN_ID(PIN_T)	(CONCAT(PORT_INDEX_, LETTER_(PIN_T)) * 8 + NUMBER_(PIN_T))
+
 /*
 	End Public Interface
 */
@@ -404,4 +410,18 @@
 
 //////////////////////////////////////////////////////////////////////////
 
+#define PORT_INDEX_A 0
+#define PORT_INDEX_B 1
+#define PORT_INDEX_C 2
+#define PORT_INDEX_D 3
+#define PORT_INDEX_E 4
+#define PORT_INDEX_F 5
+#define PORT_INDEX_G 6
+#define PORT_INDEX_H 7
+#define PORT_INDEX_J 8
+#define PORT_INDEX_K 9
+#define PORT_INDEX_L 10
+
+//////////////////////////////////////////////////////////////////////////
+
 #endif /* UTIL_PINDEFS_H_ */
\ No newline at end of file
@@ -17,31 +17,22 @@
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/sleep.h>
 #include <util/delay.h>
+#include <util/atomic.h>
 #include "pid.h"
+#include "scheduler.h"
+#include "utils_bitops.h"
+#include "board.h"
+#include "board_motor.h"
+#include "motor_pwm.h"
+#include "pulse_tick_timer.h"
 
 
 /*
  *	Begin Macros
  */
 
-//////////////////////////////////////////////////////////////////////////
-// -- Bitwise Operators
-#define SET_BIT(REG, BIT) REG |= _BV(BIT)
-#define CLR_BIT(REG, BIT) REG &= ~_BV(BIT)
-#define TGL_BIT(REG, BIT) REG ^= _BV(BIT)
-
-#define IS_BIT_SET(REG, BIT) (REG & _BV(BIT))
-
-#define GET_BYTE(REG, OFFSET) (uint8_t)((REG >> OFFSET) & 0xFF)
-//////////////////////////////////////////////////////////////////////////
-
-//////////////////////////////////////////////////////////////////////////
-// ------ Pin Modes
-#define PIN_MODE_OUTPUT(REG, BIT) SET_BIT(REG, BIT)
-#define PIN_MODE_INPUT(REG, BIT)  CLR_BIT(REG, BIT)
-//////////////////////////////////////////////////////////////////////////
-
 //////////////////////////////////////////////////////////////////////////
 // Flag that is used to declare that a function or a block
 // of code uses some resource named X. If a resource is reused
@@ -64,14 +55,14 @@
 typedef struct {
 	uint32_t timer_value;
 	uint32_t buffered_timer_value;
-	uint32_t current_rps;
-	uint8_t  is_measurement_ready;
+	float current_rps;
+	volatile uint8_t is_measurement_ready;
 } hall_encoder_t;
 
 typedef struct {
 	hall_encoder_t hall_encoder;
 	pid_t pid;
-	uint8_t setpoint;
+	float setpoint;
 } motor_t;
 
 /*
@@ -83,18 +74,7 @@ typedef struct {
  *	Begin Pin Definitions
  */
 
-// Connection table for three VNH2SP30 motor controllers
-// * Pin format: ATMEGA328P (ARDUINO UNO)
-
-//	+========+==========+=========+===========+
-//	|        |   IN A   |   PWM   | HALL CH A |
-//	+========+==========+=========+===========+
-//	| MOTOR1 |  PD7(7)  |  PD5(5) |  PD2(2)   |  OC0B
-//	+--------+----------+---------+-----------+
-//	| MOTOR2 |  PB0(8)  |  PD6(6) |  PD3(3)   |  OC0A
-//	+--------+----------+---------+-----------+
-//	| MOTOR3 |  PB4(12) |  PB3(11)|  PD4(4)   |  OC1A
-//	+--------+----------+---------+-----------+
+// Motor pins, PWM channels and encoder interrupts are in board_config.h
 
 /*
  *	End Pin Definitions
@@ -119,8 +99,11 @@ typedef struct {
 #define PID_KP	(float)1.4049
 #define PID_TI	(float)2.1316
 
-#define SAMPLING_FREQUENCY (float)62.5
-#define SAMPLE_TIME_S 1/(float)SAMPLING_FREQUENCY
+// TIMER 2 drives PWM of motor 3, so PID tick counts its overflows:
+// phase correct PWM overflows every 2 * 255 * 8 / F_CPU s (255 us), 63 of
+// them give 62.25 Hz
+#define PID_TICK_OVERFLOWS 63
+#define SAMPLE_TIME_S ((float)PID_TICK_OVERFLOWS * 2 * 255 * 8 / F_CPU)
 //////////////////////////////////////////////////////////////////////////
 
 #define PULSES_PER_ROTATION 245
@@ -134,12 +117,15 @@ typedef struct {
 	#error "Baud rate not supported for frequency"
 #endif
 
-// Defines maximum "believable" RPM value
-// All RPM values above RPM_UPPER_DISCARD_LIMIT
-// will not be saved as RPM values, instead old
+// Defines maximum "believable" RPS value
+// All RPS values above RPS_UPPER_DISCARD_LIMIT
+// will not be saved as RPS values, instead old
 // value will be held. (Crude low pass filter)
 // (Disturbance rejection)
-#define RPM_UPPER_DISCARD_LIMIT 10
+#define RPS_UPPER_DISCARD_LIMIT 10
+
+// Setpoint RPS (Revolutions Per Second) of every motor
+#define MOTOR_SETPOINT_RPS 1.0f
 
 /*
  *	End Constants
@@ -150,17 +136,20 @@ typedef struct {
  *	Start Global Variables
  */
 
-// Used by TIMER 1 overflow ISR to increment
-// Used to keep track of RPM pulse counters (volatile, do not use)
-volatile uint16_t pulse_tick_counter_high_nibble = 0;
-
 // Motors
-motor_t g_motor_1;
-motor_t g_motor_2;
-motor_t g_motor_3;
+#define DEFINE_MOTOR(N)	motor_t g_motor_##N;
+BOARD_FOR_EACH_MOTOR(DEFINE_MOTOR)
 
-volatile uint8_t g_flag_pid = 0;
-pid_t g_pid;
+// Main loop tasks, task id is priority (0 is highest).
+typedef enum {
+	TASK_UPDATE_ENCODERS = 0,	// Posted by encoder ISRs
+	TASK_ADVANCE_PIDS = 1		// Posted by TIMER2_OVF_vect (PID tick)
+} task_id_e;
+
+scheduler_t g_scheduler;
+
+// Counts TIMER 2 overflows up to PID_TICK_OVERFLOWS
+volatile uint8_t g_pid_tick_overflows = 0;
 
 /*
  *	End Global Variables
@@ -180,32 +169,26 @@ pid_t g_pid;
  *	Start User Code Implementation
  */
 
+// Called from encoder ISRs
+static inline void hall_encoder_do_save_timer_value(hall_encoder_t* hEncoder)
+{
+	hEncoder->buffered_timer_value = hEncoder->timer_value;
+	hEncoder->timer_value = PulseTickTimer_GetTimestampFromISR();
+	hEncoder->is_measurement_ready = 1;
+	Scheduler_PostFromISR(&g_scheduler, TASK_UPDATE_ENCODERS);
+}
+
 void setup_gpio_pins(void)
 {
-	// --- MOTOR 1
-		// IN A - PD7
-		PIN_MODE_OUTPUT(DDRD, DDD7);
-		// PWM - PD5
-		PIN_MODE_OUTPUT(DDRD, DDD5);
-		// HALL CH A - PD2
-		PIN_MODE_INPUT(DDRD, DDD2);
-	// --- MOTOR 2
-		// IN A - PB0
-		PIN_MODE_OUTPUT(DDRB, DDB0);
-		// PWM - PD6
-		PIN_MODE_OUTPUT(DDRD, DDD6);
-		// HALL CH A - PD3
-		PIN_MODE_INPUT(DDRD, DDD3);
-	// --- MOTOR 3
-		// IN A - PB4
-		PIN_MODE_OUTPUT(DDRB, DDB4);
-		// PWM - PB3
-		PIN_MODE_OUTPUT(DDRB, DDB3);
-		// HALL CH A - PD4
-		PIN_MODE_INPUT(DDRD, DDD4);
+	// MOTORS (See. board_config.h)
+	board_motor_setup_pins();
 		
 	// UART
-	// TODO ???
+		// TX - PD1
+		PIN_MODE_OUTPUT(PIN_D1);
+	
+	// DEBUG INBUILD-LED
+	PIN_MODE_OUTPUT(ONBOARD_LED);
 }
 
 void set_motor_direction(void)
@@ -213,256 +196,110 @@ void set_motor_direction(void)
 	// Clockwise direction = INA & ~INB
 	
 	// * IN B tied to GND
-	
-	// --- MOTOR 1 (PD7)
-	SET_BIT(PORTD, PORTD7);
-	// --- MOTOR 2 (PB0)
-	SET_BIT(PORTB, PORTB0);
-	// --- MOTOR 3 (PB4)
-	SET_BIT(PORTB, PORTB4);
+#define SET_MOTOR_FORWARD(N)	BOARD_MOTOR_SET_FORWARD(N);
+	BOARD_FOR_EACH_MOTOR(SET_MOTOR_FORWARD)
 }
 
-void configure_motor_pwm_timer(void)
-{
-	//////////////////////////////////////////////////////////////////////////
-	// Three motors need three PWM channels (Output Compare Registers):
-	// - 8 bit TIMER0 Channels A & B
-	// - 8 bit TIMER2 Channels A (& B UNUSED)
-	//////////////////////////////////////////////////////////////////////////
-	
-	//////////////////////////////////////////////////////////////////////////
-	// -- Timer 0
-	// Phase corrected PWM mode
-	
-	// Set phase corrected PWM mode of operation
-	SET_BIT(TCCR0A, WGM00);
-	CLR_BIT(TCCR0A, WGM01);
-	CLR_BIT(TCCR0B, WGM02);
-	
-	// Set on upcount, clear on downcount
-	// Output Compare - A
-	SET_BIT(TCCR0A, COM0A0);
-	SET_BIT(TCCR0A, COM0A1);
-	
-	// Output Compare - B
-	SET_BIT(TCCR0A, COM0B0);
-	SET_BIT(TCCR0A, COM0B1);
-
-	// Set clock prescaler to 1/8
-	// Which gives 16MHz/(8 * 510) = 3.9 kHz PWM frequency
-	CLR_BIT(TCCR0B, CS00);
-	SET_BIT(TCCR0B, CS01);
-	CLR_BIT(TCCR0B, CS02);
-	
-	// Disable interrupts
-	// Overflow
-	CLR_BIT(TIMSK0, TOV0);
-	// Output Compare B Match
-	CLR_BIT(TIMSK0, OCIE0A);
-	// Output Compare B Match
-	CLR_BIT(TIMSK0, OCIE0B);
-	//////////////////////////////////////////////////////////////////////////
-	
-	//////////////////////////////////////////////////////////////////////////
-	// -- Timer 2
-	
-	// Phase corrected PWM mode
-	
-	// Set phase corrected PWM mode of operation
-	SET_BIT(TCCR2A, WGM20);
-	CLR_BIT(TCCR2A, WGM21);
-	CLR_BIT(TCCR2B, WGM22);
+// Calculates new RPS value of 'hEncoder' Hall Encoder
+// from timestamps saved by encoder ISRs
+void do_update_rps(hall_encoder_t* hEncoder)
+{	
+	uint32_t ticks = 0;
 	
-	// Set on upcount, clear on downcount
-	// Output Compare - A
-	SET_BIT(TCCR2A, COM2A0);
-	SET_BIT(TCCR2A, COM2A1);
+	// Timestamps are written by encoder ISR, unsigned subtraction handles timer wrap-around
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		ticks = hEncoder->timer_value - hEncoder->buffered_timer_value;
+	}
 	
-	// Output Compare - B
-	// ------ UNUSED
-	// SET_BIT(TCCR2A, COM2B0);
-	// SET_BIT(TCCR2A, COM2B1);
-
-	// Set clock prescaler to 1/8
-	// Which gives 16MHz/(8 * 510) = 3.9 kHz PWM frequency
-	CLR_BIT(TCCR2B, CS00);
-	SET_BIT(TCCR2B, CS01);
-	CLR_BIT(TCCR2B, CS02);
+	if (ticks == 0)
+	{
+		return;
+	}
 	
-	// Disable interrupts
-	// Overflow
-	CLR_BIT(TIMSK2, TOV2);
-	// Output Compare B Match
-	CLR_BIT(TIMSK2, OCIE2A);
-	// Output Compare B Match
-	CLR_BIT(TIMSK2, OCIE2B);
+	const float new_rps = F_CPU/((float)ticks * PULSES_PER_ROTATION);
 	
-	//////////////////////////////////////////////////////////////////////////
+	// Crude low-pass (disturbance rejection) filter
+	if(new_rps < RPS_UPPER_DISCARD_LIMIT)
+	{
+		hEncoder->current_rps = new_rps;
+	}
 }
 
-// input:
-// - duty_cycle = [0..100] = Duty Cycle Percentage
-// output:
-// - Output compare value for:
-//		* 8 bit timer
-//		* Phase corrected PWM mode
-//		* Set on upcount, clear on downcount
-inline uint8_t calculate_oc_value_from_dc(uint32_t duty_cycle)
+void enable_pid_timer(void)
 {
-	// Set phase corrected PWM value
-	// from defined duty cycle
-	// NOTE: Formula used is modified for integer division
-	
-	return (uint8_t)((255 * ((uint32_t)100 - duty_cycle))/100);
+	// PID tick counts overflows of PWM TIMER 2 (See. motor_pwm.h)
+	TIFR2 = _BV(TOV2);
+	SET_BIT(TIMSK2, TOIE2);
 }
 
-
-void enable_encoder_interrupt(void)
+void setup_usart(void)
 {
-	// Enable Pullups (Disable pullup blockade)
-	CLR_BIT(MCUCR, PUD);
-	
-	//////////////////////////////////////////////////////////////////////////
-	// -- MOTOR 1
-	// Configure PD2 (INT0) as input
-	CLR_BIT(DDRD, DDD2);
-	
-	// Enable pullup (IG32E Hall encoder docs require 1k external pullup)
-	SET_BIT(PORTD, PORTD2);
-	
-	// Set rising edge mode for INT0 (PD2)
-	SET_BIT(EICRA, ISC00);
-	SET_BIT(EICRA, ISC01);
-	
-	// Enable external interrupt
-	SET_BIT(EIMSK, INT0);
-	//////////////////////////////////////////////////////////////////////////
-
-	//////////////////////////////////////////////////////////////////////////
-	// -- MOTOR 2
-	// Configure PD3 (INT1) as input
-	CLR_BIT(DDRD, DDD3);
-	
-	// Enable pullup (IG32E Hall encoder docs require 1k external pullup)
-	SET_BIT(PORTD, PORTD3);
-	
-	// Set rising edge mode for INT1 (PD3)
-	SET_BIT(EICRA, ISC10);
-	SET_BIT(EICRA, ISC11);
+	// USART0
 	
-	// Enable external interrupt
-	SET_BIT(EIMSK, INT1);
-	//////////////////////////////////////////////////////////////////////////
-
+	// Set baud rate to 115.2 kbps
+	UBRR0 = (uint16_t)BAUD_RATE_UBBR_115_2_KBPS;
 
-	//////////////////////////////////////////////////////////////////////////
-	// -- MOTOR 3
-	// * NOTE: Motor 3 Hall sensor uses PCINT instead of INT pins
-	// Configure PD4 as input
-	CLR_BIT(DDRD, DDD4);
-	
-	// Enable pullup (IG32E Hall encoder docs require 1k external pullup)
-	SET_BIT(PORTD, PORTD4);
-	
-	// Enable Pin Change Interrupt (PCIE2)
-	SET_BIT(PCICR, PCIE2);
+	// Enable transmitter
+	SET_BIT(UCSR0B, TXEN0);
 	
-	// Mask all PCINT except PCINT20
-	SET_BIT(PCMSK2, PCINT20);
-	//////////////////////////////////////////////////////////////////////////
+	// Set frame format: 8data, 1 stop bit
+	SET_BIT(UCSR0C, UCSZ00);
+	SET_BIT(UCSR0C, UCSZ01);
+	CLR_BIT(UCSR0B, UCSZ02);
 
 }
 
-/////////////////////////////// TOOOOOOOOOOOOOOOODOOOOOOOOOOOOOOOOOOOO
- 
-void configure_pulse_tick_timer(void) 
+void setup_PID(void)
 {
-	// Set normal mode of operation
-	CLR_BIT(TCCR1A, COM1A0);
-	CLR_BIT(TCCR1A, COM1A1);
-	
-	CLR_BIT(TCCR1A, WGM10);
-	CLR_BIT(TCCR1A, WGM11);
-	CLR_BIT(TCCR1B, WGM12);
-	CLR_BIT(TCCR1B, WGM13);
-	
-	// Initialize timer value
-	TCNT1 = 0;
+	// PID Controller of every motor
+#define SETUP_MOTOR_PID(N)	\
+	PID_Init(&g_motor_##N.pid, PID_KP, 0, PID_TI, 0, 95);	\
+	g_motor_##N.setpoint = MOTOR_SETPOINT_RPS;
+	BOARD_FOR_EACH_MOTOR(SETUP_MOTOR_PID)
 }
 
-void enable_pulse_tick_timer(void)
+void do_advance_pids(void)
 {
-	// Enable overflow interrupt	
-	SET_BIT(TIMSK1, TOIE1);
-	
-	// Enable clock (no prescaler)
-	SET_BIT(TCCR1B, CS10);
-	CLR_BIT(TCCR1B, CS11);
-	CLR_BIT(TCCR1B, CS12);
-}
-
-void do_update_rpm(void)
-{	
-	float new_rpm = F_CPU/((float)buffered_pulse_tick_counter * PULSES_PER_ROTATION);
+	motor_pwm_compare_t compares[BOARD_MOTOR_COUNT];
 	
-	// Crude low-pass (disturbance rejection) filter
-	if(new_rpm < RPM_UPPER_DISCARD_LIMIT)
-	{
-		g_current_rpm = new_rpm;
+#define ADVANCE_MOTOR_PID(N)																	\
+	{																							\
+		const float error = g_motor_##N.setpoint - g_motor_##N.hall_encoder.current_rps;		\
+		const float input = PID_Advance(&g_motor_##N.pid, SAMPLE_TIME_S, error);				\
+		compares[BOARD_MOTOR_INDEX(N)] = motor_pwm_compare_from_duty(PIDQ_FROM_FLOAT(input));	\
 	}
+	BOARD_FOR_EACH_MOTOR(ADVANCE_MOTOR_PID)
+	
+	// Also clears TIMER 2, next PID tick is PID_TICK_OVERFLOWS from now
+	motor_pwm_write(compares);
 }
 
-void setup_pid_timer(void)
+void task_update_encoders(void)
 {
-	// Time for timer to tick once T1 = 256/F_CPU (prescaler = 256).
-	// If we want timer to interrupt every T seconds, we must set compare register
-	// to N ticks where N = T/T1 = F_CPU/F_S where F_S is the sampling (interrupt) frequency.
-	// For explanation of (- 1) at the end, see documentation
-	//const uint8_t timer_compare_value = (uint8_t)(F_CPU/(1024 * SAMPLING_FREQUENCY));
-	const uint8_t timer_compare_value = 250;
-	// Set output compare register A value
-	OCR2A = timer_compare_value;
-	
-	// Initialize timer value
-	TCNT2 = 0;
-	
-	// Set OC CTC mode of operation
-	CLR_BIT(TCCR2A, WGM20);
-	CLR_BIT(TCCR2A, WGM21);
-	SET_BIT(TCCR2B, WGM22);
+#define UPDATE_MOTOR_ENCODER(N)								\
+	if(g_motor_##N.hall_encoder.is_measurement_ready)		\
+	{														\
+		g_motor_##N.hall_encoder.is_measurement_ready = 0;	\
+		do_update_rps(&g_motor_##N.hall_encoder);			\
+	}
+	BOARD_FOR_EACH_MOTOR(UPDATE_MOTOR_ENCODER)
 }
 
-void enable_pid_timer(void)
+void task_advance_pids(void)
 {
-	// Enable interrupt
-	SET_BIT(TIMSK2, OCIE2A);
-	
-	// Enable clock (prescaler = 1024)
-	CLR_BIT(TCCR2B, CS20);
-	CLR_BIT(TCCR2B, CS21);
-	SET_BIT(TCCR2B, CS22);
+	do_advance_pids();
 }
 
-void setup_usart(void)
+void setup_scheduler(void)
 {
-	// USART0
+	Scheduler_Init(&g_scheduler);
 	
-	// Set baud rate to 115.2 kbps
-	UBRR0 = (uint16_t)BAUD_RATE_UBBR_115_2_KBPS;
-
-	// Enable transmitter
-	SET_BIT(UCSR0B, TXEN0);
+	// CPU sleeps when no task is ready, timers keep running
+	set_sleep_mode(SLEEP_MODE_IDLE);
 	
-	// Set frame format: 8data, 1 stop bit
-	SET_BIT(UCSR0C, UCSZ00);
-	SET_BIT(UCSR0C, UCSZ01);
-	CLR_BIT(UCSR0B, UCSZ02);
-
-}
-
-void setup_PID(void)
-{
-	PID_Init(&g_pid, PID_KP, 0, PID_TI, 0, 95);
+	Scheduler_RegisterTask(&g_scheduler, TASK_UPDATE_ENCODERS,	task_update_encoders);
+	Scheduler_RegisterTask(&g_scheduler, TASK_ADVANCE_PIDS,		task_advance_pids);
 }
 
 int main(void)
@@ -471,51 +308,24 @@ int main(void)
 	setup_gpio_pins();
 	set_motor_direction();
 	
-	configure_pulse_tick_timer();
+	PulseTickTimer_Init(NULL);
 	setup_usart();
 	
 	setup_PID();
 	
-	//_delay_ms(STEP_INPUT_DELAY_MS);
+	board_motor_enable_encoder_interrupts();
+	PulseTickTimer_Start();
+	motor_pwm_init();
 	
-	enable_encoder_interrupt();
-	enable_pulse_tick_timer();
-	configure_motor_pwm_timer();
-	set_motor_enable();
-	set_motor_speed_pwm(30);
-
+	setup_scheduler();
 	
 	sei();
 	
-	 //Ignore first measurement
-	 
-	while(!is_rpm_measurement_ready)
-	{
-		;
-	}
-	is_rpm_measurement_ready = 0;
-	
-	setup_pid_timer();
 	enable_pid_timer();
 	
-	
     while (1) 
     {
-		if(is_rpm_measurement_ready)
-		{
-			do_update_rpm();
-			is_rpm_measurement_ready = 0;
-		}
-		
-		if(flag_pid)
-		{
-			g_current_error = setpoint_rpm - g_current_rpm;
-			g_current_duty_cycle_input = PID_Advance(&g_pid, SAMPLE_TIME_S, g_current_error);
-			set_motor_speed_pwm((uint32_t)g_current_duty_cycle_input);
-			 do_send_data();
-			flag_pid = 0;
-		}
-		
+		Scheduler_RunNextOrSleep(&g_scheduler);
     }
 }
 
@@ -527,34 +337,30 @@ int main(void)
  *	Start Signal Handlers
  */
 
-ISR(INT0_vect)
-{
-	// Save old values for UART
-	buffered_pulse_tick_counter = TCNT1;
-	buffered_pulse_tick_counter |= ((uint32_t)(pulse_tick_counter_high_nibble)) << 16;
-	
-	// Signal data to UART
-	is_rpm_measurement_ready = 1;
-	
-	// Clear timer/counter
-	TCNT1 = 0;
-	pulse_tick_counter_high_nibble = 0;
-	
-	
-}
-
-ISR(TIMER1_OVF_vect)
-{
-	++pulse_tick_counter_high_nibble;
-	
-	// For debugging and calculating
-	// timer period using oscilloscope
-	TGL_BIT(PORTB, PORTB5); 
-}
+// Channel A of motors on INTn (See. board_config.h)
+#define DEFINE_MOTOR_ENCODER_ISR(N)	\
+	ISR(MOTOR_##N##_ENCODER_ISR) { hall_encoder_do_save_timer_value(&g_motor_##N.hall_encoder); }
+BOARD_FOR_EACH_EXT_INT_MOTOR(DEFINE_MOTOR_ENCODER_ISR)
+
+// Channel A of motors on pin change interrupts (See. board_config.h),
+// interrupt fires on both edges, only rising edge is timestamped
+#define DEFINE_MOTOR_PCINT_ENCODER_ISR(N)							\
+	ISR(MOTOR_##N##_ENCODER_ISR)									\
+	{																\
+		if (READ_PIN(MOTOR_##N##_HCHA))								\
+		{															\
+			hall_encoder_do_save_timer_value(&g_motor_##N.hall_encoder);	\
+		}															\
+	}
+BOARD_FOR_EACH_PCINT_MOTOR(DEFINE_MOTOR_PCINT_ENCODER_ISR)
 
-ISR(TIMER2_COMPA_vect)
+ISR(TIMER2_OVF_vect)
 {
-	flag_pid = 1;
+	if (++g_pid_tick_overflows >= PID_TICK_OVERFLOWS)
+	{
+		g_pid_tick_overflows = 0;
+		Scheduler_PostFromISR(&g_scheduler, TASK_ADVANCE_PIDS);
+	}
 }
 /*
  *	End Signal Handlers
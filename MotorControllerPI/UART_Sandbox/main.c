@@ -176,8 +176,8 @@ PRIVATE volatile command_receiver_state_e g_frame_receiver_state = CMD_RCV_IDLE;
 
 #define RECEIVE_BUFFER_SIZE 64
 
-PRIVATE volatile uint8_t g_receive_buffer_internal_[RECEIVE_BUFFER_SIZE] = {0};
-PRIVATE volatile circular_buffer_t g_receive_buffer;
+PRIVATE uint8_t g_receive_buffer_internal_[RECEIVE_BUFFER_SIZE] = {0};
+PRIVATE circular_buffer_t g_receive_buffer;
 
 /*
  *	End Global Variables
@@ -606,7 +606,7 @@ int main(void)
 	
     while (1) 
     {
-		if(CBuf_AvailableForRead(g_receive_buffer) && g_frame_receiver_state != CMD_RCV_FULL_FRAME_READ)
+		if(CBuf_AvailableForRead(&g_receive_buffer) && g_frame_receiver_state != CMD_RCV_FULL_FRAME_READ)
 		{
 			uint8_t value;
 			uint8_t error = CBuf_Read(&g_receive_buffer, &value);
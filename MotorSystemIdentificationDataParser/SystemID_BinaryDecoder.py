@@ -0,0 +1,237 @@
+import os
+import time
+from dataclasses import dataclass
+from typing import Dict, Iterator, List, Tuple
+import numpy as np
+
+
+# Vectorized decoder for the fixed-size binary records the controller
+# streams while capturing MotorSamples. Every record is a packed
+# little-endian struct followed by a line terminator, the decoder memory
+# maps the capture, resynchronizes on the terminator after dropped or
+# inserted bytes and returns one numpy array per field.
+
+# ----------------------------------------------------------------- #
+#                            SETTINGS                               #
+# ----------------------------------------------------------------- #
+
+INPUT_FILE = r'MotorSamples\PulsePosition\pid\setpoint_30_sampling_f_62_5_006_live.bin'
+
+# ----------------------------------------------------------------- #
+#                                                                   #
+# ----------------------------------------------------------------- #
+
+
+@dataclass(frozen=True)
+class RecordLayout:
+    fields : Tuple[Tuple[str, str], ...]
+    terminator : bytes
+
+    @property
+    def dtype(self) -> np.dtype:
+        names = [name for (name, _) in self.fields]
+        formats = [fmt for (_, fmt) in self.fields]
+        offsets = []
+        offset = 0
+        for fmt in formats:
+            offsets.append(offset)
+            offset += np.dtype(fmt).itemsize
+        return np.dtype({
+            'names': names,
+            'formats': formats,
+            'offsets': offsets,
+            'itemsize': offset + len(self.terminator),
+        })
+
+    @property
+    def size(self) -> int:
+        return self.dtype.itemsize
+
+
+# uint16 sample_nr, uint32 pulse period [F_CPU ticks], '\n'
+PULSE_POSITION = RecordLayout(
+    fields=(('sample_nr', '<u2'), ('period_ticks', '<u4')),
+    terminator=b'\n',
+)
+
+# uint32 sample_nr, ',', uint8 input, ',', uint32 pulse count, '\n'
+PULSE_COUNT = RecordLayout(
+    fields=(('sample_nr', '<u4'), ('_separator_0', 'u1'), ('input', 'u1'),
+            ('_separator_1', 'u1'), ('pulse_count', '<u4')),
+    terminator=b'\n',
+)
+
+# uint16 sample_nr, float setpoint, float rps, '\r\n'
+PID = RecordLayout(
+    fields=(('sample_nr', '<u2'), ('setpoint', '<f4'), ('rps', '<f4')),
+    terminator=b'\r\n',
+)
+
+# uint16 sample_nr, float setpoint, float rps, float input, '\r\n'
+PID_WITH_INPUT = RecordLayout(
+    fields=(('sample_nr', '<u2'), ('setpoint', '<f4'), ('rps', '<f4'), ('input', '<f4')),
+    terminator=b'\r\n',
+)
+
+
+LAYOUTS = (PULSE_POSITION, PULSE_COUNT, PID, PID_WITH_INPUT)
+
+# Number of bytes at the start of a capture used to detect its layout
+DETECT_LAYOUT_SIZE = 4096
+
+
+# Returns mask of offsets at which a complete record with a valid
+# terminator starts
+def _get_terminator_mask(buffer : np.ndarray, layout : RecordLayout) -> np.ndarray:
+    R = layout.size
+    T = layout.terminator
+    n_starts = len(buffer) - R + 1
+    if n_starts <= 0:
+        return np.zeros(0, dtype=bool)
+
+    mask = np.ones(n_starts, dtype=bool)
+    for k, byte in enumerate(T):
+        first = R - len(T) + k
+        mask &= buffer[first:first + n_starts] == byte
+    return mask
+
+
+# Returns list of (offset, record count) of consecutive valid records and
+# the offset of the first byte not belonging to a complete record
+def _find_segments(buffer : np.ndarray, layout : RecordLayout) -> Tuple[List[Tuple[int, int]], int]:
+    R = layout.size
+    valid = _get_terminator_mask(buffer, layout)
+    # After losing sync two consecutive terminators are required, a single
+    # terminator byte is too likely to show up inside the payload
+    sync_offsets = np.flatnonzero(valid[:-R] & valid[R:])
+
+    segments = []
+    offset = 0
+    end = 0
+    while offset < len(valid):
+        chain = valid[offset::R]
+        count = int(np.argmin(chain)) if not chain.all() else len(chain)
+        if count > 0:
+            segments.append((offset, count))
+            end = offset + count * R
+
+        next_offset = offset + count * R
+        if next_offset >= len(valid):
+            break
+
+        i = np.searchsorted(sync_offsets, next_offset + 1)
+        if i == len(sync_offsets):
+            break
+        offset = int(sync_offsets[i])
+
+    return segments, end
+
+
+def decode_buffer(buffer : np.ndarray, layout : RecordLayout) -> Tuple[Dict[str, np.ndarray], int, int]:
+    """Decodes all records in `buffer` (uint8 array).
+
+    Returns (columns, consumed bytes, discarded bytes). Bytes past
+    `consumed` may hold an incomplete record.
+    """
+    segments, consumed = _find_segments(buffer, layout)
+    dtype = layout.dtype
+    R = layout.size
+
+    parts = [buffer[offset:offset + count * R].view(dtype) for (offset, count) in segments]
+    if len(parts) == 0:
+        records = np.zeros(0, dtype=dtype)
+    elif len(parts) == 1:
+        records = parts[0]
+    else:
+        records = np.concatenate(parts)
+
+    columns = {
+        name: np.ascontiguousarray(records[name])
+        for (name, _) in layout.fields if not name.startswith('_')
+    }
+    discarded = consumed - len(records) * R
+    return columns, consumed, discarded
+
+
+def detect_layout(buffer : np.ndarray) -> RecordLayout:
+    """Picks the layout that explains most bytes at the start of `buffer`."""
+    head = buffer[:DETECT_LAYOUT_SIZE]
+    best_layout = LAYOUTS[0]
+    best_coverage = -1
+    for layout in LAYOUTS:
+        segments, _ = _find_segments(head, layout)
+        coverage = sum(count for (_, count) in segments) * layout.size
+        if coverage > best_coverage:
+            best_layout = layout
+            best_coverage = coverage
+    return best_layout
+
+
+def decode_file(file_path, layout : RecordLayout = None) -> Dict[str, np.ndarray]:
+    """Decodes whole capture file into one numpy array per record field."""
+    if os.path.getsize(file_path) == 0:
+        layout = layout if layout is not None else LAYOUTS[0]
+        return {name: np.zeros(0, dtype=fmt) for (name, fmt) in layout.fields if not name.startswith('_')}
+
+    buffer = np.memmap(file_path, dtype=np.uint8, mode='r')
+    if layout is None:
+        layout = detect_layout(buffer)
+    columns, _, _ = decode_buffer(buffer, layout)
+    return columns
+
+
+class StreamDecoder:
+    """Incremental decoder for live captures, keeps incomplete records
+    between calls to `feed`."""
+    layout : RecordLayout
+    discarded_bytes : int
+
+    _pending : bytes
+
+    def __init__(self, layout : RecordLayout) -> None:
+        self.layout = layout
+        self.discarded_bytes = 0
+        self._pending = b''
+
+    def feed(self, data : bytes) -> Dict[str, np.ndarray]:
+        self._pending += data
+        buffer = np.frombuffer(self._pending, dtype=np.uint8)
+        columns, consumed, discarded = decode_buffer(buffer, self.layout)
+
+        # Out of sync, keep only what could still start a record
+        keep = 2 * self.layout.size - 1
+        if len(self._pending) - consumed > keep:
+            discarded += len(self._pending) - keep - consumed
+            consumed = len(self._pending) - keep
+
+        self.discarded_bytes += discarded
+        self._pending = self._pending[consumed:]
+        return columns
+
+
+def follow_file(file_path, layout : RecordLayout, poll_interval : float = 0.1) -> Iterator[Dict[str, np.ndarray]]:
+    """Yields newly decoded records as `file_path` grows."""
+    decoder = StreamDecoder(layout)
+    with open(file_path, 'rb') as f:
+        while True:
+            data = f.read()
+            if not data:
+                time.sleep(poll_interval)
+                continue
+            columns = decoder.feed(data)
+            if len(columns['sample_nr']) > 0:
+                yield columns
+
+
+if __name__ == '__main__':
+
+    file_path = INPUT_FILE
+
+    start = time.perf_counter()
+    columns = decode_file(file_path)
+    elapsed = time.perf_counter() - start
+
+    n_records = len(columns['sample_nr'])
+    print(f'{n_records} records decoded in {elapsed * 1e3:.2f} ms')
+    for name, values in columns.items():
+        print(f'{name}: {values[:8]}')
@@ -4,6 +4,7 @@ import os
 import csv
 from typing import List, Tuple
 from matplotlib import pyplot as plt
+from SystemID_BinaryDecoder import decode_file, PULSE_POSITION
  
 
 # RPS = revolutions per second
@@ -33,16 +34,12 @@ def parse_line(line : bytes) -> Tuple[int, int]:
 
 # Takes a file path and returns tuple of parsed values
 def parse_file(file_path) -> List[Tuple[int, int]]:
-    with open(file_path, 'rb') as f:
-        data = f.read()
-        N = 7
-        data = [data[i:i + N] for i in range(0, len(data), N)]
-        data = [parse_line(x) for x in data]
+    columns = decode_file(file_path, PULSE_POSITION)
 
-        i_data = [i for (i, Tp) in data]
-        Tp_data = [Tp for (i, Tp) in data]
+    i_data = columns['sample_nr'].tolist()
+    Tp_data = columns['period_ticks'].tolist()
 
-        return (i_data, Tp_data)
+    return (i_data, Tp_data)
 
 def plot_data(data : Tuple[int, int, int]) -> Tuple[float, float]:
     (i, Tp) = data
@@ -1,9 +1,11 @@
 from enum import Enum
+import itertools
 import math
 import os
 import csv
 from typing import List, Tuple
 from matplotlib import pyplot as plt
+from SystemID_BinaryDecoder import decode_file, PULSE_POSITION
  
 
 # RPS = revolutions per second
@@ -33,16 +35,12 @@ def parse_line(line : bytes) -> Tuple[int, int]:
 
 # Takes a file path and returns tuple of parsed values
 def parse_file(file_path) -> List[Tuple[int, int]]:
-    with open(file_path, 'rb') as f:
-        data = f.read()
-        N = 7
-        data = [data[i:i + N] for i in range(0, len(data), N)]
-        data = [parse_line(x) for x in data]
+    columns = decode_file(file_path, PULSE_POSITION)
 
-        i_data = [i for (i, Tp) in data]
-        Tp_data = [Tp for (i, Tp) in data]
+    i_data = columns['sample_nr'].tolist()
+    Tp_data = columns['period_ticks'].tolist()
 
-        return (i_data, Tp_data)
+    return (i_data, Tp_data)
 
 def get_ideal_reponse(t : Tuple[int], tau : int, K : int) -> Tuple[float]:
     y = [K * (1 - math.exp(-x/tau)) for x in t]
@@ -64,7 +62,9 @@ def plot_data(data : Tuple[int, int, int]) -> Tuple[float, float]:
     tau_p_index = next(i for i,v in enumerate(spd) if v >= tau_p_speed_value)
     tau_p = sum(Tp[:tau_p_index]) * 1/F_CPU
 
-    t = [sum(Tp[:x]) * 1/F_CPU for x in i]
+    # Prefix sums, t[x] = sum(Tp[:x]) / F_CPU
+    prefix = list(itertools.accumulate(Tp, initial=0))
+    t = [prefix[min(x, len(Tp))] * 1/F_CPU for x in i]
 
     y = get_ideal_reponse(t, tau_p, Kp)
 
@@ -7,6 +7,10 @@ TIMESTEP = 0.016
 SETPOINT = 0.5
 A = 0.04924
 B = 0.2617
+# Mirrors PID_FEEDFORWARD_INVERSE_MODEL in MotorControllerPI/MotorControllerCore/pid.c
+FEEDFORWARD = False
+# Settling band relative to setpoint
+SETTLING_BAND = 0.02
 
 class FirstOrderPlant:
     A : float
@@ -58,7 +62,9 @@ class PIController:
         self._current_output = 0
         self._previous_output = 0
 
-    def CalculateSample(self, error : float, timestep : float) -> float:
+    def CalculateSample(self, error : float, timestep : float, feedforward : float = 0) -> float:
+        # `_current_output` holds PI part only, limits apply to PI + feedforward
+        # (same as PID_AdvanceFixedRateWithFeedforward())
         self._previous_error = self._current_error
         self._current_error = error
 
@@ -73,28 +79,74 @@ class PIController:
             + self._current_output
         )
 
-        if self._current_output > self.out_max:
-            self._current_output = self.out_max
-        elif self._current_output < self.out_min:
-            self._current_output = self.out_min
+        if self._current_output + feedforward > self.out_max:
+            self._current_output = self.out_max - feedforward
+        elif self._current_output + feedforward < self.out_min:
+            self._current_output = self.out_min - feedforward
 
-        return self._current_output
+        return self._current_output + feedforward
+
+
+class InverseModelFeedforward:
+    c0 : float
+    c1 : float
+
+    A : float
+    B : float
+    # Model response to feedforward outputs, PI error is `reference - y`
+    reference : float
+
+    _previous_setpoint : float
+    _previous_output : float
+
+    def __init__(self, A, B) -> None:
+        self.c0 = 1 / A
+        self.c1 = -B / A
+        self.A = A
+        self.B = B
+        self.reference = 0
+        self._previous_setpoint = 0
+        self._previous_output = 0
+
+    def Advance(self, setpoint : float) -> float:
+        self.reference = self.A * self._previous_output + self.B * self.reference
+        output = self.c0 * setpoint + self.c1 * self._previous_setpoint
+        self._previous_setpoint = setpoint
+        self._previous_output = output
+        return output
+
+
+def step_response_metrics(y : list, setpoint : float, timestep : float, band : float) -> tuple:
+    """Returns (overshoot [%], settling time [s]) of step response `y`."""
+    overshoot = max(0.0, (max(y) - setpoint) / setpoint * 100)
+
+    settling_index = 0
+    for i, value in enumerate(y):
+        if abs(value - setpoint) > band * setpoint:
+            settling_index = i + 1
+
+    return overshoot, settling_index * timestep
 
 
 if __name__ == '__main__':
 
     pid = PIController(KP, TI, 0, 95)
     plant = FirstOrderPlant(A, B)
+    feedforward = InverseModelFeedforward(A, B)
 
     y = STEPS * [0,]
     x = STEPS * [0,]
     e = STEPS * [0,]
 
     for i in range(1, STEPS):
-        e[i] = SETPOINT - y[i - 1]
-        x[i] = pid.CalculateSample(e[i], TIMESTEP)
+        ff = feedforward.Advance(SETPOINT) if FEEDFORWARD else 0
+        e[i] = (feedforward.reference if FEEDFORWARD else SETPOINT) - y[i - 1]
+        x[i] = pid.CalculateSample(e[i], TIMESTEP, ff)
         y[i] = plant.Advance(x[i])
 
+    overshoot, settling_time = step_response_metrics(y, SETPOINT, TIMESTEP, SETTLING_BAND)
+    print(f'Overshoot: {overshoot:.2f} %, settling time ({SETTLING_BAND * 100:.0f} %): {settling_time:.3f} s')
+
     t = range(STEPS)
     t = [v * TIMESTEP for v in t]
 